@@ -3,28 +3,40 @@
 #include "VSServerCommandlet.h"
 #include "VSTestAdapterCommandlet.h"
 
-#include "Windows/AllowWindowsPlatformTypes.h"
+#include "VSServerTransport.h"
 
 #include "HAL/PlatformNamedPipe.h"
 #include "Runtime/Core/Public/Async/TaskGraphInterfaces.h"
+#include "Runtime/Core/Public/Containers/Queue.h"
 #include "Runtime/Core/Public/Containers/Ticker.h"
+#include "Runtime/Core/Public/HAL/Event.h"
+#include "Runtime/Core/Public/HAL/FileManager.h"
+#include "Runtime/Core/Public/HAL/PlatformProcess.h"
+#include "Runtime/Core/Public/Misc/Paths.h"
 #include "Runtime/Engine/Classes/Engine/World.h"
 #include "Runtime/Engine/Public/TimerManager.h"
 #include "Runtime/Launch/Resources/Version.h"
-#include "Runtime\CoreUObject\Public\UObject\UObjectGlobals.h"
+#include "Runtime/CoreUObject/Public/UObject/UObjectGlobals.h"
+#include <atomic>
 #include <chrono>
-#include <codecvt>
 #include <fstream>
 #include <string>
 #include <thread>
-#include <windows.h>
-
-#include "Windows/HideWindowsPlatformTypes.h"
 
 #include "VisualStudioTools.h"
 
 static constexpr auto NamedPipeParam = TEXT("NamedPipe");
 static constexpr auto KillServerParam = TEXT("KillVSServer");
+static constexpr auto LatencyClientParam = TEXT("LatencyClient");
+static constexpr auto ColdRunsParam = TEXT("ColdRuns");
+
+// Answered right away without running a commandlet, used to measure the transport itself.
+static constexpr auto PingRequest = TEXT("Ping");
+
+static double Percentile(const TArray<double>& Sorted, double Fraction)
+{
+	return Sorted[FMath::Clamp(FMath::FloorToInt(Fraction * (Sorted.Num() - 1)), 0, Sorted.Num() - 1)];
+}
 
 UVSServerCommandlet::UVSServerCommandlet()
 {
@@ -32,63 +44,218 @@ UVSServerCommandlet::UVSServerCommandlet()
 	HelpUsage = TEXT("<Editor-Cmd.exe> <path_to_uproject> -run=VSServer [-stdout -multiprocess -silent -unattended -AllowStdOutLogVerbosity -NoShaderCompile]");
 
 	HelpParamNames.Add(NamedPipeParam);
-	HelpParamDescriptions.Add(TEXT("[Required] The name of the named pipe used to communicate with Visual Studio."));
+	HelpParamDescriptions.Add(TEXT("[Required] The name of the named pipe used to communicate with Visual Studio. On Linux, a Unix domain socket: this path, or <name>.sock in the temp directory."));
 
 	HelpParamNames.Add(KillServerParam);
 	HelpParamDescriptions.Add(TEXT("[Optional] Quit the server mode commandlet immediately."));
+
+	HelpParamNames.Add(LatencyClientParam);
+	HelpParamDescriptions.Add(TEXT("[Optional] Connect to the server on the named pipe as a client instead, send this many ping requests and report their round-trip latency."));
+
+	HelpParamNames.Add(ColdRunsParam);
+	HelpParamDescriptions.Add(TEXT("[Optional] With -LatencyClient, also time this many test discovery requests on the warm server against the same request run as a new commandlet process."));
+}
+
+int32 UVSServerCommandlet::ExecuteRequest(const FString& SubCommandletParams, bool& bOutKillServer)
+{
+	// Determine which sub-commandlet to invoke.
+	if (SubCommandletParams.Contains("VSTestAdapter"))
+	{
+		UVSTestAdapterCommandlet *Commandlet = NewObject<UVSTestAdapterCommandlet>();
+		try
+		{
+			return Commandlet->Main(SubCommandletParams);
+		}
+		catch (const std::exception &ex)
+		{
+			UE_LOG(LogVisualStudioTools, Display, TEXT("Exception invoking VSTestAdapter commandlet: %s"), UTF8_TO_TCHAR(ex.what()));
+			return 1;
+		}
+	}
+	else if (SubCommandletParams.Contains(KillServerParam))
+	{
+		// Answered before the server stops, so the client knows the request arrived.
+		bOutKillServer = true;
+		return 0;
+	}
+	else if (SubCommandletParams.Equals(PingRequest))
+	{
+		return 0;
+	}
+
+	// If cannot find which sub-commandlet to run, then return error.
+	UE_LOG(LogVisualStudioTools, Warning, TEXT("Unknown server request: %s"), *SubCommandletParams);
+	return 1;
 }
 
-void UVSServerCommandlet::ExecuteSubCommandlet(FString ueServerNamedPipe)
+int32 UVSServerCommandlet::RunServer(const FString& ueServerNamedPipe)
 {
-	char buffer[1024];
-	DWORD dwRead;
-	std::string result = "0";
-
-	// Open the named pipe.
-	std::wstring pipeName = L"\\\\.\\pipe\\";
-	pipeName.append(ueServerNamedPipe.GetCharArray().GetData());
-	HANDLE HPipe = CreateFile(pipeName.c_str(), GENERIC_READ | GENERIC_WRITE, 0, NULL, OPEN_EXISTING, 0, NULL);
-	if (HPipe != INVALID_HANDLE_VALUE)
+	TUniquePtr<FVSServerListener> Listener = FVSServerListener::Create(ueServerNamedPipe);
+	if (!Listener)
+	{
+		return 1;
+	}
+
+	FEvent* RequestReady = FPlatformProcess::GetSynchEventFromPool(false);
+	bool bKillServer = false;
+
+	while (!bKillServer)
 	{
-		ConnectNamedPipe(HPipe, NULL);
-		DWORD dwState;
-		BOOL bSuccess = GetNamedPipeHandleState(HPipe, &dwState, NULL, NULL, NULL, NULL, 0);
-		if (bSuccess)
+		UE_LOG(LogVisualStudioTools, Display, TEXT("Waiting for a client on %s"), *ueServerNamedPipe);
+		TUniquePtr<FVSServerConnection> Connection = Listener->Accept();
+		if (!Connection)
+		{
+			break;
+		}
+
+		// The reader keeps taking requests off the connection while the game thread runs earlier ones.
+		FVSServerConnection* Client = Connection.Get();
+		TQueue<FString, EQueueMode::Spsc> Requests;
+		std::atomic<bool> bClientConnected(true);
+		std::thread Reader([Client, RequestReady, &Requests, &bClientConnected]()
 		{
-			// Read data from the named pipe.
-			ReadFile(HPipe, buffer, sizeof(buffer) - 1, &dwRead, NULL);
-			buffer[dwRead] = '\0';
-			std::string strSubCommandletParams(buffer, dwRead);
-			FString SubCommandletParams = FString(strSubCommandletParams.c_str());
-
-			// Determine which sub-commandlet to invoke, and write back result response.
-			if (SubCommandletParams.Contains("VSTestAdapter"))
+			FString Request;
+			while (Client->ReadMessage(Request))
 			{
-				UVSTestAdapterCommandlet *Commandlet = NewObject<UVSTestAdapterCommandlet>();
-				try
-				{
-					int32 subCommandletResult = Commandlet->Main(SubCommandletParams);
-				}
-				catch (const std::exception &ex)
-				{
-					UE_LOG(LogVisualStudioTools, Display, TEXT("Exception invoking VSTestAdapter commandlet: %s"), UTF8_TO_TCHAR(ex.what()));
-					result = "0";
-				}
+				Requests.Enqueue(MoveTemp(Request));
+				RequestReady->Trigger();
 			}
-			else if (SubCommandletParams.Contains("KillVSServer"))
+
+			bClientConnected = false;
+			RequestReady->Trigger();
+		});
+
+		// Commandlets run on the game thread, one request at a time in the order they arrived,
+		// and each result is written back as soon as it is ready.
+		while (!bKillServer)
+		{
+			// Read before dequeuing: once the reader is done, everything it queued is already visible.
+			const bool bStillConnected = bClientConnected;
+
+			FString Request;
+			if (Requests.Dequeue(Request))
 			{
-				// When KillVSServer is passed in, then kill the Unreal Editor process to end server mode.
-				exit(0);
+				const int32 Result = ExecuteRequest(Request, bKillServer);
+				Client->WriteMessage(FString::FromInt(Result));
+				continue;
 			}
-			else
+
+			if (!bStillConnected)
 			{
-				// If cannot find which sub-commandlet to run, then return error.
-				result = "1";
+				break;
 			}
 
-			WriteFile(HPipe, result.c_str(), result.size(), &dwRead, NULL);
+			RequestReady->Wait();
+		}
+
+		// Unblocks the reader when the server is stopping with the client still connected.
+		Client->CancelRead();
+		Reader.join();
+	}
+
+	FPlatformProcess::ReturnSynchEventToPool(RequestReady);
+
+	return 0;
+}
+
+int32 UVSServerCommandlet::RunLatencyClient(const FString& ueServerNamedPipe, int32 NumRequests, int32 NumColdRuns)
+{
+	TUniquePtr<FVSServerConnection> Connection = FVSServerConnection::Connect(ueServerNamedPipe);
+	if (!Connection)
+	{
+		return 1;
+	}
+
+	// One request at a time: the full round trip of each.
+	TArray<double> RoundTrips;
+	RoundTrips.Reserve(NumRequests);
+
+	FString Response;
+	for (int32 Idx = 0; Idx < NumRequests; ++Idx)
+	{
+		const double Start = FPlatformTime::Seconds();
+		if (!Connection->WriteMessage(PingRequest) || !Connection->ReadMessage(Response))
+		{
+			UE_LOG(LogVisualStudioTools, Error, TEXT("Connection lost after %d requests."), Idx);
+			return 1;
+		}
+		RoundTrips.Add((FPlatformTime::Seconds() - Start) * 1000.0);
+	}
+
+	// Every request queued before the first response is read.
+	const double PipelinedStart = FPlatformTime::Seconds();
+	bool bPipelined = true;
+	for (int32 Idx = 0; Idx < NumRequests && bPipelined; ++Idx)
+	{
+		bPipelined = Connection->WriteMessage(PingRequest);
+	}
+	for (int32 Idx = 0; Idx < NumRequests && bPipelined; ++Idx)
+	{
+		bPipelined = Connection->ReadMessage(Response);
+	}
+	const double PipelinedMs = (FPlatformTime::Seconds() - PipelinedStart) * 1000.0;
+
+	RoundTrips.Sort();
+	UE_LOG(LogVisualStudioTools, Display, TEXT("%d requests, round trip p50 %.3f ms, p99 %.3f ms, max %.3f ms"),
+		NumRequests, Percentile(RoundTrips, 0.5), Percentile(RoundTrips, 0.99), RoundTrips.Last());
+
+	if (!bPipelined)
+	{
+		return 1;
+	}
+
+	UE_LOG(LogVisualStudioTools, Display, TEXT("%d queued requests answered in %.3f ms, %.3f ms per request"),
+		NumRequests, PipelinedMs, PipelinedMs / NumRequests);
+
+	if (NumColdRuns <= 0)
+	{
+		return 0;
+	}
+
+	// Test discovery is what the IDE asks for most. Warm, the server runs it in the editor it
+	// already has loaded; cold, every request starts an editor process of its own.
+	const FString ListFile = FPaths::ConvertRelativePathToFull(FPaths::ProjectIntermediateDir() / TEXT("VSServer") / TEXT("LatencyClientTests.txt"));
+	const FString DiscoveryRequest = FString::Printf(TEXT("-run=VSTestAdapter -listtests=\"%s\""), *ListFile);
+	IFileManager::Get().MakeDirectory(*FPaths::GetPath(ListFile), true);
+
+	TArray<double> WarmTimes;
+	for (int32 Idx = 0; Idx < NumColdRuns; ++Idx)
+	{
+		const double Start = FPlatformTime::Seconds();
+		if (!Connection->WriteMessage(DiscoveryRequest) || !Connection->ReadMessage(Response))
+		{
+			UE_LOG(LogVisualStudioTools, Error, TEXT("Connection lost during test discovery."));
+			return 1;
 		}
+		WarmTimes.Add((FPlatformTime::Seconds() - Start) * 1000.0);
 	}
+
+	const FString ProjectFile = FPaths::ConvertRelativePathToFull(FPaths::GetProjectFilePath());
+	const FString ColdArgs = FString::Printf(TEXT("\"%s\" %s -stdout -multiprocess -silent -unattended -NoShaderCompile"), *ProjectFile, *DiscoveryRequest);
+
+	TArray<double> ColdTimes;
+	for (int32 Idx = 0; Idx < NumColdRuns; ++Idx)
+	{
+		const double Start = FPlatformTime::Seconds();
+		FProcHandle Process = FPlatformProcess::CreateProc(FPlatformProcess::ExecutablePath(), *ColdArgs, true, true, true, nullptr, 0, nullptr, nullptr);
+		if (!Process.IsValid())
+		{
+			UE_LOG(LogVisualStudioTools, Error, TEXT("Failed to start %s"), FPlatformProcess::ExecutablePath());
+			return 1;
+		}
+		FPlatformProcess::WaitForProc(Process);
+		FPlatformProcess::CloseProc(Process);
+		ColdTimes.Add((FPlatformTime::Seconds() - Start) * 1000.0);
+	}
+
+	WarmTimes.Sort();
+	ColdTimes.Sort();
+	const double WarmMs = Percentile(WarmTimes, 0.5);
+	const double ColdMs = Percentile(ColdTimes, 0.5);
+	UE_LOG(LogVisualStudioTools, Display, TEXT("Test discovery, median of %d: warm server %.1f ms, cold commandlet %.1f ms, %.1fx faster warm"),
+		NumColdRuns, WarmMs, ColdMs, ColdMs / FMath::Max(WarmMs, 0.001));
+
+	return 0;
 }
 
 int32 UVSServerCommandlet::Main(const FString &ServerParams)
@@ -102,12 +269,13 @@ int32 UVSServerCommandlet::Main(const FString &ServerParams)
 	{
 		FString ueServerNamedPipe = ParamVals[NamedPipeParam];
 
-		// Infinite loop that listens to requests every second.
-		while (true)
+		if (ParamVals.Contains(LatencyClientParam))
 		{
-			std::this_thread::sleep_for(std::chrono::seconds(1));
-			ExecuteSubCommandlet(ueServerNamedPipe);
+			const int32 NumColdRuns = ParamVals.Contains(ColdRunsParam) ? FCString::Atoi(*ParamVals[ColdRunsParam]) : 0;
+			return RunLatencyClient(ueServerNamedPipe, FMath::Max(FCString::Atoi(*ParamVals[LatencyClientParam]), 1), NumColdRuns);
 		}
+
+		return RunServer(ueServerNamedPipe);
 	}
 	else
 	{
@@ -25,5 +25,13 @@ public:
 	virtual int32 Main(const FString& Params) override;
 
 private:
-	void ExecuteSubCommandlet(FString ueServerNamedPipe);
+	// Hosts the named pipe and serves one client connection after another until KillVSServer.
+	int32 RunServer(const FString& ueServerNamedPipe);
+
+	// Connects to a running server and measures the round-trip latency of NumRequests pings, then
+	// compares NumColdRuns test discovery requests on the server against fresh commandlet processes.
+	int32 RunLatencyClient(const FString& ueServerNamedPipe, int32 NumRequests, int32 NumColdRuns);
+
+	// Runs one request on the game thread and returns its result code.
+	int32 ExecuteRequest(const FString& SubCommandletParams, bool& bOutKillServer);
 };
\ No newline at end of file
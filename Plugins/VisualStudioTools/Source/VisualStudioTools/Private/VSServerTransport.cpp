@@ -0,0 +1,541 @@
+// Copyright 2022 (c) Microsoft. All rights reserved.
+
+#include "VSServerTransport.h"
+
+#include "Runtime/Core/Public/HAL/PlatformProcess.h"
+#include "Runtime/Core/Public/Misc/Paths.h"
+
+#if PLATFORM_WINDOWS
+#include "Windows/AllowWindowsPlatformTypes.h"
+#include <string>
+#include <windows.h>
+#include <sddl.h>
+#include "Windows/HideWindowsPlatformTypes.h"
+#else
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include "VisualStudioTools.h"
+
+// Anything longer than this is treated as a corrupt stream and ends the connection.
+static constexpr uint32 MaxMessageSize = 64 * 1024 * 1024;
+
+bool FVSServerConnection::ReadMessage(FString& OutMessage)
+{
+	uint8 Header[4];
+	if (!ReadExact(Header, sizeof(Header)))
+	{
+		return false;
+	}
+
+	const uint32 Size = Header[0] | (Header[1] << 8) | (Header[2] << 16) | (static_cast<uint32>(Header[3]) << 24);
+	if (Size > MaxMessageSize)
+	{
+		UE_LOG(LogVisualStudioTools, Error, TEXT("Message of %u bytes is over the limit, closing the connection."), Size);
+		return false;
+	}
+
+	TArray<uint8> Payload;
+	Payload.SetNumUninitialized(static_cast<int32>(Size));
+	if (Size > 0 && !ReadExact(Payload.GetData(), Size))
+	{
+		return false;
+	}
+
+	const FUTF8ToTCHAR Converter(reinterpret_cast<const ANSICHAR*>(Payload.GetData()), Payload.Num());
+	OutMessage = FString(Converter.Length(), Converter.Get());
+	return true;
+}
+
+bool FVSServerConnection::WriteMessage(const FString& Message)
+{
+	const FTCHARToUTF8 Converter(*Message);
+	const uint32 Size = static_cast<uint32>(Converter.Length());
+
+	// Header and payload go out in one write so a response is never split between other writes.
+	TArray<uint8> Buffer;
+	Buffer.SetNumUninitialized(static_cast<int32>(sizeof(uint32) + Size));
+	Buffer[0] = static_cast<uint8>(Size);
+	Buffer[1] = static_cast<uint8>(Size >> 8);
+	Buffer[2] = static_cast<uint8>(Size >> 16);
+	Buffer[3] = static_cast<uint8>(Size >> 24);
+	FMemory::Memcpy(Buffer.GetData() + sizeof(uint32), Converter.Get(), Size);
+
+	return WriteExact(Buffer.GetData(), static_cast<uint32>(Buffer.Num()));
+}
+
+#if PLATFORM_WINDOWS
+
+static constexpr DWORD PipeBufferSize = 64 * 1024;
+
+static std::wstring GetPipePath(const FString& Name)
+{
+	std::wstring pipeName = L"\\\\.\\pipe\\";
+	pipeName.append(*Name);
+	return pipeName;
+}
+
+// Reads or writes exactly Size bytes, blocking until done. Handles are overlapped so a read and
+// a write can be pending on one at the same time. Once HStop is signaled, a pending or later
+// transfer is cancelled and fails.
+static bool TransferExact(HANDLE HPipe, uint8* Data, uint32 Size, bool bWrite, HANDLE HStop)
+{
+	OVERLAPPED Overlapped = {};
+	Overlapped.hEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+
+	bool bSuccess = true;
+	uint32 Done = 0;
+	while (Done < Size)
+	{
+		ResetEvent(Overlapped.hEvent);
+
+		const BOOL bStarted = bWrite
+			? WriteFile(HPipe, Data + Done, Size - Done, NULL, &Overlapped)
+			: ReadFile(HPipe, Data + Done, Size - Done, NULL, &Overlapped);
+		if (!bStarted && GetLastError() != ERROR_IO_PENDING)
+		{
+			bSuccess = false;
+			break;
+		}
+
+		DWORD Transferred = 0;
+		if (HStop)
+		{
+			const HANDLE Handles[] = { Overlapped.hEvent, HStop };
+			if (WaitForMultipleObjects(2, Handles, FALSE, INFINITE) != WAIT_OBJECT_0)
+			{
+				// The transfer still owns the buffer and the OVERLAPPED until it has really ended.
+				CancelIoEx(HPipe, &Overlapped);
+				GetOverlappedResult(HPipe, &Overlapped, &Transferred, TRUE);
+				bSuccess = false;
+				break;
+			}
+		}
+
+		if (!GetOverlappedResult(HPipe, &Overlapped, &Transferred, TRUE) || Transferred == 0)
+		{
+			bSuccess = false;
+			break;
+		}
+
+		Done += Transferred;
+	}
+
+	CloseHandle(Overlapped.hEvent);
+	return bSuccess;
+}
+
+// A DACL that lets only the user running the server open the pipe. Free the descriptor with LocalFree.
+static bool MakeCurrentUserOnlySecurity(SECURITY_ATTRIBUTES& OutAttributes)
+{
+	HANDLE HToken = NULL;
+	if (!OpenProcessToken(GetCurrentProcess(), TOKEN_QUERY, &HToken))
+	{
+		return false;
+	}
+
+	DWORD Size = 0;
+	GetTokenInformation(HToken, TokenUser, NULL, 0, &Size);
+	TArray<uint8> User;
+	User.SetNumZeroed(static_cast<int32>(Size));
+
+	LPWSTR Sid = NULL;
+	const bool bHasSid = Size > 0
+		&& GetTokenInformation(HToken, TokenUser, User.GetData(), Size, &Size)
+		&& ConvertSidToStringSidW(reinterpret_cast<TOKEN_USER*>(User.GetData())->User.Sid, &Sid);
+	CloseHandle(HToken);
+	if (!bHasSid)
+	{
+		return false;
+	}
+
+	std::wstring Sddl = L"D:P(A;;GA;;;";
+	Sddl.append(Sid);
+	Sddl.append(L")");
+	LocalFree(Sid);
+
+	OutAttributes = {};
+	OutAttributes.nLength = sizeof(OutAttributes);
+	OutAttributes.bInheritHandle = FALSE;
+	return ConvertStringSecurityDescriptorToSecurityDescriptorW(Sddl.c_str(), SDDL_REVISION_1, &OutAttributes.lpSecurityDescriptor, NULL) != FALSE;
+}
+
+class FNamedPipeConnection : public FVSServerConnection
+{
+public:
+	// The server end borrows the listener's pipe instance and only disconnects it.
+	FNamedPipeConnection(HANDLE InPipe, bool bInServer)
+		: HPipe(InPipe)
+		, HStopRead(CreateEvent(NULL, TRUE, FALSE, NULL))
+		, bServer(bInServer)
+	{
+	}
+
+	virtual ~FNamedPipeConnection() override
+	{
+		CloseHandle(HStopRead);
+		if (bServer)
+		{
+			FlushFileBuffers(HPipe);
+			DisconnectNamedPipe(HPipe);
+		}
+		else
+		{
+			CloseHandle(HPipe);
+		}
+	}
+
+	// Stays signaled, so a read the reader has not started yet fails too.
+	virtual void CancelRead() override
+	{
+		SetEvent(HStopRead);
+	}
+
+protected:
+	virtual bool ReadExact(uint8* Data, uint32 Size) override
+	{
+		return TransferExact(HPipe, Data, Size, false, HStopRead);
+	}
+
+	virtual bool WriteExact(const uint8* Data, uint32 Size) override
+	{
+		return TransferExact(HPipe, const_cast<uint8*>(Data), Size, true, NULL);
+	}
+
+private:
+	HANDLE HPipe;
+	HANDLE HStopRead;
+	bool bServer;
+};
+
+class FNamedPipeListener : public FVSServerListener
+{
+public:
+	explicit FNamedPipeListener(HANDLE InPipe)
+		: HPipe(InPipe)
+	{
+	}
+
+	virtual ~FNamedPipeListener() override
+	{
+		CloseHandle(HPipe);
+	}
+
+	virtual TUniquePtr<FVSServerConnection> Accept() override
+	{
+		OVERLAPPED Overlapped = {};
+		Overlapped.hEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+
+		bool bConnected = ConnectNamedPipe(HPipe, &Overlapped) != FALSE;
+		if (!bConnected)
+		{
+			const DWORD Error = GetLastError();
+			if (Error == ERROR_IO_PENDING)
+			{
+				DWORD Unused = 0;
+				bConnected = GetOverlappedResult(HPipe, &Overlapped, &Unused, TRUE) != FALSE;
+			}
+			else
+			{
+				// The client connected between CreateNamedPipe and ConnectNamedPipe.
+				bConnected = Error == ERROR_PIPE_CONNECTED;
+			}
+		}
+
+		const DWORD LastError = GetLastError();
+		CloseHandle(Overlapped.hEvent);
+
+		if (!bConnected)
+		{
+			UE_LOG(LogVisualStudioTools, Error, TEXT("Failed to accept a client on the named pipe (error %u)."), LastError);
+			return nullptr;
+		}
+
+		return MakeUnique<FNamedPipeConnection>(HPipe, true);
+	}
+
+private:
+	HANDLE HPipe;
+};
+
+TUniquePtr<FVSServerListener> FVSServerListener::Create(const FString& Name)
+{
+	SECURITY_ATTRIBUTES Security;
+	if (!MakeCurrentUserOnlySecurity(Security))
+	{
+		UE_LOG(LogVisualStudioTools, Error, TEXT("Failed to build the security descriptor for named pipe %s (error %u)."), *Name, GetLastError());
+		return nullptr;
+	}
+
+	// Local clients of this user only, and only if no other process already owns the name.
+	const std::wstring pipeName = GetPipePath(Name);
+	HANDLE HPipe = CreateNamedPipe(pipeName.c_str(), PIPE_ACCESS_DUPLEX | FILE_FLAG_OVERLAPPED | FILE_FLAG_FIRST_PIPE_INSTANCE,
+		PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_WAIT | PIPE_REJECT_REMOTE_CLIENTS, 1, PipeBufferSize, PipeBufferSize, 0, &Security);
+	const DWORD Error = GetLastError();
+	LocalFree(Security.lpSecurityDescriptor);
+
+	if (HPipe == INVALID_HANDLE_VALUE)
+	{
+		if (Error == ERROR_ACCESS_DENIED)
+		{
+			UE_LOG(LogVisualStudioTools, Error, TEXT("Named pipe %s is already in use by another process."), *Name);
+		}
+		else
+		{
+			UE_LOG(LogVisualStudioTools, Error, TEXT("Failed to create named pipe %s (error %u)."), *Name, Error);
+		}
+		return nullptr;
+	}
+
+	return MakeUnique<FNamedPipeListener>(HPipe);
+}
+
+TUniquePtr<FVSServerConnection> FVSServerConnection::Connect(const FString& Name)
+{
+	const std::wstring pipeName = GetPipePath(Name);
+	HANDLE HPipe = CreateFile(pipeName.c_str(), GENERIC_READ | GENERIC_WRITE, 0, NULL, OPEN_EXISTING, FILE_FLAG_OVERLAPPED, NULL);
+
+	// The single pipe instance is still being released by the previous client.
+	if (HPipe == INVALID_HANDLE_VALUE && GetLastError() == ERROR_PIPE_BUSY && WaitNamedPipe(pipeName.c_str(), 5000))
+	{
+		HPipe = CreateFile(pipeName.c_str(), GENERIC_READ | GENERIC_WRITE, 0, NULL, OPEN_EXISTING, FILE_FLAG_OVERLAPPED, NULL);
+	}
+
+	if (HPipe == INVALID_HANDLE_VALUE)
+	{
+		UE_LOG(LogVisualStudioTools, Error, TEXT("Failed to connect to named pipe %s (error %u)."), *Name, GetLastError());
+		return nullptr;
+	}
+
+	return MakeUnique<FNamedPipeConnection>(HPipe, false);
+}
+
+#else
+
+static FString GetSocketPath(const FString& Name)
+{
+	return Name.Contains(TEXT("/")) ? Name : FString(FPlatformProcess::UserTempDir()) / (Name + TEXT(".sock"));
+}
+
+static bool MakeSocketAddress(const FString& Path, sockaddr_un& OutAddress)
+{
+	const FTCHARToUTF8 Converter(*Path);
+	if (static_cast<SIZE_T>(Converter.Length()) >= sizeof(OutAddress.sun_path))
+	{
+		UE_LOG(LogVisualStudioTools, Error, TEXT("Socket path %s is too long."), *Path);
+		return false;
+	}
+
+	FMemory::Memzero(OutAddress);
+	OutAddress.sun_family = AF_UNIX;
+	FMemory::Memcpy(OutAddress.sun_path, Converter.Get(), Converter.Length());
+	return true;
+}
+
+class FUnixSocketConnection : public FVSServerConnection
+{
+public:
+	explicit FUnixSocketConnection(int InSocket)
+		: Socket(InSocket)
+	{
+#if defined(SO_NOSIGPIPE)
+		// A client that went away fails the write instead of raising SIGPIPE.
+		const int Enable = 1;
+		setsockopt(Socket, SOL_SOCKET, SO_NOSIGPIPE, &Enable, sizeof(Enable));
+#endif
+	}
+
+	virtual ~FUnixSocketConnection() override
+	{
+		close(Socket);
+	}
+
+	virtual void CancelRead() override
+	{
+		shutdown(Socket, SHUT_RDWR);
+	}
+
+protected:
+	virtual bool ReadExact(uint8* Data, uint32 Size) override
+	{
+		uint32 Done = 0;
+		while (Done < Size)
+		{
+			const ssize_t Received = recv(Socket, Data + Done, Size - Done, 0);
+			if (Received < 0 && errno == EINTR)
+			{
+				continue;
+			}
+			if (Received <= 0)
+			{
+				return false;
+			}
+
+			Done += static_cast<uint32>(Received);
+		}
+
+		return true;
+	}
+
+	virtual bool WriteExact(const uint8* Data, uint32 Size) override
+	{
+#if defined(MSG_NOSIGNAL)
+		const int Flags = MSG_NOSIGNAL;
+#else
+		const int Flags = 0;
+#endif
+
+		uint32 Done = 0;
+		while (Done < Size)
+		{
+			const ssize_t Sent = send(Socket, Data + Done, Size - Done, Flags);
+			if (Sent < 0 && errno == EINTR)
+			{
+				continue;
+			}
+			if (Sent <= 0)
+			{
+				return false;
+			}
+
+			Done += static_cast<uint32>(Sent);
+		}
+
+		return true;
+	}
+
+private:
+	int Socket;
+};
+
+class FUnixSocketListener : public FVSServerListener
+{
+public:
+	FUnixSocketListener(int InSocket, const FString& InPath)
+		: Socket(InSocket)
+		, Path(InPath)
+	{
+	}
+
+	virtual ~FUnixSocketListener() override
+	{
+		close(Socket);
+		unlink(TCHAR_TO_UTF8(*Path));
+	}
+
+	virtual TUniquePtr<FVSServerConnection> Accept() override
+	{
+		int Client = -1;
+		do
+		{
+			Client = accept(Socket, nullptr, nullptr);
+		}
+		while (Client < 0 && errno == EINTR);
+
+		if (Client < 0)
+		{
+			UE_LOG(LogVisualStudioTools, Error, TEXT("Failed to accept a client on %s (errno %d)."), *Path, errno);
+			return nullptr;
+		}
+
+		return MakeUnique<FUnixSocketConnection>(Client);
+	}
+
+private:
+	int Socket;
+	FString Path;
+};
+
+TUniquePtr<FVSServerListener> FVSServerListener::Create(const FString& Name)
+{
+	const FString Path = GetSocketPath(Name);
+
+	sockaddr_un Address;
+	if (!MakeSocketAddress(Path, Address))
+	{
+		return nullptr;
+	}
+
+	// A server that did not shut down cleanly leaves its socket file behind. Only a socket that
+	// nothing answers on is removed; any other file, or a live server, is left alone.
+	struct stat Status;
+	if (lstat(Address.sun_path, &Status) == 0)
+	{
+		if (!S_ISSOCK(Status.st_mode))
+		{
+			UE_LOG(LogVisualStudioTools, Error, TEXT("%s exists and is not a socket."), *Path);
+			return nullptr;
+		}
+
+		const int Probe = socket(AF_UNIX, SOCK_STREAM, 0);
+		const bool bLive = Probe >= 0 && connect(Probe, reinterpret_cast<const sockaddr*>(&Address), sizeof(Address)) == 0;
+		if (Probe >= 0)
+		{
+			close(Probe);
+		}
+		if (bLive)
+		{
+			UE_LOG(LogVisualStudioTools, Error, TEXT("Another server is already listening on %s."), *Path);
+			return nullptr;
+		}
+
+		unlink(Address.sun_path);
+	}
+
+	const int Socket = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (Socket < 0)
+	{
+		UE_LOG(LogVisualStudioTools, Error, TEXT("Failed to create a socket (errno %d)."), errno);
+		return nullptr;
+	}
+
+	if (bind(Socket, reinterpret_cast<const sockaddr*>(&Address), sizeof(Address)) != 0)
+	{
+		UE_LOG(LogVisualStudioTools, Error, TEXT("Failed to bind %s (errno %d)."), *Path, errno);
+		close(Socket);
+		return nullptr;
+	}
+
+	// Only this user may connect, whatever the umask, as the pipe's DACL does on Windows. The mode
+	// is set before listen, so nobody can connect in between.
+	if (chmod(Address.sun_path, S_IRUSR | S_IWUSR) != 0 || listen(Socket, 1) != 0)
+	{
+		UE_LOG(LogVisualStudioTools, Error, TEXT("Failed to listen on %s (errno %d)."), *Path, errno);
+		close(Socket);
+		unlink(Address.sun_path);
+		return nullptr;
+	}
+
+	UE_LOG(LogVisualStudioTools, Display, TEXT("Listening on %s"), *Path);
+	return MakeUnique<FUnixSocketListener>(Socket, Path);
+}
+
+TUniquePtr<FVSServerConnection> FVSServerConnection::Connect(const FString& Name)
+{
+	const FString Path = GetSocketPath(Name);
+
+	sockaddr_un Address;
+	if (!MakeSocketAddress(Path, Address))
+	{
+		return nullptr;
+	}
+
+	const int Socket = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (Socket < 0 || connect(Socket, reinterpret_cast<const sockaddr*>(&Address), sizeof(Address)) != 0)
+	{
+		UE_LOG(LogVisualStudioTools, Error, TEXT("Failed to connect to %s (errno %d)."), *Path, errno);
+		if (Socket >= 0)
+		{
+			close(Socket);
+		}
+		return nullptr;
+	}
+
+	return MakeUnique<FUnixSocketConnection>(Socket);
+}
+
+#endif
@@ -0,0 +1,48 @@
+// Copyright 2022 (c) Microsoft. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * One end of a VSServer connection: a named pipe on Windows, a Unix domain socket elsewhere.
+ * Every message is a 4-byte little-endian length followed by that many bytes of UTF-8.
+ * One thread may read while another writes.
+ */
+class FVSServerConnection
+{
+public:
+	virtual ~FVSServerConnection() = default;
+
+	// Blocks until a whole message has arrived. Returns false once the connection is closed.
+	bool ReadMessage(FString& OutMessage);
+
+	bool WriteMessage(const FString& Message);
+
+	// Unblocks a ReadMessage pending on another thread; the connection is closed afterwards.
+	virtual void CancelRead() = 0;
+
+	// Connects to the server listening on Name, or returns null.
+	static TUniquePtr<FVSServerConnection> Connect(const FString& Name);
+
+protected:
+	virtual bool ReadExact(uint8* Data, uint32 Size) = 0;
+	virtual bool WriteExact(const uint8* Data, uint32 Size) = 0;
+};
+
+/**
+ * Accepts VSServer clients one at a time. On Windows Name is a pipe under \\.\pipe\, elsewhere a
+ * socket file: Name itself when it is a path, otherwise <Name>.sock in the user temp directory.
+ */
+class FVSServerListener
+{
+public:
+	virtual ~FVSServerListener() = default;
+
+	// Blocks until a client connects. The connection must be destroyed before the next Accept.
+	virtual TUniquePtr<FVSServerConnection> Accept() = 0;
+
+	// Starts listening on Name, or returns null.
+	static TUniquePtr<FVSServerListener> Create(const FString& Name);
+};
@@ -4,6 +4,10 @@
 
 #include "Runtime/Core/Public/Async/TaskGraphInterfaces.h"
 #include "Runtime/Core/Public/Containers/Ticker.h"
+#include "Runtime/Core/Public/HAL/FileManager.h"
+#include "Runtime/Core/Public/HAL/PlatformProcess.h"
+#include "Runtime/Core/Public/Misc/Guid.h"
+#include "Runtime/Core/Public/Misc/Paths.h"
 #include "Runtime/Launch/Resources/Version.h"
 #include <string>
 #include <fstream>
@@ -14,8 +18,87 @@ static constexpr auto FiltersParam = TEXT("filters");
 static constexpr auto ListTestsParam = TEXT("listtests");
 static constexpr auto RunTestsParam = TEXT("runtests");
 static constexpr auto TestResultsFileParam = TEXT("testresultfile");
+static constexpr auto ShardsParam = TEXT("shards");
+static constexpr auto TimingsFileParam = TEXT("timingsfile");
 static constexpr auto HelpParam = TEXT("help");
 
+static constexpr auto RunTestTag = TEXT("[RUNTEST]");
+
+// The adapter's files are read and written with wide std streams, and TCHAR is wchar_t only on Windows.
+// Elsewhere paths go through UTF-8, and text goes from UTF-16 TCHARs to UTF-32 wchar_t and back, so
+// characters outside the BMP stay one character in the file instead of two lone surrogates.
+#if PLATFORM_WINDOWS
+static const TCHAR* ToStreamPath(const FString& Path)
+{
+	return *Path;
+}
+
+static const TCHAR* ToStreamText(const FString& Text)
+{
+	return *Text;
+}
+
+static FString FromStreamText(const std::wstring& Text)
+{
+	return FString(Text.c_str());
+}
+#else
+static_assert(sizeof(wchar_t) == 4, "Stream text is converted to UTF-32 wchar_t");
+
+static bool IsHighSurrogate(uint32 CodeUnit)
+{
+	return CodeUnit >= 0xD800 && CodeUnit <= 0xDBFF;
+}
+
+static bool IsLowSurrogate(uint32 CodeUnit)
+{
+	return CodeUnit >= 0xDC00 && CodeUnit <= 0xDFFF;
+}
+
+static std::string ToStreamPath(const FString& Path)
+{
+	return TCHAR_TO_UTF8(*Path);
+}
+
+static std::wstring ToStreamText(const FString& Text)
+{
+	std::wstring Result;
+	Result.reserve(Text.Len());
+	for (int32 Idx = 0; Idx < Text.Len(); ++Idx)
+	{
+		uint32 CodePoint = static_cast<uint16>(Text[Idx]);
+		if (IsHighSurrogate(CodePoint) && Idx + 1 < Text.Len() && IsLowSurrogate(static_cast<uint16>(Text[Idx + 1])))
+		{
+			CodePoint = 0x10000 + ((CodePoint - 0xD800) << 10) + (static_cast<uint16>(Text[++Idx]) - 0xDC00);
+		}
+
+		// A lone surrogate is passed through as is.
+		Result.push_back(static_cast<wchar_t>(CodePoint));
+	}
+	return Result;
+}
+
+static FString FromStreamText(const std::wstring& Text)
+{
+	FString Result;
+	Result.Reserve(static_cast<int32>(Text.size()));
+	for (const wchar_t Char : Text)
+	{
+		const uint32 CodePoint = static_cast<uint32>(Char);
+		if (CodePoint >= 0x10000 && CodePoint <= 0x10FFFF)
+		{
+			Result.AppendChar(static_cast<TCHAR>(0xD800 + ((CodePoint - 0x10000) >> 10)));
+			Result.AppendChar(static_cast<TCHAR>(0xDC00 + ((CodePoint - 0x10000) & 0x3FF)));
+		}
+		else
+		{
+			Result.AppendChar(static_cast<TCHAR>(CodePoint));
+		}
+	}
+	return Result;
+}
+#endif
+
 static void GetAllTests(TArray<FAutomationTestInfo>& OutTestList)
 {
 	FAutomationTestFramework& Framework = FAutomationTestFramework::GetInstance();
@@ -28,7 +111,7 @@ static void ReadTestsFromFile(const FString& InFile, TArray<FAutomationTestInfo>
 
 	// Wrapping in an inner scope to ensure automatic destruction of InStream object without explicitly calling .close().
 	{
-		std::wifstream InStream(*InFile);
+		std::wifstream InStream(ToStreamPath(InFile));
 		if (!InStream.good())
 		{
 			UE_LOG(LogVisualStudioTools, Error, TEXT("Failed to open file at path: %s"), *InFile);
@@ -40,7 +123,7 @@ static void ReadTestsFromFile(const FString& InFile, TArray<FAutomationTestInfo>
 		{
 			if (Line.length() > 0)
 			{
-				TestCommands.Add(FString(Line.c_str()));
+				TestCommands.Add(FromStreamText(Line));
 			}
 		}
 	}
@@ -57,7 +140,7 @@ static void ReadTestsFromFile(const FString& InFile, TArray<FAutomationTestInfo>
 
 static int32 ListTests(const FString& TargetFile)
 {
-	std::wofstream OutFile(*TargetFile);
+	std::wofstream OutFile(ToStreamPath(TargetFile));
 	if (!OutFile.good())
 	{
 		UE_LOG(LogVisualStudioTools, Error, TEXT("Failed to open file at path: %s"), *TargetFile);
@@ -76,7 +159,7 @@ static int32 ListTests(const FString& TargetFile)
 		const FString SourceFile = TestInfo.GetSourceFile();
 		const int32 Line = TestInfo.GetSourceFileLine();
 
-		OutFile << *TestCommand << TEXT("|") << *DisplayName << TEXT("|") << Line << TEXT("|") << *SourceFile << std::endl;
+		OutFile << ToStreamText(TestCommand) << L"|" << ToStreamText(DisplayName) << L"|" << Line << L"|" << ToStreamText(SourceFile) << std::endl;
 	}
 
 	UE_LOG(LogVisualStudioTools, Display, TEXT("Found %d tests"), TestInfos.Num());
@@ -85,25 +168,57 @@ static int32 ListTests(const FString& TargetFile)
 	return 0;
 }
 
-static int32 RunTests(const FString& TestListFile, const FString& ResultsFile)
+static FString GetDefaultTimingsFile()
 {
-	std::wofstream OutFile(*ResultsFile);
-	if (!OutFile.good())
+	return FPaths::ProjectSavedDir() / TEXT("VisualStudioTools") / TEXT("TestDurations.txt");
+}
+
+static void ReadTestDurations(const FString& InFile, TMap<FString, double>& OutDurations)
+{
+	std::wifstream InStream(ToStreamPath(InFile));
+	if (!InStream.good())
 	{
-		UE_LOG(LogVisualStudioTools, Error, TEXT("Failed to open file at path: %s"), *ResultsFile);
-		return 1;
+		// No history yet, so every test gets the same estimate.
+		return;
 	}
 
-	TArray<FAutomationTestInfo> TestInfos;
-	if (TestListFile.Equals(TEXT("All"), ESearchCase::IgnoreCase))
+	std::wstring Line;
+	while (std::getline(InStream, Line))
 	{
-		GetAllTests(TestInfos);
+		FString TestCommand;
+		FString Duration;
+		if (FromStreamText(Line).Split(TEXT("|"), &TestCommand, &Duration, ESearchCase::CaseSensitive, ESearchDir::FromEnd))
+		{
+			OutDurations.Add(TestCommand, FCString::Atod(*Duration));
+		}
 	}
-	else
+}
+
+static void WriteTestDurations(const FString& InFile, const TMap<FString, double>& Durations)
+{
+	// Tests that did not run this time keep their previous duration.
+	TMap<FString, double> AllDurations;
+	ReadTestDurations(InFile, AllDurations);
+	AllDurations.Append(Durations);
+
+	IFileManager::Get().MakeDirectory(*FPaths::GetPath(InFile), true);
+
+	std::wofstream OutFile(ToStreamPath(InFile));
+	if (!OutFile.good())
 	{
-		ReadTestsFromFile(TestListFile, TestInfos);
+		UE_LOG(LogVisualStudioTools, Warning, TEXT("Failed to open file at path: %s"), *InFile);
+		return;
 	}
 
+	for (const auto& Pair : AllDurations)
+	{
+		OutFile << ToStreamText(Pair.Key) << L"|" << Pair.Value << std::endl;
+	}
+}
+
+// Runs the tests one after another in this process.
+static bool RunTestsInProcess(const TArray<FAutomationTestInfo>& TestInfos, std::wofstream& OutFile, TMap<FString, double>& OutDurations)
+{
 	bool AllSuccessful = true;
 
 	FAutomationTestFramework& Framework = FAutomationTestFramework::GetInstance();
@@ -141,11 +256,20 @@ static int32 RunTests(const FString& TestListFile, const FString& ResultsFile)
 		FAutomationTestExecutionInfo ExecutionInfo;
 		const bool CurrentTestSuccessful = Framework.StopTest(ExecutionInfo) && ExecutionInfo.GetErrorTotal() == 0;
 		AllSuccessful = AllSuccessful && CurrentTestSuccessful;
+		OutDurations.Add(TestCommand, ExecutionInfo.Duration);
 
 		const FString Result = CurrentTestSuccessful ? TEXT("OK") : TEXT("FAIL");
 
 		// [RUNTEST] is part of the protocol, so do not remove.
-		OutFile << TEXT("[RUNTEST]") << *TestCommand << TEXT("|") << *DisplayName << TEXT("|") << *Result << TEXT("|") << ExecutionInfo.Duration << std::endl;
+		OutFile << L"[RUNTEST]" << ToStreamText(TestCommand) << L"|" << ToStreamText(DisplayName) << L"|" << ToStreamText(Result) << L"|" << ExecutionInfo.Duration << std::endl;
+
+#if ENGINE_MAJOR_VERSION > 5 || (ENGINE_MAJOR_VERSION == 5 && ENGINE_MINOR_VERSION >= 2)
+		// [METRIC] lines follow their [RUNTEST] line, one per measurement the test recorded with AddTelemetryData.
+		for (const FAutomationTelemetryData& Item : ExecutionInfo.TelemetryItems)
+		{
+			OutFile << L"[METRIC]" << ToStreamText(TestCommand) << L"|" << ToStreamText(Item.DataPoint) << L"|" << Item.Measurement << L"|" << ToStreamText(Item.Context) << std::endl;
+		}
+#endif
 
 		if (!CurrentTestSuccessful)
 		{
@@ -153,7 +277,7 @@ static int32 RunTests(const FString& TestListFile, const FString& ResultsFile)
 			{
 				if (Entry.Event.Type == EAutomationEventType::Error)
 				{
-					OutFile << *Entry.Event.Message << std::endl;
+					OutFile << ToStreamText(Entry.Event.Message) << std::endl;
 					UE_LOG(LogVisualStudioTools, Error, TEXT("%s"), *Entry.Event.Message);
 				}
 			}
@@ -164,6 +288,291 @@ static int32 RunTests(const FString& TestListFile, const FString& ResultsFile)
 		OutFile.flush();
 	}
 
+	return AllSuccessful;
+}
+
+struct FTestShard
+{
+	TArray<int32> Tests;
+	double EstimatedSeconds = 0.0;
+
+	FString TestListFile;
+	FString ResultsFile;
+	FString LogFile;
+
+	FProcHandle Process;
+	int32 ReturnCode = -1;
+};
+
+// Assigns the longest tests first, each to the shard with the least estimated time so far.
+static void BalanceShards(const TArray<FAutomationTestInfo>& TestInfos, const TMap<FString, double>& Durations, TArray<FTestShard>& Shards)
+{
+	TArray<double> Estimates;
+	Estimates.Init(-1.0, TestInfos.Num());
+
+	double KnownSeconds = 0.0;
+	int32 NumKnown = 0;
+	for (int32 Idx = 0; Idx < TestInfos.Num(); ++Idx)
+	{
+		if (const double* Duration = Durations.Find(TestInfos[Idx].GetTestName()))
+		{
+			Estimates[Idx] = *Duration;
+			KnownSeconds += *Duration;
+			++NumKnown;
+		}
+	}
+
+	// Tests without history are estimated at the average of those with one.
+	const double DefaultEstimate = NumKnown > 0 ? KnownSeconds / NumKnown : 1.0;
+	for (double& Estimate : Estimates)
+	{
+		if (Estimate < 0.0)
+		{
+			Estimate = DefaultEstimate;
+		}
+	}
+
+	TArray<int32> Order;
+	Order.Reserve(TestInfos.Num());
+	for (int32 Idx = 0; Idx < TestInfos.Num(); ++Idx)
+	{
+		Order.Add(Idx);
+	}
+	Order.StableSort([&Estimates](int32 A, int32 B) { return Estimates[A] > Estimates[B]; });
+
+	for (const int32 TestIdx : Order)
+	{
+		FTestShard* LeastLoaded = &Shards[0];
+		for (FTestShard& Shard : Shards)
+		{
+			if (Shard.EstimatedSeconds < LeastLoaded->EstimatedSeconds)
+			{
+				LeastLoaded = &Shard;
+			}
+		}
+
+		LeastLoaded->Tests.Add(TestIdx);
+		LeastLoaded->EstimatedSeconds += Estimates[TestIdx];
+	}
+
+	// Within a shard the tests still run in the order they were requested.
+	for (FTestShard& Shard : Shards)
+	{
+		Shard.Tests.Sort();
+	}
+}
+
+// Reads a shard's results file into the lines reported for each test, keyed by test command.
+static void ReadShardResults(const FString& InFile, TMap<FString, TArray<FString>>& OutResults, TMap<FString, double>& OutDurations)
+{
+	std::wifstream InStream(ToStreamPath(InFile));
+	if (!InStream.good())
+	{
+		return;
+	}
+
+	const int32 RunTestTagLen = FCString::Strlen(RunTestTag);
+
+	FString CurrentTest;
+	std::wstring Line;
+	while (std::getline(InStream, Line))
+	{
+		const FString Entry = FromStreamText(Line);
+		if (Entry.StartsWith(RunTestTag))
+		{
+			// [RUNTEST]<TestCommand>|<DisplayName>|<Result>|<Duration>
+			TArray<FString> Fields;
+			Entry.RightChop(RunTestTagLen).ParseIntoArray(Fields, TEXT("|"), false);
+			if (Fields.Num() < 4)
+			{
+				CurrentTest.Reset();
+				continue;
+			}
+
+			CurrentTest = Fields[0];
+			OutResults.Add(CurrentTest);
+			OutDurations.Add(CurrentTest, FCString::Atod(*Fields.Last()));
+		}
+
+		// [METRIC] and error lines belong to the [RUNTEST] line before them.
+		if (!CurrentTest.IsEmpty())
+		{
+			OutResults.FindChecked(CurrentTest).Add(Entry);
+		}
+	}
+}
+
+// Splits the tests across worker processes and merges their results into OutFile in the requested order.
+static bool RunTestsSharded(const TArray<FAutomationTestInfo>& TestInfos, int32 NumShards, const FString& Filters, const TMap<FString, double>& HistoricalDurations, std::wofstream& OutFile, TMap<FString, double>& OutDurations)
+{
+	TArray<FTestShard> Shards;
+	Shards.SetNum(NumShards);
+	BalanceShards(TestInfos, HistoricalDurations, Shards);
+
+	const FString ShardDir = FPaths::ConvertRelativePathToFull(FPaths::ProjectIntermediateDir() / TEXT("VSTestAdapter") / FGuid::NewGuid().ToString());
+	IFileManager::Get().MakeDirectory(*ShardDir, true);
+
+	const FString ProjectFile = FPaths::ConvertRelativePathToFull(FPaths::GetProjectFilePath());
+	const FString FiltersArg = Filters.IsEmpty() ? FString() : FString::Printf(TEXT(" -%s=%s"), FiltersParam, *Filters);
+
+	for (int32 ShardIdx = 0; ShardIdx < Shards.Num(); ++ShardIdx)
+	{
+		FTestShard& Shard = Shards[ShardIdx];
+		Shard.TestListFile = ShardDir / FString::Printf(TEXT("Shard%d.txt"), ShardIdx);
+		Shard.ResultsFile = ShardDir / FString::Printf(TEXT("Shard%d.results.txt"), ShardIdx);
+		Shard.LogFile = ShardDir / FString::Printf(TEXT("Shard%d.log"), ShardIdx);
+
+		{
+			std::wofstream ListFile(ToStreamPath(Shard.TestListFile));
+			for (const int32 TestIdx : Shard.Tests)
+			{
+				ListFile << ToStreamText(TestInfos[TestIdx].GetTestName()) << std::endl;
+			}
+		}
+
+		// Workers run their list serially and leave the timings file to this process.
+		const FString Args = FString::Printf(
+			TEXT("\"%s\" -run=VSTestAdapter -%s=\"%s\" -%s=\"%s\" -%s=None%s -abslog=\"%s\" -stdout -multiprocess -silent -unattended -AllowStdOutLogVerbosity -NoShaderCompile"),
+			*ProjectFile, RunTestsParam, *Shard.TestListFile, TestResultsFileParam, *Shard.ResultsFile, TimingsFileParam, *FiltersArg, *Shard.LogFile);
+
+		Shard.Process = FPlatformProcess::CreateProc(FPlatformProcess::ExecutablePath(), *Args, true, true, true, nullptr, 0, nullptr, nullptr);
+		if (!Shard.Process.IsValid())
+		{
+			UE_LOG(LogVisualStudioTools, Error, TEXT("Failed to start test shard %d"), ShardIdx);
+			continue;
+		}
+
+		UE_LOG(LogVisualStudioTools, Display, TEXT("Shard %d: %d tests, %.1f s estimated"), ShardIdx, Shard.Tests.Num(), Shard.EstimatedSeconds);
+	}
+
+	for (FTestShard& Shard : Shards)
+	{
+		if (Shard.Process.IsValid())
+		{
+			FPlatformProcess::WaitForProc(Shard.Process);
+			FPlatformProcess::GetProcReturnCode(Shard.Process, &Shard.ReturnCode);
+			FPlatformProcess::CloseProc(Shard.Process);
+		}
+	}
+
+	TMap<FString, TArray<FString>> Results;
+	TArray<int32> TestShards;
+	TestShards.Init(INDEX_NONE, TestInfos.Num());
+	for (int32 ShardIdx = 0; ShardIdx < Shards.Num(); ++ShardIdx)
+	{
+		ReadShardResults(Shards[ShardIdx].ResultsFile, Results, OutDurations);
+		for (const int32 TestIdx : Shards[ShardIdx].Tests)
+		{
+			TestShards[TestIdx] = ShardIdx;
+		}
+	}
+
+	bool AllSuccessful = true;
+	bool AllReported = true;
+	for (const FTestShard& Shard : Shards)
+	{
+		AllSuccessful = AllSuccessful && Shard.ReturnCode == 0;
+	}
+
+	for (int32 TestIdx = 0; TestIdx < TestInfos.Num(); ++TestIdx)
+	{
+		const FString TestCommand = TestInfos[TestIdx].GetTestName();
+		if (const TArray<FString>* Lines = Results.Find(TestCommand))
+		{
+			for (const FString& Line : *Lines)
+			{
+				OutFile << ToStreamText(Line) << std::endl;
+			}
+			continue;
+		}
+
+		// The worker crashed, or never started, before it got to this test.
+		const FTestShard& Shard = Shards[TestShards[TestIdx]];
+		const FString Message = FString::Printf(TEXT("Test shard %d exited with code %d before reporting this test, see %s"), TestShards[TestIdx], Shard.ReturnCode, *Shard.LogFile);
+
+		OutFile << ToStreamText(RunTestTag) << ToStreamText(TestCommand) << L"|" << ToStreamText(TestInfos[TestIdx].GetDisplayName()) << L"|" << L"FAIL" << L"|" << 0.0 << std::endl;
+		OutFile << ToStreamText(Message) << std::endl;
+		UE_LOG(LogVisualStudioTools, Error, TEXT("%s: %s"), *TestCommand, *Message);
+
+		AllSuccessful = false;
+		AllReported = false;
+	}
+	OutFile.flush();
+
+	// Shard logs are kept when a worker did not report all of its tests.
+	if (AllReported)
+	{
+		IFileManager::Get().DeleteDirectory(*ShardDir, false, true);
+	}
+
+	return AllSuccessful;
+}
+
+static int32 RunTests(const FString& TestListFile, const FString& ResultsFile, int32 NumShards, const FString& TimingsFile, const FString& Filters)
+{
+	std::wofstream OutFile(ToStreamPath(ResultsFile));
+	if (!OutFile.good())
+	{
+		UE_LOG(LogVisualStudioTools, Error, TEXT("Failed to open file at path: %s"), *ResultsFile);
+		return 1;
+	}
+
+	TArray<FAutomationTestInfo> TestInfos;
+	if (TestListFile.Equals(TEXT("All"), ESearchCase::IgnoreCase))
+	{
+		GetAllTests(TestInfos);
+	}
+	else
+	{
+		ReadTestsFromFile(TestListFile, TestInfos);
+	}
+
+	const bool RecordTimings = !TimingsFile.Equals(TEXT("None"), ESearchCase::IgnoreCase);
+	NumShards = FMath::Clamp(NumShards, 1, TestInfos.Num());
+
+	TMap<FString, double> Durations;
+	const double StartTime = FPlatformTime::Seconds();
+
+	bool AllSuccessful = true;
+	if (NumShards > 1)
+	{
+		TMap<FString, double> HistoricalDurations;
+		if (RecordTimings)
+		{
+			ReadTestDurations(TimingsFile, HistoricalDurations);
+		}
+
+		AllSuccessful = RunTestsSharded(TestInfos, NumShards, Filters, HistoricalDurations, OutFile, Durations);
+	}
+	else
+	{
+		AllSuccessful = RunTestsInProcess(TestInfos, OutFile, Durations);
+	}
+
+	const double WallSeconds = FPlatformTime::Seconds() - StartTime;
+
+	if (NumShards > 1)
+	{
+		// Run serially, the same tests take the sum of their durations.
+		double SerialSeconds = 0.0;
+		for (const auto& Pair : Durations)
+		{
+			SerialSeconds += Pair.Value;
+		}
+
+		UE_LOG(LogVisualStudioTools, Display, TEXT("Ran %d tests on %d shards in %.1f s; serially they take %.1f s, a %.2fx speedup"),
+			TestInfos.Num(), NumShards, WallSeconds, SerialSeconds, SerialSeconds / FMath::Max(WallSeconds, 0.001));
+	}
+	else
+	{
+		UE_LOG(LogVisualStudioTools, Display, TEXT("Ran %d tests in %.1f s"), TestInfos.Num(), WallSeconds);
+	}
+
+	if (RecordTimings)
+	{
+		WriteTestDurations(TimingsFile, Durations);
+	}
+
 	return AllSuccessful ? 0 : 1;
 }
 
@@ -181,6 +590,12 @@ UVSTestAdapterCommandlet::UVSTestAdapterCommandlet()
 	HelpParamNames.Add(TestResultsFileParam);
 	HelpParamDescriptions.Add(TEXT("[Required] The output file from running test cases that we parse to retrieve test case results."));
 
+	HelpParamNames.Add(ShardsParam);
+	HelpParamDescriptions.Add(TEXT("[Optional] Number of worker processes (run with -multiprocess) to split the test cases across, balanced by their previous durations. Default is 1, which runs them in this process."));
+
+	HelpParamNames.Add(TimingsFileParam);
+	HelpParamDescriptions.Add(TEXT("[Optional] The file that keeps each test case's last duration for balancing shards, or 'None'. Default is Saved/VisualStudioTools/TestDurations.txt."));
+
 	HelpParamNames.Add(FiltersParam);
 	HelpParamDescriptions.Add(TEXT("[Optional] List of test filters to enable separated by '+'. Default is 'application+smoke+product+perf+stress+negative'"));
 
@@ -280,7 +695,9 @@ int32 UVSTestAdapterCommandlet::Main(const FString& Params)
 	}
 	else if (ParamVals.Contains(RunTestsParam) && ParamVals.Contains(TestResultsFileParam))
 	{
-		return RunTests(ParamVals[RunTestsParam], ParamVals[TestResultsFileParam]);
+		const int32 NumShards = ParamVals.Contains(ShardsParam) ? FCString::Atoi(*ParamVals[ShardsParam]) : 1;
+		const FString TimingsFile = ParamVals.Contains(TimingsFileParam) ? ParamVals[TimingsFileParam] : GetDefaultTimingsFile();
+		return RunTests(ParamVals[RunTestsParam], ParamVals[TestResultsFileParam], NumShards, TimingsFile, ParamVals.FindRef(FiltersParam));
 	}
 
 	PrintHelp();
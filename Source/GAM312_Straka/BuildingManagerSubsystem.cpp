@@ -0,0 +1,667 @@
+#include "BuildingManagerSubsystem.h"
+#include "GAM312_Straka.h"
+#include "BuildingPreviewPool.h"
+#include "BuildingReplicator.h"
+#include "ResourceRegistry.h"
+#include "WorldSaveSubsystem.h"
+#include "Components/HierarchicalInstancedStaticMeshComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/Pawn.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformMemory.h"
+#include "Kismet/GameplayStatics.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Building Instances"), STAT_GAM312_BuildingInstances, STATGROUP_GAM312);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Building Batches"), STAT_GAM312_BuildingBatches, STATGROUP_GAM312);
+
+static TAutoConsoleVariable<bool> CVarBuildingInstancing(
+	TEXT("gam312.Building.Instancing"),
+	true,
+	TEXT("Convert placed building parts into HISM instances (false keeps one actor per part)."));
+
+static TAutoConsoleVariable<float> CVarBuildingNetCellSize(
+	TEXT("gam312.Building.NetCellSize"),
+	8000.0f,
+	TEXT("Size of the grid cells placed building parts are replicated in. Read when the first part is placed in a networked game."));
+
+namespace BuildingBenchmark
+{
+	// Part counts measured by gam312.Building.Benchmark, in order
+	static const int32 PartCounts[] = { 1000, 10000, 50000 };
+
+	// Frames skipped after spawning before sampling starts, then frames sampled
+	static constexpr int32 WarmupFrames = 30;
+	static constexpr int32 SampleFrames = 240;
+
+	// Grid spacing between benchmark parts
+	static constexpr float Spacing = 450.0f;
+
+	static const TCHAR* DefaultPartClass = TEXT("/Game/Building/Wall_BP.Wall_BP_C");
+
+	// Runtime-placed actors when instancing is disabled, so stages can clean up
+	static TArray<TWeakObjectPtr<ABuildingPart>> LooseActors;
+	static double LastFrameTime = 0.0;
+}
+
+void UBuildingManagerSubsystem::Deinitialize()
+{
+	Batches.Reset();
+	Records.Reset();
+	BatchLookup.Reset();
+	FreeRecords.Reset();
+	NumPlacedParts = 0;
+	PlacementSnapshot.Reset();
+	BenchStage = INDEX_NONE;
+	CellReplicators.Reset();
+	NetToLocal.Reset();
+	LocalToNet.Reset();
+	bReplicateChanges = false;
+
+	Super::Deinitialize();
+}
+
+void UBuildingManagerSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	// Servers share placed parts with clients through one replicator per grid cell
+	const ENetMode NetMode = InWorld.GetNetMode();
+	bReplicateChanges = NetMode == NM_DedicatedServer || NetMode == NM_ListenServer;
+}
+
+FIntPoint UBuildingManagerSubsystem::GetReplicationCell(const FVector& Location)
+{
+	const float CellSize = FMath::Max(CVarBuildingNetCellSize.GetValueOnGameThread(), 100.0f);
+	return FIntPoint(FMath::FloorToInt32(Location.X / CellSize), FMath::FloorToInt32(Location.Y / CellSize));
+}
+
+ABuildingReplicator* UBuildingManagerSubsystem::GetOrAddCellReplicator(const FVector& Location)
+{
+	const FIntPoint Cell = GetReplicationCell(Location);
+	if (TObjectPtr<ABuildingReplicator>* Existing = CellReplicators.Find(Cell))
+	{
+		return *Existing;
+	}
+
+	// The replicator sits at the cell centre, so distance-based relevancy works per cell
+	const float CellSize = FMath::Max(CVarBuildingNetCellSize.GetValueOnGameThread(), 100.0f);
+	const FVector CellCenter((Cell.X + 0.5f) * CellSize, (Cell.Y + 0.5f) * CellSize, Location.Z);
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.Name = *FString::Printf(TEXT("BuildingReplicator_%d_%d"), Cell.X, Cell.Y);
+	ABuildingReplicator* Replicator = GetWorld()->SpawnActor<ABuildingReplicator>(CellCenter, FRotator::ZeroRotator, SpawnParams);
+	CellReplicators.Add(Cell, Replicator);
+	return Replicator;
+}
+
+int32 UBuildingManagerSubsystem::GetNetId(int32 RecordId) const
+{
+	if (GetWorld()->GetNetMode() != NM_Client)
+	{
+		return RecordId;
+	}
+
+	const int32* NetId = LocalToNet.Find(RecordId);
+	return NetId ? *NetId : INDEX_NONE;
+}
+
+void UBuildingManagerSubsystem::ForgetNetPiece(int32 NetId)
+{
+	int32 LocalRecordId = INDEX_NONE;
+	if (NetToLocal.RemoveAndCopyValue(NetId, LocalRecordId))
+	{
+		LocalToNet.Remove(LocalRecordId);
+	}
+}
+
+void UBuildingManagerSubsystem::AddNetPiece(const FReplicatedBuildingPiece& Piece)
+{
+	// The server already validated the spot, so place it unconditionally
+	int32 LocalRecordId = INDEX_NONE;
+	PlacePart(Piece.PartClass, Piece.BuildingId, FTransform(Piece.Rotation, Piece.Location), false, &LocalRecordId);
+	if (LocalRecordId != INDEX_NONE)
+	{
+		NetToLocal.Add(Piece.RecordId, LocalRecordId);
+		LocalToNet.Add(LocalRecordId, Piece.RecordId);
+	}
+}
+
+void UBuildingManagerSubsystem::RemoveNetPiece(int32 NetId)
+{
+	int32 LocalRecordId = INDEX_NONE;
+	if (NetToLocal.RemoveAndCopyValue(NetId, LocalRecordId))
+	{
+		LocalToNet.Remove(LocalRecordId);
+		RemovePart(LocalRecordId);
+	}
+}
+
+void UBuildingManagerSubsystem::Tick(float DeltaTime)
+{
+	GAM312_SCOPE(UBuildingManagerSubsystem, Tick);
+
+	Super::Tick(DeltaTime);
+
+	TickBenchmark(DeltaTime);
+}
+
+bool UBuildingManagerSubsystem::IsTickable() const
+{
+	return BenchStage != INDEX_NONE;
+}
+
+TStatId UBuildingManagerSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UBuildingManagerSubsystem, STATGROUP_Tickables);
+}
+
+// Moves a finalized part into its mesh/material batch and destroys the actor
+int32 UBuildingManagerSubsystem::AbsorbPart(ABuildingPart* Part, bool bDestroyActor)
+{
+	if (!CVarBuildingInstancing.GetValueOnGameThread() || !IsValid(Part) || !Part->Mesh || !Part->Mesh->GetStaticMesh())
+	{
+		return INDEX_NONE;
+	}
+
+	FBuildingBatchKey Key;
+	Key.Mesh = Part->Mesh->GetStaticMesh();
+	Key.Materials.Reserve(Part->Mesh->GetNumMaterials());
+	for (int32 MaterialIndex = 0; MaterialIndex < Part->Mesh->GetNumMaterials(); ++MaterialIndex)
+	{
+		Key.Materials.Add(Part->Mesh->GetMaterial(MaterialIndex));
+	}
+
+	const int32 BatchIndex = FindOrAddBatch(Key, Part->Mesh);
+	if (BatchIndex == INDEX_NONE)
+	{
+		return INDEX_NONE;
+	}
+
+	const int32 RecordId = FreeRecords.Num() > 0 ? FreeRecords.Pop(EAllowShrinking::No) : Records.AddDefaulted();
+	FPlacedBuildingRecord& Record = Records[RecordId];
+	Record.Transform = Part->GetActorTransform();
+	Record.PartClass = Part->GetClass();
+	Record.BuildingId = Part->BuildingId;
+	Record.BatchIndex = BatchIndex;
+
+	const FPlacementShape Shape = FPlacementShape::FromPart(Part);
+	Record.BoundsCenter = Shape.LocalCenter;
+	Record.BoundsExtent = Shape.LocalExtent;
+	Record.PivotOffset = Shape.PivotOffset;
+
+	// Reuse a collapsed slot when possible so existing instance indices never shift
+	FBuildingBatch& Batch = Batches[BatchIndex];
+	if (Batch.FreeInstances.Num() > 0)
+	{
+		Record.InstanceIndex = Batch.FreeInstances.Pop(EAllowShrinking::No);
+		Batch.Component->UpdateInstanceTransform(Record.InstanceIndex, Record.Transform, true, true, true);
+	}
+	else
+	{
+		Record.InstanceIndex = Batch.Component->AddInstance(Record.Transform, true);
+		if (Batch.InstanceToRecord.Num() <= Record.InstanceIndex)
+		{
+			Batch.InstanceToRecord.SetNumUninitialized(Record.InstanceIndex + 1);
+		}
+	}
+	Batch.InstanceToRecord[Record.InstanceIndex] = RecordId;
+
+	if (FPlacementSnapshot* Snapshot = GetMutablePlacementSnapshot())
+	{
+		Snapshot->Add(Shape, RecordId);
+	}
+
+	++NumPlacedParts;
+	INC_DWORD_STAT(STAT_GAM312_BuildingInstances);
+
+	if (UWorldSaveSubsystem* WorldSave = GetWorld()->GetSubsystem<UWorldSaveSubsystem>())
+	{
+		WorldSave->MarkPartAdded(Record);
+	}
+
+	if (bReplicateChanges)
+	{
+		GetOrAddCellReplicator(Record.Transform.GetLocation())->AddPiece(RecordId, Record.BuildingId, Record.PartClass, Record.Transform);
+	}
+
+	if (bDestroyActor)
+	{
+		Part->Destroy();
+	}
+	return RecordId;
+}
+
+// Brings a placed part back as a full actor, e.g. when the player picks it for editing
+ABuildingPart* UBuildingManagerSubsystem::RestorePart(int32 RecordId, ABuildingPart* Into)
+{
+	if (!Records.IsValidIndex(RecordId) || !Records[RecordId].IsValid())
+	{
+		return nullptr;
+	}
+
+	FPlacedBuildingRecord& Record = Records[RecordId];
+	const FBuildingBatch& Batch = Batches[Record.BatchIndex];
+
+	ABuildingPart* Part = Into;
+	if (Part)
+	{
+		Part->SetActorTransform(Record.Transform, false, nullptr, ETeleportType::TeleportPhysics);
+	}
+	else
+	{
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+		Part = GetWorld()->SpawnActor<ABuildingPart>(Record.PartClass, Record.Transform, SpawnParams);
+		if (!Part)
+		{
+			return nullptr;
+		}
+	}
+
+	// The batch may have come from a swapped mesh/material, so copy them back onto the actor
+	if (Part->Mesh)
+	{
+		Part->Mesh->SetStaticMesh(Batch.Component->GetStaticMesh());
+		for (int32 MaterialIndex = 0; MaterialIndex < Batch.Component->GetNumMaterials(); ++MaterialIndex)
+		{
+			Part->Mesh->SetMaterial(MaterialIndex, Batch.Component->GetMaterial(MaterialIndex));
+		}
+	}
+
+	Part->BuildingId = Record.BuildingId;
+
+	RemovePart(RecordId);
+	return Part;
+}
+
+bool UBuildingManagerSubsystem::RemovePart(int32 RecordId, FPlacedBuildingRecord* OutRecord)
+{
+	if (!Records.IsValidIndex(RecordId) || !Records[RecordId].IsValid())
+	{
+		return false;
+	}
+
+	FPlacedBuildingRecord& Record = Records[RecordId];
+	if (OutRecord)
+	{
+		*OutRecord = Record;
+	}
+
+	if (UWorldSaveSubsystem* WorldSave = GetWorld()->GetSubsystem<UWorldSaveSubsystem>())
+	{
+		WorldSave->MarkPartRemoved(Record);
+	}
+
+	if (bReplicateChanges)
+	{
+		if (TObjectPtr<ABuildingReplicator>* Replicator = CellReplicators.Find(GetReplicationCell(Record.Transform.GetLocation())))
+		{
+			(*Replicator)->RemovePiece(RecordId);
+		}
+	}
+
+	if (FPlacementSnapshot* Snapshot = GetMutablePlacementSnapshot())
+	{
+		Snapshot->Remove(RecordId);
+	}
+
+	ReleaseInstance(Record);
+	Record = FPlacedBuildingRecord();
+	FreeRecords.Add(RecordId);
+	return true;
+}
+
+// Borrows a pooled actor to dress and measure the part, absorbs it, then hands the actor back
+bool UBuildingManagerSubsystem::PlacePart(TSubclassOf<ABuildingPart> PartClass, int32 BuildingId, const FTransform& Transform, bool bRequireFree, int32* OutRecordId)
+{
+	if (OutRecordId)
+	{
+		*OutRecordId = INDEX_NONE;
+	}
+
+	UBuildingPreviewPool* PreviewPool = GetWorld()->GetSubsystem<UBuildingPreviewPool>();
+	if (!PreviewPool || !PartClass)
+	{
+		return false;
+	}
+
+	const UResourceRegistry& Registry = UResourceRegistry::Get();
+	const FBuildingTypeDef* TypeDef = Registry.Buildings.IsValidIndex(BuildingId) ? &Registry.Buildings[BuildingId] : nullptr;
+
+	ABuildingPart* Part = PreviewPool->Acquire(PartClass, Transform, TypeDef);
+	if (!Part)
+	{
+		return false;
+	}
+	Part->BuildingId = BuildingId;
+
+	if (bRequireFree && !BuildingPlacement::IsPlacementFree(*GetPlacementSnapshot(), FPlacementShape::FromPart(Part), Transform))
+	{
+		PreviewPool->Release(Part);
+		return false;
+	}
+
+	const int32 RecordId = AbsorbPart(Part, false);
+	if (RecordId == INDEX_NONE)
+	{
+		// Instancing is off: the borrowed actor stays behind as the placed part
+		if (!CVarBuildingInstancing.GetValueOnGameThread())
+		{
+			return true;
+		}
+
+		PreviewPool->Release(Part);
+		return false;
+	}
+
+	if (OutRecordId)
+	{
+		*OutRecordId = RecordId;
+	}
+	PreviewPool->Release(Part);
+	return true;
+}
+
+int32 UBuildingManagerSubsystem::FindRecordFromHit(const FHitResult& Hit) const
+{
+	const UPrimitiveComponent* HitComponent = Hit.GetComponent();
+	if (!HitComponent || Hit.Item == INDEX_NONE)
+	{
+		return INDEX_NONE;
+	}
+
+	for (const FBuildingBatch& Batch : Batches)
+	{
+		if (Batch.Component.Get() == HitComponent)
+		{
+			return Batch.InstanceToRecord.IsValidIndex(Hit.Item) ? Batch.InstanceToRecord[Hit.Item] : INDEX_NONE;
+		}
+	}
+
+	return INDEX_NONE;
+}
+
+void UBuildingManagerSubsystem::FindPartsInRadius(const FVector& Center, float Radius, TArray<int32>& OutRecordIds) const
+{
+	const float RadiusSq = FMath::Square(Radius);
+
+	for (int32 RecordId = 0; RecordId < Records.Num(); ++RecordId)
+	{
+		const FPlacedBuildingRecord& Record = Records[RecordId];
+		if (Record.IsValid() && FVector::DistSquared(Record.Transform.GetLocation(), Center) <= RadiusSq)
+		{
+			OutRecordIds.Add(RecordId);
+		}
+	}
+}
+
+const FPlacedBuildingRecord* UBuildingManagerSubsystem::GetRecord(int32 RecordId) const
+{
+	return Records.IsValidIndex(RecordId) && Records[RecordId].IsValid() ? &Records[RecordId] : nullptr;
+}
+
+void UBuildingManagerSubsystem::ClearAll()
+{
+	for (FBuildingBatch& Batch : Batches)
+	{
+		if (Batch.Component)
+		{
+			Batch.Component->ClearInstances();
+		}
+		Batch.InstanceToRecord.Reset();
+		Batch.FreeInstances.Reset();
+	}
+
+	Records.Reset();
+	FreeRecords.Reset();
+	NumPlacedParts = 0;
+	PlacementSnapshot.Reset();
+	SET_DWORD_STAT(STAT_GAM312_BuildingInstances, 0);
+
+	for (const TPair<FIntPoint, TObjectPtr<ABuildingReplicator>>& Pair : CellReplicators)
+	{
+		Pair.Value->ClearPieces();
+	}
+	NetToLocal.Reset();
+	LocalToNet.Reset();
+
+	if (UWorldSaveSubsystem* WorldSave = GetWorld()->GetSubsystem<UWorldSaveSubsystem>())
+	{
+		WorldSave->MarkPartsCleared();
+	}
+}
+
+TSharedRef<const FPlacementSnapshot> UBuildingManagerSubsystem::GetPlacementSnapshot()
+{
+	if (!PlacementSnapshot.IsValid())
+	{
+		TSharedRef<FPlacementSnapshot> Snapshot = MakeShared<FPlacementSnapshot>();
+		for (int32 RecordId = 0; RecordId < Records.Num(); ++RecordId)
+		{
+			const FPlacedBuildingRecord& Record = Records[RecordId];
+			if (Record.IsValid())
+			{
+				FPlacementShape Shape;
+				Shape.Transform = Record.Transform;
+				Shape.LocalCenter = Record.BoundsCenter;
+				Shape.LocalExtent = Record.BoundsExtent;
+				Shape.PivotOffset = Record.PivotOffset;
+				Snapshot->Add(Shape, RecordId);
+			}
+		}
+		PlacementSnapshot = Snapshot;
+	}
+
+	return PlacementSnapshot.ToSharedRef();
+}
+
+FPlacementSnapshot* UBuildingManagerSubsystem::GetMutablePlacementSnapshot()
+{
+	if (!PlacementSnapshot.IsValid())
+	{
+		return nullptr;
+	}
+
+	// A worker may still be solving against this one, so it must not change under it
+	if (!PlacementSnapshot.IsUnique())
+	{
+		PlacementSnapshot = MakeShared<FPlacementSnapshot>(*PlacementSnapshot);
+	}
+
+	return PlacementSnapshot.Get();
+}
+
+int32 UBuildingManagerSubsystem::FindOrAddBatch(const FBuildingBatchKey& Key, const UStaticMeshComponent* Source)
+{
+	if (const int32* Existing = BatchLookup.Find(Key))
+	{
+		return *Existing;
+	}
+
+	AActor* Owner = GetOrCreateBatchOwner();
+	if (!Owner)
+	{
+		return INDEX_NONE;
+	}
+
+	UHierarchicalInstancedStaticMeshComponent* Component = NewObject<UHierarchicalInstancedStaticMeshComponent>(Owner);
+	Component->SetStaticMesh(Key.Mesh);
+	for (int32 MaterialIndex = 0; MaterialIndex < Key.Materials.Num(); ++MaterialIndex)
+	{
+		Component->SetMaterial(MaterialIndex, Key.Materials[MaterialIndex]);
+	}
+	Component->SetCollisionProfileName(Source->GetCollisionProfileName());
+	Component->SetMobility(EComponentMobility::Static);
+	Component->SetupAttachment(Owner->GetRootComponent());
+	Component->RegisterComponent();
+	Owner->AddInstanceComponent(Component);
+
+	FBuildingBatch& Batch = Batches.AddDefaulted_GetRef();
+	Batch.Component = Component;
+
+	const int32 BatchIndex = Batches.Num() - 1;
+	BatchLookup.Add(Key, BatchIndex);
+	INC_DWORD_STAT(STAT_GAM312_BuildingBatches);
+
+	return BatchIndex;
+}
+
+AActor* UBuildingManagerSubsystem::GetOrCreateBatchOwner()
+{
+	if (!BatchOwner)
+	{
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.Name = TEXT("BuildingBatches");
+		SpawnParams.NameMode = FActorSpawnParameters::ESpawnActorNameMode::Requested;
+		SpawnParams.ObjectFlags |= RF_Transient;
+
+		BatchOwner = GetWorld()->SpawnActor<AActor>(AActor::StaticClass(), FTransform::Identity, SpawnParams);
+		if (BatchOwner)
+		{
+			USceneComponent* Root = NewObject<USceneComponent>(BatchOwner, TEXT("Root"));
+			Root->SetMobility(EComponentMobility::Static);
+			BatchOwner->SetRootComponent(Root);
+			Root->RegisterComponent();
+		}
+	}
+
+	return BatchOwner;
+}
+
+// Collapses the record's instance to zero scale and hands the slot back to the batch
+void UBuildingManagerSubsystem::ReleaseInstance(FPlacedBuildingRecord& Record)
+{
+	FBuildingBatch& Batch = Batches[Record.BatchIndex];
+
+	const FTransform Collapsed(FQuat::Identity, FVector::ZeroVector, FVector::ZeroVector);
+	Batch.Component->UpdateInstanceTransform(Record.InstanceIndex, Collapsed, false, true, true);
+	Batch.InstanceToRecord[Record.InstanceIndex] = INDEX_NONE;
+	Batch.FreeInstances.Add(Record.InstanceIndex);
+
+	--NumPlacedParts;
+	DEC_DWORD_STAT(STAT_GAM312_BuildingInstances);
+}
+
+/** ---------- Benchmark ---------- **/
+
+void UBuildingManagerSubsystem::StartBenchmark(TSubclassOf<ABuildingPart> PartClass, const FVector& Origin)
+{
+	BenchPartClass = PartClass;
+	BenchOrigin = Origin;
+	BenchStage = 0;
+	BenchFramesLeft = 0;
+
+	UE_LOG(LogGAM312, Display, TEXT("[BuildingBench] Starting with %s, instancing %s"),
+		*GetNameSafe(PartClass), CVarBuildingInstancing.GetValueOnGameThread() ? TEXT("on") : TEXT("off"));
+}
+
+void UBuildingManagerSubsystem::SpawnBenchmarkParts(int32 Count)
+{
+	const int32 Side = FMath::CeilToInt(FMath::Sqrt(static_cast<float>(Count)));
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	for (int32 Index = 0; Index < Count; ++Index)
+	{
+		const FVector Location = BenchOrigin + FVector((Index % Side) * BuildingBenchmark::Spacing, (Index / Side) * BuildingBenchmark::Spacing, 0.0f);
+		ABuildingPart* Part = GetWorld()->SpawnActor<ABuildingPart>(BenchPartClass, Location, FRotator::ZeroRotator, SpawnParams);
+		if (Part && AbsorbPart(Part) == INDEX_NONE)
+		{
+			BuildingBenchmark::LooseActors.Add(Part);
+		}
+	}
+}
+
+void UBuildingManagerSubsystem::TickBenchmark(float DeltaTime)
+{
+	if (BenchStage == INDEX_NONE)
+	{
+		return;
+	}
+
+	const double Now = FPlatformTime::Seconds();
+	const double FrameMs = (Now - BuildingBenchmark::LastFrameTime) * 1000.0;
+	BuildingBenchmark::LastFrameTime = Now;
+
+	// Start the next stage: clear the previous parts and spawn this stage's count
+	if (BenchFramesLeft == 0)
+	{
+		ClearAll();
+		for (const TWeakObjectPtr<ABuildingPart>& Loose : BuildingBenchmark::LooseActors)
+		{
+			if (Loose.IsValid())
+			{
+				Loose->Destroy();
+			}
+		}
+		BuildingBenchmark::LooseActors.Reset();
+
+		BenchBaselineMemory = FPlatformMemory::GetStats().UsedPhysical;
+		SpawnBenchmarkParts(BuildingBenchmark::PartCounts[BenchStage]);
+
+		BenchFramesLeft = BuildingBenchmark::WarmupFrames + BuildingBenchmark::SampleFrames;
+		BenchFrameCount = 0;
+		BenchFrameTimeSum = 0.0;
+		BenchFrameTimeMax = 0.0;
+		BuildingBenchmark::LastFrameTime = FPlatformTime::Seconds();
+		return;
+	}
+
+	if (BenchFramesLeft-- <= BuildingBenchmark::SampleFrames)
+	{
+		++BenchFrameCount;
+		BenchFrameTimeSum += FrameMs;
+		BenchFrameTimeMax = FMath::Max(BenchFrameTimeMax, FrameMs);
+	}
+
+	if (BenchFramesLeft > 0)
+	{
+		return;
+	}
+
+	const int64 MemoryDelta = static_cast<int64>(FPlatformMemory::GetStats().UsedPhysical) - static_cast<int64>(BenchBaselineMemory);
+	UE_LOG(LogGAM312, Display, TEXT("[BuildingBench] %6d parts: avg %.2f ms, max %.2f ms, memory %+.1f MB, %d batches, %d actors"),
+		BuildingBenchmark::PartCounts[BenchStage],
+		BenchFrameTimeSum / FMath::Max(BenchFrameCount, 1),
+		BenchFrameTimeMax,
+		MemoryDelta / (1024.0 * 1024.0),
+		Batches.Num(),
+		BuildingBenchmark::LooseActors.Num());
+
+	if (++BenchStage >= static_cast<int32>(UE_ARRAY_COUNT(BuildingBenchmark::PartCounts)))
+	{
+		BenchStage = INDEX_NONE;
+		UE_LOG(LogGAM312, Display, TEXT("[BuildingBench] Done"));
+	}
+}
+
+static FAutoConsoleCommandWithWorldAndArgs GBuildingBenchmarkCommand(
+	TEXT("gam312.Building.Benchmark"),
+	TEXT("Spawns 1k, 10k and 50k building parts and logs frame time and memory for each. Optional arg: part class path."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		UBuildingManagerSubsystem* BuildingManager = World ? World->GetSubsystem<UBuildingManagerSubsystem>() : nullptr;
+		if (!BuildingManager)
+		{
+			return;
+		}
+
+		const FString ClassPath = Args.Num() > 0 ? Args[0] : FString(BuildingBenchmark::DefaultPartClass);
+		UClass* PartClass = LoadClass<ABuildingPart>(nullptr, *ClassPath);
+		if (!PartClass)
+		{
+			UE_LOG(LogGAM312, Warning, TEXT("[BuildingBench] Could not load part class %s"), *ClassPath);
+			return;
+		}
+
+		// Lay the grid out in front of the first player so the parts are on screen
+		FVector Origin = FVector::ZeroVector;
+		if (APawn* Pawn = UGameplayStatics::GetPlayerPawn(World, 0))
+		{
+			Origin = Pawn->GetActorLocation() + Pawn->GetActorForwardVector() * 1000.0f;
+		}
+
+		BuildingManager->StartBenchmark(PartClass, Origin);
+	}));
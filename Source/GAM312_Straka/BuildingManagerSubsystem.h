@@ -0,0 +1,237 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "BuildingPart.h"
+#include "BuildingPlacement.h"
+#include "BuildingManagerSubsystem.generated.h"
+
+class ABuildingReplicator;
+struct FReplicatedBuildingPiece;
+class UHierarchicalInstancedStaticMeshComponent;
+class UMaterialInterface;
+class UStaticMesh;
+
+/**
+ * FBuildingBatchKey
+ *
+ * Identifies one HISM batch: every placed part sharing a mesh and material set
+ * is drawn by the same component.
+ */
+struct FBuildingBatchKey
+{
+	UStaticMesh* Mesh = nullptr;
+	TArray<UMaterialInterface*> Materials;
+
+	bool operator==(const FBuildingBatchKey& Other) const
+	{
+		return Mesh == Other.Mesh && Materials == Other.Materials;
+	}
+
+	friend uint32 GetTypeHash(const FBuildingBatchKey& Key)
+	{
+		uint32 Hash = GetTypeHash(Key.Mesh);
+		for (UMaterialInterface* Material : Key.Materials)
+		{
+			Hash = HashCombine(Hash, GetTypeHash(Material));
+		}
+		return Hash;
+	}
+};
+
+/**
+ * FBuildingBatch
+ *
+ * One HISM component plus the mapping from its instance slots back to part records.
+ * Removed instances are collapsed to zero scale and reused, so instance indices stay stable.
+ */
+USTRUCT()
+struct FBuildingBatch
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TObjectPtr<UHierarchicalInstancedStaticMeshComponent> Component = nullptr;
+
+	// Record index for each instance slot (INDEX_NONE for free slots)
+	TArray<int32> InstanceToRecord;
+
+	// Instance slots that can be reused by the next absorbed part
+	TArray<int32> FreeInstances;
+};
+
+/**
+ * FPlacedBuildingRecord
+ *
+ * Lightweight stand-in for a placed ABuildingPart once its actor has been absorbed.
+ */
+USTRUCT(BlueprintType)
+struct FPlacedBuildingRecord
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly)
+	FTransform Transform;
+
+	UPROPERTY(BlueprintReadOnly)
+	TSubclassOf<ABuildingPart> PartClass;
+
+	// Registry building type (INDEX_NONE for parts without one)
+	UPROPERTY(BlueprintReadOnly)
+	int32 BuildingId = INDEX_NONE;
+
+	// Actor-space box and PivotArrow offset, used by the placement solver
+	FVector BoundsCenter = FVector::ZeroVector;
+	FVector BoundsExtent = FVector::ZeroVector;
+	FVector PivotOffset = FVector::ZeroVector;
+
+	// Batch and instance slot currently drawing this part
+	int32 BatchIndex = INDEX_NONE;
+	int32 InstanceIndex = INDEX_NONE;
+
+	bool IsValid() const { return BatchIndex != INDEX_NONE; }
+};
+
+/**
+ * UBuildingManagerSubsystem
+ *
+ * Per-world owner of all finalized building pieces. Placed ABuildingPart actors are
+ * converted to hierarchical instanced static mesh instances keyed by mesh and material,
+ * so a base of thousands of parts costs a handful of draw calls and no actors.
+ * A real actor is only restored when a piece is picked for editing.
+ *
+ * In networked games the server mirrors every record into the ABuildingReplicator of
+ * its grid cell. Clients only receive the cells near them, and they rebuild those
+ * pieces as instances in their own manager.
+ */
+UCLASS()
+class GAM312_STRAKA_API UBuildingManagerSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+
+	// Only ticks while a benchmark is running
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+
+	// Converts a finalized part into an instance. Returns the record ID, or INDEX_NONE if the part was left as an actor.
+	// With bDestroyActor false the caller keeps the actor (e.g. to return it to the preview pool).
+	UFUNCTION(BlueprintCallable, Category = "Building")
+	int32 AbsorbPart(ABuildingPart* Part, bool bDestroyActor = true);
+
+	// Turns the record back into a real actor and removes its instance. Reuses Into when given,
+	// otherwise spawns a new actor. Returns nullptr on failure.
+	UFUNCTION(BlueprintCallable, Category = "Building")
+	ABuildingPart* RestorePart(int32 RecordId, ABuildingPart* Into = nullptr);
+
+	// Removes a record and its instance without creating an actor. OutRecord receives the removed record.
+	bool RemovePart(int32 RecordId, FPlacedBuildingRecord* OutRecord = nullptr);
+
+	// Places a part of PartClass dressed as BuildingId at Transform, going through the preview pool.
+	// With bRequireFree the part is rejected if it overlaps a placed part. OutRecordId is INDEX_NONE
+	// when instancing is disabled and the part stays a (local, unreplicated) actor.
+	bool PlacePart(TSubclassOf<ABuildingPart> PartClass, int32 BuildingId, const FTransform& Transform, bool bRequireFree, int32* OutRecordId = nullptr);
+
+	// Resolves a trace hit against one of the batch components to a record ID
+	int32 FindRecordFromHit(const FHitResult& Hit) const;
+
+	// Collects the IDs of every placed part within Radius of Center
+	UFUNCTION(BlueprintCallable, Category = "Building")
+	void FindPartsInRadius(const FVector& Center, float Radius, TArray<int32>& OutRecordIds) const;
+
+	// Read-only access to a placed part record
+	const FPlacedBuildingRecord* GetRecord(int32 RecordId) const;
+
+	// Every record slot, including free ones (check IsValid)
+	const TArray<FPlacedBuildingRecord>& GetRecords() const { return Records; }
+
+	// Number of parts currently stored as instances
+	UFUNCTION(BlueprintCallable, Category = "Building")
+	int32 GetNumPlacedParts() const { return NumPlacedParts; }
+
+	// Removes every instance and record
+	void ClearAll();
+
+	// Copy of all placed parts for async placement solves. Built on first use, then kept up to date
+	// part by part as records are added and removed.
+	TSharedRef<const FPlacementSnapshot> GetPlacementSnapshot();
+
+	/** ---------- Networking ---------- **/
+
+	// Network ID of a local record: the record ID itself except on clients, where it is the server's record ID
+	// (INDEX_NONE for records the server doesn't know about)
+	int32 GetNetId(int32 RecordId) const;
+
+	// Client: drops the mapping of a piece the client already removed itself (e.g. picked up for editing)
+	void ForgetNetPiece(int32 NetId);
+
+	// Client: mirrors pieces added to or removed from a relevant building cell
+	void AddNetPiece(const FReplicatedBuildingPiece& Piece);
+	void RemoveNetPiece(int32 NetId);
+
+	// Replication grid cell holding a location
+	static FIntPoint GetReplicationCell(const FVector& Location);
+
+	// Spawns and absorbs parts at 1k, 10k and 50k, logging frame time and memory for each
+	void StartBenchmark(TSubclassOf<ABuildingPart> PartClass, const FVector& Origin);
+
+private:
+	int32 FindOrAddBatch(const FBuildingBatchKey& Key, const UStaticMeshComponent* Source);
+	AActor* GetOrCreateBatchOwner();
+	void ReleaseInstance(FPlacedBuildingRecord& Record);
+
+	// Snapshot to apply a record change to, copied first if a solve still holds it (null until first built)
+	FPlacementSnapshot* GetMutablePlacementSnapshot();
+
+	// Advances the benchmark state machine by one frame
+	void TickBenchmark(float DeltaTime);
+	void SpawnBenchmarkParts(int32 Count);
+
+	// Actor that owns every batch component
+	UPROPERTY()
+	TObjectPtr<AActor> BatchOwner;
+
+	// Server: the replicator of the cell holding Location, spawned on first use
+	ABuildingReplicator* GetOrAddCellReplicator(const FVector& Location);
+
+	// Server: one replicator per grid cell that ever held a part
+	UPROPERTY()
+	TMap<FIntPoint, TObjectPtr<ABuildingReplicator>> CellReplicators;
+
+	// True where record changes must be sent to clients
+	bool bReplicateChanges = false;
+
+	// Client: mapping between server record IDs and local record IDs
+	TMap<int32, int32> NetToLocal;
+	TMap<int32, int32> LocalToNet;
+
+	UPROPERTY()
+	TArray<FBuildingBatch> Batches;
+
+	UPROPERTY()
+	TArray<FPlacedBuildingRecord> Records;
+
+	TMap<FBuildingBatchKey, int32> BatchLookup;
+	TArray<int32> FreeRecords;
+	int32 NumPlacedParts = 0;
+
+	// Placement snapshot, slot per record ID; cleared only by ClearAll
+	TSharedPtr<FPlacementSnapshot> PlacementSnapshot;
+
+	/** ---------- Benchmark State ---------- **/
+
+	UPROPERTY()
+	TSubclassOf<ABuildingPart> BenchPartClass;
+
+	FVector BenchOrigin = FVector::ZeroVector;
+	int32 BenchStage = INDEX_NONE;
+	int32 BenchFramesLeft = 0;
+	int32 BenchFrameCount = 0;
+	double BenchFrameTimeSum = 0.0;
+	double BenchFrameTimeMax = 0.0;
+	uint64 BenchBaselineMemory = 0;
+};
@@ -1,11 +1,15 @@
 #include "BuildingPart.h"
+#include "GAM312_Straka.h"
 #include "Components/StaticMeshComponent.h"
 #include "Components/ArrowComponent.h"
+#include "BuildingManagerSubsystem.h"
 
 // Constructor
 ABuildingPart::ABuildingPart()
 {
+	// Placed parts have nothing to do per frame; tick is only switched on for previews
 	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bStartWithTickEnabled = false;
 
 	// Initialize and attach mesh component
 	Mesh = CreateDefaultSubobject<UStaticMeshComponent>(TEXT("Mesh"));
@@ -19,11 +23,111 @@ ABuildingPart::ABuildingPart()
 // Called when the game starts or when spawned
 void ABuildingPart::BeginPlay()
 {
+	GAM312_SCOPE(ABuildingPart, BeginPlay);
+
 	Super::BeginPlay();
 }
 
-// Called every frame
+// Called every frame while previewing
 void ABuildingPart::Tick(float DeltaTime)
 {
+	GAM312_SCOPE(ABuildingPart, Tick);
+
 	Super::Tick(DeltaTime);
-}
\ No newline at end of file
+
+	USceneComponent* Target = PreviewTarget.Get();
+	if (!Target)
+	{
+		StopPreview();
+		return;
+	}
+
+	UpdatePlacement(Target);
+}
+
+// Applies last frame's snapped placement and hands this frame's camera transform to a worker
+void ABuildingPart::UpdatePlacement(const USceneComponent* Target)
+{
+	GAM312_SCOPE(ABuildingPart, UpdatePlacement);
+
+	if (PendingPlacement.IsValid() && PendingPlacement.IsCompleted())
+	{
+		const FPlacementResult& Result = PendingPlacement.GetResult();
+		SetActorLocation(Result.Location);
+		bHasPlacementResult = true;
+
+		if (Result.bValid != bPlacementValid)
+		{
+			bPlacementValid = Result.bValid;
+			OnPlacementValidityChanged(bPlacementValid);
+		}
+
+		PendingPlacement = {};
+	}
+
+	// Keep the preview in front of the camera until the first solve lands
+	if (!bHasPlacementResult)
+	{
+		SetActorLocation(Target->GetComponentLocation() + Target->GetForwardVector() * PreviewDistance);
+	}
+
+	UBuildingManagerSubsystem* BuildingManager = GetWorld()->GetSubsystem<UBuildingManagerSubsystem>();
+	if (PendingPlacement.IsValid() || !BuildingManager)
+	{
+		return;
+	}
+
+	FPlacementRequest Request;
+	Request.ViewLocation = Target->GetComponentLocation();
+	Request.ViewDirection = Target->GetForwardVector();
+	Request.Distance = PreviewDistance;
+	Request.Rotation = GetActorQuat();
+	Request.Shape = FPlacementShape::FromPart(this);
+
+	TSharedRef<const FPlacementSnapshot> Snapshot = BuildingManager->GetPlacementSnapshot();
+	PendingPlacement = UE::Tasks::Launch(UE_SOURCE_LOCATION, [Snapshot, Request]()
+	{
+		return BuildingPlacement::Solve(*Snapshot, Request);
+	});
+}
+
+// Starts following the camera and turns tick on
+void ABuildingPart::StartPreview(USceneComponent* FollowTarget, float Distance)
+{
+	GAM312_SCOPE(ABuildingPart, StartPreview);
+
+	PreviewTarget = FollowTarget;
+	PreviewDistance = Distance;
+	PendingPlacement = {};
+	bHasPlacementResult = false;
+
+	// Nothing has been checked at the new spot yet
+	if (bPlacementValid)
+	{
+		bPlacementValid = false;
+		OnPlacementValidityChanged(false);
+	}
+
+	// Tick after the owner so the camera has already moved this frame
+	if (FollowTarget && FollowTarget->GetOwner())
+	{
+		AddTickPrerequisiteActor(FollowTarget->GetOwner());
+	}
+	SetActorTickEnabled(FollowTarget != nullptr);
+}
+
+// Stops following the camera and turns tick off
+void ABuildingPart::StopPreview()
+{
+	GAM312_SCOPE(ABuildingPart, StopPreview);
+
+	USceneComponent* Target = PreviewTarget.Get();
+	if (Target && Target->GetOwner())
+	{
+		RemoveTickPrerequisiteActor(Target->GetOwner());
+	}
+
+	PreviewTarget.Reset();
+	PendingPlacement = {};
+	SetActorTickEnabled(false);
+}
@@ -5,6 +5,8 @@
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
 #include "Components/ArrowComponent.h"
+#include "Tasks/Task.h"
+#include "BuildingPlacement.h"
 #include "BuildingPart.generated.h"
 
 UCLASS()
@@ -21,13 +23,48 @@ protected:
 	virtual void BeginPlay() override;
 
 public:	
-	// Called every frame
+	// Called every frame, but only while the part is a preview following a camera
 	virtual void Tick(float DeltaTime) override;
 
+	// Makes the part follow FollowTarget's forward vector at Distance units and enables ticking
+	void StartPreview(USceneComponent* FollowTarget, float Distance);
+
+	// Stops following and disables ticking again (called when the part is placed)
+	void StopPreview();
+
+	// Whether the last placement solve found a spot that overlaps no placed part (false until the first solve lands)
+	bool IsPlacementValid() const { return bPlacementValid; }
+
+	// Lets Blueprints tint the preview when it turns valid or invalid
+	UFUNCTION(BlueprintImplementableEvent)
+	void OnPlacementValidityChanged(bool bValid);
+
 	UPROPERTY(EditAnywhere)
 	UStaticMeshComponent* Mesh;
 
 	UPROPERTY(EditAnywhere)
 	UArrowComponent* PivotArrow;
 
+	// Registry building type this part was crafted as (INDEX_NONE if it has none)
+	UPROPERTY(VisibleInstanceOnly)
+	int32 BuildingId = INDEX_NONE;
+
+private:
+	// Component the preview follows; tick is disabled whenever this is unset
+	UPROPERTY()
+	TWeakObjectPtr<USceneComponent> PreviewTarget;
+
+	float PreviewDistance = 0.0f;
+
+	// Applies a finished solve, then queues a new one from the current camera transform
+	void UpdatePlacement(const USceneComponent* Target);
+
+	// Solve running on a worker; its result is applied on the next tick
+	UE::Tasks::TTask<FPlacementResult> PendingPlacement;
+
+	// False until the first solve lands; the preview follows the raw camera ray until then
+	bool bHasPlacementResult = false;
+
+	// Stays false until a solve has accepted the spot, so a fresh preview can't be placed unchecked
+	bool bPlacementValid = false;
 };
@@ -0,0 +1,301 @@
+#include "BuildingPlacement.h"
+#include "GAM312_Straka.h"
+#include "BuildingPart.h"
+#include "Async/ParallelFor.h"
+#include "Engine/StaticMesh.h"
+#include "HAL/IConsoleManager.h"
+
+FPlacementShape FPlacementShape::FromPart(const ABuildingPart* Part)
+{
+	FPlacementShape Shape;
+	Shape.Transform = Part->GetActorTransform();
+
+	if (Part->Mesh && Part->Mesh->GetStaticMesh())
+	{
+		const FBoxSphereBounds Bounds = Part->Mesh->GetStaticMesh()->GetBounds();
+		Shape.LocalCenter = Bounds.Origin;
+		Shape.LocalExtent = Bounds.BoxExtent;
+	}
+
+	if (Part->PivotArrow)
+	{
+		Shape.PivotOffset = Part->PivotArrow->GetRelativeLocation();
+	}
+
+	return Shape;
+}
+
+FBox FPlacementShape::GetWorldBox() const
+{
+	return GetWorldBox(Transform);
+}
+
+FBox FPlacementShape::GetWorldBox(const FTransform& AtTransform) const
+{
+	return FBox(LocalCenter - LocalExtent, LocalCenter + LocalExtent).TransformBy(AtTransform);
+}
+
+FIntVector FPlacementSnapshot::GetCell(const FVector& Location) const
+{
+	return FIntVector(
+		FMath::FloorToInt(Location.X / CellSize),
+		FMath::FloorToInt(Location.Y / CellSize),
+		FMath::FloorToInt(Location.Z / CellSize));
+}
+
+int32 FPlacementSnapshot::Add(const FPlacementShape& Shape, int32 Id)
+{
+	int32 Index = Id;
+	if (Index == INDEX_NONE)
+	{
+		Index = Parts.Add(Shape);
+	}
+	else
+	{
+		Remove(Index);
+		Parts.Insert(Index, Shape);
+	}
+	WorldBoxes.Insert(Index, Shape.GetWorldBox());
+	const FBox& Box = WorldBoxes[Index];
+
+	// Parts larger than a cell are listed in every cell they cover
+	const FIntVector MinCell = GetCell(Box.Min);
+	const FIntVector MaxCell = GetCell(Box.Max);
+	for (int32 Z = MinCell.Z; Z <= MaxCell.Z; ++Z)
+	{
+		for (int32 Y = MinCell.Y; Y <= MaxCell.Y; ++Y)
+		{
+			for (int32 X = MinCell.X; X <= MaxCell.X; ++X)
+			{
+				Cells.FindOrAdd(FIntVector(X, Y, Z)).Add(Index);
+			}
+		}
+	}
+
+	return Index;
+}
+
+void FPlacementSnapshot::Remove(int32 Id)
+{
+	if (!Parts.IsValidIndex(Id))
+	{
+		return;
+	}
+
+	const FBox& Box = WorldBoxes[Id];
+	const FIntVector MinCell = GetCell(Box.Min);
+	const FIntVector MaxCell = GetCell(Box.Max);
+	for (int32 Z = MinCell.Z; Z <= MaxCell.Z; ++Z)
+	{
+		for (int32 Y = MinCell.Y; Y <= MaxCell.Y; ++Y)
+		{
+			for (int32 X = MinCell.X; X <= MaxCell.X; ++X)
+			{
+				const FIntVector Cell(X, Y, Z);
+				if (TArray<int32>* CellParts = Cells.Find(Cell))
+				{
+					CellParts->RemoveSingleSwap(Id, EAllowShrinking::No);
+					if (CellParts->IsEmpty())
+					{
+						Cells.Remove(Cell);
+					}
+				}
+			}
+		}
+	}
+
+	Parts.RemoveAt(Id);
+	WorldBoxes.RemoveAt(Id);
+}
+
+void FPlacementSnapshot::ForEachNear(const FBox& Box, TFunctionRef<void(const FPlacementShape&, const FBox&)> Visitor) const
+{
+	const FIntVector MinCell = GetCell(Box.Min);
+	const FIntVector MaxCell = GetCell(Box.Max);
+
+	// A part spanning several cells must only be visited once. A set rather than per-entry
+	// stamps, since solves for several previews can query the snapshot in parallel.
+	TSet<int32, DefaultKeyFuncs<int32>, TInlineSetAllocator<64>> Visited;
+
+	for (int32 Z = MinCell.Z; Z <= MaxCell.Z; ++Z)
+	{
+		for (int32 Y = MinCell.Y; Y <= MaxCell.Y; ++Y)
+		{
+			for (int32 X = MinCell.X; X <= MaxCell.X; ++X)
+			{
+				const TArray<int32>* CellParts = Cells.Find(FIntVector(X, Y, Z));
+				if (!CellParts)
+				{
+					continue;
+				}
+
+				for (const int32 Index : *CellParts)
+				{
+					bool bAlreadyVisited = false;
+					Visited.Add(Index, &bAlreadyVisited);
+					if (!bAlreadyVisited)
+					{
+						Visitor(Parts[Index], WorldBoxes[Index]);
+					}
+				}
+			}
+		}
+	}
+}
+
+namespace BuildingPlacement
+{
+	// True if the shape at Transform overlaps any placed part by more than the tolerance
+	static bool Overlaps(const FPlacementSnapshot& Snapshot, const FPlacementShape& Shape, const FTransform& Transform, float Tolerance)
+	{
+		const FBox Box = Shape.GetWorldBox(Transform).ExpandBy(-Tolerance);
+		if (!Box.IsValid)
+		{
+			return false;
+		}
+
+		bool bOverlaps = false;
+		Snapshot.ForEachNear(Box, [&Box, &bOverlaps](const FPlacementShape&, const FBox& PlacedBox)
+		{
+			bOverlaps = bOverlaps || Box.Intersect(PlacedBox);
+		});
+		return bOverlaps;
+	}
+
+	FPlacementResult Solve(const FPlacementSnapshot& Snapshot, const FPlacementRequest& Request)
+	{
+		const FVector Unsnapped = Request.ViewLocation + Request.ViewDirection * Request.Distance;
+		const FVector PivotOffset = Request.Rotation.RotateVector(Request.Shape.PivotOffset);
+		const FVector DesiredPivot = Unsnapped + PivotOffset;
+
+		// Sockets sit one part-length away from a neighbour's pivot along each of its local axes
+		struct FSocket
+		{
+			FVector Pivot;
+			double DistanceSq;
+		};
+		TArray<FSocket, TInlineAllocator<64>> Sockets;
+
+		const double SnapDistanceSq = FMath::Square(Request.SnapDistance);
+		const FVector SearchExtent = FVector(Request.SnapDistance) + Request.Shape.LocalExtent * 3.0f;
+		Snapshot.ForEachNear(FBox(DesiredPivot - SearchExtent, DesiredPivot + SearchExtent),
+			[&Sockets, &DesiredPivot, SnapDistanceSq](const FPlacementShape& Placed, const FBox&)
+			{
+				const FVector PlacedPivot = Placed.Transform.TransformPosition(Placed.PivotOffset);
+				const FVector Step = Placed.LocalExtent * 2.0f * Placed.Transform.GetScale3D();
+				const FVector Axes[] = {
+					Placed.Transform.GetUnitAxis(EAxis::X) * Step.X,
+					Placed.Transform.GetUnitAxis(EAxis::Y) * Step.Y,
+					Placed.Transform.GetUnitAxis(EAxis::Z) * Step.Z };
+
+				for (const FVector& Axis : Axes)
+				{
+					for (const FVector& Candidate : { PlacedPivot + Axis, PlacedPivot - Axis })
+					{
+						const double DistanceSq = FVector::DistSquared(Candidate, DesiredPivot);
+						if (DistanceSq <= SnapDistanceSq)
+						{
+							Sockets.Add({ Candidate, DistanceSq });
+						}
+					}
+				}
+			});
+
+		Sockets.Sort([](const FSocket& A, const FSocket& B) { return A.DistanceSq < B.DistanceSq; });
+
+		// Nearest free socket wins
+		FPlacementResult Result;
+		for (const FSocket& Socket : Sockets)
+		{
+			const FVector Location = Socket.Pivot - PivotOffset;
+			if (!Overlaps(Snapshot, Request.Shape, FTransform(Request.Rotation, Location), Request.OverlapTolerance))
+			{
+				Result.Location = Location;
+				Result.bValid = true;
+				Result.bSnappedToSocket = true;
+				return Result;
+			}
+		}
+
+		// No usable socket: snap the pivot to the world grid instead
+		const FVector GridPivot = Request.GridSize > 0.0f ? DesiredPivot.GridSnap(Request.GridSize) : DesiredPivot;
+		Result.Location = GridPivot - PivotOffset;
+		Result.bValid = !Overlaps(Snapshot, Request.Shape, FTransform(Request.Rotation, Result.Location), Request.OverlapTolerance);
+		return Result;
+	}
+
+	bool IsPlacementFree(const FPlacementSnapshot& Snapshot, const FPlacementShape& Shape, const FTransform& Transform, float Tolerance)
+	{
+		return !Overlaps(Snapshot, Shape, Transform, Tolerance);
+	}
+}
+
+/** ---------- Benchmark ---------- **/
+
+static FAutoConsoleCommand GPlacementBenchmarkCommand(
+	TEXT("gam312.Placement.Benchmark"),
+	TEXT("Solves placement queries against a synthetic 10k-part base and logs queries per second. Optional arg: query count (default 100000)."),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		const int32 NumQueries = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 100000;
+
+		// 100 x 100 grid alternating floor tiles (400 x 400 x 20) and walls (400 x 20 x 300)
+		constexpr int32 Side = 100;
+		constexpr float TileSize = 400.0f;
+
+		FPlacementShape Floor;
+		Floor.LocalCenter = FVector(0.0f, 0.0f, 10.0f);
+		Floor.LocalExtent = FVector(200.0f, 200.0f, 10.0f);
+
+		FPlacementShape Wall;
+		Wall.LocalCenter = FVector(0.0f, 0.0f, 150.0f);
+		Wall.LocalExtent = FVector(200.0f, 10.0f, 150.0f);
+
+		FPlacementSnapshot Snapshot;
+		for (int32 Index = 0; Snapshot.Num() < 10000; ++Index)
+		{
+			const FVector Tile((Index % Side) * TileSize, (Index / Side) * TileSize, 0.0f);
+
+			FPlacementShape Part = (Index % 2) ? Wall : Floor;
+			Part.Transform = FTransform(Tile + ((Index % 2) ? FVector(0.0f, 190.0f, 20.0f) : FVector::ZeroVector));
+			Snapshot.Add(Part);
+		}
+
+		// Random camera rays over the base, cycling through floor and wall shapes
+		FRandomStream Random(312);
+		TArray<FPlacementRequest> Requests;
+		Requests.SetNum(1024);
+		for (FPlacementRequest& Request : Requests)
+		{
+			Request.ViewLocation = FVector(Random.FRandRange(0.0f, Side * TileSize), Random.FRandRange(0.0f, Side * TileSize), 170.0f);
+			Request.ViewDirection = FRotator(Random.FRandRange(-30.0f, 0.0f), Random.FRandRange(0.0f, 360.0f), 0.0f).Vector();
+			Request.Rotation = FRotator(0.0f, 90.0f * Random.RandRange(0, 3), 0.0f).Quaternion();
+			Request.Shape = Random.RandRange(0, 1) ? Wall : Floor;
+		}
+
+		// Single thread, as one preview's worker task sees it
+		int32 NumValid = 0;
+		int32 NumSnapped = 0;
+		double StartTime = FPlatformTime::Seconds();
+		for (int32 Index = 0; Index < NumQueries; ++Index)
+		{
+			const FPlacementResult Result = BuildingPlacement::Solve(Snapshot, Requests[Index % Requests.Num()]);
+			NumValid += Result.bValid ? 1 : 0;
+			NumSnapped += Result.bSnappedToSocket ? 1 : 0;
+		}
+		const double SerialSeconds = FMath::Max(FPlatformTime::Seconds() - StartTime, UE_SMALL_NUMBER);
+
+		// All workers, as many simultaneous previews would see it
+		StartTime = FPlatformTime::Seconds();
+		ParallelFor(NumQueries, [&Snapshot, &Requests](int32 Index)
+		{
+			BuildingPlacement::Solve(Snapshot, Requests[Index % Requests.Num()]);
+		});
+		const double ParallelSeconds = FMath::Max(FPlatformTime::Seconds() - StartTime, UE_SMALL_NUMBER);
+
+		UE_LOG(LogGAM312, Display, TEXT("[PlacementBench] %d parts, %d queries: %.0f queries/s serial (%.2f us each), %.0f queries/s parallel; %.1f%% valid, %.1f%% snapped"),
+			Snapshot.Num(), NumQueries,
+			NumQueries / SerialSeconds, SerialSeconds * 1.0e6 / NumQueries,
+			NumQueries / ParallelSeconds,
+			100.0 * NumValid / NumQueries, 100.0 * NumSnapped / NumQueries);
+	}));
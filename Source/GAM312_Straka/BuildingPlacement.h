@@ -0,0 +1,103 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+class ABuildingPart;
+
+/**
+ * FPlacementShape
+ *
+ * Box and snap pivot of one building part in actor space, plus its world transform.
+ * The pivot comes from the part's PivotArrow.
+ */
+struct GAM312_STRAKA_API FPlacementShape
+{
+	FTransform Transform;
+	FVector LocalCenter = FVector::ZeroVector;
+	FVector LocalExtent = FVector::ZeroVector;
+	FVector PivotOffset = FVector::ZeroVector;
+
+	// Reads mesh bounds and pivot arrow from a part (Transform is taken from the actor)
+	static FPlacementShape FromPart(const ABuildingPart* Part);
+
+	// World-space box for this shape at Transform
+	FBox GetWorldBox() const;
+	FBox GetWorldBox(const FTransform& AtTransform) const;
+};
+
+/**
+ * FPlacementSnapshot
+ *
+ * Copy of every placed part, bucketed in a uniform 3D grid. Solver tasks hold a shared
+ * reference and only read it; the owner copies a snapshot that is still shared before
+ * changing it, so a running solve never sees a part appear or vanish.
+ */
+struct GAM312_STRAKA_API FPlacementSnapshot
+{
+	explicit FPlacementSnapshot(float InCellSize = 500.0f) : CellSize(InCellSize) {}
+
+	// Adds Shape in slot Id (INDEX_NONE takes any free slot) and returns the slot
+	int32 Add(const FPlacementShape& Shape, int32 Id = INDEX_NONE);
+
+	// Removes the shape in slot Id, if there is one
+	void Remove(int32 Id);
+
+	// Calls Visitor for every part whose cell touches Box
+	void ForEachNear(const FBox& Box, TFunctionRef<void(const FPlacementShape&, const FBox&)> Visitor) const;
+
+	int32 Num() const { return Parts.Num(); }
+
+private:
+	FIntVector GetCell(const FVector& Location) const;
+
+	float CellSize;
+	TSparseArray<FPlacementShape> Parts;
+	TSparseArray<FBox> WorldBoxes;
+	TMap<FIntVector, TArray<int32>> Cells;
+};
+
+/**
+ * FPlacementRequest
+ *
+ * Input for one solve: where the camera was looking and the shape being placed.
+ */
+struct FPlacementRequest
+{
+	FVector ViewLocation = FVector::ZeroVector;
+	FVector ViewDirection = FVector::ForwardVector;
+	float Distance = 400.0f;
+
+	FQuat Rotation = FQuat::Identity;
+	FPlacementShape Shape;
+
+	// Max distance from the unsnapped pivot to a neighbour's socket
+	float SnapDistance = 150.0f;
+
+	// World grid used when no socket is in range
+	float GridSize = 50.0f;
+
+	// Boxes may touch or overlap by this much before the placement is rejected
+	float OverlapTolerance = 2.0f;
+};
+
+/**
+ * FPlacementResult
+ */
+struct FPlacementResult
+{
+	FVector Location = FVector::ZeroVector;
+	bool bValid = false;
+	bool bSnappedToSocket = false;
+};
+
+/**
+ * Snaps a part to its neighbours' sockets (or the world grid) and checks it against
+ * every placed part. Pure function of its inputs, safe to run on any thread.
+ */
+namespace BuildingPlacement
+{
+	GAM312_STRAKA_API FPlacementResult Solve(const FPlacementSnapshot& Snapshot, const FPlacementRequest& Request);
+
+	// True if Shape at Transform overlaps no placed part by more than Tolerance (server-side validation)
+	GAM312_STRAKA_API bool IsPlacementFree(const FPlacementSnapshot& Snapshot, const FPlacementShape& Shape, const FTransform& Transform, float Tolerance = 2.0f);
+}
@@ -0,0 +1,133 @@
+#include "BuildingPreviewPool.h"
+#include "GAM312_Straka.h"
+#include "ResourceRegistry.h"
+#include "Engine/World.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Preview Actors Spawned"), STAT_GAM312_PreviewActorsSpawned, STATGROUP_GAM312);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Preview Pool Reuses"), STAT_GAM312_PreviewPoolReuses, STATGROUP_GAM312);
+
+void UBuildingPreviewPool::Deinitialize()
+{
+	Pools.Reset();
+
+	Super::Deinitialize();
+}
+
+void UBuildingPreviewPool::Prewarm(TSubclassOf<ABuildingPart> PartClass, int32 Count)
+{
+	if (!PartClass)
+	{
+		return;
+	}
+
+	FBuildingPartPool& Pool = Pools.FindOrAdd(PartClass);
+	while (Pool.Free.Num() < Count)
+	{
+		ABuildingPart* Part = SpawnPooled(PartClass, Pool);
+		if (!Part)
+		{
+			break;
+		}
+		Pool.Free.Add(Part);
+	}
+}
+
+ABuildingPart* UBuildingPreviewPool::Acquire(TSubclassOf<ABuildingPart> PartClass, const FTransform& Transform, const FBuildingTypeDef* TypeDef)
+{
+	if (!PartClass)
+	{
+		return nullptr;
+	}
+
+	FBuildingPartPool& Pool = Pools.FindOrAdd(PartClass);
+
+	// Take an idle actor if there is one, skipping any destroyed behind our back
+	ABuildingPart* Part = nullptr;
+	while (!Part && Pool.Free.Num() > 0)
+	{
+		Part = Pool.Free.Pop(EAllowShrinking::No);
+		Part = IsValid(Part) ? Part : nullptr;
+	}
+
+	if (Part)
+	{
+		INC_DWORD_STAT(STAT_GAM312_PreviewPoolReuses);
+	}
+	else
+	{
+		Part = SpawnPooled(PartClass, Pool);
+		if (!Part)
+		{
+			return nullptr;
+		}
+	}
+
+	// Dress the actor for the requested type, falling back to the class defaults
+	if (Part->Mesh)
+	{
+		UStaticMesh* Mesh = TypeDef && TypeDef->Mesh ? TypeDef->Mesh : Pool.DefaultMesh;
+		const TArray<UMaterialInterface*>& Materials = TypeDef && TypeDef->Materials.Num() > 0 ? TypeDef->Materials : Pool.DefaultMaterials;
+
+		if (Part->Mesh->GetStaticMesh() != Mesh)
+		{
+			Part->Mesh->SetStaticMesh(Mesh);
+		}
+		for (int32 MaterialIndex = 0; MaterialIndex < Materials.Num(); ++MaterialIndex)
+		{
+			Part->Mesh->SetMaterial(MaterialIndex, Materials[MaterialIndex]);
+		}
+	}
+
+	Part->SetActorTransform(Transform, false, nullptr, ETeleportType::TeleportPhysics);
+	SetPooledState(Part, false);
+
+	return Part;
+}
+
+void UBuildingPreviewPool::Release(ABuildingPart* Part)
+{
+	if (!IsValid(Part))
+	{
+		return;
+	}
+
+	Part->StopPreview();
+	SetPooledState(Part, true);
+	Pools.FindOrAdd(Part->GetClass()).Free.Add(Part);
+}
+
+ABuildingPart* UBuildingPreviewPool::SpawnPooled(TSubclassOf<ABuildingPart> PartClass, FBuildingPartPool& Pool)
+{
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	SpawnParams.ObjectFlags |= RF_Transient;
+
+	ABuildingPart* Part = GetWorld()->SpawnActor<ABuildingPart>(PartClass, FTransform::Identity, SpawnParams);
+	if (!Part)
+	{
+		return nullptr;
+	}
+
+	INC_DWORD_STAT(STAT_GAM312_PreviewActorsSpawned);
+
+	// A freshly spawned actor carries the class defaults; remember them for resetting reused actors
+	if (!Pool.bHasDefaults && Part->Mesh)
+	{
+		Pool.DefaultMesh = Part->Mesh->GetStaticMesh();
+		for (int32 MaterialIndex = 0; MaterialIndex < Part->Mesh->GetNumMaterials(); ++MaterialIndex)
+		{
+			Pool.DefaultMaterials.Add(Part->Mesh->GetMaterial(MaterialIndex));
+		}
+		Pool.bHasDefaults = true;
+	}
+
+	SetPooledState(Part, true);
+	return Part;
+}
+
+// Pooled actors are hidden and have no collision; active previews are visible and collide as before
+void UBuildingPreviewPool::SetPooledState(ABuildingPart* Part, bool bPooled)
+{
+	Part->SetActorHiddenInGame(bPooled);
+	Part->SetActorEnableCollision(!bPooled);
+}
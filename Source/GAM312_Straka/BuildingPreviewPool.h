@@ -0,0 +1,69 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "BuildingPart.h"
+#include "BuildingPreviewPool.generated.h"
+
+struct FBuildingTypeDef;
+class UMaterialInterface;
+class UStaticMesh;
+
+/**
+ * FBuildingPartPool
+ *
+ * Hidden, idle preview actors of one ABuildingPart class, plus the class's default
+ * mesh and materials so a reused actor can be reset after a type swapped them.
+ */
+USTRUCT()
+struct FBuildingPartPool
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<TObjectPtr<ABuildingPart>> Free;
+
+	UPROPERTY()
+	UStaticMesh* DefaultMesh = nullptr;
+
+	UPROPERTY()
+	TArray<UMaterialInterface*> DefaultMaterials;
+
+	bool bHasDefaults = false;
+};
+
+/**
+ * UBuildingPreviewPool
+ *
+ * Per-world pool of building preview actors. Entering build mode takes an idle actor
+ * and swaps its mesh and materials to the requested building type instead of spawning,
+ * so cycling pieces never pays for construction scripts, component registration or
+ * physics-state creation. Placed previews come back here once the building manager
+ * has turned them into instances.
+ */
+UCLASS()
+class GAM312_STRAKA_API UBuildingPreviewPool : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	// Spawns Count hidden actors of PartClass ahead of time (call from BeginPlay)
+	void Prewarm(TSubclassOf<ABuildingPart> PartClass, int32 Count);
+
+	// Returns a visible actor of PartClass at Transform, dressed as TypeDef when given
+	ABuildingPart* Acquire(TSubclassOf<ABuildingPart> PartClass, const FTransform& Transform, const FBuildingTypeDef* TypeDef = nullptr);
+
+	// Hides the actor and keeps it for the next Acquire of its class
+	void Release(ABuildingPart* Part);
+
+private:
+	// Spawns a new hidden actor and records the class defaults on first use
+	ABuildingPart* SpawnPooled(TSubclassOf<ABuildingPart> PartClass, FBuildingPartPool& Pool);
+
+	static void SetPooledState(ABuildingPart* Part, bool bPooled);
+
+	UPROPERTY()
+	TMap<TSubclassOf<ABuildingPart>, FBuildingPartPool> Pools;
+};
@@ -0,0 +1,118 @@
+#include "BuildingReplicator.h"
+#include "GAM312_Straka.h"
+#include "BuildingManagerSubsystem.h"
+#include "Components/SceneComponent.h"
+#include "Engine/World.h"
+#include "Net/UnrealNetwork.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Replicated Building Pieces"), STAT_GAM312_ReplicatedPieces, STATGROUP_GAM312);
+
+ABuildingReplicator::ABuildingReplicator()
+{
+	bReplicates = true;
+	SetCanBeDamaged(false);
+
+	// Relevancy is measured from the cell centre; keep whole cells around well past view range
+	RootComponent = CreateDefaultSubobject<USceneComponent>(TEXT("Root"));
+	NetCullDistanceSquared = FMath::Square(20000.0f);
+
+	// Pieces change in bursts when players build; nothing else on this actor changes
+	NetUpdateFrequency = 10.0f;
+	MinNetUpdateFrequency = 1.0f;
+
+	Pieces.Owner = this;
+}
+
+// Clients drop the cell's pieces when it stops being relevant; they come back with the cell
+void ABuildingReplicator::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	UBuildingManagerSubsystem* BuildingManager = GetWorld()->GetSubsystem<UBuildingManagerSubsystem>();
+	if (BuildingManager && !HasAuthority())
+	{
+		for (const FReplicatedBuildingPiece& Piece : Pieces.Items)
+		{
+			BuildingManager->RemoveNetPiece(Piece.RecordId);
+		}
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void ABuildingReplicator::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(ABuildingReplicator, Pieces);
+}
+
+void ABuildingReplicator::AddPiece(int32 RecordId, int32 BuildingId, TSubclassOf<ABuildingPart> PartClass, const FTransform& Transform)
+{
+	FReplicatedBuildingPiece& Piece = Pieces.Items.AddDefaulted_GetRef();
+	Piece.RecordId = RecordId;
+	Piece.BuildingId = BuildingId;
+	Piece.PartClass = PartClass;
+	Piece.Location = Transform.GetLocation();
+	Piece.Rotation = Transform.Rotator();
+	Pieces.MarkItemDirty(Piece);
+
+	INC_DWORD_STAT(STAT_GAM312_ReplicatedPieces);
+}
+
+void ABuildingReplicator::RemovePiece(int32 RecordId)
+{
+	// Removals only happen when a part is picked up for editing, so a scan is fine
+	const int32 Index = Pieces.Items.IndexOfByPredicate([RecordId](const FReplicatedBuildingPiece& Piece) { return Piece.RecordId == RecordId; });
+	if (Index != INDEX_NONE)
+	{
+		Pieces.Items.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+		Pieces.MarkArrayDirty();
+
+		DEC_DWORD_STAT(STAT_GAM312_ReplicatedPieces);
+	}
+}
+
+void ABuildingReplicator::ClearPieces()
+{
+	DEC_DWORD_STAT_BY(STAT_GAM312_ReplicatedPieces, Pieces.Items.Num());
+
+	Pieces.Items.Reset();
+	Pieces.MarkArrayDirty();
+}
+
+void ABuildingReplicator::OnPieceAdded(const FReplicatedBuildingPiece& Piece)
+{
+	UBuildingManagerSubsystem* BuildingManager = GetWorld() ? GetWorld()->GetSubsystem<UBuildingManagerSubsystem>() : nullptr;
+	if (!BuildingManager || HasAuthority())
+	{
+		return;
+	}
+
+	BuildingManager->AddNetPiece(Piece);
+}
+
+void ABuildingReplicator::OnPieceRemoved(const FReplicatedBuildingPiece& Piece)
+{
+	UBuildingManagerSubsystem* BuildingManager = GetWorld() ? GetWorld()->GetSubsystem<UBuildingManagerSubsystem>() : nullptr;
+	if (!BuildingManager || HasAuthority())
+	{
+		return;
+	}
+
+	BuildingManager->RemoveNetPiece(Piece.RecordId);
+}
+
+void FReplicatedBuildingPiece::PostReplicatedAdd(const FReplicatedBuildingArray& InArray)
+{
+	if (InArray.Owner)
+	{
+		InArray.Owner->OnPieceAdded(*this);
+	}
+}
+
+void FReplicatedBuildingPiece::PreReplicatedRemove(const FReplicatedBuildingArray& InArray)
+{
+	if (InArray.Owner)
+	{
+		InArray.Owner->OnPieceRemoved(*this);
+	}
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "Net/Serialization/FastArraySerializer.h"
+#include "BuildingPart.h"
+#include "BuildingReplicator.generated.h"
+
+class ABuildingReplicator;
+
+/**
+ * FReplicatedBuildingPiece
+ *
+ * One placed part as clients see it. RecordId is the server's record ID and serves
+ * as the piece's network ID.
+ */
+USTRUCT()
+struct FReplicatedBuildingPiece : public FFastArraySerializerItem
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	int32 RecordId = INDEX_NONE;
+
+	UPROPERTY()
+	int32 BuildingId = INDEX_NONE;
+
+	UPROPERTY()
+	TSubclassOf<ABuildingPart> PartClass;
+
+	// Parts snap to a 50-unit grid or a neighbour's socket, so 0.1-unit precision is plenty
+	UPROPERTY()
+	FVector_NetQuantize10 Location;
+
+	UPROPERTY()
+	FRotator Rotation = FRotator::ZeroRotator;
+
+	void PostReplicatedAdd(const struct FReplicatedBuildingArray& InArray);
+	void PreReplicatedRemove(const struct FReplicatedBuildingArray& InArray);
+};
+
+/**
+ * FReplicatedBuildingArray
+ */
+USTRUCT()
+struct FReplicatedBuildingArray : public FFastArraySerializer
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<FReplicatedBuildingPiece> Items;
+
+	// Actor applying replicated changes to the local building manager (not replicated)
+	UPROPERTY(NotReplicated)
+	TObjectPtr<ABuildingReplicator> Owner = nullptr;
+
+	bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms)
+	{
+		return FFastArraySerializer::FastArrayDeltaSerialize<FReplicatedBuildingPiece, FReplicatedBuildingArray>(Items, DeltaParms, *this);
+	}
+};
+
+template<>
+struct TStructOpsTypeTraits<FReplicatedBuildingArray> : public TStructOpsTypeTraitsBase2<FReplicatedBuildingArray>
+{
+	enum { WithNetDeltaSerializer = true };
+};
+
+/**
+ * ABuildingReplicator
+ *
+ * Actor the server spawns at the centre of each building grid cell in networked games
+ * (see UBuildingManagerSubsystem::GetReplicationCell) to share the parts placed in it.
+ * Parts travel as a fast array, so a client that comes within range gets the whole cell
+ * once and afterwards only the pieces that were added or removed. Clients turn each
+ * piece into an instance of their own building manager, and drop the cell's pieces again
+ * when the replicator stops being relevant to them.
+ */
+UCLASS(NotPlaceable, Transient)
+class GAM312_STRAKA_API ABuildingReplicator : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	ABuildingReplicator();
+
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+	/** ---------- Server ---------- **/
+
+	void AddPiece(int32 RecordId, int32 BuildingId, TSubclassOf<ABuildingPart> PartClass, const FTransform& Transform);
+	void RemovePiece(int32 RecordId);
+	void ClearPieces();
+
+	/** ---------- Client ---------- **/
+
+	void OnPieceAdded(const FReplicatedBuildingPiece& Piece);
+	void OnPieceRemoved(const FReplicatedBuildingPiece& Piece);
+
+	int32 GetNumPieces() const { return Pieces.Items.Num(); }
+
+private:
+	UPROPERTY(Replicated)
+	FReplicatedBuildingArray Pieces;
+};
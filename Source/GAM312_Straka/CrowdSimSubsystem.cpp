@@ -0,0 +1,742 @@
+#include "CrowdSimSubsystem.h"
+#include "GAM312_Straka.h"
+#include "ResourceLifecycleSubsystem.h"
+#include "ResourcePlannerSubsystem.h"
+#include "ResourceRegistry.h"
+#include "Resource_M.h"
+#include "WorldSaveSubsystem.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/World.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+
+DECLARE_CYCLE_STAT(TEXT("Crowd Simulate"), STAT_GAM312_CrowdSimulate, STATGROUP_GAM312);
+DECLARE_CYCLE_STAT(TEXT("Crowd Think"), STAT_GAM312_CrowdThink, STATGROUP_GAM312);
+DECLARE_CYCLE_STAT(TEXT("Crowd Instances"), STAT_GAM312_CrowdInstances, STATGROUP_GAM312);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Crowd Agents"), STAT_GAM312_CrowdAgents, STATGROUP_GAM312);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Crowd Actors"), STAT_GAM312_CrowdActors, STATGROUP_GAM312);
+
+static TAutoConsoleVariable<float> CVarCrowdPromoteDistance(
+	TEXT("gam312.Crowd.PromoteDistance"),
+	4000.0f,
+	TEXT("Crowd agents this close to a player are promoted to full actors; they are demoted again a quarter further out."));
+
+static TAutoConsoleVariable<int32> CVarCrowdMaxActors(
+	TEXT("gam312.Crowd.MaxActors"),
+	24,
+	TEXT("Most crowd agents promoted to full actors at once."));
+
+static TAutoConsoleVariable<bool> CVarCrowdDraw(
+	TEXT("gam312.Crowd.Draw"),
+	true,
+	TEXT("Draw crowd agents that aren't promoted as one instanced mesh."));
+
+namespace CrowdSim
+{
+	static const TCHAR* DefaultAgentClass = TEXT("/Game/AI/AIChar.AIChar_C");
+	static const TCHAR* AgentMesh = TEXT("/Engine/BasicShapes/Cylinder.Cylinder");
+
+	// Instanced stand-in for a character capsule (the cylinder is 100 units across and tall)
+	static const FVector AgentMeshScale(0.7f, 0.7f, 1.8f);
+	static constexpr float HalfHeight = 90.0f;
+
+	static constexpr float WalkSpeed = 400.0f;
+	static constexpr float SearchRadius = 8000.0f;
+
+	// Close enough to swing at a node, about a player's reach
+	static constexpr float HarvestReach = 200.0f;
+
+	// Seconds between swings, and between thinks for an idle agent
+	static constexpr float HarvestInterval = 1.0f;
+	static constexpr float ThinkInterval = 0.5f;
+	static constexpr float PromoteInterval = 0.25f;
+
+	// Same stamina rules as AMyCharacter::HarvestAlong
+	static constexpr float HarvestMinStamina = 5.0f;
+	static constexpr float HarvestStaminaCost = 5.0f;
+
+	// Agents eat (or look for Berry bushes) below this hunger
+	static constexpr float HungryBelow = 50.0f;
+	static constexpr float HungerPerBerry = 10.0f;
+
+	// Stat cap shared with AMyCharacter::SetHunger/SetStamina
+	static constexpr float StatCap = 100.0f;
+}
+
+namespace CrowdBenchmark
+{
+	static const int32 AgentCounts[] = { 100, 1000, 5000 };
+
+	static constexpr int32 WarmupFrames = 60;
+	static constexpr int32 SampleFrames = 300;
+	static constexpr float SpawnRadius = 20000.0f;
+}
+
+/** ---------- FCrowdAgentFragments ---------- **/
+
+int32 FCrowdAgentFragments::Add(const FVector& InLocation, float InHealth, float InHunger, float InStamina)
+{
+	Location.Add(InLocation);
+	Goal.Add(InLocation);
+	State.Add(ECrowdAgentState::Idle);
+	TargetNode.AddDefaulted();
+	PlanHandle.Add(INDEX_NONE);
+	HarvestCooldown.Add(0.0f);
+	Berries.Add(0);
+	Actor.AddDefaulted();
+	return Stats.Add(InHealth, InHunger, InStamina);
+}
+
+void FCrowdAgentFragments::RemoveAtSwap(int32 Index)
+{
+	Location.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	Goal.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	State.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	TargetNode.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	PlanHandle.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	HarvestCooldown.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	Berries.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	Actor.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	Stats.RemoveAtSwap(Index);
+}
+
+void FCrowdAgentFragments::Reset()
+{
+	Location.Reset();
+	Goal.Reset();
+	State.Reset();
+	TargetNode.Reset();
+	PlanHandle.Reset();
+	HarvestCooldown.Reset();
+	Berries.Reset();
+	Actor.Reset();
+	Stats.Reset();
+}
+
+/** ---------- UCrowdSimSubsystem ---------- **/
+
+void UCrowdSimSubsystem::Deinitialize()
+{
+	ClearAgents();
+	BenchStage = INDEX_NONE;
+
+	Super::Deinitialize();
+}
+
+bool UCrowdSimSubsystem::IsTickable() const
+{
+	return Agents.Num() > 0 || BenchStage != INDEX_NONE;
+}
+
+TStatId UCrowdSimSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UCrowdSimSubsystem, STATGROUP_Tickables);
+}
+
+void UCrowdSimSubsystem::Tick(float DeltaTime)
+{
+	GAM312_SCOPE(UCrowdSimSubsystem, Tick);
+
+	Super::Tick(DeltaTime);
+
+	const double SimStart = FPlatformTime::Seconds();
+	{
+		SCOPE_CYCLE_COUNTER(STAT_GAM312_CrowdSimulate);
+
+		// Promoted actors that were destroyed by gameplay take their agent with them
+		for (int32 Index = Agents.Num() - 1; Index >= 0; --Index)
+		{
+			if (Agents.Actor[Index].IsStale())
+			{
+				--NumPromoted;
+				DEC_DWORD_STAT(STAT_GAM312_CrowdActors);
+				Agents.Actor[Index].Reset();
+				RemoveAgent(Index);
+			}
+		}
+
+		Think(DeltaTime);
+		Move(DeltaTime);
+		Harvest(DeltaTime);
+
+		TimeSinceStep += DeltaTime;
+		if (TimeSinceStep >= USurvivalStatsSubsystem::StepInterval)
+		{
+			// Like the survival subsystem, a long hitch doesn't step more than once
+			TimeSinceStep = FMath::Min(TimeSinceStep - USurvivalStatsSubsystem::StepInterval, USurvivalStatsSubsystem::StepInterval);
+			StepStats();
+		}
+
+		TimeSincePromotion += DeltaTime;
+		if (TimeSincePromotion >= CrowdSim::PromoteInterval)
+		{
+			TimeSincePromotion = 0.0f;
+			UpdatePromotion();
+		}
+
+		UpdateInstances();
+	}
+	LastSimSeconds = FPlatformTime::Seconds() - SimStart;
+
+	TickBenchmark();
+}
+
+void UCrowdSimSubsystem::SpawnAgents(int32 Count, const FVector& Center, float Radius)
+{
+	UWorld* World = GetWorld();
+	if (World->GetNetMode() == NM_Client || Count <= 0)
+	{
+		return;
+	}
+
+	if (!AgentClass)
+	{
+		AgentClass = LoadClass<APawn>(nullptr, CrowdSim::DefaultAgentClass);
+	}
+	BerryId = UResourceRegistry::Get().FindResourceId(TEXT("Berry"));
+
+	FCollisionQueryParams TraceParams(SCENE_QUERY_STAT(CrowdSpawn), false);
+	for (int32 Spawned = 0; Spawned < Count; ++Spawned)
+	{
+		FVector Location = Center + FVector(Random.GetUnitVector2D() * Radius * FMath::Sqrt(Random.FRand()), 0.0f);
+
+		// Stand on whatever is below; agents keep this height while they walk
+		FHitResult Hit;
+		GAM312_COUNT(Traces);
+		if (World->LineTraceSingleByChannel(Hit, Location + FVector(0.0f, 0.0f, 10000.0f), Location - FVector(0.0f, 0.0f, 10000.0f), ECC_WorldStatic, TraceParams))
+		{
+			Location.Z = Hit.ImpactPoint.Z + CrowdSim::HalfHeight;
+		}
+
+		// Full health (which the cap keeps there until starving), varied hunger and stamina
+		Agents.Add(Location, 100.0f, Random.FRandRange(20.0f, 100.0f), Random.FRandRange(20.0f, 100.0f));
+	}
+
+	INC_DWORD_STAT_BY(STAT_GAM312_CrowdAgents, Count);
+	UE_LOG(LogGAM312, Log, TEXT("[Crowd] Spawned %d agents (%d total), promoting to %s"), Count, Agents.Num(), *GetNameSafe(AgentClass));
+}
+
+void UCrowdSimSubsystem::ClearAgents()
+{
+	for (const TWeakObjectPtr<APawn>& Actor : Agents.Actor)
+	{
+		if (APawn* Pawn = Actor.Get())
+		{
+			Pawn->Destroy();
+		}
+	}
+
+	if (UResourcePlannerSubsystem* Planner = GetWorld()->GetSubsystem<UResourcePlannerSubsystem>())
+	{
+		for (int32 Handle : Agents.PlanHandle)
+		{
+			if (Handle != INDEX_NONE)
+			{
+				Planner->CancelPlan(Handle);
+			}
+		}
+	}
+
+	DEC_DWORD_STAT_BY(STAT_GAM312_CrowdAgents, Agents.Num());
+	DEC_DWORD_STAT_BY(STAT_GAM312_CrowdActors, NumPromoted);
+
+	Agents.Reset();
+	NumPromoted = 0;
+	ThinkCursor = 0;
+	NumHarvests = 0;
+	NumMeals = 0;
+	NumDeaths = 0;
+
+	if (Instances)
+	{
+		Instances->ClearInstances();
+	}
+}
+
+void UCrowdSimSubsystem::RemoveAgent(int32 Index)
+{
+	if (APawn* Pawn = Agents.Actor[Index].Get())
+	{
+		Pawn->Destroy();
+		--NumPromoted;
+		DEC_DWORD_STAT(STAT_GAM312_CrowdActors);
+	}
+
+	if (Agents.PlanHandle[Index] != INDEX_NONE)
+	{
+		if (UResourcePlannerSubsystem* Planner = GetWorld()->GetSubsystem<UResourcePlannerSubsystem>())
+		{
+			Planner->CancelPlan(Agents.PlanHandle[Index]);
+		}
+	}
+
+	Agents.RemoveAtSwap(Index);
+	DEC_DWORD_STAT(STAT_GAM312_CrowdAgents);
+}
+
+void UCrowdSimSubsystem::Think(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_GAM312_CrowdThink);
+
+	const int32 NumAgents = Agents.Num();
+	if (NumAgents == 0)
+	{
+		return;
+	}
+
+	// Every agent thinks once per interval, spread evenly over the frames
+	const int32 SliceSize = FMath::Clamp(FMath::CeilToInt32(NumAgents * DeltaTime / CrowdSim::ThinkInterval), 1, NumAgents);
+
+	UResourcePlannerSubsystem* Planner = GetWorld()->GetSubsystem<UResourcePlannerSubsystem>();
+	if (!Planner)
+	{
+		return;
+	}
+
+	// Collect answers first so agents whose plan failed can ask again in this slice
+	for (int32 Index = 0; Index < NumAgents; ++Index)
+	{
+		if (Agents.State[Index] != ECrowdAgentState::Planning)
+		{
+			continue;
+		}
+
+		FResourcePlan Plan;
+		if (!Planner->TakePlan(Agents.PlanHandle[Index], Plan))
+		{
+			continue;
+		}
+
+		Agents.PlanHandle[Index] = INDEX_NONE;
+		AResource_M* Node = Plan.Node.Get();
+		if (Plan.Status == EResourcePlanStatus::Succeeded && Node && !Node->IsDepleted())
+		{
+			Agents.State[Index] = ECrowdAgentState::Moving;
+			Agents.TargetNode[Index] = Node;
+			Agents.Goal[Index] = Node->GetActorLocation();
+		}
+		else
+		{
+			Agents.State[Index] = ECrowdAgentState::Idle;
+		}
+	}
+
+	for (int32 Step = 0; Step < SliceSize; ++Step)
+	{
+		const int32 Index = ThinkCursor++ % NumAgents;
+		if (Agents.State[Index] != ECrowdAgentState::Idle)
+		{
+			continue;
+		}
+
+		float& Hunger = Agents.Stats.Hunger[Index];
+		const bool bHungry = Hunger < CrowdSim::HungryBelow;
+		if (bHungry && Agents.Berries[Index] > 0)
+		{
+			--Agents.Berries[Index];
+			if (Hunger + CrowdSim::HungerPerBerry < CrowdSim::StatCap)
+			{
+				Hunger += CrowdSim::HungerPerBerry;
+			}
+			++NumMeals;
+			continue;
+		}
+
+		// Rest until harvesting is possible again
+		if (Agents.Stats.Stamina[Index] <= CrowdSim::HarvestMinStamina)
+		{
+			continue;
+		}
+
+		// Agents walk straight at their node, so the planner can skip the navmesh
+		FResourcePlanRequest Request;
+		Request.Origin = Agents.Location[Index];
+		Request.Radius = CrowdSim::SearchRadius;
+		Request.ResourceId = bHungry ? BerryId : INDEX_NONE;
+		Request.bFindPath = false;
+		Agents.PlanHandle[Index] = Planner->RequestPlan(Request);
+		Agents.State[Index] = ECrowdAgentState::Planning;
+	}
+	ThinkCursor %= NumAgents;
+}
+
+void UCrowdSimSubsystem::Move(float DeltaTime)
+{
+	const float StepDistance = CrowdSim::WalkSpeed * DeltaTime;
+	const float ReachSq = FMath::Square(CrowdSim::HarvestReach);
+
+	for (int32 Index = 0; Index < Agents.Num(); ++Index)
+	{
+		if (Agents.State[Index] != ECrowdAgentState::Moving)
+		{
+			continue;
+		}
+
+		// Promoted agents walk their actor and follow it
+		APawn* Pawn = Agents.Actor[Index].Get();
+		if (Pawn)
+		{
+			Agents.Location[Index] = Pawn->GetActorLocation();
+		}
+
+		const FVector ToGoal = (Agents.Goal[Index] - Agents.Location[Index]) * FVector(1.0f, 1.0f, 0.0f);
+		const double DistanceSq = ToGoal.SizeSquared();
+		if (DistanceSq <= ReachSq)
+		{
+			Agents.State[Index] = ECrowdAgentState::Harvesting;
+			Agents.HarvestCooldown[Index] = 0.0f;
+			continue;
+		}
+
+		const FVector Direction = ToGoal * FMath::InvSqrt(DistanceSq);
+		if (Pawn)
+		{
+			Pawn->AddMovementInput(Direction, 1.0f);
+		}
+		else
+		{
+			Agents.Location[Index] += Direction * StepDistance;
+		}
+	}
+}
+
+void UCrowdSimSubsystem::Harvest(float DeltaTime)
+{
+	for (int32 Index = 0; Index < Agents.Num(); ++Index)
+	{
+		if (Agents.State[Index] != ECrowdAgentState::Harvesting)
+		{
+			continue;
+		}
+
+		Agents.HarvestCooldown[Index] -= DeltaTime;
+		if (Agents.HarvestCooldown[Index] > 0.0f)
+		{
+			continue;
+		}
+		Agents.HarvestCooldown[Index] = CrowdSim::HarvestInterval;
+
+		// Gone, emptied by someone else, too tired, or not food for a hungry agent: think again
+		AResource_M* Node = Agents.TargetNode[Index].Get();
+		const bool bWantsFood = Agents.Stats.Hunger[Index] < CrowdSim::HungryBelow && Agents.Berries[Index] == 0;
+		if (!Node || Node->IsDepleted() || Agents.Stats.Stamina[Index] <= CrowdSim::HarvestMinStamina
+			|| (bWantsFood && Node->ResourceId != BerryId) || !HarvestNode(Index, Node))
+		{
+			Agents.State[Index] = ECrowdAgentState::Idle;
+			Agents.TargetNode[Index].Reset();
+		}
+	}
+}
+
+bool UCrowdSimSubsystem::HarvestNode(int32 Index, AResource_M* Node)
+{
+	const int32 ResourceValue = Node->resourceAmount;
+	Node->totalResource -= ResourceValue;
+	if (UWorldSaveSubsystem* WorldSave = GetWorld()->GetSubsystem<UWorldSaveSubsystem>())
+	{
+		WorldSave->MarkResourceDirty(Node);
+	}
+
+	if (Node->totalResource >= ResourceValue)
+	{
+		if (Node->ResourceId == BerryId)
+		{
+			Agents.Berries[Index] += ResourceValue;
+		}
+		Agents.Stats.Stamina[Index] -= CrowdSim::HarvestStaminaCost;
+		++NumHarvests;
+		return true;
+	}
+
+	// Used up: hide it until it regrows
+	if (UResourceLifecycleSubsystem* Lifecycle = GetWorld()->GetSubsystem<UResourceLifecycleSubsystem>())
+	{
+		Lifecycle->DepleteNode(Node);
+	}
+	else
+	{
+		Node->Destroy();
+	}
+	return false;
+}
+
+void UCrowdSimSubsystem::StepStats()
+{
+	Agents.Stats.Step();
+
+	// Agents starve to death rather than sit at negative health
+	for (int32 Index = Agents.Num() - 1; Index >= 0; --Index)
+	{
+		if (Agents.Stats.Health[Index] <= 0.0f)
+		{
+			RemoveAgent(Index);
+			++NumDeaths;
+		}
+	}
+}
+
+void UCrowdSimSubsystem::UpdatePromotion()
+{
+	TArray<FVector, TInlineAllocator<8>> PlayerLocations;
+	for (FConstPlayerControllerIterator Iterator = GetWorld()->GetPlayerControllerIterator(); Iterator; ++Iterator)
+	{
+		const APlayerController* Controller = Iterator->Get();
+		if (Controller && Controller->GetPawn())
+		{
+			PlayerLocations.Add(Controller->GetPawn()->GetActorLocation());
+		}
+	}
+
+	const float PromoteDistance = CVarCrowdPromoteDistance.GetValueOnGameThread();
+	const double PromoteSq = FMath::Square(PromoteDistance);
+	const double DemoteSq = FMath::Square(PromoteDistance * 1.25f);
+	const int32 MaxActors = AgentClass ? CVarCrowdMaxActors.GetValueOnGameThread() : 0;
+
+	for (int32 Index = 0; Index < Agents.Num(); ++Index)
+	{
+		double NearestSq = TNumericLimits<double>::Max();
+		for (const FVector& Location : PlayerLocations)
+		{
+			NearestSq = FMath::Min(NearestSq, FVector::DistSquared(Location, Agents.Location[Index]));
+		}
+
+		const bool bPromoted = Agents.Actor[Index].IsValid();
+		if (!bPromoted && NearestSq < PromoteSq && NumPromoted < MaxActors)
+		{
+			Promote(Index);
+		}
+		else if (bPromoted && (NearestSq > DemoteSq || NumPromoted > MaxActors))
+		{
+			Demote(Index);
+		}
+	}
+}
+
+void UCrowdSimSubsystem::Promote(int32 Index)
+{
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+
+	const FVector ToGoal = Agents.Goal[Index] - Agents.Location[Index];
+	const FRotator Facing(0.0f, ToGoal.IsNearlyZero() ? Random.FRandRange(0.0f, 360.0f) : ToGoal.Rotation().Yaw, 0.0f);
+
+	APawn* Pawn = GetWorld()->SpawnActor<APawn>(AgentClass, Agents.Location[Index], Facing, SpawnParams);
+	if (!Pawn)
+	{
+		return;
+	}
+
+	// Walks by movement input from Move; the controller only has to possess it
+	if (!Pawn->GetController())
+	{
+		Pawn->SpawnDefaultController();
+	}
+
+	Agents.Actor[Index] = Pawn;
+	++NumPromoted;
+	INC_DWORD_STAT(STAT_GAM312_CrowdActors);
+}
+
+void UCrowdSimSubsystem::Demote(int32 Index)
+{
+	APawn* Pawn = Agents.Actor[Index].Get();
+	Agents.Location[Index] = Pawn->GetActorLocation();
+	Agents.Actor[Index].Reset();
+	Pawn->Destroy();
+
+	--NumPromoted;
+	DEC_DWORD_STAT(STAT_GAM312_CrowdActors);
+}
+
+void UCrowdSimSubsystem::UpdateInstances()
+{
+	SCOPE_CYCLE_COUNTER(STAT_GAM312_CrowdInstances);
+
+	if (!CVarCrowdDraw.GetValueOnGameThread() || GetWorld()->GetNetMode() == NM_DedicatedServer)
+	{
+		if (Instances && Instances->GetInstanceCount() > 0)
+		{
+			Instances->ClearInstances();
+		}
+		return;
+	}
+
+	if (!Instances)
+	{
+		UStaticMesh* Mesh = LoadObject<UStaticMesh>(nullptr, CrowdSim::AgentMesh);
+		if (!Mesh)
+		{
+			return;
+		}
+
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.Name = TEXT("CrowdAgents");
+		SpawnParams.NameMode = FActorSpawnParameters::ESpawnActorNameMode::Requested;
+		SpawnParams.ObjectFlags |= RF_Transient;
+
+		InstanceOwner = GetWorld()->SpawnActor<AActor>(AActor::StaticClass(), FTransform::Identity, SpawnParams);
+		if (!InstanceOwner)
+		{
+			return;
+		}
+
+		Instances = NewObject<UInstancedStaticMeshComponent>(InstanceOwner);
+		Instances->SetMobility(EComponentMobility::Movable);
+		Instances->SetStaticMesh(Mesh);
+		Instances->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+		Instances->SetCastShadow(false);
+		InstanceOwner->SetRootComponent(Instances);
+		Instances->RegisterComponent();
+	}
+
+	// One instance per agent slot; promoted agents collapse theirs while the actor stands in
+	const FTransform Collapsed(FQuat::Identity, FVector::ZeroVector, FVector::ZeroVector);
+	InstanceTransforms.Reset(Agents.Num());
+	for (int32 Index = 0; Index < Agents.Num(); ++Index)
+	{
+		InstanceTransforms.Add(Agents.Actor[Index].IsValid() ? Collapsed : FTransform(FQuat::Identity, Agents.Location[Index], CrowdSim::AgentMeshScale));
+	}
+
+	const int32 NumInstances = Instances->GetInstanceCount();
+	if (NumInstances > Agents.Num())
+	{
+		TArray<int32> Removed;
+		for (int32 Index = Agents.Num(); Index < NumInstances; ++Index)
+		{
+			Removed.Add(Index);
+		}
+		Instances->RemoveInstances(Removed);
+	}
+	else if (NumInstances < Agents.Num())
+	{
+		Instances->AddInstances(TArray<FTransform>(InstanceTransforms.GetData() + NumInstances, Agents.Num() - NumInstances), false, true);
+	}
+
+	if (InstanceTransforms.Num() > 0)
+	{
+		Instances->BatchUpdateInstancesTransforms(0, InstanceTransforms, true, true, true);
+	}
+}
+
+/** ---------- Benchmark ---------- **/
+
+void UCrowdSimSubsystem::StartBenchmark(const FVector& Center)
+{
+	BenchCenter = Center;
+	BenchStage = 0;
+	BenchFramesLeft = 0;
+
+	UE_LOG(LogGAM312, Display, TEXT("[CrowdBench] Starting around (%.0f, %.0f)"), Center.X, Center.Y);
+}
+
+void UCrowdSimSubsystem::TickBenchmark()
+{
+	if (BenchStage == INDEX_NONE)
+	{
+		return;
+	}
+
+	const double Now = FPlatformTime::Seconds();
+	const double FrameMs = (Now - BenchLastFrameTime) * 1000.0;
+	BenchLastFrameTime = Now;
+
+	// Start the next stage with a fresh crowd
+	if (BenchFramesLeft == 0)
+	{
+		ClearAgents();
+		SpawnAgents(CrowdBenchmark::AgentCounts[BenchStage], BenchCenter, CrowdBenchmark::SpawnRadius);
+
+		BenchFramesLeft = CrowdBenchmark::WarmupFrames + CrowdBenchmark::SampleFrames;
+		BenchFrameCount = 0;
+		BenchFrameTimeSum = 0.0;
+		BenchFrameTimeMax = 0.0;
+		BenchSimTimeSum = 0.0;
+		return;
+	}
+
+	if (BenchFramesLeft-- <= CrowdBenchmark::SampleFrames)
+	{
+		++BenchFrameCount;
+		BenchFrameTimeSum += FrameMs;
+		BenchFrameTimeMax = FMath::Max(BenchFrameTimeMax, FrameMs);
+		BenchSimTimeSum += LastSimSeconds * 1000.0;
+	}
+
+	if (BenchFramesLeft > 0)
+	{
+		return;
+	}
+
+	UE_LOG(LogGAM312, Display, TEXT("[CrowdBench] %5d agents: frame avg %.2f ms, max %.2f ms, crowd avg %.3f ms | %d alive, %d actors, %d harvests, %d meals, %d starved"),
+		CrowdBenchmark::AgentCounts[BenchStage],
+		BenchFrameTimeSum / FMath::Max(BenchFrameCount, 1),
+		BenchFrameTimeMax,
+		BenchSimTimeSum / FMath::Max(BenchFrameCount, 1),
+		Agents.Num(), NumPromoted, NumHarvests, NumMeals, NumDeaths);
+
+	if (++BenchStage >= static_cast<int32>(UE_ARRAY_COUNT(CrowdBenchmark::AgentCounts)))
+	{
+		BenchStage = INDEX_NONE;
+		ClearAgents();
+		UE_LOG(LogGAM312, Display, TEXT("[CrowdBench] Done"));
+	}
+}
+
+// Around the local player, or the world origin without one
+static FVector GetCrowdCenter(UWorld* World)
+{
+	const APlayerController* Controller = World->GetFirstPlayerController();
+	return Controller && Controller->GetPawn() ? Controller->GetPawn()->GetActorLocation() : FVector::ZeroVector;
+}
+
+static FAutoConsoleCommandWithWorldAndArgs GCrowdSpawnCommand(
+	TEXT("gam312.Crowd.Spawn"),
+	TEXT("Spawns crowd agents around the local player. Args: count (default 1000), radius (default 20000), promoted actor class path."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		UCrowdSimSubsystem* Crowd = World ? World->GetSubsystem<UCrowdSimSubsystem>() : nullptr;
+		if (!Crowd)
+		{
+			return;
+		}
+
+		if (Args.Num() > 2)
+		{
+			UClass* AgentClass = LoadClass<APawn>(nullptr, *Args[2]);
+			if (!AgentClass)
+			{
+				UE_LOG(LogGAM312, Warning, TEXT("[Crowd] Could not load agent class %s"), *Args[2]);
+				return;
+			}
+			Crowd->SetAgentClass(AgentClass);
+		}
+
+		Crowd->SpawnAgents(
+			Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 1000,
+			GetCrowdCenter(World),
+			Args.Num() > 1 ? FCString::Atof(*Args[1]) : CrowdBenchmark::SpawnRadius);
+	}));
+
+static FAutoConsoleCommandWithWorld GCrowdClearCommand(
+	TEXT("gam312.Crowd.Clear"),
+	TEXT("Removes every crowd agent."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (UCrowdSimSubsystem* Crowd = World ? World->GetSubsystem<UCrowdSimSubsystem>() : nullptr)
+		{
+			Crowd->ClearAgents();
+		}
+	}));
+
+static FAutoConsoleCommandWithWorld GCrowdBenchmarkCommand(
+	TEXT("gam312.Crowd.Benchmark"),
+	TEXT("Runs the crowd at 100, 1k and 5k agents around the local player and logs frame time for each."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (UCrowdSimSubsystem* Crowd = World ? World->GetSubsystem<UCrowdSimSubsystem>() : nullptr)
+		{
+			Crowd->StartBenchmark(GetCrowdCenter(World));
+		}
+	}));
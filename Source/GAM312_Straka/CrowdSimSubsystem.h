@@ -0,0 +1,171 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "SurvivalStatsSubsystem.h"
+#include "CrowdSimSubsystem.generated.h"
+
+class AResource_M;
+class UInstancedStaticMeshComponent;
+
+/**
+ * ECrowdAgentState
+ */
+enum class ECrowdAgentState : uint8
+{
+	// Waiting for its next think to pick a node (or resting until stamina is back)
+	Idle,
+	// Waiting for the resource planner to answer
+	Planning,
+	// Walking to its target node
+	Moving,
+	// At its target node, swinging once per harvest interval
+	Harvesting,
+};
+
+/**
+ * FCrowdAgentFragments
+ *
+ * Every crowd agent's data, one array per field, all indexed by agent slot. Each pass
+ * only walks the arrays it needs (movement reads State, Location and Goal; the survival
+ * step reads Stats) instead of whole agent objects. Removing an agent swaps the last one in.
+ */
+struct GAM312_STRAKA_API FCrowdAgentFragments
+{
+	// Adds an agent and returns its slot
+	int32 Add(const FVector& InLocation, float InHealth, float InHunger, float InStamina);
+
+	// Moves the last agent into Index
+	void RemoveAtSwap(int32 Index);
+
+	void Reset();
+
+	int32 Num() const { return Location.Num(); }
+
+	TArray<FVector> Location;
+	TArray<FVector> Goal;
+	TArray<ECrowdAgentState> State;
+	TArray<TWeakObjectPtr<AResource_M>> TargetNode;
+
+	// UResourcePlannerSubsystem request of a planning agent
+	TArray<int32> PlanHandle;
+
+	// Seconds until the next harvest swing
+	TArray<float> HarvestCooldown;
+
+	// Berries carried, eaten once hungry
+	TArray<int32> Berries;
+
+	// Full actor standing in for the agent while a player is near (null otherwise)
+	TArray<TWeakObjectPtr<APawn>> Actor;
+
+	// Health, hunger and stamina, stepped with the same logic as AMyCharacter::DecreaseStats
+	FSurvivorStatArrays Stats;
+};
+
+/**
+ * UCrowdSimSubsystem
+ *
+ * Simulates survivors and wildlife as lightweight agents instead of one ACharacter and
+ * AI controller each. Agents think in slices spread over several frames: a hungry agent
+ * eats a carried Berry, otherwise it asks UResourcePlannerSubsystem for the nearest
+ * AResource_M (a Berry bush when hungry), walks to it in a straight line and harvests it
+ * with the player's rules (resourceAmount per swing, stamina cost, depletion through
+ * UResourceLifecycleSubsystem). Survival stats advance with
+ * FSurvivorStatArrays at the player's rate; agents that starve to death are removed.
+ *
+ * Agents are drawn as one instanced mesh. Agents within gam312.Crowd.PromoteDistance of
+ * a player are promoted to a full actor (up to gam312.Crowd.MaxActors) that walks under
+ * the crowd's control, and demoted back once the player leaves. Only the server simulates.
+ */
+UCLASS()
+class GAM312_STRAKA_API UCrowdSimSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+
+	// Adds Count agents scattered within Radius of Center
+	void SpawnAgents(int32 Count, const FVector& Center, float Radius);
+
+	// Removes every agent and its promoted actor
+	void ClearAgents();
+
+	int32 GetNumAgents() const { return Agents.Num(); }
+	int32 GetNumPromoted() const { return NumPromoted; }
+
+	// Actor class agents are promoted to
+	void SetAgentClass(TSubclassOf<APawn> InAgentClass) { AgentClass = InAgentClass; }
+
+	// Runs the crowd at 100, 1k and 5k agents around Center, logging frame and simulation time for each
+	void StartBenchmark(const FVector& Center);
+
+private:
+	// Eats or asks for a target for the next slice of idle agents, and collects the planner's answers
+	void Think(float DeltaTime);
+	void Move(float DeltaTime);
+	void Harvest(float DeltaTime);
+
+	// One DecreaseStats for every agent; removes the ones that starved
+	void StepStats();
+
+	void UpdatePromotion();
+	void Promote(int32 Index);
+	void Demote(int32 Index);
+
+	void RemoveAgent(int32 Index);
+
+	// One swing at Node, as AMyCharacter::HarvestAlong. Returns false once the node is used up.
+	bool HarvestNode(int32 Index, AResource_M* Node);
+
+	void UpdateInstances();
+
+	// Advances the benchmark state machine by one frame
+	void TickBenchmark();
+
+	FCrowdAgentFragments Agents;
+
+	UPROPERTY()
+	TSubclassOf<APawn> AgentClass;
+
+	// Transient actor owning the instanced agent mesh
+	UPROPERTY()
+	TObjectPtr<AActor> InstanceOwner;
+
+	UPROPERTY()
+	TObjectPtr<UInstancedStaticMeshComponent> Instances;
+
+	// Reused every frame for the instance transforms
+	TArray<FTransform> InstanceTransforms;
+
+	int32 BerryId = INDEX_NONE;
+	int32 ThinkCursor = 0;
+	float TimeSinceStep = 0.0f;
+	float TimeSincePromotion = 0.0f;
+	int32 NumPromoted = 0;
+	FRandomStream Random;
+
+	// Totals since the agents were spawned, for the benchmark
+	int32 NumHarvests = 0;
+	int32 NumMeals = 0;
+	int32 NumDeaths = 0;
+
+	// Seconds spent in the last Tick
+	double LastSimSeconds = 0.0;
+
+	/** ---------- Benchmark State ---------- **/
+
+	int32 BenchStage = INDEX_NONE;
+	int32 BenchFramesLeft = 0;
+	int32 BenchFrameCount = 0;
+	double BenchFrameTimeSum = 0.0;
+	double BenchFrameTimeMax = 0.0;
+	double BenchSimTimeSum = 0.0;
+	double BenchLastFrameTime = 0.0;
+	FVector BenchCenter = FVector::ZeroVector;
+};
@@ -0,0 +1,182 @@
+#include "GAM312ReplicationGraph.h"
+#include "GAM312_Straka.h"
+#include "BuildingReplicator.h"
+#include "Resource_M.h"
+#include "Engine/NetDriver.h"
+#include "GameFramework/Info.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+#include "UObject/UObjectIterator.h"
+
+DECLARE_CYCLE_STAT(TEXT("Replicate Actors"), STAT_GAM312_ReplicateActors, STATGROUP_GAM312);
+
+static TAutoConsoleVariable<float> CVarRepGraphCellSize(
+	TEXT("gam312.Net.GridCellSize"),
+	10000.0f,
+	TEXT("Cell size of the replication graph's spatial grid. Read when the net driver starts."));
+
+void UGAM312ReplicationGraph::InitGlobalActorClassSettings()
+{
+	Super::InitGlobalActorClassSettings();
+
+	const float NetServerMaxTickRate = FMath::Max(static_cast<float>(NetDriver->NetServerMaxTickRate), 1.0f);
+
+	for (TObjectIterator<UClass> It; It; ++It)
+	{
+		UClass* Class = *It;
+		const AActor* ActorCDO = Cast<AActor>(Class->GetDefaultObject());
+		if (!ActorCDO || !ActorCDO->GetIsReplicated())
+		{
+			continue;
+		}
+
+		// Blueprint compilation leftovers never spawn
+		if (Class->GetName().StartsWith(TEXT("SKEL_")) || Class->GetName().StartsWith(TEXT("REINST_")))
+		{
+			continue;
+		}
+
+		const EGAM312RepNodeMapping Mapping = GetMappingPolicy(Class);
+		ClassRepNodePolicies.Set(Class, Mapping);
+
+		// Spatialized classes are culled by their own NetCullDistance; the rest replicate at their NetUpdateFrequency
+		FClassReplicationInfo ClassInfo;
+		if (Mapping >= EGAM312RepNodeMapping::SpatializeStatic)
+		{
+			ClassInfo.SetCullDistanceSquared(ActorCDO->NetCullDistanceSquared);
+		}
+		ClassInfo.ReplicationPeriodFrame = static_cast<uint16>(FMath::Clamp(FMath::RoundToInt(NetServerMaxTickRate / FMath::Max(ActorCDO->NetUpdateFrequency, 0.01f)), 1, MAX_uint16));
+		GlobalActorReplicationInfoMap.SetClassInfo(Class, ClassInfo);
+	}
+}
+
+// Our own classes first, then engine defaults by role
+EGAM312RepNodeMapping UGAM312ReplicationGraph::GetMappingPolicy(const UClass* Class) const
+{
+	const AActor* ActorCDO = Class->GetDefaultObject<AActor>();
+
+	if (Class->IsChildOf(ABuildingReplicator::StaticClass()))
+	{
+		return EGAM312RepNodeMapping::SpatializeStatic;
+	}
+	if (Class->IsChildOf(AResource_M::StaticClass()))
+	{
+		return EGAM312RepNodeMapping::SpatializeDormancy;
+	}
+	if (Class->IsChildOf(APlayerController::StaticClass()) || ActorCDO->bOnlyRelevantToOwner)
+	{
+		return EGAM312RepNodeMapping::NotRouted;
+	}
+	if (ActorCDO->bAlwaysRelevant || Class->IsChildOf(AInfo::StaticClass()))
+	{
+		return EGAM312RepNodeMapping::RelevantAllConnections;
+	}
+	if (Class->IsChildOf(APawn::StaticClass()))
+	{
+		return EGAM312RepNodeMapping::SpatializeDynamic;
+	}
+
+	// Anything else might move, so it is re-gridded every frame
+	return ActorCDO->NetDormancy > DORM_Awake ? EGAM312RepNodeMapping::SpatializeDormancy : EGAM312RepNodeMapping::SpatializeDynamic;
+}
+
+void UGAM312ReplicationGraph::InitGlobalGraphNodes()
+{
+	Super::InitGlobalGraphNodes();
+
+	GridNode = CreateNewNode<UReplicationGraphNode_GridSpatialization2D>();
+	GridNode->CellSize = FMath::Max(CVarRepGraphCellSize.GetValueOnGameThread(), 1000.0f);
+	GridNode->SpatialBias = FVector2D(-UE_OLD_WORLD_MAX, -UE_OLD_WORLD_MAX);
+	AddGlobalGraphNode(GridNode);
+
+	AlwaysRelevantNode = CreateNewNode<UReplicationGraphNode_ActorList>();
+	AddGlobalGraphNode(AlwaysRelevantNode);
+}
+
+// Each connection always gets its own controller, pawn and view target
+void UGAM312ReplicationGraph::InitConnectionGraphNodes(UNetReplicationGraphConnection* RepGraphConnection)
+{
+	Super::InitConnectionGraphNodes(RepGraphConnection);
+
+	UReplicationGraphNode_AlwaysRelevant_ForConnection* ConnectionNode = CreateNewNode<UReplicationGraphNode_AlwaysRelevant_ForConnection>();
+	AddConnectionGraphNode(ConnectionNode, RepGraphConnection);
+}
+
+void UGAM312ReplicationGraph::RouteAddNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo)
+{
+	const EGAM312RepNodeMapping* Policy = ClassRepNodePolicies.Get(ActorInfo.Class);
+	switch (Policy ? *Policy : EGAM312RepNodeMapping::NotRouted)
+	{
+	case EGAM312RepNodeMapping::RelevantAllConnections:
+		AlwaysRelevantNode->NotifyAddNetworkActor(ActorInfo);
+		break;
+
+	case EGAM312RepNodeMapping::SpatializeStatic:
+		GridNode->AddActor_Static(ActorInfo, GlobalInfo);
+		break;
+
+	case EGAM312RepNodeMapping::SpatializeDynamic:
+		GridNode->AddActor_Dynamic(ActorInfo, GlobalInfo);
+		break;
+
+	case EGAM312RepNodeMapping::SpatializeDormancy:
+		GridNode->AddActor_Dormancy(ActorInfo, GlobalInfo);
+		break;
+
+	default:
+		break;
+	}
+}
+
+void UGAM312ReplicationGraph::RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo)
+{
+	const EGAM312RepNodeMapping* Policy = ClassRepNodePolicies.Get(ActorInfo.Class);
+	switch (Policy ? *Policy : EGAM312RepNodeMapping::NotRouted)
+	{
+	case EGAM312RepNodeMapping::RelevantAllConnections:
+		AlwaysRelevantNode->NotifyRemoveNetworkActor(ActorInfo);
+		break;
+
+	case EGAM312RepNodeMapping::SpatializeStatic:
+		GridNode->RemoveActor_Static(ActorInfo);
+		break;
+
+	case EGAM312RepNodeMapping::SpatializeDynamic:
+		GridNode->RemoveActor_Dynamic(ActorInfo);
+		break;
+
+	case EGAM312RepNodeMapping::SpatializeDormancy:
+		GridNode->RemoveActor_Dormancy(ActorInfo);
+		break;
+
+	default:
+		break;
+	}
+}
+
+int32 UGAM312ReplicationGraph::ServerReplicateActors(float DeltaSeconds)
+{
+	SCOPE_CYCLE_COUNTER(STAT_GAM312_ReplicateActors);
+
+	const double StartTime = FPlatformTime::Seconds();
+	const int32 Result = Super::ServerReplicateActors(DeltaSeconds);
+
+	if (bCapturingTimings)
+	{
+		CapturedTimings.Add(FPlatformTime::Seconds() - StartTime);
+	}
+	return Result;
+}
+
+void UGAM312ReplicationGraph::BeginTimingCapture()
+{
+	CapturedTimings.Reset();
+	bCapturingTimings = true;
+}
+
+TArray<double> UGAM312ReplicationGraph::EndTimingCapture()
+{
+	bCapturingTimings = false;
+	return MoveTemp(CapturedTimings);
+}
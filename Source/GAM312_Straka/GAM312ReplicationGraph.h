@@ -0,0 +1,77 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ReplicationGraph.h"
+#include "GAM312ReplicationGraph.generated.h"
+
+/**
+ * EGAM312RepNodeMapping
+ *
+ * Which graph node a replicated class is routed to.
+ */
+enum class EGAM312RepNodeMapping : uint8
+{
+	// Not routed globally: player controllers are picked up by each connection's own node
+	NotRouted,
+	// Sent to every connection (game state, player states, other always-relevant actors)
+	RelevantAllConnections,
+	// Spatialized once and never moves: building grid cells
+	SpatializeStatic,
+	// Spatialized and re-gridded every frame: characters and other movers
+	SpatializeDynamic,
+	// Spatialized, treated as static while dormant: resource nodes
+	SpatializeDormancy
+};
+
+/**
+ * UGAM312ReplicationGraph
+ *
+ * Replication graph for this game, enabled as the IpNetDriver's replication driver in
+ * DefaultEngine.ini. The world is cut into a 2D grid: each connection only considers
+ * the actors in the cells around its viewer instead of every replicated actor.
+ *
+ *   ABuildingReplicator  static grid actor (one per building cell, never moves)
+ *   AResource_M          dormancy-aware grid actor (wakes only when depleted or regrown)
+ *   APawn                dynamic grid actor
+ *   AInfo / always-relevant actors go to a global list; each connection's own
+ *   controller, pawn and view target come from a per-connection node.
+ *
+ * Server time spent replicating is reported by "stat GAM312" and can be captured for
+ * benchmarks (UNetLoopbackTestSubsystem).
+ */
+UCLASS(Transient)
+class GAM312_STRAKA_API UGAM312ReplicationGraph : public UReplicationGraph
+{
+	GENERATED_BODY()
+
+public:
+	virtual void InitGlobalActorClassSettings() override;
+	virtual void InitGlobalGraphNodes() override;
+	virtual void InitConnectionGraphNodes(UNetReplicationGraphConnection* RepGraphConnection) override;
+	virtual void RouteAddNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo) override;
+	virtual void RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo) override;
+
+	// Times every replication pass
+	virtual int32 ServerReplicateActors(float DeltaSeconds) override;
+
+	// Starts recording the duration of every replication pass (seconds)
+	void BeginTimingCapture();
+
+	// Stops recording and returns what was captured
+	TArray<double> EndTimingCapture();
+
+	UPROPERTY()
+	TObjectPtr<UReplicationGraphNode_GridSpatialization2D> GridNode;
+
+	UPROPERTY()
+	TObjectPtr<UReplicationGraphNode_ActorList> AlwaysRelevantNode;
+
+private:
+	EGAM312RepNodeMapping GetMappingPolicy(const UClass* Class) const;
+
+	// Routing per class; lookups walk up to the nearest routed parent
+	TClassMap<EGAM312RepNodeMapping> ClassRepNodePolicies;
+
+	bool bCapturingTimings = false;
+	TArray<double> CapturedTimings;
+};
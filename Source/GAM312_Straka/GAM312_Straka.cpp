@@ -3,4 +3,24 @@
 #include "GAM312_Straka.h"
 #include "Modules/ModuleManager.h"
 
+DEFINE_LOG_CATEGORY(LogGAM312);
+
+UE_TRACE_CHANNEL_DEFINE(GAM312Channel);
+
+DEFINE_STAT(STAT_GAM312_Traces);
+DEFINE_STAT(STAT_GAM312_Spawns);
+DEFINE_STAT(STAT_GAM312_Destroys);
+DEFINE_STAT(STAT_GAM312_UIEvents);
+
+FGameplayScopeStat* FGameplayScopeStat::First = nullptr;
+bool FGameplayScopeStat::bCapturing = false;
+int32 FGameplayScopeStat::FrameCounts[static_cast<int32>(EGameplayCounter::Num)] = {};
+
+FGameplayScopeStat::FGameplayScopeStat(const TCHAR* InName)
+	: Name(InName)
+	, Next(First)
+{
+	First = this;
+}
+
 IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, GAM312_Straka, "GAM312_Straka" );
@@ -3,4 +3,101 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "Trace/Trace.h"
 
+// Log category for gameplay code in this module
+DECLARE_LOG_CATEGORY_EXTERN(LogGAM312, Log, All);
+
+// Stat group for gameplay code in this module ("stat GAM312" in the console)
+DECLARE_STATS_GROUP(TEXT("GAM312"), STATGROUP_GAM312, STATCAT_Advanced);
+
+// Insights channel for gameplay scopes ("-trace=cpu,GAM312" on the command line, or "trace.enable GAM312")
+UE_TRACE_CHANNEL_EXTERN(GAM312Channel, GAM312_STRAKA_API);
+
+// Gameplay events per frame, all actors included for spawns and destroys
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Traces"), STAT_GAM312_Traces, STATGROUP_GAM312, GAM312_STRAKA_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Spawns"), STAT_GAM312_Spawns, STATGROUP_GAM312, GAM312_STRAKA_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Destroys"), STAT_GAM312_Destroys, STATGROUP_GAM312, GAM312_STRAKA_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("UI Events"), STAT_GAM312_UIEvents, STATGROUP_GAM312, GAM312_STRAKA_API);
+
+/**
+ * EGameplayCounter
+ */
+enum class EGameplayCounter : uint8
+{
+	Traces,
+	Spawns,
+	Destroys,
+	UIEvents,
+	Num,
+};
+
+/**
+ * FGameplayScopeStat
+ *
+ * Time and calls of one GAM312_SCOPE for the current frame, collected by
+ * UGameplayProfilerSubsystem while it captures. Every scope links itself into one list
+ * the first time it runs. Game thread only.
+ */
+struct GAM312_STRAKA_API FGameplayScopeStat
+{
+	explicit FGameplayScopeStat(const TCHAR* InName);
+
+	const TCHAR* Name;
+	FGameplayScopeStat* Next = nullptr;
+
+	uint64 FrameCycles = 0;
+	int32 FrameCalls = 0;
+
+	// Head of the list of every scope that has run
+	static FGameplayScopeStat* First;
+
+	// Scopes and counters only record while a capture runs
+	static bool bCapturing;
+
+	static int32 FrameCounts[static_cast<int32>(EGameplayCounter::Num)];
+};
+
+struct FGameplayScopeTimer
+{
+	explicit FGameplayScopeTimer(FGameplayScopeStat& InStat)
+		: Stat(FGameplayScopeStat::bCapturing ? &InStat : nullptr)
+		, StartCycles(Stat ? FPlatformTime::Cycles64() : 0)
+	{
+	}
+
+	~FGameplayScopeTimer()
+	{
+		if (Stat)
+		{
+			Stat->FrameCycles += FPlatformTime::Cycles64() - StartCycles;
+			++Stat->FrameCalls;
+		}
+	}
+
+private:
+	FGameplayScopeStat* Stat;
+	uint64 StartCycles;
+};
+
+// Times a gameplay entry point in "stat GAM312", on the GAM312 trace channel and in gam312.Profile.Capture
+#define GAM312_SCOPE(Class, Function) \
+	DECLARE_SCOPE_CYCLE_COUNTER(TEXT(#Class) TEXT("::") TEXT(#Function), STAT_GAM312_##Class##_##Function, STATGROUP_GAM312); \
+	TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL_STR(#Class "::" #Function, GAM312Channel); \
+	static FGameplayScopeStat GAM312ScopeStat_##Function(TEXT(#Class) TEXT("::") TEXT(#Function)); \
+	FGameplayScopeTimer GAM312ScopeTimer_##Function(GAM312ScopeStat_##Function)
+
+// Counts gameplay events (Traces, Spawns, Destroys or UIEvents) for this frame
+#define GAM312_COUNT_BY(Counter, Amount) \
+	do \
+	{ \
+		INC_DWORD_STAT_BY(STAT_GAM312_##Counter, Amount); \
+		if (FGameplayScopeStat::bCapturing) \
+		{ \
+			FGameplayScopeStat::FrameCounts[static_cast<int32>(EGameplayCounter::Counter)] += Amount; \
+		} \
+	} while (0)
+
+#define GAM312_COUNT(Counter) GAM312_COUNT_BY(Counter, 1)
@@ -0,0 +1,628 @@
+#include "GameplayBenchmarkCommandlet.h"
+#include "GAM312_Straka.h"
+#include "BuildingManagerSubsystem.h"
+#include "GameplayProfilerSubsystem.h"
+#include "MyCharacter.h"
+#include "ResourceRegistry.h"
+#include "ResourceSpatialSubsystem.h"
+#include "Resource_M.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "Camera/CameraComponent.h"
+#include "Containers/Ticker.h"
+#include "Dom/JsonObject.h"
+#include "Engine/Engine.h"
+#include "Engine/GameInstance.h"
+#include "Engine/World.h"
+#include "HAL/MemoryBase.h"
+#include "Misc/App.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+#include "Tickable.h"
+
+namespace GameplayBenchmark
+{
+	static const TCHAR* DefaultMap = TEXT("/Game/Maps/testMap");
+	static const TCHAR* DefaultCharacterClass = TEXT("/Game/Player/PlayerChar_BP.PlayerChar_BP_C");
+	static const TCHAR* ResourceClasses[] = {
+		TEXT("/Game/Resources/Wood_Resource.Wood_Resource_C"),
+		TEXT("/Game/Resources/Stone_Resource.Stone_Resource_C"),
+		TEXT("/Game/Resources/Berry_Resource.Berry_Resource_C"),
+	};
+
+	// Stations sit on a grid high above the map so they never see or block each other
+	static constexpr float StationSpacing = 3000.0f;
+	static constexpr float StationHeight = 50000.0f;
+
+	// Nodes ring their character at arm's length, centered on the camera's line of sight
+	static constexpr float NodeDistance = 150.0f;
+
+	// Frames in one loop: four harvests, craft, spawn building, rotate, place
+	static constexpr int32 LoopFrames = 8;
+	static constexpr int32 HarvestFrames = 4;
+
+	static constexpr double BytesPerMB = 1024.0 * 1024.0;
+
+	// Paths gated on their time per call: harvesting grants, crafting, traces, interaction,
+	// building previews and the batched survival step (DecreaseStats for every character)
+	static const TCHAR* GatedScopes[] = {
+		TEXT("AMyCharacter::GiveResourceById"),
+		TEXT("AMyCharacter::UpdateResources"),
+		TEXT("AMyCharacter::TraceInteraction"),
+		TEXT("AMyCharacter::FindObject"),
+		TEXT("AMyCharacter::SpawnBuilding"),
+		TEXT("USurvivalStatsSubsystem::Tick"),
+	};
+
+	// A metric regresses once it is this much worse than its baseline
+	static constexpr float DefaultTolerance = 0.2f;
+
+	// Smaller changes never fail the gate, so microsecond noise on cheap paths doesn't either
+	static constexpr double MinRegression = 0.005;
+
+	static double Percentile(const TArray<double>& Sorted, double Fraction)
+	{
+		return Sorted.Num() > 0 ? Sorted[FMath::Clamp(FMath::FloorToInt(Fraction * (Sorted.Num() - 1)), 0, Sorted.Num() - 1)] : 0.0;
+	}
+
+	// Whatever the engine allocator reports about itself; which stats there are depends on the allocator
+	static void SampleAllocatorStats(TMap<FString, uint64>& OutStats)
+	{
+		FGenericMemoryStats Stats;
+		GMalloc->GetAllocatorStats(Stats);
+
+		OutStats.Reset();
+		for (const auto& Pair : Stats.Data)
+		{
+			OutStats.Add(FString(Pair.Key), Pair.Value);
+		}
+	}
+}
+
+UGameplayBenchmarkCommandlet::UGameplayBenchmarkCommandlet()
+{
+	// Uncooked content from the editor build, simulated as a headless server
+	IsClient = false;
+	IsServer = true;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+int32 UGameplayBenchmarkCommandlet::Main(const FString& Params)
+{
+	MapName = GameplayBenchmark::DefaultMap;
+	FString CharacterClassPath = GameplayBenchmark::DefaultCharacterClass;
+	FString ReportPath = FPaths::ProfilingDir() / TEXT("GAM312") / TEXT("GameplayBenchmark.json");
+	FString BuildingParam;
+	FString BaselinePath;
+	float Tolerance = -1.0f;
+	int32 NumCharacters = 8;
+	int32 NumResources = 400;
+	NumFrames = 1800;
+	WarmupFrames = 120;
+	DeltaSeconds = 1.0f / 60.0f;
+
+	FParse::Value(*Params, TEXT("Map="), MapName);
+	FParse::Value(*Params, TEXT("CharacterClass="), CharacterClassPath);
+	FParse::Value(*Params, TEXT("Report="), ReportPath);
+	FParse::Value(*Params, TEXT("Building="), BuildingParam);
+	FParse::Value(*Params, TEXT("Characters="), NumCharacters);
+	FParse::Value(*Params, TEXT("Resources="), NumResources);
+	FParse::Value(*Params, TEXT("Frames="), NumFrames);
+	FParse::Value(*Params, TEXT("Warmup="), WarmupFrames);
+	FParse::Value(*Params, TEXT("DeltaTime="), DeltaSeconds);
+	FParse::Value(*Params, TEXT("Baseline="), BaselinePath);
+	FParse::Value(*Params, TEXT("Tolerance="), Tolerance);
+	const bool bUpdateBaseline = FParse::Param(*Params, TEXT("UpdateBaseline"));
+
+	NumCharacters = FMath::Max(NumCharacters, 1);
+	NumResources = FMath::Max(NumResources, NumCharacters);
+	NumFrames = FMath::Max(NumFrames, 1);
+	WarmupFrames = FMath::Max(WarmupFrames, 1);
+	DeltaSeconds = FMath::Max(DeltaSeconds, UE_KINDA_SMALL_NUMBER);
+
+	UClass* CharacterClass = LoadClass<AMyCharacter>(nullptr, *CharacterClassPath);
+	if (!CharacterClass)
+	{
+		UE_LOG(LogGAM312, Warning, TEXT("[Benchmark] Could not load %s, using AMyCharacter"), *CharacterClassPath);
+		CharacterClass = AMyCharacter::StaticClass();
+	}
+
+	// The loop crafts and places one building type; each loop is granted its recipe
+	const UResourceRegistry& Registry = UResourceRegistry::Get();
+	BuildingId = BuildingParam.IsEmpty() ? (Registry.NumBuildings() > 0 ? 0 : INDEX_NONE) : Registry.FindBuildingId(FName(*BuildingParam));
+	if (BuildingId != INDEX_NONE)
+	{
+		static const FName NAME_Wood(TEXT("Wood"));
+		static const FName NAME_Stone(TEXT("Stone"));
+
+		const FBuildingTypeDef& Building = Registry.Buildings[BuildingId];
+		BuildingName = Building.Name.ToString();
+		for (const FResourceCost& Item : Building.Cost)
+		{
+			WoodCost += Item.Resource == NAME_Wood ? Item.Amount : 0.0f;
+			StoneCost += Item.Resource == NAME_Stone ? Item.Amount : 0.0f;
+		}
+	}
+	else
+	{
+		UE_LOG(LogGAM312, Warning, TEXT("[Benchmark] No building type to craft; the loop only harvests"));
+	}
+
+	UWorld* World = LoadWorld(MapName);
+	if (!World)
+	{
+		return 1;
+	}
+
+	SpawnStations(World, CharacterClass, NumCharacters, NumResources);
+	UE_LOG(LogGAM312, Display, TEXT("[Benchmark] %s: %d characters, %d resource nodes, %d frames after %d warmup frames at %.4f s"),
+		*MapName, Stations.Num(), NumResources, NumFrames, WarmupFrames, DeltaSeconds);
+
+	UGameplayProfilerSubsystem* Profiler = World->GetSubsystem<UGameplayProfilerSubsystem>();
+	for (int32 Frame = 0; Frame < WarmupFrames; ++Frame)
+	{
+		// The capture skips the frame it starts in, so it covers exactly the measured frames
+		if (Frame == WarmupFrames - 1 && Profiler)
+		{
+			Profiler->StartCapture(NumFrames, FPaths::ChangeExtension(ReportPath, TEXT("csv")));
+		}
+		TickFrame(World, DeltaSeconds, Frame);
+	}
+
+	FrameTimes.Reset(NumFrames);
+	StartUsedMemory = FPlatformMemory::GetStats().UsedPhysical;
+	PeakUsedMemory = StartUsedMemory;
+	GameplayBenchmark::SampleAllocatorStats(StartAllocatorStats);
+
+	for (int32 Frame = 0; Frame < NumFrames; ++Frame)
+	{
+		FrameTimes.Add(TickFrame(World, DeltaSeconds, WarmupFrames + Frame));
+		PeakUsedMemory = FMath::Max(PeakUsedMemory, FPlatformMemory::GetStats().UsedPhysical);
+	}
+
+	GameplayBenchmark::SampleAllocatorStats(EndAllocatorStats);
+	EndUsedMemory = FPlatformMemory::GetStats().UsedPhysical;
+
+	TMap<FString, double> Metrics;
+	GatherMetrics(World, Metrics);
+
+	bool bPassed = true;
+	TSharedPtr<FJsonObject> Gate;
+	if (!BaselinePath.IsEmpty())
+	{
+		bPassed = bUpdateBaseline ? WriteBaseline(BaselinePath, Metrics, Tolerance) : CheckBaseline(BaselinePath, Metrics, Tolerance, Gate);
+	}
+
+	const bool bWritten = WriteReport(World, ReportPath, Metrics, Gate);
+
+	GameInstance->Shutdown();
+	GEngine->DestroyWorldContext(World);
+	World->DestroyWorld(false);
+
+	return bWritten && bPassed ? 0 : 1;
+}
+
+UWorld* UGameplayBenchmarkCommandlet::LoadWorld(const FString& InMapName)
+{
+	GameInstance = NewObject<UGameInstance>(GEngine);
+	GameInstance->InitializeStandalone();
+
+	FWorldContext* WorldContext = GameInstance->GetWorldContext();
+	FString Error;
+	if (!GEngine->LoadMap(*WorldContext, FURL(*InMapName), nullptr, Error))
+	{
+		UE_LOG(LogGAM312, Error, TEXT("[Benchmark] Could not load %s: %s"), *InMapName, *Error);
+		return nullptr;
+	}
+
+	return WorldContext->World();
+}
+
+void UGameplayBenchmarkCommandlet::SpawnStations(UWorld* World, UClass* CharacterClass, int32 NumCharacters, int32 NumResources)
+{
+	TArray<UClass*, TInlineAllocator<3>> NodeClasses;
+	for (const TCHAR* ClassPath : GameplayBenchmark::ResourceClasses)
+	{
+		if (UClass* NodeClass = LoadClass<AResource_M>(nullptr, ClassPath))
+		{
+			NodeClasses.Add(NodeClass);
+		}
+	}
+	if (NodeClasses.Num() == 0)
+	{
+		UE_LOG(LogGAM312, Warning, TEXT("[Benchmark] No resource classes found, using AResource_M"));
+		NodeClasses.Add(AResource_M::StaticClass());
+	}
+
+	UResourceSpatialSubsystem* SpatialIndex = World->GetSubsystem<UResourceSpatialSubsystem>();
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	const int32 GridSize = FMath::CeilToInt32(FMath::Sqrt(static_cast<float>(NumCharacters)));
+	Stations.Reset(NumCharacters);
+	for (int32 Index = 0; Index < NumCharacters; ++Index)
+	{
+		const FVector Location(
+			(Index % GridSize) * GameplayBenchmark::StationSpacing,
+			(Index / GridSize) * GameplayBenchmark::StationSpacing,
+			GameplayBenchmark::StationHeight);
+
+		AMyCharacter* Character = World->SpawnActor<AMyCharacter>(CharacterClass, Location, FRotator::ZeroRotator, SpawnParams);
+		if (!Character)
+		{
+			continue;
+		}
+
+		FStation& Station = Stations.AddDefaulted_GetRef();
+		Station.Character = Character;
+
+		// Spread the nodes over the characters, mixing the types so crafts can be paid for
+		const int32 NumNodes = NumResources / NumCharacters + (Index < NumResources % NumCharacters ? 1 : 0);
+		const FVector Eye = Character->PlayerCamComp->GetComponentLocation();
+		for (int32 NodeIndex = 0; NodeIndex < NumNodes; ++NodeIndex)
+		{
+			const float Yaw = 360.0f * NodeIndex / NumNodes;
+			const FVector Target = Eye + FRotator(0.0f, Yaw, 0.0f).Vector() * GameplayBenchmark::NodeDistance;
+
+			AResource_M* Node = World->SpawnActor<AResource_M>(NodeClasses[(Index + NodeIndex) % NodeClasses.Num()], Target, FRotator::ZeroRotator, SpawnParams);
+			if (!Node)
+			{
+				continue;
+			}
+
+			// Center the mesh on the camera's level trace; the spatial index needs the final spot
+			if (SpatialIndex)
+			{
+				SpatialIndex->UnregisterNode(Node);
+			}
+			Node->SetActorLocation(Target - (Node->GetComponentsBoundingBox().GetCenter() - Node->GetActorLocation()));
+			if (SpatialIndex)
+			{
+				SpatialIndex->RegisterNode(Node);
+			}
+
+			Station.Nodes.Add(Node);
+		}
+	}
+}
+
+void UGameplayBenchmarkCommandlet::DriveCharacters(int32 Frame)
+{
+	for (int32 Index = 0; Index < Stations.Num(); ++Index)
+	{
+		FStation& Station = Stations[Index];
+		AMyCharacter* Character = Station.Character.Get();
+		if (!Character)
+		{
+			continue;
+		}
+
+		// Characters are staggered so their crafts and placements land on different frames
+		const int32 Step = (Frame + Index) % GameplayBenchmark::LoopFrames;
+		const int32 Loop = (Frame + Index) / GameplayBenchmark::LoopFrames;
+
+		// Each loop starts rested and fed, with the recipe paid up front, so the measured paths do
+		// real work instead of stopping at the stamina check or an unaffordable craft
+		if (Step == 0)
+		{
+			Character->Stamina = 100.0f;
+			Character->Hunger = 100.0f;
+			Character->MarkStatsDirty(EPlayerStatFlags::Stamina | EPlayerStatFlags::Hunger);
+
+			if (BuildingId != INDEX_NONE)
+			{
+				for (const FResourceCost& Item : UResourceRegistry::Get().Buildings[BuildingId].Cost)
+				{
+					Character->Inventory->GrantResource(Item.ResourceId, Item.Amount);
+				}
+			}
+		}
+
+		if (Step < GameplayBenchmark::HarvestFrames)
+		{
+			// FindObject places instead of harvesting while a part is still being previewed
+			const AResource_M* Node = Station.Nodes.Num() > 0 ? Station.Nodes[(Loop * GameplayBenchmark::HarvestFrames + Step) % Station.Nodes.Num()].Get() : nullptr;
+			if (Node && !Character->isBuilding)
+			{
+				const FVector ToNode = Node->GetActorLocation() - Character->GetActorLocation();
+				Character->SetActorRotation(FRotator(0.0f, ToNode.Rotation().Yaw, 0.0f));
+				Character->FindObject();
+				++NumHarvests;
+			}
+		}
+		else if (BuildingId == INDEX_NONE)
+		{
+			continue;
+		}
+		else if (Step == GameplayBenchmark::HarvestFrames)
+		{
+			// The craft is queued for the end of the frame, but the projected count shows it went through
+			const int32 PiecesBefore = Character->Inventory->GetProjectedBuildingCount(BuildingId);
+			Character->UpdateResources(WoodCost, StoneCost, BuildingName);
+			NumCrafts += Character->Inventory->GetProjectedBuildingCount(BuildingId) > PiecesBefore ? 1 : 0;
+		}
+		else if (Step == GameplayBenchmark::HarvestFrames + 1)
+		{
+			bool bSuccess = false;
+			Character->SpawnBuilding(BuildingId, bSuccess);
+			NumBuildingSpawns += bSuccess ? 1 : 0;
+		}
+		else if (Step == GameplayBenchmark::HarvestFrames + 2)
+		{
+			Character->RotateBuilding();
+			++NumRotations;
+		}
+		else if (Character->isBuilding)
+		{
+			// Stays in build mode while the placement solver reports an overlap
+			Character->FindObject();
+			NumPlacements += Character->isBuilding ? 0 : 1;
+		}
+	}
+}
+
+double UGameplayBenchmarkCommandlet::TickFrame(UWorld* World, float InDeltaSeconds, int32 Frame)
+{
+	const double StartTime = FPlatformTime::Seconds();
+
+	// What FEngineLoop::Tick does around the world tick, minus rendering
+	++GFrameCounter;
+	FApp::SetDeltaTime(InDeltaSeconds);
+	FApp::SetCurrentTime(FApp::GetCurrentTime() + InDeltaSeconds);
+
+	DriveCharacters(Frame);
+
+	World->Tick(LEVELTICK_All, InDeltaSeconds);
+	FTickableGameObject::TickObjects(nullptr, LEVELTICK_All, false, InDeltaSeconds);
+	FTSTicker::GetCoreTicker().Tick(InDeltaSeconds);
+	FTaskGraphInterface::Get().ProcessThreadUntilIdle(ENamedThreads::GameThread);
+	GEngine->ConditionalCollectGarbage();
+
+	return FPlatformTime::Seconds() - StartTime;
+}
+
+void UGameplayBenchmarkCommandlet::GatherMetrics(UWorld* World, TMap<FString, double>& OutMetrics) const
+{
+	TArray<double> Sorted = FrameTimes;
+	Sorted.Sort();
+
+	OutMetrics.Add(TEXT("frameTimeMs.p50"), GameplayBenchmark::Percentile(Sorted, 0.5) * 1000.0);
+	OutMetrics.Add(TEXT("frameTimeMs.p99"), GameplayBenchmark::Percentile(Sorted, 0.99) * 1000.0);
+	OutMetrics.Add(TEXT("memoryGrowthMB"), (static_cast<double>(EndUsedMemory) - static_cast<double>(StartUsedMemory)) / GameplayBenchmark::BytesPerMB);
+
+	const UGameplayProfilerSubsystem* Profiler = World->GetSubsystem<UGameplayProfilerSubsystem>();
+	if (!Profiler)
+	{
+		return;
+	}
+
+	// Paths the loop never reached this run (no building type, say) are left out rather than gated at zero
+	for (const TPair<const FGameplayScopeStat*, FGameplayScopeSummary>& Pair : Profiler->GetScopeSummaries())
+	{
+		for (const TCHAR* ScopeName : GameplayBenchmark::GatedScopes)
+		{
+			if (Pair.Value.Calls > 0 && FCString::Strcmp(Pair.Key->Name, ScopeName) == 0)
+			{
+				OutMetrics.Add(FString(ScopeName) + TEXT(".msPerCall"), FPlatformTime::ToMilliseconds64(Pair.Value.TotalCycles) / Pair.Value.Calls);
+			}
+		}
+	}
+}
+
+bool UGameplayBenchmarkCommandlet::CheckBaseline(const FString& BaselinePath, const TMap<FString, double>& Metrics, float Tolerance, TSharedPtr<FJsonObject>& OutGate) const
+{
+	FString Json;
+	TSharedPtr<FJsonObject> Baseline;
+	if (!FFileHelper::LoadFileToString(Json, *BaselinePath) || !FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(Json), Baseline) || !Baseline)
+	{
+		UE_LOG(LogGAM312, Error, TEXT("[Benchmark] Could not read baseline %s; record one with -UpdateBaseline"), *BaselinePath);
+		return false;
+	}
+
+	// The command line wins over the tolerance recorded with the baseline
+	double BaselineTolerance = GameplayBenchmark::DefaultTolerance;
+	Baseline->TryGetNumberField(TEXT("tolerance"), BaselineTolerance);
+	const double UsedTolerance = Tolerance >= 0.0f ? Tolerance : BaselineTolerance;
+
+	const TSharedPtr<FJsonObject>* BaselineMetrics = nullptr;
+	if (!Baseline->TryGetObjectField(TEXT("metrics"), BaselineMetrics))
+	{
+		UE_LOG(LogGAM312, Error, TEXT("[Benchmark] Baseline %s has no metrics"), *BaselinePath);
+		return false;
+	}
+
+	OutGate = MakeShared<FJsonObject>();
+	OutGate->SetStringField(TEXT("baseline"), BaselinePath);
+	OutGate->SetNumberField(TEXT("tolerance"), UsedTolerance);
+
+	TSharedRef<FJsonObject> Results = MakeShared<FJsonObject>();
+	int32 NumRegressions = 0;
+	for (const TPair<FString, TSharedPtr<FJsonValue>>& Pair : (*BaselineMetrics)->Values)
+	{
+		const double* Current = Metrics.Find(Pair.Key);
+		if (!Current)
+		{
+			UE_LOG(LogGAM312, Warning, TEXT("[Benchmark] %s is in the baseline but wasn't measured"), *Pair.Key);
+			continue;
+		}
+
+		const double Expected = Pair.Value->AsNumber();
+		const bool bRegressed = *Current > Expected * (1.0 + UsedTolerance) && *Current - Expected > GameplayBenchmark::MinRegression;
+		NumRegressions += bRegressed ? 1 : 0;
+
+		TSharedRef<FJsonObject> Result = MakeShared<FJsonObject>();
+		Result->SetNumberField(TEXT("baseline"), Expected);
+		Result->SetNumberField(TEXT("current"), *Current);
+		Result->SetNumberField(TEXT("change"), Expected > 0.0 ? *Current / Expected - 1.0 : 0.0);
+		Result->SetBoolField(TEXT("regressed"), bRegressed);
+		Results->SetObjectField(Pair.Key, Result);
+
+		if (bRegressed)
+		{
+			UE_LOG(LogGAM312, Error, TEXT("[Benchmark] Regression: %s %.4f, baseline %.4f (+%.0f%%, tolerance %.0f%%)"),
+				*Pair.Key, *Current, Expected, (*Current / FMath::Max(Expected, UE_DOUBLE_SMALL_NUMBER) - 1.0) * 100.0, UsedTolerance * 100.0);
+		}
+	}
+
+	OutGate->SetObjectField(TEXT("metrics"), Results);
+	OutGate->SetBoolField(TEXT("passed"), NumRegressions == 0);
+
+	UE_LOG(LogGAM312, Display, TEXT("[Benchmark] %d of %d metrics regressed against %s"), NumRegressions, (*BaselineMetrics)->Values.Num(), *BaselinePath);
+	return NumRegressions == 0;
+}
+
+bool UGameplayBenchmarkCommandlet::WriteBaseline(const FString& BaselinePath, const TMap<FString, double>& Metrics, float Tolerance) const
+{
+	TSharedRef<FJsonObject> Baseline = MakeShared<FJsonObject>();
+	Baseline->SetNumberField(TEXT("tolerance"), Tolerance >= 0.0f ? Tolerance : GameplayBenchmark::DefaultTolerance);
+	Baseline->SetNumberField(TEXT("characters"), Stations.Num());
+	Baseline->SetNumberField(TEXT("frames"), FrameTimes.Num());
+
+	TSharedRef<FJsonObject> BaselineMetrics = MakeShared<FJsonObject>();
+	for (const TPair<FString, double>& Pair : Metrics)
+	{
+		BaselineMetrics->SetNumberField(Pair.Key, Pair.Value);
+	}
+	Baseline->SetObjectField(TEXT("metrics"), BaselineMetrics);
+
+	FString Json;
+	if (!FJsonSerializer::Serialize(Baseline, TJsonWriterFactory<>::Create(&Json)) || !FFileHelper::SaveStringToFile(Json, *BaselinePath))
+	{
+		UE_LOG(LogGAM312, Error, TEXT("[Benchmark] Could not write baseline %s"), *BaselinePath);
+		return false;
+	}
+
+	UE_LOG(LogGAM312, Display, TEXT("[Benchmark] Recorded %d metrics as the baseline in %s"), Metrics.Num(), *BaselinePath);
+	return true;
+}
+
+bool UGameplayBenchmarkCommandlet::WriteReport(UWorld* World, const FString& ReportPath, const TMap<FString, double>& Metrics, const TSharedPtr<FJsonObject>& Gate) const
+{
+	TArray<double> Sorted = FrameTimes;
+	Sorted.Sort();
+
+	double FrameTimeSum = 0.0;
+	for (double FrameTime : FrameTimes)
+	{
+		FrameTimeSum += FrameTime;
+	}
+	const double Frames = FMath::Max(FrameTimes.Num(), 1);
+
+	TSharedRef<FJsonObject> Report = MakeShared<FJsonObject>();
+	Report->SetStringField(TEXT("map"), MapName);
+	Report->SetNumberField(TEXT("characters"), Stations.Num());
+	Report->SetNumberField(TEXT("frames"), FrameTimes.Num());
+	Report->SetNumberField(TEXT("warmupFrames"), WarmupFrames);
+	Report->SetNumberField(TEXT("deltaTime"), DeltaSeconds);
+
+	int32 NumNodes = 0;
+	for (const FStation& Station : Stations)
+	{
+		NumNodes += Station.Nodes.Num();
+	}
+	Report->SetNumberField(TEXT("resources"), NumNodes);
+
+	TSharedRef<FJsonObject> FrameTime = MakeShared<FJsonObject>();
+	FrameTime->SetNumberField(TEXT("avg"), FrameTimeSum * 1000.0 / Frames);
+	FrameTime->SetNumberField(TEXT("p50"), GameplayBenchmark::Percentile(Sorted, 0.5) * 1000.0);
+	FrameTime->SetNumberField(TEXT("p90"), GameplayBenchmark::Percentile(Sorted, 0.9) * 1000.0);
+	FrameTime->SetNumberField(TEXT("p99"), GameplayBenchmark::Percentile(Sorted, 0.99) * 1000.0);
+	FrameTime->SetNumberField(TEXT("max"), Sorted.Num() > 0 ? Sorted.Last() * 1000.0 : 0.0);
+	Report->SetObjectField(TEXT("frameTimeMs"), FrameTime);
+
+	// Every GAM312_SCOPE that ran, subsystem ticks included; times are inclusive
+	TSharedRef<FJsonObject> GameThread = MakeShared<FJsonObject>();
+	TSharedRef<FJsonObject> Counters = MakeShared<FJsonObject>();
+	if (const UGameplayProfilerSubsystem* Profiler = World->GetSubsystem<UGameplayProfilerSubsystem>())
+	{
+		const double ProfiledFrames = FMath::Max(Profiler->GetFramesCaptured(), 1);
+		for (const TPair<const FGameplayScopeStat*, FGameplayScopeSummary>& Pair : Profiler->GetScopeSummaries())
+		{
+			TSharedRef<FJsonObject> Scope = MakeShared<FJsonObject>();
+			Scope->SetNumberField(TEXT("msPerFrame"), FPlatformTime::ToMilliseconds64(Pair.Value.TotalCycles) / ProfiledFrames);
+			Scope->SetNumberField(TEXT("maxFrameMs"), FPlatformTime::ToMilliseconds64(Pair.Value.MaxFrameCycles));
+			Scope->SetNumberField(TEXT("callsPerFrame"), Pair.Value.Calls / ProfiledFrames);
+			GameThread->SetObjectField(Pair.Key->Name, Scope);
+		}
+
+		for (int32 Index = 0; Index < static_cast<int32>(EGameplayCounter::Num); ++Index)
+		{
+			const FGameplayCounterSummary& Summary = Profiler->GetCounterSummary(static_cast<EGameplayCounter>(Index));
+			TSharedRef<FJsonObject> Counter = MakeShared<FJsonObject>();
+			Counter->SetNumberField(TEXT("total"), Summary.Total);
+			Counter->SetNumberField(TEXT("perFrame"), Summary.Total / ProfiledFrames);
+			Counter->SetNumberField(TEXT("maxPerFrame"), Summary.MaxFrameCount);
+			Counters->SetObjectField(UGameplayProfilerSubsystem::GetCounterName(static_cast<EGameplayCounter>(Index)), Counter);
+		}
+	}
+	Report->SetObjectField(TEXT("gameThreadMs"), GameThread);
+	Report->SetObjectField(TEXT("counters"), Counters);
+
+	// Allocator stats before and after the measured frames. Per-call allocation counts and
+	// callstacks come from a run with -trace=memalloc in Unreal Insights, or -llm per tag.
+	TSharedRef<FJsonObject> Allocator = MakeShared<FJsonObject>();
+	Allocator->SetStringField(TEXT("name"), GMalloc->GetDescriptiveName());
+	TSharedRef<FJsonObject> AllocatorStats = MakeShared<FJsonObject>();
+	for (const TPair<FString, uint64>& Pair : EndAllocatorStats)
+	{
+		const uint64* Start = StartAllocatorStats.Find(Pair.Key);
+		TSharedRef<FJsonObject> Stat = MakeShared<FJsonObject>();
+		Stat->SetNumberField(TEXT("start"), Start ? *Start : 0);
+		Stat->SetNumberField(TEXT("end"), Pair.Value);
+		Stat->SetNumberField(TEXT("delta"), static_cast<double>(Pair.Value) - static_cast<double>(Start ? *Start : 0));
+		AllocatorStats->SetObjectField(Pair.Key, Stat);
+	}
+	Allocator->SetObjectField(TEXT("stats"), AllocatorStats);
+	Report->SetObjectField(TEXT("allocator"), Allocator);
+
+	TSharedRef<FJsonObject> Memory = MakeShared<FJsonObject>();
+	Memory->SetNumberField(TEXT("startUsedMB"), StartUsedMemory / GameplayBenchmark::BytesPerMB);
+	Memory->SetNumberField(TEXT("endUsedMB"), EndUsedMemory / GameplayBenchmark::BytesPerMB);
+	Memory->SetNumberField(TEXT("peakUsedMB"), PeakUsedMemory / GameplayBenchmark::BytesPerMB);
+	Memory->SetNumberField(TEXT("processPeakMB"), FPlatformMemory::GetStats().PeakUsedPhysical / GameplayBenchmark::BytesPerMB);
+	Report->SetObjectField(TEXT("memory"), Memory);
+
+	TSharedRef<FJsonObject> Actions = MakeShared<FJsonObject>();
+	Actions->SetNumberField(TEXT("harvests"), NumHarvests);
+	Actions->SetNumberField(TEXT("crafts"), NumCrafts);
+	Actions->SetNumberField(TEXT("buildingSpawns"), NumBuildingSpawns);
+	Actions->SetNumberField(TEXT("rotations"), NumRotations);
+	Actions->SetNumberField(TEXT("placements"), NumPlacements);
+	if (const UBuildingManagerSubsystem* BuildingManager = World->GetSubsystem<UBuildingManagerSubsystem>())
+	{
+		Actions->SetNumberField(TEXT("placedParts"), BuildingManager->GetNumPlacedParts());
+	}
+	Report->SetObjectField(TEXT("actions"), Actions);
+
+	TSharedRef<FJsonObject> GatedMetrics = MakeShared<FJsonObject>();
+	for (const TPair<FString, double>& Pair : Metrics)
+	{
+		GatedMetrics->SetNumberField(Pair.Key, Pair.Value);
+	}
+	Report->SetObjectField(TEXT("metrics"), GatedMetrics);
+	if (Gate)
+	{
+		Report->SetObjectField(TEXT("gate"), Gate.ToSharedRef());
+	}
+
+	FString Json;
+	TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Json);
+	if (!FJsonSerializer::Serialize(Report, Writer) || !FFileHelper::SaveStringToFile(Json, *ReportPath))
+	{
+		UE_LOG(LogGAM312, Error, TEXT("[Benchmark] Could not write %s"), *ReportPath);
+		return false;
+	}
+
+	UE_LOG(LogGAM312, Display, TEXT("[Benchmark] Frame avg %.2f ms, p50 %.2f, p99 %.2f, max %.2f; %+.1f MB over the run; peak %.1f MB; report written to %s"),
+		FrameTimeSum * 1000.0 / Frames,
+		GameplayBenchmark::Percentile(Sorted, 0.5) * 1000.0,
+		GameplayBenchmark::Percentile(Sorted, 0.99) * 1000.0,
+		Sorted.Num() > 0 ? Sorted.Last() * 1000.0 : 0.0,
+		(static_cast<double>(EndUsedMemory) - static_cast<double>(StartUsedMemory)) / GameplayBenchmark::BytesPerMB,
+		PeakUsedMemory / GameplayBenchmark::BytesPerMB,
+		*FPaths::ConvertRelativePathToFull(ReportPath));
+	return true;
+}
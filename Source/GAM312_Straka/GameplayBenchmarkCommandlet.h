@@ -0,0 +1,107 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "GameplayBenchmarkCommandlet.generated.h"
+
+class AMyCharacter;
+class AResource_M;
+class FJsonObject;
+class UGameInstance;
+
+/**
+ * UGameplayBenchmarkCommandlet
+ *
+ * Measures the gameplay code headless, without a GPU or the editor UI:
+ *
+ *   UnrealEditor-Cmd GAM312_Straka.uproject -run=GameplayBenchmark -nullrhi -unattended
+ *       [-Map=/Game/Maps/testMap] [-Characters=8] [-Resources=400] [-Frames=1800] [-Warmup=120]
+ *       [-DeltaTime=0.0166667] [-CharacterClass=<class path>] [-Building=<name>] [-Report=<file.json>]
+ *       [-Baseline=<file.json> [-Tolerance=0.2] [-UpdateBaseline]]
+ *
+ * Loads the map as a game world and spawns every character in its own ring of resource
+ * nodes. Each character then runs a scripted loop at a fixed time step: four harvests
+ * (FindObject at the next node), a craft (UpdateResources), SpawnBuilding, RotateBuilding
+ * and placing the part. The JSON report has frame time percentiles, game-thread time of
+ * every GAM312_SCOPE (each subsystem's Tick included), the allocator's stats before and
+ * after the measured frames, and memory. The gam312.Profile.Capture CSV of the same frames
+ * is written next to it. For allocation counts and callstacks, run with -trace=memalloc
+ * and open the trace in Unreal Insights.
+ *
+ * With -Baseline the gated metrics (frame time, memory growth and the per-call time of the
+ * GiveResource, UpdateResources, trace, FindObject, SpawnBuilding and survival stat paths)
+ * are compared to the baseline file, and the commandlet fails when one is worse than its
+ * baseline by more than the tolerance. -UpdateBaseline records the run as the new baseline.
+ */
+UCLASS()
+class GAM312_STRAKA_API UGameplayBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UGameplayBenchmarkCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+
+private:
+	struct FStation
+	{
+		TWeakObjectPtr<AMyCharacter> Character;
+		TArray<TWeakObjectPtr<AResource_M>> Nodes;
+	};
+
+	// Loads the map into a standalone game instance and begins play
+	UWorld* LoadWorld(const FString& InMapName);
+
+	void SpawnStations(UWorld* World, UClass* CharacterClass, int32 NumCharacters, int32 NumResources);
+
+	// One step of every character's scripted loop
+	void DriveCharacters(int32 Frame);
+
+	// Runs one engine frame; returns the seconds it took
+	double TickFrame(UWorld* World, float InDeltaSeconds, int32 Frame);
+
+	// Gated metrics of this run, by name
+	void GatherMetrics(UWorld* World, TMap<FString, double>& OutMetrics) const;
+
+	// Compares against the baseline file; returns false on a regression
+	bool CheckBaseline(const FString& BaselinePath, const TMap<FString, double>& Metrics, float Tolerance, TSharedPtr<FJsonObject>& OutGate) const;
+
+	bool WriteBaseline(const FString& BaselinePath, const TMap<FString, double>& Metrics, float Tolerance) const;
+
+	bool WriteReport(UWorld* World, const FString& ReportPath, const TMap<FString, double>& Metrics, const TSharedPtr<FJsonObject>& Gate) const;
+
+	UPROPERTY()
+	TObjectPtr<UGameInstance> GameInstance;
+
+	TArray<FStation> Stations;
+
+	// Building crafted and placed by the loop, and its Wood and Stone cost
+	int32 BuildingId = INDEX_NONE;
+	FString BuildingName;
+	float WoodCost = 0.0f;
+	float StoneCost = 0.0f;
+
+	/** ---------- Results ---------- **/
+
+	FString MapName;
+	int32 NumFrames = 0;
+	int32 WarmupFrames = 0;
+	float DeltaSeconds = 0.0f;
+
+	TArray<double> FrameTimes;
+
+	// GMalloc's own stats, sampled around the measured frames
+	TMap<FString, uint64> StartAllocatorStats;
+	TMap<FString, uint64> EndAllocatorStats;
+
+	uint64 StartUsedMemory = 0;
+	uint64 EndUsedMemory = 0;
+	uint64 PeakUsedMemory = 0;
+
+	int32 NumHarvests = 0;
+	int32 NumCrafts = 0;
+	int32 NumBuildingSpawns = 0;
+	int32 NumRotations = 0;
+	int32 NumPlacements = 0;
+};
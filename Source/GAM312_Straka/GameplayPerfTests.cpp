@@ -0,0 +1,398 @@
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "GAM312_Straka.h"
+#include "InventoryComponent.h"
+#include "MyCharacter.h"
+#include "ResourceRegistry.h"
+#include "ResourceSpatialSubsystem.h"
+#include "Resource_M.h"
+#include "Camera/CameraComponent.h"
+#include "Dom/JsonObject.h"
+#include "Engine/Engine.h"
+#include "Engine/GameInstance.h"
+#include "Engine/World.h"
+#include "Misc/CommandLine.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+
+/**
+ * Performance tests of the gameplay paths the benchmark commandlet gates, each timed on its
+ * own over many characters in an empty world (Session Frontend or -ExecCmds="Automation
+ * RunTests GAM312.Perf"). Every test records its time per call with AddTelemetryData and
+ * fails when it is worse than Tests/GameplayPerfBaseline.json by more than the tolerance.
+ * -GameplayPerfBaseline=<file.json> reads another baseline; -UpdateGameplayPerfBaseline
+ * records the run as the baseline instead. Each test rewrites the whole file, so record it
+ * in one unsharded run (no -shards), on the machine the gate runs on. A metric missing from
+ * the baseline only warns.
+ */
+namespace GameplayPerfTests
+{
+	static const TCHAR* CharacterClass = TEXT("/Game/Player/PlayerChar_BP.PlayerChar_BP_C");
+	static const TCHAR* ResourceClass = TEXT("/Game/Resources/Wood_Resource.Wood_Resource_C");
+
+	static constexpr uint32 TestFlags = EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter;
+
+	// Characters sit on a grid high above everything so their traces never cross
+	static constexpr float CharacterSpacing = 3000.0f;
+	static constexpr float CharacterHeight = 50000.0f;
+
+	// A node right in front of each camera, within interaction range
+	static constexpr float NodeDistance = 150.0f;
+
+	// A metric regresses once it is this much worse than its baseline
+	static constexpr double DefaultTolerance = 0.2;
+
+	// Smaller changes never fail the gate, so sub-microsecond noise on cheap paths doesn't either
+	static constexpr double MinRegressionUs = 0.1;
+
+	static FString GetBaselinePath()
+	{
+		FString BaselinePath = FPaths::ProjectDir() / TEXT("Tests/GameplayPerfBaseline.json");
+		FParse::Value(FCommandLine::Get(), TEXT("GameplayPerfBaseline="), BaselinePath);
+		return BaselinePath;
+	}
+
+	/**
+	 * A standalone game world with its game mode started, so spawned characters begin play
+	 * as they would in a match. Torn down with the scope.
+	 */
+	struct FPerfWorld
+	{
+		FPerfWorld(int32 NumCharacters, bool bWithNodes)
+		{
+			GameInstance = NewObject<UGameInstance>(GEngine);
+			GameInstance->AddToRoot();
+			GameInstance->InitializeStandalone();
+
+			World = GameInstance->GetWorld();
+			World->SetGameMode(FURL());
+			World->InitializeActorsForPlay(FURL());
+			World->BeginPlay();
+
+			UClass* PlayerClass = LoadClass<AMyCharacter>(nullptr, CharacterClass);
+			UClass* NodeClass = LoadClass<AResource_M>(nullptr, ResourceClass);
+			PlayerClass = PlayerClass ? PlayerClass : AMyCharacter::StaticClass();
+			NodeClass = NodeClass ? NodeClass : AResource_M::StaticClass();
+
+			UResourceSpatialSubsystem* SpatialIndex = World->GetSubsystem<UResourceSpatialSubsystem>();
+			FActorSpawnParameters SpawnParams;
+			SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+			const int32 GridSize = FMath::CeilToInt32(FMath::Sqrt(static_cast<float>(NumCharacters)));
+			for (int32 Index = 0; Index < NumCharacters; ++Index)
+			{
+				const FVector Location((Index % GridSize) * CharacterSpacing, (Index / GridSize) * CharacterSpacing, CharacterHeight);
+				AMyCharacter* Character = World->SpawnActor<AMyCharacter>(PlayerClass, Location, FRotator::ZeroRotator, SpawnParams);
+				if (!Character)
+				{
+					continue;
+				}
+				Characters.Add(Character);
+
+				if (!bWithNodes)
+				{
+					continue;
+				}
+
+				// Center the node on the camera's line of sight; the spatial index needs the final spot
+				const FVector Target = Character->PlayerCamComp->GetComponentLocation() + Character->PlayerCamComp->GetForwardVector() * NodeDistance;
+				if (AResource_M* Node = World->SpawnActor<AResource_M>(NodeClass, Target, FRotator::ZeroRotator, SpawnParams))
+				{
+					Nodes.Add(Node);
+					if (SpatialIndex)
+					{
+						SpatialIndex->UnregisterNode(Node);
+					}
+					Node->SetActorLocation(Target - (Node->GetComponentsBoundingBox().GetCenter() - Node->GetActorLocation()));
+					if (SpatialIndex)
+					{
+						SpatialIndex->RegisterNode(Node);
+					}
+				}
+			}
+		}
+
+		~FPerfWorld()
+		{
+			GEngine->DestroyWorldContext(World);
+			World->DestroyWorld(false);
+			GameInstance->RemoveFromRoot();
+		}
+
+		// Grants every character Amount of each resource and Count of each building, committed
+		void GrantAll(float Amount, int32 Count)
+		{
+			const UResourceRegistry& Registry = UResourceRegistry::Get();
+			for (AMyCharacter* Character : Characters)
+			{
+				for (int32 ResourceId = 0; ResourceId < Registry.NumResources() && Amount > 0.0f; ++ResourceId)
+				{
+					Character->Inventory->GrantResource(ResourceId, Amount);
+				}
+				for (int32 BuildingId = 0; BuildingId < Registry.NumBuildings() && Count > 0; ++BuildingId)
+				{
+					Character->Inventory->GrantBuilding(BuildingId, Count);
+				}
+				Character->Inventory->Commit();
+			}
+		}
+
+		/**
+		 * Calls Body once per character for NumFrames frames and returns the microseconds
+		 * per call. Outside the measured time, each frame advances GFrameCounter (so nothing
+		 * cached for the frame carries over), runs BeginFrame and ends by committing the
+		 * inventories, as a frame in game would.
+		 */
+		template <typename BeginFrameType, typename BodyType>
+		double TimePerCall(int32 NumFrames, BeginFrameType&& BeginFrame, BodyType&& Body)
+		{
+			uint64 Cycles = 0;
+			int32 Calls = 0;
+			for (int32 Frame = 0; Frame < NumFrames; ++Frame)
+			{
+				++GFrameCounter;
+				BeginFrame(Frame);
+
+				for (AMyCharacter* Character : Characters)
+				{
+					const uint64 StartCycles = FPlatformTime::Cycles64();
+					Body(*Character, Frame);
+					Cycles += FPlatformTime::Cycles64() - StartCycles;
+					++Calls;
+				}
+
+				for (AMyCharacter* Character : Characters)
+				{
+					Character->Inventory->Commit();
+				}
+			}
+
+			return FPlatformTime::ToMilliseconds64(Cycles) * 1000.0 / FMath::Max(Calls, 1);
+		}
+
+		template <typename BodyType>
+		double TimePerCall(int32 NumFrames, BodyType&& Body)
+		{
+			return TimePerCall(NumFrames, [](int32 Frame) {}, Forward<BodyType>(Body));
+		}
+
+		UGameInstance* GameInstance = nullptr;
+		UWorld* World = nullptr;
+		TArray<AMyCharacter*> Characters;
+		TArray<AResource_M*> Nodes;
+	};
+
+	/**
+	 * Records Metric (microseconds per call) as telemetry, then compares it with the baseline
+	 * file. Returns false on a regression. With -UpdateGameplayPerfBaseline the metric is
+	 * written into the baseline instead.
+	 */
+	static bool CheckMetric(FAutomationTestBase& Test, const FString& Metric, double MicrosecondsPerCall, int32 NumCalls)
+	{
+		Test.AddTelemetryData(Metric, MicrosecondsPerCall, FString::Printf(TEXT("us per call, %d calls"), NumCalls));
+
+		const FString BaselinePath = GetBaselinePath();
+		FString Json;
+		TSharedPtr<FJsonObject> Baseline;
+		const bool bHasBaseline = FFileHelper::LoadFileToString(Json, *BaselinePath) && FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(Json), Baseline) && Baseline;
+
+		if (FParse::Param(FCommandLine::Get(), TEXT("UpdateGameplayPerfBaseline")))
+		{
+			if (!bHasBaseline)
+			{
+				Baseline = MakeShared<FJsonObject>();
+				Baseline->SetNumberField(TEXT("tolerance"), DefaultTolerance);
+			}
+
+			const TSharedPtr<FJsonObject>* ExistingMetrics = nullptr;
+			TSharedPtr<FJsonObject> Metrics = MakeShared<FJsonObject>();
+			if (Baseline->TryGetObjectField(TEXT("metrics"), ExistingMetrics))
+			{
+				Metrics = *ExistingMetrics;
+			}
+			Metrics->SetNumberField(Metric, MicrosecondsPerCall);
+			Baseline->SetObjectField(TEXT("metrics"), Metrics);
+			Baseline->SetStringField(TEXT("recorded"), FString::Printf(TEXT("%s on %s"), *FDateTime::UtcNow().ToIso8601(), FPlatformProcess::ComputerName()));
+
+			Json.Reset();
+			if (!FJsonSerializer::Serialize(Baseline.ToSharedRef(), TJsonWriterFactory<>::Create(&Json)) || !FFileHelper::SaveStringToFile(Json, *BaselinePath))
+			{
+				Test.AddError(FString::Printf(TEXT("Could not write baseline %s"), *BaselinePath));
+				return false;
+			}
+
+			Test.AddInfo(FString::Printf(TEXT("%s: %.3f us per call recorded in %s"), *Metric, MicrosecondsPerCall, *BaselinePath));
+			return true;
+		}
+
+		const TSharedPtr<FJsonObject>* BaselineMetrics = nullptr;
+		double Expected = 0.0;
+		if (!bHasBaseline || !Baseline->TryGetObjectField(TEXT("metrics"), BaselineMetrics) || !(*BaselineMetrics)->TryGetNumberField(Metric, Expected))
+		{
+			Test.AddWarning(FString::Printf(TEXT("%s: %.3f us per call is not gated; no baseline for it in %s, record one with -UpdateGameplayPerfBaseline"), *Metric, MicrosecondsPerCall, *BaselinePath));
+			return true;
+		}
+
+		double Tolerance = DefaultTolerance;
+		Baseline->TryGetNumberField(TEXT("tolerance"), Tolerance);
+
+		if (MicrosecondsPerCall > Expected * (1.0 + Tolerance) && MicrosecondsPerCall - Expected > MinRegressionUs)
+		{
+			Test.AddError(FString::Printf(TEXT("Regression: %s %.3f us per call, baseline %.3f (+%.0f%%, tolerance %.0f%%)"),
+				*Metric, MicrosecondsPerCall, Expected, (MicrosecondsPerCall / FMath::Max(Expected, UE_DOUBLE_SMALL_NUMBER) - 1.0) * 100.0, Tolerance * 100.0));
+			return false;
+		}
+
+		Test.AddInfo(FString::Printf(TEXT("%s: %.3f us per call, baseline %.3f"), *Metric, MicrosecondsPerCall, Expected));
+		return true;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGameplayPerfGiveResourceTest, "GAM312.Perf.GiveResource", GameplayPerfTests::TestFlags)
+
+bool FGameplayPerfGiveResourceTest::RunTest(const FString& Parameters)
+{
+	static constexpr int32 NumCharacters = 64;
+	static constexpr int32 NumFrames = 200;
+
+	const UResourceRegistry& Registry = UResourceRegistry::Get();
+	if (!TestTrue(TEXT("The registry has resource types"), Registry.NumResources() > 0))
+	{
+		return false;
+	}
+
+	GameplayPerfTests::FPerfWorld PerfWorld(NumCharacters, false);
+
+	// By name, as harvested nodes grant, cycling through every resource type
+	const double UsPerCall = PerfWorld.TimePerCall(NumFrames, [&Registry](AMyCharacter& Character, int32 Frame)
+	{
+		Character.GiveResource(1.0f, Registry.Resources[Frame % Registry.NumResources()].Name);
+	});
+
+	return GameplayPerfTests::CheckMetric(*this, TEXT("GiveResource.usPerCall"), UsPerCall, NumCharacters * NumFrames);
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGameplayPerfUpdateResourcesTest, "GAM312.Perf.UpdateResources", GameplayPerfTests::TestFlags)
+
+bool FGameplayPerfUpdateResourcesTest::RunTest(const FString& Parameters)
+{
+	static constexpr int32 NumCharacters = 64;
+	static constexpr int32 NumFrames = 100;
+
+	const UResourceRegistry& Registry = UResourceRegistry::Get();
+	if (!TestTrue(TEXT("The registry has building types"), Registry.NumBuildings() > 0))
+	{
+		return false;
+	}
+
+	GameplayPerfTests::FPerfWorld PerfWorld(NumCharacters, false);
+
+	// Enough of everything that every craft is paid for and commits
+	PerfWorld.GrantAll(1.0e6f, 0);
+
+	const FString BuildingName = Registry.Buildings[0].Name.ToString();
+	float WoodAmount = 0.0f;
+	float StoneAmount = 0.0f;
+	PerfWorld.Characters[0]->GetBuildingCost(Registry.Buildings[0].Name, WoodAmount, StoneAmount);
+
+	const double UsPerCall = PerfWorld.TimePerCall(NumFrames, [&BuildingName, WoodAmount, StoneAmount](AMyCharacter& Character, int32 Frame)
+	{
+		Character.UpdateResources(WoodAmount, StoneAmount, BuildingName);
+	});
+
+	TestEqual(TEXT("Every craft was paid for"), PerfWorld.Characters[0]->Inventory->GetBuildingCount(0), NumFrames);
+
+	return GameplayPerfTests::CheckMetric(*this, TEXT("UpdateResources.usPerCall"), UsPerCall, NumCharacters * NumFrames);
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGameplayPerfFindObjectTest, "GAM312.Perf.FindObject", GameplayPerfTests::TestFlags)
+
+bool FGameplayPerfFindObjectTest::RunTest(const FString& Parameters)
+{
+	static constexpr int32 NumCharacters = 64;
+	static constexpr int32 NumFrames = 50;
+
+	GameplayPerfTests::FPerfWorld PerfWorld(NumCharacters, true);
+	if (!TestEqual(TEXT("Every character has a node in front of it"), PerfWorld.Nodes.Num(), PerfWorld.Characters.Num()))
+	{
+		return false;
+	}
+
+	// Every call is a full harvest: stamina and the nodes are topped up each frame, before they
+	// would run out and turn the rest of the run into early-outs
+	const int32 NodeTotal = GetDefault<AResource_M>(PerfWorld.Nodes[0]->GetClass())->totalResource;
+	auto BeginFrame = [&PerfWorld, NodeTotal](int32 Frame)
+	{
+		for (AMyCharacter* Character : PerfWorld.Characters)
+		{
+			Character->Stamina = 100.0f;
+		}
+		for (AResource_M* Node : PerfWorld.Nodes)
+		{
+			Node->totalResource = NodeTotal;
+		}
+	};
+
+	// The spatial query, the interaction trace and the harvest of the node in front of each character
+	const double UsPerCall = PerfWorld.TimePerCall(NumFrames, BeginFrame, [](AMyCharacter& Character, int32 Frame)
+	{
+		Character.FindObject();
+	});
+
+	return GameplayPerfTests::CheckMetric(*this, TEXT("FindObject.usPerCall"), UsPerCall, NumCharacters * NumFrames);
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGameplayPerfSpawnBuildingTest, "GAM312.Perf.SpawnBuilding", GameplayPerfTests::TestFlags)
+
+bool FGameplayPerfSpawnBuildingTest::RunTest(const FString& Parameters)
+{
+	static constexpr int32 NumCharacters = 256;
+
+	const UResourceRegistry& Registry = UResourceRegistry::Get();
+	if (!TestTrue(TEXT("The registry has building types"), Registry.NumBuildings() > 0))
+	{
+		return false;
+	}
+
+	GameplayPerfTests::FPerfWorld PerfWorld(NumCharacters, false);
+	PerfWorld.GrantAll(0.0f, 1);
+
+	// A character previews one part at a time, so every character enters build mode once
+	int32 NumSpawned = 0;
+	const double UsPerCall = PerfWorld.TimePerCall(1, [&NumSpawned](AMyCharacter& Character, int32 Frame)
+	{
+		bool bSuccess = false;
+		Character.SpawnBuilding(0, bSuccess);
+		NumSpawned += bSuccess ? 1 : 0;
+	});
+
+	TestEqual(TEXT("Every character entered build mode"), NumSpawned, PerfWorld.Characters.Num());
+
+	return GameplayPerfTests::CheckMetric(*this, TEXT("SpawnBuilding.usPerCall"), UsPerCall, PerfWorld.Characters.Num());
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGameplayPerfDecreaseStatsTest, "GAM312.Perf.DecreaseStats", GameplayPerfTests::TestFlags)
+
+bool FGameplayPerfDecreaseStatsTest::RunTest(const FString& Parameters)
+{
+	static constexpr int32 NumCharacters = 256;
+	static constexpr int32 NumSteps = 150;
+
+	GameplayPerfTests::FPerfWorld PerfWorld(NumCharacters, false);
+
+	// Long enough that hunger runs out and health starts dropping too
+	const double UsPerCall = PerfWorld.TimePerCall(NumSteps, [](AMyCharacter& Character, int32 Step)
+	{
+		Character.DecreaseStats();
+	});
+
+	return GameplayPerfTests::CheckMetric(*this, TEXT("DecreaseStats.usPerCall"), UsPerCall, NumCharacters * NumSteps);
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
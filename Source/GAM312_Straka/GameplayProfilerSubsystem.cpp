@@ -0,0 +1,245 @@
+#include "GameplayProfilerSubsystem.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+namespace GameplayProfiler
+{
+	static const TCHAR* CounterNames[] = { TEXT("Traces"), TEXT("Spawns"), TEXT("Destroys"), TEXT("UI Events") };
+	static_assert(UE_ARRAY_COUNT(CounterNames) == static_cast<int32>(EGameplayCounter::Num), "Name every gameplay counter");
+
+	// Scopes logged once the capture is written; the CSV has all of them
+	static constexpr int32 NumLoggedScopes = 5;
+}
+
+void UGameplayProfilerSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	UWorld* World = GetWorld();
+	ActorSpawnedHandle = World->AddOnActorSpawnedHandler(FOnActorSpawned::FDelegate::CreateUObject(this, &UGameplayProfilerSubsystem::OnActorSpawned));
+	ActorDestroyedHandle = World->AddOnActorDestroyedHandler(FOnActorDestroyed::FDelegate::CreateUObject(this, &UGameplayProfilerSubsystem::OnActorDestroyed));
+}
+
+void UGameplayProfilerSubsystem::Deinitialize()
+{
+	UWorld* World = GetWorld();
+	World->RemoveOnActorSpawnedHandler(ActorSpawnedHandle);
+	World->RemoveOnActorDestroyedHandler(ActorDestroyedHandle);
+
+	// A capture cut short by a map change still leaves its summary behind
+	if (IsCapturing())
+	{
+		FramesLeft = 0;
+		FGameplayScopeStat::bCapturing = false;
+		WriteSummary();
+	}
+
+	Super::Deinitialize();
+}
+
+const TCHAR* UGameplayProfilerSubsystem::GetCounterName(EGameplayCounter Counter)
+{
+	return GameplayProfiler::CounterNames[static_cast<int32>(Counter)];
+}
+
+bool UGameplayProfilerSubsystem::IsTickable() const
+{
+	return FramesLeft > 0;
+}
+
+TStatId UGameplayProfilerSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UGameplayProfilerSubsystem, STATGROUP_Tickables);
+}
+
+void UGameplayProfilerSubsystem::OnActorSpawned(AActor* Actor)
+{
+	GAM312_COUNT(Spawns);
+}
+
+void UGameplayProfilerSubsystem::OnActorDestroyed(AActor* Actor)
+{
+	GAM312_COUNT(Destroys);
+}
+
+void UGameplayProfilerSubsystem::StartCapture(int32 NumFrames, const FString& Filename)
+{
+	if (NumFrames <= 0)
+	{
+		return;
+	}
+
+	// Scopes and counters are shared by every world, so only one capture runs at a time
+	if (FGameplayScopeStat::bCapturing)
+	{
+		UE_LOG(LogGAM312, Warning, TEXT("[Profile] A capture is already running"));
+		return;
+	}
+
+	Scopes.Reset();
+	for (FGameplayCounterSummary& Counter : Counters)
+	{
+		Counter = FGameplayCounterSummary();
+	}
+
+	CaptureFilename = !Filename.IsEmpty() ? Filename
+		: FPaths::ProfilingDir() / TEXT("GAM312") / FString::Printf(TEXT("Gameplay-%s.csv"), *FDateTime::Now().ToString());
+	FramesLeft = NumFrames;
+	FramesCaptured = 0;
+	FrameTimeSum = 0.0;
+	FrameTimeMax = 0.0;
+	WorstFrame = 0;
+
+	// Started from the console mid-frame; the window begins with the next full frame
+	ResetFrame();
+	LastFrameTime = 0.0;
+	FGameplayScopeStat::bCapturing = true;
+
+	UE_LOG(LogGAM312, Display, TEXT("[Profile] Capturing %d frames"), NumFrames);
+}
+
+void UGameplayProfilerSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	const double Now = FPlatformTime::Seconds();
+	if (LastFrameTime == 0.0)
+	{
+		ResetFrame();
+	}
+	else
+	{
+		CollectFrame(Now - LastFrameTime);
+		if (--FramesLeft == 0)
+		{
+			FGameplayScopeStat::bCapturing = false;
+			WriteSummary();
+		}
+	}
+	LastFrameTime = Now;
+}
+
+void UGameplayProfilerSubsystem::CollectFrame(double FrameSeconds)
+{
+	const int32 Frame = FramesCaptured++;
+
+	FrameTimeSum += FrameSeconds;
+	if (FrameSeconds > FrameTimeMax)
+	{
+		FrameTimeMax = FrameSeconds;
+		WorstFrame = Frame;
+	}
+
+	for (FGameplayScopeStat* Stat = FGameplayScopeStat::First; Stat; Stat = Stat->Next)
+	{
+		if (Stat->FrameCalls == 0)
+		{
+			continue;
+		}
+
+		FGameplayScopeSummary& Summary = Scopes.FindOrAdd(Stat);
+		Summary.TotalCycles += Stat->FrameCycles;
+		Summary.Calls += Stat->FrameCalls;
+		Summary.MaxFrameCalls = FMath::Max(Summary.MaxFrameCalls, Stat->FrameCalls);
+		if (Stat->FrameCycles > Summary.MaxFrameCycles)
+		{
+			Summary.MaxFrameCycles = Stat->FrameCycles;
+			Summary.WorstFrame = Frame;
+		}
+	}
+
+	for (int32 Index = 0; Index < static_cast<int32>(EGameplayCounter::Num); ++Index)
+	{
+		const int32 Count = FGameplayScopeStat::FrameCounts[Index];
+		FGameplayCounterSummary& Counter = Counters[Index];
+		Counter.Total += Count;
+		if (Count > Counter.MaxFrameCount)
+		{
+			Counter.MaxFrameCount = Count;
+			Counter.WorstFrame = Frame;
+		}
+	}
+
+	ResetFrame();
+}
+
+void UGameplayProfilerSubsystem::ResetFrame()
+{
+	for (FGameplayScopeStat* Stat = FGameplayScopeStat::First; Stat; Stat = Stat->Next)
+	{
+		Stat->FrameCycles = 0;
+		Stat->FrameCalls = 0;
+	}
+
+	for (int32& Count : FGameplayScopeStat::FrameCounts)
+	{
+		Count = 0;
+	}
+}
+
+void UGameplayProfilerSubsystem::WriteSummary() const
+{
+	const int32 Frames = FMath::Max(FramesCaptured, 1);
+
+	TArray<TPair<const FGameplayScopeStat*, FGameplayScopeSummary>> Sorted;
+	Sorted.Reserve(Scopes.Num());
+	for (const TPair<const FGameplayScopeStat*, FGameplayScopeSummary>& Pair : Scopes)
+	{
+		Sorted.Add(Pair);
+	}
+	Sorted.Sort([](const TPair<const FGameplayScopeStat*, FGameplayScopeSummary>& A, const TPair<const FGameplayScopeStat*, FGameplayScopeSummary>& B)
+	{
+		return A.Value.TotalCycles > B.Value.TotalCycles;
+	});
+
+	// Counts for every row; times only for the frame and the scopes
+	FString Csv = TEXT("Kind,Name,Total,PerFrame,MaxPerFrame,WorstFrame,TotalMs,MsPerFrame,MaxFrameMs\n");
+	Csv += FString::Printf(TEXT("Frame,Frame,%d,1,1,%d,%.3f,%.3f,%.3f\n"),
+		FramesCaptured, WorstFrame, FrameTimeSum * 1000.0, FrameTimeSum * 1000.0 / Frames, FrameTimeMax * 1000.0);
+
+	for (int32 Index = 0; Index < static_cast<int32>(EGameplayCounter::Num); ++Index)
+	{
+		const FGameplayCounterSummary& Counter = Counters[Index];
+		Csv += FString::Printf(TEXT("Counter,%s,%lld,%.2f,%d,%d,,,\n"),
+			GetCounterName(static_cast<EGameplayCounter>(Index)), Counter.Total, double(Counter.Total) / Frames, Counter.MaxFrameCount, Counter.WorstFrame);
+	}
+
+	for (const TPair<const FGameplayScopeStat*, FGameplayScopeSummary>& Pair : Sorted)
+	{
+		const FGameplayScopeSummary& Summary = Pair.Value;
+		const double TotalMs = FPlatformTime::ToMilliseconds64(Summary.TotalCycles);
+		Csv += FString::Printf(TEXT("Scope,%s,%lld,%.2f,%d,%d,%.3f,%.4f,%.3f\n"),
+			Pair.Key->Name, Summary.Calls, double(Summary.Calls) / Frames, Summary.MaxFrameCalls, Summary.WorstFrame,
+			TotalMs, TotalMs / Frames, FPlatformTime::ToMilliseconds64(Summary.MaxFrameCycles));
+	}
+
+	if (!FFileHelper::SaveStringToFile(Csv, *CaptureFilename))
+	{
+		UE_LOG(LogGAM312, Warning, TEXT("[Profile] Could not write %s"), *CaptureFilename);
+		return;
+	}
+
+	UE_LOG(LogGAM312, Display, TEXT("[Profile] %d frames, avg %.2f ms, worst %.2f ms (frame %d), written to %s"),
+		FramesCaptured, FrameTimeSum * 1000.0 / Frames, FrameTimeMax * 1000.0, WorstFrame, *FPaths::ConvertRelativePathToFull(CaptureFilename));
+
+	for (int32 Index = 0; Index < FMath::Min(Sorted.Num(), GameplayProfiler::NumLoggedScopes); ++Index)
+	{
+		const FGameplayScopeSummary& Summary = Sorted[Index].Value;
+		UE_LOG(LogGAM312, Display, TEXT("[Profile]   %-40s %8.4f ms/frame, worst %.3f ms (frame %d)"),
+			Sorted[Index].Key->Name, FPlatformTime::ToMilliseconds64(Summary.TotalCycles) / Frames,
+			FPlatformTime::ToMilliseconds64(Summary.MaxFrameCycles), Summary.WorstFrame);
+	}
+}
+
+static FAutoConsoleCommandWithWorldAndArgs GProfileCaptureCommand(
+	TEXT("gam312.Profile.Capture"),
+	TEXT("Records gameplay scopes and counters for N frames (default 300) and writes a CSV summary. Args: frames, output file."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (UGameplayProfilerSubsystem* Profiler = World ? World->GetSubsystem<UGameplayProfilerSubsystem>() : nullptr)
+		{
+			Profiler->StartCapture(Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 300, Args.Num() > 1 ? Args[1] : FString());
+		}
+	}));
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "GAM312_Straka.h"
+#include "GameplayProfilerSubsystem.generated.h"
+
+/**
+ * FGameplayScopeSummary
+ *
+ * One GAM312_SCOPE over a capture.
+ */
+struct FGameplayScopeSummary
+{
+	uint64 TotalCycles = 0;
+	uint64 MaxFrameCycles = 0;
+	int64 Calls = 0;
+	int32 MaxFrameCalls = 0;
+
+	// Capture frame with the most time in the scope
+	int32 WorstFrame = 0;
+};
+
+/**
+ * FGameplayCounterSummary
+ *
+ * One GAM312_COUNT counter over a capture.
+ */
+struct FGameplayCounterSummary
+{
+	int64 Total = 0;
+	int32 MaxFrameCount = 0;
+	int32 WorstFrame = 0;
+};
+
+/**
+ * UGameplayProfilerSubsystem
+ *
+ * Captures the GAM312_SCOPE entry points and GAM312_COUNT events frame by frame for a
+ * window of frames, then writes a CSV summary: calls, total and per-frame time, and the
+ * worst frame of every scope, plus per-frame traces, spawns, destroys and UI events. A
+ * hitch shows up as the scope (or counter) whose worst frame matches the frame time's.
+ *
+ * Spawns and destroys are counted for every actor in the world through its delegates.
+ * Scope times are inclusive, so HarvestAlong is also part of FindObject.
+ */
+UCLASS()
+class GAM312_STRAKA_API UGameplayProfilerSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+
+	// Records NumFrames frames, then writes the summary to Filename (Saved/Profiling/GAM312 by default)
+	void StartCapture(int32 NumFrames, const FString& Filename = FString());
+
+	bool IsCapturing() const { return FramesLeft > 0; }
+
+	// Results of the last capture, kept until the next one starts
+	const TMap<const FGameplayScopeStat*, FGameplayScopeSummary>& GetScopeSummaries() const { return Scopes; }
+	const FGameplayCounterSummary& GetCounterSummary(EGameplayCounter Counter) const { return Counters[static_cast<int32>(Counter)]; }
+	int32 GetFramesCaptured() const { return FramesCaptured; }
+
+	static const TCHAR* GetCounterName(EGameplayCounter Counter);
+
+private:
+	void OnActorSpawned(AActor* Actor);
+	void OnActorDestroyed(AActor* Actor);
+
+	// Folds this frame's scopes and counters into the summary and clears them
+	void CollectFrame(double FrameSeconds);
+
+	// Clears what the scopes and counters hold for the current frame
+	static void ResetFrame();
+
+	void WriteSummary() const;
+
+	FDelegateHandle ActorSpawnedHandle;
+	FDelegateHandle ActorDestroyedHandle;
+
+	TMap<const FGameplayScopeStat*, FGameplayScopeSummary> Scopes;
+	FGameplayCounterSummary Counters[static_cast<int32>(EGameplayCounter::Num)];
+
+	FString CaptureFilename;
+	int32 FramesLeft = 0;
+	int32 FramesCaptured = 0;
+	double LastFrameTime = 0.0;
+	double FrameTimeSum = 0.0;
+	double FrameTimeMax = 0.0;
+	int32 WorstFrame = 0;
+};
@@ -0,0 +1,149 @@
+#include "InteractionTrace.h"
+#include "GAM312_Straka.h"
+#include "Engine/World.h"
+#include "GameFramework/Pawn.h"
+#include "HAL/IConsoleManager.h"
+#include "Kismet/GameplayStatics.h"
+#include "Resource_M.h"
+#include "ResourceSpatialSubsystem.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Interaction Traces"), STAT_GAM312_InteractionTraces, STATGROUP_GAM312);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Interaction Trace Cache Hits"), STAT_GAM312_InteractionTraceCacheHits, STATGROUP_GAM312);
+
+bool FInteractionTraceCache::Trace(const UWorld* World, const FVector& Start, const FVector& Direction, const FInteractionTraceProfile& Profile,
+	const FCollisionQueryParams& BaseParams, FHitResult& OutHit)
+{
+	// Same frame, same camera transform, same profile: the answer cannot have changed
+	const bool bSameQuery = bValid
+		&& CachedFrame == GFrameCounter
+		&& CachedStart == Start
+		&& CachedDirection == Direction
+		&& CachedProfile.Channel == Profile.Channel
+		&& CachedProfile.bTraceComplex == Profile.bTraceComplex
+		&& CachedProfile.bReturnFaceIndex == Profile.bReturnFaceIndex
+		&& CachedProfile.Range == Profile.Range;
+
+	if (bSameQuery && (!bCachedBlockingHit || IsValid(CachedHit.GetActor())))
+	{
+		INC_DWORD_STAT(STAT_GAM312_InteractionTraceCacheHits);
+		OutHit = CachedHit;
+		return bCachedBlockingHit;
+	}
+
+	FCollisionQueryParams Params = BaseParams;
+	Params.bTraceComplex = Profile.bTraceComplex;
+	Params.bReturnFaceIndex = Profile.bTraceComplex && Profile.bReturnFaceIndex;
+
+	INC_DWORD_STAT(STAT_GAM312_InteractionTraces);
+	GAM312_COUNT(Traces);
+	bCachedBlockingHit = World->LineTraceSingleByChannel(CachedHit, Start, Start + Direction * Profile.Range, Profile.Channel, Params);
+
+	bValid = true;
+	CachedFrame = GFrameCounter;
+	CachedStart = Start;
+	CachedDirection = Direction;
+	CachedProfile = Profile;
+
+	OutHit = CachedHit;
+	return bCachedBlockingHit;
+}
+
+/** ---------- Benchmark ---------- **/
+
+namespace InteractionTraceBenchmark
+{
+	// Traces issued per target set and profile
+	static constexpr int32 NumTraces = 10000;
+
+	struct FRay
+	{
+		FVector Start;
+		FVector Direction;
+		float Range;
+	};
+
+	// Times NumTraces traces cycling through Rays and logs traces per second and hit rate
+	static void Run(const UWorld* World, const TCHAR* TargetName, const TArray<FRay>& Rays, bool bTraceComplex, const FCollisionQueryParams& BaseParams)
+	{
+		if (Rays.Num() == 0)
+		{
+			UE_LOG(LogGAM312, Display, TEXT("[TraceBench] %-10s no targets"), TargetName);
+			return;
+		}
+
+		FCollisionQueryParams Params = BaseParams;
+		Params.bTraceComplex = bTraceComplex;
+		Params.bReturnFaceIndex = bTraceComplex;
+
+		int32 NumHits = 0;
+		FHitResult Hit;
+		const double StartTime = FPlatformTime::Seconds();
+
+		for (int32 Index = 0; Index < NumTraces; ++Index)
+		{
+			const FRay& Ray = Rays[Index % Rays.Num()];
+			NumHits += World->LineTraceSingleByChannel(Hit, Ray.Start, Ray.Start + Ray.Direction * Ray.Range, ECC_Visibility, Params) ? 1 : 0;
+		}
+
+		const double Seconds = FMath::Max(FPlatformTime::Seconds() - StartTime, UE_SMALL_NUMBER);
+		UE_LOG(LogGAM312, Display, TEXT("[TraceBench] %-10s %-22s %10.0f traces/s  %6.2f us/trace  %5.1f%% hits"),
+			TargetName,
+			bTraceComplex ? TEXT("complex + face index") : TEXT("simple"),
+			NumTraces / Seconds,
+			Seconds * 1.0e6 / NumTraces,
+			100.0 * NumHits / NumTraces);
+	}
+}
+
+static FAutoConsoleCommandWithWorld GTraceBenchmarkCommand(
+	TEXT("gam312.Trace.Benchmark"),
+	TEXT("Compares simple vs complex interaction traces per second against the landscape and nearby resource meshes."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		APawn* Pawn = World ? UGameplayStatics::GetPlayerPawn(World, 0) : nullptr;
+		if (!Pawn)
+		{
+			UE_LOG(LogGAM312, Warning, TEXT("[TraceBench] Needs a player pawn in the world"));
+			return;
+		}
+
+		using InteractionTraceBenchmark::FRay;
+		const FVector Eye = Pawn->GetPawnViewLocation();
+		FRandomStream Random(312);
+
+		FCollisionQueryParams BaseParams(SCENE_QUERY_STAT(GAM312TraceBenchmark));
+		BaseParams.AddIgnoredActor(Pawn);
+
+		// Landscape: rays fanned downward around the player
+		TArray<FRay> LandscapeRays;
+		for (int32 Index = 0; Index < 256; ++Index)
+		{
+			const FRotator Rotation(Random.FRandRange(-80.0f, -20.0f), Random.FRandRange(0.0f, 360.0f), 0.0f);
+			LandscapeRays.Add({ Eye, Rotation.Vector(), 5000.0f });
+		}
+
+		// Resources: rays aimed at each nearby node from a few hundred units away
+		TArray<FRay> ResourceRays;
+		if (const UResourceSpatialSubsystem* SpatialIndex = World->GetSubsystem<UResourceSpatialSubsystem>())
+		{
+			FResourceQuery Query;
+			Query.Origin = Eye;
+			Query.Radius = 20000.0f;
+			Query.MaxResults = 64;
+
+			TArray<FResourceHit> Nodes;
+			SpatialIndex->FindNearest(Query, Nodes);
+			for (const FResourceHit& Node : Nodes)
+			{
+				const FVector Target = Node.Node->GetActorLocation() + FVector(0.0f, 0.0f, 100.0f);
+				const FVector Offset = FRotator(0.0f, Random.FRandRange(0.0f, 360.0f), 0.0f).Vector() * 400.0f;
+				ResourceRays.Add({ Target + Offset, -Offset.GetSafeNormal(), 800.0f });
+			}
+		}
+
+		for (const bool bTraceComplex : { false, true })
+		{
+			InteractionTraceBenchmark::Run(World, TEXT("Landscape"), LandscapeRays, bTraceComplex, BaseParams);
+			InteractionTraceBenchmark::Run(World, TEXT("Resources"), ResourceRays, bTraceComplex, BaseParams);
+		}
+	}));
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/EngineTypes.h"
+#include "CollisionQueryParams.h"
+#include "InteractionTrace.generated.h"
+
+/**
+ * FInteractionTraceProfile
+ *
+ * How the player's interaction line trace is issued. Defaults to simple collision
+ * without face indices, which is all harvesting and building pickup need.
+ */
+USTRUCT(BlueprintType)
+struct FInteractionTraceProfile
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	TEnumAsByte<ECollisionChannel> Channel = ECC_Visibility;
+
+	// Trace against per-triangle collision instead of simple shapes
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	bool bTraceComplex = false;
+
+	// Only meaningful with bTraceComplex
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	bool bReturnFaceIndex = false;
+
+	// Length of the trace from the camera
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float Range = 800.0f;
+};
+
+/**
+ * FInteractionTraceCache
+ *
+ * Remembers the last interaction trace for the current frame. A repeat trace from the
+ * same camera transform in the same frame returns the previous hit instead of
+ * querying physics again.
+ */
+struct GAM312_STRAKA_API FInteractionTraceCache
+{
+	// Traces from Start along Direction using Profile, or reuses this frame's result
+	bool Trace(const UWorld* World, const FVector& Start, const FVector& Direction, const FInteractionTraceProfile& Profile,
+		const FCollisionQueryParams& BaseParams, FHitResult& OutHit);
+
+	// Forces the next Trace call to query physics (e.g. after the world changed under the cursor)
+	void Invalidate() { bValid = false; }
+
+private:
+	bool bValid = false;
+	uint64 CachedFrame = 0;
+	FVector CachedStart = FVector::ZeroVector;
+	FVector CachedDirection = FVector::ZeroVector;
+	FInteractionTraceProfile CachedProfile;
+	bool bCachedBlockingHit = false;
+	FHitResult CachedHit;
+};
@@ -0,0 +1,481 @@
+#include "InventoryComponent.h"
+#include "GAM312_Straka.h"
+#include "ResourceRegistry.h"
+#include "HAL/IConsoleManager.h"
+#include "Net/UnrealNetwork.h"
+#include "UObject/Package.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Inventory Transactions Queued"), STAT_GAM312_InventoryTransactions, STATGROUP_GAM312);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Inventory Transactions Rejected"), STAT_GAM312_InventoryRejected, STATGROUP_GAM312);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Inventory Commits"), STAT_GAM312_InventoryCommits, STATGROUP_GAM312);
+DECLARE_CYCLE_STAT(TEXT("Inventory Commit"), STAT_GAM312_InventoryCommit, STATGROUP_GAM312);
+
+UInventoryComponent::UInventoryComponent()
+{
+	// Ticks only on frames that queued something, after gameplay has run
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+	PrimaryComponentTick.TickGroup = TG_PostUpdateWork;
+
+	SetIsReplicatedByDefault(true);
+	Entries.Owner = this;
+
+	const UResourceRegistry* DefaultRegistry = GetDefault<UResourceRegistry>();
+	SetNumSlots(DefaultRegistry->NumResources(), DefaultRegistry->NumBuildings());
+}
+
+void UInventoryComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// The configured registry may list more types than the class defaults
+	const UResourceRegistry& Registry = UResourceRegistry::Get();
+	SetNumSlots(Registry.NumResources(), Registry.NumBuildings());
+}
+
+void UInventoryComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	// Nobody but the owner needs to see what is in a player's pockets
+	DOREPLIFETIME_CONDITION(UInventoryComponent, Entries, COND_OwnerOnly);
+}
+
+void UInventoryComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	GAM312_SCOPE(UInventoryComponent, TickComponent);
+
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	Commit();
+	SetComponentTickEnabled(false);
+}
+
+bool UInventoryComponent::QueueTransaction(TConstArrayView<FInventoryOp> Ops)
+{
+	// Clients only mirror the server's committed totals
+	if (GetOwner() && !GetOwner()->HasAuthority())
+	{
+		return false;
+	}
+
+	// Apply to the projection in order, undoing everything if one op fails
+	int32 NumApplied = 0;
+	bool bFailed = false;
+
+	for (const FInventoryOp& Op : Ops)
+	{
+		const bool bResource = Op.Type == EInventoryOpType::GrantResource || Op.Type == EInventoryOpType::ConsumeResource;
+		const bool bConsume = Op.Type == EInventoryOpType::ConsumeResource || Op.Type == EInventoryOpType::ConsumeBuilding;
+
+		if (Op.Amount < 0.0f || (bResource ? !ProjectedResources.IsValidIndex(Op.Id) : !ProjectedBuildings.IsValidIndex(Op.Id)))
+		{
+			bFailed = true;
+			break;
+		}
+
+		if (bResource)
+		{
+			if (bConsume && ProjectedResources[Op.Id] < Op.Amount)
+			{
+				bFailed = true;
+				break;
+			}
+			ProjectedResources[Op.Id] += bConsume ? -Op.Amount : Op.Amount;
+		}
+		else
+		{
+			const int32 Count = FMath::RoundToInt(Op.Amount);
+			if (bConsume && ProjectedBuildings[Op.Id] < Count)
+			{
+				bFailed = true;
+				break;
+			}
+			ProjectedBuildings[Op.Id] += bConsume ? -Count : Count;
+		}
+		++NumApplied;
+	}
+
+	if (bFailed)
+	{
+		for (int32 Index = NumApplied - 1; Index >= 0; --Index)
+		{
+			const FInventoryOp& Op = Ops[Index];
+			switch (Op.Type)
+			{
+			case EInventoryOpType::GrantResource:   ProjectedResources[Op.Id] -= Op.Amount; break;
+			case EInventoryOpType::ConsumeResource: ProjectedResources[Op.Id] += Op.Amount; break;
+			case EInventoryOpType::GrantBuilding:   ProjectedBuildings[Op.Id] -= FMath::RoundToInt(Op.Amount); break;
+			case EInventoryOpType::ConsumeBuilding: ProjectedBuildings[Op.Id] += FMath::RoundToInt(Op.Amount); break;
+			}
+		}
+
+		INC_DWORD_STAT(STAT_GAM312_InventoryRejected);
+		return false;
+	}
+
+	for (const FInventoryOp& Op : Ops)
+	{
+		if (Op.Type == EInventoryOpType::GrantResource || Op.Type == EInventoryOpType::ConsumeResource)
+		{
+			DirtyResources[Op.Id] = true;
+			if (Op.Type == EInventoryOpType::GrantResource)
+			{
+				PendingGranted += Op.Amount;
+				GrantedTotals[Op.Id] += Op.Amount;
+			}
+		}
+		else
+		{
+			DirtyBuildings[Op.Id] = true;
+		}
+	}
+
+	++NumPendingTransactions;
+	INC_DWORD_STAT(STAT_GAM312_InventoryTransactions);
+
+	if (!IsComponentTickEnabled())
+	{
+		SetComponentTickEnabled(true);
+	}
+	return true;
+}
+
+bool UInventoryComponent::GrantResource(int32 ResourceId, float Amount)
+{
+	const FInventoryOp Op = FInventoryOp::Make(EInventoryOpType::GrantResource, ResourceId, Amount);
+	return QueueTransaction(MakeArrayView(&Op, 1));
+}
+
+bool UInventoryComponent::ConsumeResource(int32 ResourceId, float Amount)
+{
+	const FInventoryOp Op = FInventoryOp::Make(EInventoryOpType::ConsumeResource, ResourceId, Amount);
+	return QueueTransaction(MakeArrayView(&Op, 1));
+}
+
+bool UInventoryComponent::GrantBuilding(int32 BuildingId, int32 Count)
+{
+	const FInventoryOp Op = FInventoryOp::Make(EInventoryOpType::GrantBuilding, BuildingId, static_cast<float>(Count));
+	return QueueTransaction(MakeArrayView(&Op, 1));
+}
+
+bool UInventoryComponent::ConsumeBuilding(int32 BuildingId, int32 Count)
+{
+	const FInventoryOp Op = FInventoryOp::Make(EInventoryOpType::ConsumeBuilding, BuildingId, static_cast<float>(Count));
+	return QueueTransaction(MakeArrayView(&Op, 1));
+}
+
+void UInventoryComponent::Commit()
+{
+	if (NumPendingTransactions == 0)
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_GAM312_InventoryCommit);
+
+	FInventoryDelta Delta;
+	Delta.ResourcesGranted = PendingGranted;
+	Delta.NumTransactions = NumPendingTransactions;
+
+	for (TConstSetBitIterator<> It(DirtyResources); It; ++It)
+	{
+		const int32 Id = It.GetIndex();
+		if (Resources[Id] != ProjectedResources[Id])
+		{
+			Resources[Id] = ProjectedResources[Id];
+			Delta.ResourceIds.Add(Id);
+			Delta.ResourceTotals.Add(Resources[Id]);
+		}
+	}
+
+	for (TConstSetBitIterator<> It(DirtyBuildings); It; ++It)
+	{
+		const int32 Id = It.GetIndex();
+		if (Buildings[Id] != ProjectedBuildings[Id])
+		{
+			Buildings[Id] = ProjectedBuildings[Id];
+			Delta.BuildingIds.Add(Id);
+			Delta.BuildingTotals.Add(Buildings[Id]);
+		}
+	}
+
+	DirtyResources.SetRange(0, DirtyResources.Num(), false);
+	DirtyBuildings.SetRange(0, DirtyBuildings.Num(), false);
+	PendingGranted = 0.0f;
+	NumPendingTransactions = 0;
+
+	UpdateReplicatedEntries(Delta);
+
+	INC_DWORD_STAT(STAT_GAM312_InventoryCommits);
+
+	// Transactions that cancel out (grant then consume) leave nothing to report
+	if (Delta.ResourceIds.Num() > 0 || Delta.BuildingIds.Num() > 0)
+	{
+		OnInventoryChanged.Broadcast(Delta);
+	}
+}
+
+float UInventoryComponent::GetResourceByName(FName ResourceName) const
+{
+	return GetResource(UResourceRegistry::Get().FindResourceId(ResourceName));
+}
+
+int32 UInventoryComponent::GetBuildingCountByName(FName BuildingName) const
+{
+	return GetBuildingCount(UResourceRegistry::Get().FindBuildingId(BuildingName));
+}
+
+void UInventoryComponent::SetNumSlots(int32 NumResources, int32 NumBuildings)
+{
+	Resources.SetNum(NumResources);
+	Buildings.SetNum(NumBuildings);
+	ProjectedResources.SetNum(NumResources);
+	ProjectedBuildings.SetNum(NumBuildings);
+	GrantedTotals.SetNum(NumResources);
+	DirtyResources.SetNum(NumResources, false);
+	DirtyBuildings.SetNum(NumBuildings, false);
+
+	// The server lays out one entry per slot; clients receive that layout instead
+	if (!GetOwner() || GetOwner()->HasAuthority())
+	{
+		Entries.Items.SetNum(NumResources + NumBuildings);
+		for (int32 Index = 0; Index < Entries.Items.Num(); ++Index)
+		{
+			FInventoryEntry& Entry = Entries.Items[Index];
+			Entry.bBuilding = Index >= NumResources;
+			Entry.Id = Entry.bBuilding ? Index - NumResources : Index;
+			Entry.Amount = Entry.bBuilding ? Buildings[Entry.Id] : Resources[Entry.Id];
+		}
+		Entries.MarkArrayDirty();
+	}
+}
+
+void UInventoryComponent::RestoreTotals(TConstArrayView<float> InResources, TConstArrayView<int32> InBuildings)
+{
+	if (GetOwner() && !GetOwner()->HasAuthority())
+	{
+		return;
+	}
+
+	// Totals missing from the save (newer registry types) start empty
+	for (int32 Id = 0; Id < ProjectedResources.Num(); ++Id)
+	{
+		ProjectedResources[Id] = InResources.IsValidIndex(Id) ? InResources[Id] : 0.0f;
+	}
+	for (int32 Id = 0; Id < ProjectedBuildings.Num(); ++Id)
+	{
+		ProjectedBuildings[Id] = InBuildings.IsValidIndex(Id) ? InBuildings[Id] : 0;
+	}
+
+	DirtyResources.SetRange(0, DirtyResources.Num(), true);
+	DirtyBuildings.SetRange(0, DirtyBuildings.Num(), true);
+	PendingGranted = 0.0f;
+	++NumPendingTransactions;
+	Commit();
+}
+
+void UInventoryComponent::UpdateReplicatedEntries(const FInventoryDelta& Delta)
+{
+	if (GetOwner() && !GetOwner()->HasAuthority())
+	{
+		return;
+	}
+
+	for (int32 Index = 0; Index < Delta.ResourceIds.Num(); ++Index)
+	{
+		FInventoryEntry& Entry = Entries.Items[Delta.ResourceIds[Index]];
+		Entry.Amount = Delta.ResourceTotals[Index];
+		Entry.Granted = GrantedTotals[Entry.Id];
+		Entries.MarkItemDirty(Entry);
+	}
+
+	for (int32 Index = 0; Index < Delta.BuildingIds.Num(); ++Index)
+	{
+		FInventoryEntry& Entry = Entries.Items[Resources.Num() + Delta.BuildingIds[Index]];
+		Entry.Amount = static_cast<float>(Delta.BuildingTotals[Index]);
+		Entries.MarkItemDirty(Entry);
+	}
+}
+
+// Client side: treat each replicated total like a queued change, so a whole update
+// from the server still reaches listeners as one OnInventoryChanged. Only what the server
+// granted since the last update counts as granted; a total arriving on join, or one restored
+// from a save, does not.
+void UInventoryComponent::OnEntryReplicated(const FInventoryEntry& Entry, bool bInitial)
+{
+	if (Entry.Id < 0)
+	{
+		return;
+	}
+
+	if (Entry.bBuilding)
+	{
+		if (Entry.Id >= ProjectedBuildings.Num())
+		{
+			SetNumSlots(Resources.Num(), Entry.Id + 1);
+		}
+		ProjectedBuildings[Entry.Id] = FMath::RoundToInt(Entry.Amount);
+		DirtyBuildings[Entry.Id] = true;
+	}
+	else
+	{
+		if (Entry.Id >= ProjectedResources.Num())
+		{
+			SetNumSlots(Entry.Id + 1, Buildings.Num());
+		}
+		PendingGranted += bInitial ? 0.0f : FMath::Max(Entry.Granted - GrantedTotals[Entry.Id], 0.0f);
+		GrantedTotals[Entry.Id] = Entry.Granted;
+		ProjectedResources[Entry.Id] = Entry.Amount;
+		DirtyResources[Entry.Id] = true;
+	}
+
+	NumPendingTransactions = FMath::Max(NumPendingTransactions, 1);
+	if (!IsComponentTickEnabled())
+	{
+		SetComponentTickEnabled(true);
+	}
+}
+
+void FInventoryEntry::PostReplicatedAdd(const FInventoryEntryArray& InArray)
+{
+	if (InArray.Owner)
+	{
+		InArray.Owner->OnEntryReplicated(*this, true);
+	}
+}
+
+void FInventoryEntry::PostReplicatedChange(const FInventoryEntryArray& InArray)
+{
+	if (InArray.Owner)
+	{
+		InArray.Owner->OnEntryReplicated(*this, false);
+	}
+}
+
+/** ---------- Test Harness ---------- **/
+
+static FAutoConsoleCommand GInventoryTestCommand(
+	TEXT("gam312.Inventory.Test"),
+	TEXT("Fires random grant/consume transactions at an inventory, committing every few ops like frames would, then checks the totals against a reference model and logs throughput. Optional args: op count (default 100000), ops per frame (default 64)."),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		const int32 NumOps = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 100000;
+		const int32 OpsPerFrame = Args.Num() > 1 ? FMath::Max(FCString::Atoi(*Args[1]), 1) : 64;
+
+		const UResourceRegistry& Registry = UResourceRegistry::Get();
+		const int32 NumResources = Registry.NumResources();
+		const int32 NumBuildings = Registry.NumBuildings();
+		if (NumResources == 0 || NumBuildings == 0)
+		{
+			UE_LOG(LogGAM312, Warning, TEXT("[InventoryTest] Registry has no resources or buildings"));
+			return;
+		}
+
+		UInventoryComponent* Inventory = NewObject<UInventoryComponent>(GetTransientPackage());
+		Inventory->SetNumSlots(NumResources, NumBuildings);
+
+		// Reference model: applies the same transactions immediately, one at a time
+		TArray<float> ExpectedResources;
+		TArray<int32> ExpectedBuildings;
+		ExpectedResources.SetNumZeroed(NumResources);
+		ExpectedBuildings.SetNumZeroed(NumBuildings);
+
+		auto ApplyExpected = [&ExpectedResources, &ExpectedBuildings](TConstArrayView<FInventoryOp> Ops)
+		{
+			TArray<float> Resources = ExpectedResources;
+			TArray<int32> Buildings = ExpectedBuildings;
+			for (const FInventoryOp& Op : Ops)
+			{
+				const int32 Count = FMath::RoundToInt(Op.Amount);
+				switch (Op.Type)
+				{
+				case EInventoryOpType::GrantResource:   Resources[Op.Id] += Op.Amount; break;
+				case EInventoryOpType::ConsumeResource: if (Resources[Op.Id] < Op.Amount) { return false; } Resources[Op.Id] -= Op.Amount; break;
+				case EInventoryOpType::GrantBuilding:   Buildings[Op.Id] += Count; break;
+				case EInventoryOpType::ConsumeBuilding: if (Buildings[Op.Id] < Count) { return false; } Buildings[Op.Id] -= Count; break;
+				}
+			}
+			ExpectedResources = MoveTemp(Resources);
+			ExpectedBuildings = MoveTemp(Buildings);
+			return true;
+		};
+
+		// Harvests, single consumes, recipe-shaped crafts and piece placements
+		FRandomStream Random(312);
+		TArray<FInventoryOp> Ops;
+		int32 NumAccepted = 0;
+		int32 NumMismatched = 0;
+		int32 NumCommits = 0;
+		int32 NumTornReads = 0;
+		double CommitSeconds = 0.0;
+
+		TArray<float> LastCommitted = Inventory->GetResources();
+		const double StartTime = FPlatformTime::Seconds();
+
+		for (int32 OpIndex = 0; OpIndex < NumOps; ++OpIndex)
+		{
+			Ops.Reset();
+			const int32 Roll = Random.RandRange(0, 99);
+			const int32 ResourceId = Random.RandRange(0, NumResources - 1);
+			const int32 BuildingId = Random.RandRange(0, NumBuildings - 1);
+
+			if (Roll < 45)
+			{
+				Ops.Add(FInventoryOp::Make(EInventoryOpType::GrantResource, ResourceId, static_cast<float>(Random.RandRange(1, 10))));
+			}
+			else if (Roll < 70)
+			{
+				Ops.Add(FInventoryOp::Make(EInventoryOpType::ConsumeResource, ResourceId, static_cast<float>(Random.RandRange(1, 10))));
+			}
+			else if (Roll < 85)
+			{
+				for (const FResourceCost& Cost : Registry.Buildings[BuildingId].Cost)
+				{
+					Ops.Add(FInventoryOp::Make(EInventoryOpType::ConsumeResource, Cost.ResourceId, Cost.Amount));
+				}
+				Ops.Add(FInventoryOp::Make(EInventoryOpType::GrantBuilding, BuildingId, 1.0f));
+			}
+			else
+			{
+				Ops.Add(FInventoryOp::Make(EInventoryOpType::ConsumeBuilding, BuildingId, 1.0f));
+			}
+
+			const bool bAccepted = Inventory->QueueTransaction(Ops);
+			NumAccepted += bAccepted ? 1 : 0;
+			NumMismatched += bAccepted != ApplyExpected(Ops) ? 1 : 0;
+
+			// Nothing queued may be visible before the commit
+			NumTornReads += Inventory->GetResources() != LastCommitted ? 1 : 0;
+
+			if ((OpIndex + 1) % OpsPerFrame == 0 || OpIndex == NumOps - 1)
+			{
+				const double CommitStart = FPlatformTime::Seconds();
+				Inventory->Commit();
+				CommitSeconds += FPlatformTime::Seconds() - CommitStart;
+				++NumCommits;
+				LastCommitted = Inventory->GetResources();
+			}
+		}
+
+		const double TotalSeconds = FMath::Max(FPlatformTime::Seconds() - StartTime, UE_SMALL_NUMBER);
+
+		int32 NumWrongTotals = 0;
+		for (int32 Id = 0; Id < NumResources; ++Id)
+		{
+			NumWrongTotals += Inventory->GetResource(Id) != ExpectedResources[Id] ? 1 : 0;
+		}
+		for (int32 Id = 0; Id < NumBuildings; ++Id)
+		{
+			NumWrongTotals += Inventory->GetBuildingCount(Id) != ExpectedBuildings[Id] ? 1 : 0;
+		}
+
+		const bool bPassed = NumMismatched == 0 && NumWrongTotals == 0 && NumTornReads == 0;
+		UE_LOG(LogGAM312, Display, TEXT("[InventoryTest] %s: %d transactions (%d accepted), %d commits; %.0f transactions/s, %.2f us per commit; %d accept mismatches, %d wrong totals, %d torn reads"),
+			bPassed ? TEXT("PASSED") : TEXT("FAILED"),
+			NumOps, NumAccepted, NumCommits,
+			NumOps / TotalSeconds, CommitSeconds * 1.0e6 / FMath::Max(NumCommits, 1),
+			NumMismatched, NumWrongTotals, NumTornReads);
+
+		Inventory->MarkAsGarbage();
+	}));
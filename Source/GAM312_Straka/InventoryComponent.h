@@ -0,0 +1,267 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "Net/Serialization/FastArraySerializer.h"
+#include "InventoryComponent.generated.h"
+
+/**
+ * EInventoryOpType
+ */
+UENUM(BlueprintType)
+enum class EInventoryOpType : uint8
+{
+	GrantResource,
+	ConsumeResource,
+	GrantBuilding,
+	ConsumeBuilding
+};
+
+/**
+ * FInventoryOp
+ *
+ * One grant or consume of a resource (by registry resource ID) or building piece
+ * (by registry building ID).
+ */
+USTRUCT(BlueprintType)
+struct FInventoryOp
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	EInventoryOpType Type = EInventoryOpType::GrantResource;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 Id = INDEX_NONE;
+
+	// Resource amount, or number of building pieces
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float Amount = 0.0f;
+
+	static FInventoryOp Make(EInventoryOpType InType, int32 InId, float InAmount)
+	{
+		FInventoryOp Op;
+		Op.Type = InType;
+		Op.Id = InId;
+		Op.Amount = InAmount;
+		return Op;
+	}
+};
+
+/**
+ * FInventoryDelta
+ *
+ * Everything that changed in one commit, sent to listeners once per frame.
+ * Only entries that actually changed are listed, with their new totals.
+ */
+USTRUCT(BlueprintType)
+struct FInventoryDelta
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly)
+	TArray<int32> ResourceIds;
+
+	UPROPERTY(BlueprintReadOnly)
+	TArray<float> ResourceTotals;
+
+	UPROPERTY(BlueprintReadOnly)
+	TArray<int32> BuildingIds;
+
+	UPROPERTY(BlueprintReadOnly)
+	TArray<int32> BuildingTotals;
+
+	// Sum of resources granted this commit (objective progress)
+	UPROPERTY(BlueprintReadOnly)
+	float ResourcesGranted = 0.0f;
+
+	// Transactions folded into this commit
+	UPROPERTY(BlueprintReadOnly)
+	int32 NumTransactions = 0;
+};
+
+class UInventoryComponent;
+
+/**
+ * FInventoryEntry
+ *
+ * Committed total of one resource or building slot, as replicated to the owner.
+ */
+USTRUCT()
+struct FInventoryEntry : public FFastArraySerializerItem
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	int32 Id = INDEX_NONE;
+
+	UPROPERTY()
+	bool bBuilding = false;
+
+	UPROPERTY()
+	float Amount = 0.0f;
+
+	// Everything ever granted to this resource slot (not restored totals), so clients can tell grants apart
+	UPROPERTY()
+	float Granted = 0.0f;
+
+	void PostReplicatedAdd(const struct FInventoryEntryArray& InArray);
+	void PostReplicatedChange(const struct FInventoryEntryArray& InArray);
+};
+
+/**
+ * FInventoryEntryArray
+ *
+ * Every slot of an inventory (resources first, then buildings). Only entries marked
+ * dirty by a commit are sent.
+ */
+USTRUCT()
+struct FInventoryEntryArray : public FFastArraySerializer
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<FInventoryEntry> Items;
+
+	// Component receiving replicated changes (not replicated)
+	UPROPERTY(NotReplicated)
+	TObjectPtr<UInventoryComponent> Owner = nullptr;
+
+	bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms)
+	{
+		return FFastArraySerializer::FastArrayDeltaSerialize<FInventoryEntry, FInventoryEntryArray>(Items, DeltaParms, *this);
+	}
+};
+
+template<>
+struct TStructOpsTypeTraits<FInventoryEntryArray> : public TStructOpsTypeTraitsBase2<FInventoryEntryArray>
+{
+	enum { WithNetDeltaSerializer = true };
+};
+
+// Fired at most once per frame after queued inventory operations are committed
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnInventoryChanged, const FInventoryDelta&, Delta);
+
+/**
+ * UInventoryComponent
+ *
+ * Resource amounts and building piece counts, indexed by UResourceRegistry IDs.
+ * Grants and consumes are queued as all-or-nothing transactions: each is checked
+ * against the committed totals plus everything queued before it, and rejected as a
+ * whole if any consume would go negative. Queued changes are committed together at
+ * the end of the frame, so readers and OnInventoryChanged listeners see one coalesced
+ * change per frame no matter how many operations ran.
+ *
+ * Only the server changes an inventory. Committed entries replicate to the owning
+ * client as a fast array, and the client raises the same coalesced OnInventoryChanged.
+ */
+UCLASS(ClassGroup = (Custom), meta = (BlueprintSpawnableComponent))
+class GAM312_STRAKA_API UInventoryComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UInventoryComponent();
+
+	virtual void BeginPlay() override;
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+	// Commits pending operations; only enabled while something is queued
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	/** ---------- Queued Operations ---------- **/
+
+	// Queues ops as one transaction. Returns false, queuing nothing, if any op is invalid or unaffordable,
+	// or if called on a client (clients only mirror the server's inventory).
+	bool QueueTransaction(TConstArrayView<FInventoryOp> Ops);
+
+	UFUNCTION(BlueprintCallable, Category = "Inventory")
+	bool QueueOps(const TArray<FInventoryOp>& Ops) { return QueueTransaction(Ops); }
+
+	UFUNCTION(BlueprintCallable, Category = "Inventory")
+	bool GrantResource(int32 ResourceId, float Amount);
+
+	UFUNCTION(BlueprintCallable, Category = "Inventory")
+	bool ConsumeResource(int32 ResourceId, float Amount);
+
+	UFUNCTION(BlueprintCallable, Category = "Inventory")
+	bool GrantBuilding(int32 BuildingId, int32 Count = 1);
+
+	UFUNCTION(BlueprintCallable, Category = "Inventory")
+	bool ConsumeBuilding(int32 BuildingId, int32 Count = 1);
+
+	// Applies everything queued so far and notifies listeners (normally done once per frame)
+	UFUNCTION(BlueprintCallable, Category = "Inventory")
+	void Commit();
+
+	bool HasPendingChanges() const { return NumPendingTransactions > 0; }
+
+	/** ---------- Queries ---------- **/
+
+	// Committed amount of a resource
+	UFUNCTION(BlueprintPure, Category = "Inventory")
+	float GetResource(int32 ResourceId) const { return Resources.IsValidIndex(ResourceId) ? Resources[ResourceId] : 0.0f; }
+
+	// Committed number of building pieces
+	UFUNCTION(BlueprintPure, Category = "Inventory")
+	int32 GetBuildingCount(int32 BuildingId) const { return Buildings.IsValidIndex(BuildingId) ? Buildings[BuildingId] : 0; }
+
+	// Resource amount once queued operations commit
+	UFUNCTION(BlueprintPure, Category = "Inventory")
+	float GetProjectedResource(int32 ResourceId) const { return ProjectedResources.IsValidIndex(ResourceId) ? ProjectedResources[ResourceId] : 0.0f; }
+
+	// Building count once queued operations commit
+	UFUNCTION(BlueprintPure, Category = "Inventory")
+	int32 GetProjectedBuildingCount(int32 BuildingId) const { return ProjectedBuildings.IsValidIndex(BuildingId) ? ProjectedBuildings[BuildingId] : 0; }
+
+	// Name-based lookups for Blueprints
+	UFUNCTION(BlueprintPure, Category = "Inventory")
+	float GetResourceByName(FName ResourceName) const;
+
+	UFUNCTION(BlueprintPure, Category = "Inventory")
+	int32 GetBuildingCountByName(FName BuildingName) const;
+
+	const TArray<float>& GetResources() const { return Resources; }
+	const TArray<int32>& GetBuildings() const { return Buildings; }
+
+	// Resizes to the given registry sizes, keeping existing totals and anything queued
+	void SetNumSlots(int32 NumResources, int32 NumBuildings);
+
+	// Server: replaces every total (e.g. from a save), dropping anything queued, and commits right away
+	void RestoreTotals(TConstArrayView<float> InResources, TConstArrayView<int32> InBuildings);
+
+	UPROPERTY(BlueprintAssignable, Category = "Inventory")
+	FOnInventoryChanged OnInventoryChanged;
+
+	// Called by replicated entries on the owning client; the first state of an entry counts as no grant
+	void OnEntryReplicated(const FInventoryEntry& Entry, bool bInitial);
+
+private:
+	// Marks the fast-array entries of every committed change dirty
+	void UpdateReplicatedEntries(const FInventoryDelta& Delta);
+
+	// Committed totals sent to the owning client
+	UPROPERTY(Replicated)
+	FInventoryEntryArray Entries;
+
+	// Committed totals (indexed by registry ID)
+	UPROPERTY(VisibleInstanceOnly, Category = "Inventory")
+	TArray<float> Resources;
+
+	UPROPERTY(VisibleInstanceOnly, Category = "Inventory")
+	TArray<int32> Buildings;
+
+	// Committed totals plus every queued transaction
+	TArray<float> ProjectedResources;
+	TArray<int32> ProjectedBuildings;
+
+	// IDs touched since the last commit
+	TBitArray<> DirtyResources;
+	TBitArray<> DirtyBuildings;
+
+	// Server: everything granted per resource, queued grants included. Client: the last replicated value
+	TArray<float> GrantedTotals;
+
+	float PendingGranted = 0.0f;
+	int32 NumPendingTransactions = 0;
+};
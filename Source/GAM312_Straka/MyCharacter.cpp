@@ -1,6 +1,19 @@
 
 
 #include "MyCharacter.h"
+#include "GAM312_Straka.h"
+#include "BuildingManagerSubsystem.h"
+#include "BuildingPreviewPool.h"
+#include "BuildingReplicator.h"
+#include "NetLoopbackTestSubsystem.h"
+#include "ResourceLifecycleSubsystem.h"
+#include "ResourceSpatialSubsystem.h"
+#include "SurvivalStatsSubsystem.h"
+#include "WorldSaveSubsystem.h"
+#include "Net/UnrealNetwork.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("HUD Updates Pushed"), STAT_GAM312_HUDUpdatesPushed, STATGROUP_GAM312);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("HUD Updates Skipped"), STAT_GAM312_HUDUpdatesSkipped, STATGROUP_GAM312);
 
 // Sets default values
 AMyCharacter::AMyCharacter()
@@ -12,52 +25,125 @@ AMyCharacter::AMyCharacter()
 	PlayerCamComp->SetupAttachment(RootComponent);
 	PlayerCamComp->bUsePawnControlRotation = true;
 
-	// Initialize arrays for building parts and resources
-	BuildingArray.SetNum(3);  // e.g., Wall, Floor, Ceiling
-	ResourcesArray.SetNum(3); // e.g., Wood, Stone, Berry
-
-	// Add names to identify resource types (used in GiveResource logic)
-	ResourcesNameArray.Add(TEXT("Wood"));
-	ResourcesNameArray.Add(TEXT("Stone"));
-	ResourcesNameArray.Add(TEXT("Berry"));
+	// Resources (e.g., Wood, Stone, Berry) and building parts (e.g., Wall, Floor, Ceiling)
+	Inventory = CreateDefaultSubobject<UInventoryComponent>(TEXT("Inventory"));
 }
 
 // Called when the game starts or the actor is spawned
 void AMyCharacter::BeginPlay()
 {
+	GAM312_SCOPE(AMyCharacter, BeginPlay);
+
 	Super::BeginPlay();
 
-	// Start a timer that periodically decreases stats every 2 seconds
-	FTimerHandle StatsTimerHandle;
-	GetWorld()->GetTimerManager().SetTimer(StatsTimerHandle, this, &AMyCharacter::DecreaseStats, 2.0f, true);
+	// Cache the resource names of the configured registry
+	const UResourceRegistry& Registry = UResourceRegistry::Get();
+	ResourcesNameArray.Reset(Registry.NumResources());
+	for (const FResourceTypeDef& Resource : Registry.Resources)
+	{
+		ResourcesNameArray.Add(Resource.Name);
+	}
+
+	Inventory->OnInventoryChanged.AddDynamic(this, &AMyCharacter::OnInventoryChanged);
+	ResourcesArray = Inventory->GetResources();
+	BuildingArray = Inventory->GetBuildings();
+
+	// Pre-spawn building previews so entering build mode never spawns an actor
+	if (UBuildingPreviewPool* PreviewPool = GetWorld()->GetSubsystem<UBuildingPreviewPool>())
+	{
+		PreviewPool->Prewarm(BuildPartClass, PreviewPoolSize);
+		for (const FBuildingTypeDef& BuildingType : Registry.Buildings)
+		{
+			PreviewPool->Prewarm(BuildingType.PartClass, PreviewPoolSize);
+		}
+	}
+
+	// Stats decrease every 2 seconds in the world's batched survival pass (on the server; clients get them replicated)
+	if (HasAuthority())
+	{
+		if (USurvivalStatsSubsystem* SurvivalStats = GetWorld()->GetSubsystem<USurvivalStatsSubsystem>())
+		{
+			SurvivalStats->RegisterCharacter(this);
+		}
+		else
+		{
+			FTimerHandle StatsTimerHandle;
+			GetWorld()->GetTimerManager().SetTimer(StatsTimerHandle, this, &AMyCharacter::DecreaseStats, USurvivalStatsSubsystem::StepInterval, true);
+		}
+	}
 
 	// Reset UI progress bars
 	if (objWidget)
 	{
 		objWidget->UpdatebuildObj(0.0f);
 		objWidget->UpdatematOBJ(0.0f);
+		GAM312_COUNT_BY(UIEvents, 2);
 	}
 
 	// Sanity check: ensure the camera component is valid
 	check(PlayerCamComp != nullptr);
 }
 
+// Called when the actor is removed from the world
+void AMyCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	GAM312_SCOPE(AMyCharacter, EndPlay);
+
+	if (USurvivalStatsSubsystem* SurvivalStats = GetWorld()->GetSubsystem<USurvivalStatsSubsystem>())
+	{
+		SurvivalStats->UnregisterCharacter(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+// Saves are keyed by player name, which is only known once a player state is attached
+void AMyCharacter::PossessedBy(AController* NewController)
+{
+	GAM312_SCOPE(AMyCharacter, PossessedBy);
+
+	Super::PossessedBy(NewController);
+
+	if (GetPlayerState())
+	{
+		if (UWorldSaveSubsystem* WorldSave = GetWorld()->GetSubsystem<UWorldSaveSubsystem>())
+		{
+			WorldSave->RestorePlayer(this);
+		}
+	}
+}
+
+void AMyCharacter::UnPossessed()
+{
+	GAM312_SCOPE(AMyCharacter, UnPossessed);
+
+	// The player state (and with it the save key) is cleared by Super
+	if (HasAuthority() && GetPlayerState())
+	{
+		if (UWorldSaveSubsystem* WorldSave = GetWorld()->GetSubsystem<UWorldSaveSubsystem>())
+		{
+			WorldSave->StashPlayer(this);
+		}
+	}
+
+	Super::UnPossessed();
+}
+
 // Called every frame
 void AMyCharacter::Tick(float DeltaTime)
 {
-	Super::Tick(DeltaTime);
+	GAM312_SCOPE(AMyCharacter, Tick);
 
-	// Update player HUD elements (e.g., health, hunger, stamina bars)
-	playerUI->UpdateBars(Health, Hunger, Stamina);
+	Super::Tick(DeltaTime);
 
-	// Move the spawned buildable part in front of the camera if in build mode
-	if (isBuilding && spawnedPart)
+	// Update player HUD elements only when a stat actually changed this frame
+	if (PendingStatChanges != EPlayerStatFlags::None)
 	{
-		FVector StartLocation = PlayerCamComp->GetComponentLocation();
-		FVector Direction = PlayerCamComp->GetForwardVector() * 400.0f;
-		FVector EndLocation = StartLocation + Direction;
-
-		spawnedPart->SetActorLocation(EndLocation);
+		FlushStatChanges();
+	}
+	else
+	{
+		INC_DWORD_STAT(STAT_GAM312_HUDUpdatesSkipped);
 	}
 }
 
@@ -81,9 +167,19 @@ void AMyCharacter::SetupPlayerInputComponent(UInputComponent* PlayerInputCompone
 	PlayerInputComponent->BindAction("RotPart", IE_Pressed, this, &AMyCharacter::RotateBuilding);
 }
 
+// Stats only matter to the player who owns them
+void AMyCharacter::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME_CONDITION(AMyCharacter, ReplicatedStats, COND_OwnerOnly);
+}
+
 // Character movement logic - forward/backward
 void AMyCharacter::MoveForward(float AxisValue)
 {
+	GAM312_SCOPE(AMyCharacter, MoveForward);
+
 	if (Controller && AxisValue != 0.0f)
 	{
 		FRotator Rotation = Controller->GetControlRotation();
@@ -97,6 +193,8 @@ void AMyCharacter::MoveForward(float AxisValue)
 // Character movement logic - left/right
 void AMyCharacter::MoveRight(float AxisValue)
 {
+	GAM312_SCOPE(AMyCharacter, MoveRight);
+
 	if (Controller && AxisValue != 0.0f)
 	{
 		FRotator Rotation = Controller->GetControlRotation();
@@ -110,94 +208,515 @@ void AMyCharacter::MoveRight(float AxisValue)
 // Called when jump input is pressed
 void AMyCharacter::StartJump()
 {
+	GAM312_SCOPE(AMyCharacter, StartJump);
+
 	bPressedJump = true;
 }
 
 // Called when jump input is released
 void AMyCharacter::StopJump()
 {
+	GAM312_SCOPE(AMyCharacter, StopJump);
+
 	bPressedJump = false;
 }
 
 // Triggers either resource collection or finalizes building placement
 void AMyCharacter::FindObject()
 {
-	FHitResult HitResult;
-	FVector StartLocation = PlayerCamComp->GetComponentLocation();
-	FVector Direction = PlayerCamComp->GetForwardVector() * 800.0f;
-	FVector EndLocation = StartLocation + Direction;
+	GAM312_SCOPE(AMyCharacter, FindObject);
 
-	FCollisionQueryParams QueryParams;
-	QueryParams.AddIgnoredActor(this);
-	QueryParams.bTraceComplex = true;
-	QueryParams.bReturnFaceIndex = true;
+	FVector StartLocation = PlayerCamComp->GetComponentLocation();
 
 	if (!isBuilding)
 	{
-		// Attempt to hit a resource actor
-		if (GetWorld()->LineTraceSingleByChannel(HitResult, StartLocation, EndLocation, ECC_Visibility, QueryParams))
+		// Skip the trace entirely when no resource node is within reach
+		if (const UResourceSpatialSubsystem* SpatialIndex = GetWorld()->GetSubsystem<UResourceSpatialSubsystem>())
+		{
+			FResourceQuery Query;
+			Query.Origin = StartLocation;
+			Query.Radius = InteractionTrace.Range;
+
+			TArray<FResourceHit> Nearby;
+			SpatialIndex->FindNearest(Query, Nearby);
+			if (Nearby.Num() == 0)
+			{
+				return;
+			}
+		}
+
+		// The server owns resource nodes and inventories, so clients ask it to harvest
+		if (HasAuthority())
+		{
+			HarvestAlong(StartLocation, PlayerCamComp->GetForwardVector());
+		}
+		else
+		{
+			ServerHarvest(StartLocation, PlayerCamComp->GetForwardVector());
+		}
+	}
+	else
+	{
+		// The placement solver reported an overlap; keep previewing
+		if (spawnedPart && !spawnedPart->IsPlacementValid())
+		{
+			return;
+		}
+
+		// Finalize building placement
+		isBuilding = false;
+
+		// Re-placing an edited part does not count as a new build
+		const bool bWasEditing = isEditingPart;
+		if (!isEditingPart)
 		{
-			AResource_M* HitResource = Cast<AResource_M>(HitResult.GetActor());
-			if (Stamina > 5.0f && HitResource)
+			objectsBuilt += 1.0f;
+			if (objWidget)
 			{
-				FString hitName = HitResource->resourceName;
-				int resourceValue = HitResource->resourceAmount;
+				objWidget->UpdatebuildObj(objectsBuilt);
+				GAM312_COUNT(UIEvents);
+			}
+		}
+		isEditingPart = false;
 
-				HitResource->totalResource -= resourceValue;
+		if (spawnedPart)
+		{
+			spawnedPart->StopPreview();
+		}
 
-				if (HitResource->totalResource >= resourceValue)
+		// Clients hand the preview back and let the server place (and pay for) the part;
+		// it comes back through the building replicator
+		if (!HasAuthority())
+		{
+			if (spawnedPart)
+			{
+				ServerPlaceBuilding(PreviewBuildingId, spawnedPart->GetActorLocation(), spawnedPart->GetActorRotation(), bWasEditing);
+				if (UBuildingPreviewPool* PreviewPool = GetWorld()->GetSubsystem<UBuildingPreviewPool>())
 				{
-					GiveResource(resourceValue, hitName);
-					matsCollected += resourceValue;
-					objWidget->UpdatematOBJ(matsCollected);
-					SetStamina(-5.0f);
+					PreviewPool->Release(spawnedPart);
 				}
 				else
 				{
-					HitResource->Destroy(); // Resource depleted
+					spawnedPart->Destroy();
 				}
+				spawnedPart = nullptr;
 			}
+			return;
 		}
+
+		// Hand the placed part to the building manager so it is drawn as an instance,
+		// then recycle the preview actor instead of destroying it
+		UBuildingManagerSubsystem* BuildingManager = GetWorld()->GetSubsystem<UBuildingManagerSubsystem>();
+		if (BuildingManager && BuildingManager->AbsorbPart(spawnedPart, false) != INDEX_NONE)
+		{
+			if (UBuildingPreviewPool* PreviewPool = GetWorld()->GetSubsystem<UBuildingPreviewPool>())
+			{
+				PreviewPool->Release(spawnedPart);
+			}
+			else
+			{
+				spawnedPart->Destroy();
+			}
+			spawnedPart = nullptr;
+		}
+	}
+}
+
+// Harvests the resource node along the given view (server)
+void AMyCharacter::HarvestAlong(const FVector& Start, const FVector& Direction)
+{
+	GAM312_SCOPE(AMyCharacter, HarvestAlong);
+
+	FHitResult HitResult;
+
+	// Attempt to hit a resource actor
+	if (TraceInteraction(Start, Direction, HitResult))
+	{
+		AResource_M* HitResource = Cast<AResource_M>(HitResult.GetActor());
+		if (Stamina > 5.0f && HitResource)
+		{
+			int resourceValue = HitResource->resourceAmount;
+
+			HitResource->totalResource -= resourceValue;
+			if (UWorldSaveSubsystem* WorldSave = GetWorld()->GetSubsystem<UWorldSaveSubsystem>())
+			{
+				WorldSave->MarkResourceDirty(HitResource);
+			}
+
+			if (HitResource->totalResource >= resourceValue)
+			{
+				// Objective progress follows once the grant commits (OnInventoryChanged)
+				GiveResourceById(HitResource->ResourceId, resourceValue);
+				SetStamina(-5.0f);
+			}
+			else
+			{
+				// Resource depleted: hide it until it regrows
+				if (UResourceLifecycleSubsystem* Lifecycle = GetWorld()->GetSubsystem<UResourceLifecycleSubsystem>())
+				{
+					Lifecycle->DepleteNode(HitResource);
+				}
+				else
+				{
+					HitResource->Destroy();
+				}
+				InteractionTraceCache.Invalidate();
+			}
+		}
+	}
+}
+
+bool AMyCharacter::IsWithinReach(const FVector& Location, float Reach) const
+{
+	return FVector::DistSquared(Location, GetActorLocation()) <= FMath::Square(Reach);
+}
+
+bool AMyCharacter::ServerHarvest_Validate(FVector_NetQuantize ViewLocation, FVector_NetQuantizeNormal ViewDirection)
+{
+	return !ViewLocation.ContainsNaN() && !ViewDirection.ContainsNaN();
+}
+
+void AMyCharacter::ServerHarvest_Implementation(FVector_NetQuantize ViewLocation, FVector_NetQuantizeNormal ViewDirection)
+{
+	GAM312_SCOPE(AMyCharacter, ServerHarvest);
+
+	// Trust the client's aim, but not a view from somewhere the character isn't
+	if (FVector::DistSquared(ViewLocation, GetPawnViewLocation()) > FMath::Square(MaxViewError))
+	{
+		return;
+	}
+
+	HarvestAlong(ViewLocation, ViewDirection.GetSafeNormal());
+}
+
+bool AMyCharacter::ServerPlaceBuilding_Validate(int32 BuildingId, FVector_NetQuantize10 Location, FRotator Rotation, bool bEdit)
+{
+	return !Location.ContainsNaN() && !Rotation.ContainsNaN();
+}
+
+void AMyCharacter::ServerPlaceBuilding_Implementation(int32 BuildingId, FVector_NetQuantize10 Location, FRotator Rotation, bool bEdit)
+{
+	GAM312_SCOPE(AMyCharacter, ServerPlaceBuilding);
+
+	UBuildingManagerSubsystem* BuildingManager = GetWorld()->GetSubsystem<UBuildingManagerSubsystem>();
+	if (!BuildingManager)
+	{
+		return;
+	}
+
+	TSubclassOf<ABuildingPart> PartClass;
+	if (bEdit)
+	{
+		if (!bHasPendingEdit)
+		{
+			return;
+		}
+
+		PartClass = PendingEditClass;
+		BuildingId = PendingEditBuildingId;
+		bHasPendingEdit = false;
 	}
 	else
 	{
-		// Finalize building placement
+		const UResourceRegistry& Registry = UResourceRegistry::Get();
+		if (!Registry.Buildings.IsValidIndex(BuildingId) || Inventory->GetProjectedBuildingCount(BuildingId) < 1)
+		{
+			return;
+		}
+
+		PartClass = Registry.Buildings[BuildingId].PartClass ? Registry.Buildings[BuildingId].PartClass : BuildPartClass;
+	}
+
+	// Re-check what the client's preview already checked: reach and overlaps
+	const bool bPlaced = IsWithinReach(Location, MaxBuildReach)
+		&& BuildingManager->PlacePart(PartClass, BuildingId, FTransform(Rotation, Location), true);
+
+	if (bPlaced && !bEdit)
+	{
+		Inventory->ConsumeBuilding(BuildingId);
+	}
+	else if (!bPlaced && bEdit)
+	{
+		// Never lose a picked-up part: put it back where it was
+		BuildingManager->PlacePart(PartClass, BuildingId, PendingEditTransform, false);
+	}
+}
+
+bool AMyCharacter::ServerEditBuilding_Validate(int32 NetId)
+{
+	return NetId >= 0;
+}
+
+void AMyCharacter::ServerEditBuilding_Implementation(int32 NetId)
+{
+	GAM312_SCOPE(AMyCharacter, ServerEditBuilding);
+
+	UBuildingManagerSubsystem* BuildingManager = GetWorld()->GetSubsystem<UBuildingManagerSubsystem>();
+	const FPlacedBuildingRecord* Record = BuildingManager ? BuildingManager->GetRecord(NetId) : nullptr;
+	if (!Record || bHasPendingEdit || !IsWithinReach(Record->Transform.GetLocation(), MaxBuildReach))
+	{
+		// The client already took its copy off the grid; tell it to put the piece back
+		if (Record)
+		{
+			ClientRejectEdit(NetId, Record->BuildingId, Record->PartClass, Record->Transform.GetLocation(), Record->Transform.Rotator());
+		}
+		else
+		{
+			ClientRejectEdit(NetId, INDEX_NONE, nullptr, FVector::ZeroVector, FRotator::ZeroRotator);
+		}
+		return;
+	}
+
+	FPlacedBuildingRecord Removed;
+	if (BuildingManager->RemovePart(NetId, &Removed))
+	{
+		PendingEditClass = Removed.PartClass;
+		PendingEditBuildingId = Removed.BuildingId;
+		PendingEditTransform = Removed.Transform;
+		bHasPendingEdit = true;
+	}
+}
+
+void AMyCharacter::ClientRejectEdit_Implementation(int32 NetId, int32 BuildingId, TSubclassOf<ABuildingPart> PartClass, FVector_NetQuantize10 Location, FRotator Rotation)
+{
+	GAM312_SCOPE(AMyCharacter, ClientRejectEdit);
+
+	// Still holding the refused part: drop the preview without placing anything
+	if (isEditingPart && EditNetId == NetId && spawnedPart)
+	{
+		spawnedPart->StopPreview();
+		if (UBuildingPreviewPool* PreviewPool = GetWorld()->GetSubsystem<UBuildingPreviewPool>())
+		{
+			PreviewPool->Release(spawnedPart);
+		}
+		else
+		{
+			spawnedPart->Destroy();
+		}
+		spawnedPart = nullptr;
 		isBuilding = false;
-		objectsBuilt += 1.0f;
-		objWidget->UpdatebuildObj(objectsBuilt);
+		isEditingPart = false;
+	}
+
+	// The server still has the piece and will never send it again, so mirror it back in
+	UBuildingManagerSubsystem* BuildingManager = GetWorld()->GetSubsystem<UBuildingManagerSubsystem>();
+	if (BuildingManager && PartClass)
+	{
+		FReplicatedBuildingPiece Piece;
+		Piece.RecordId = NetId;
+		Piece.BuildingId = BuildingId;
+		Piece.PartClass = PartClass;
+		Piece.Location = Location;
+		Piece.Rotation = Rotation;
+		BuildingManager->AddNetPiece(Piece);
+	}
+}
+
+bool AMyCharacter::ServerCraftBuilding_Validate(FName buildingType)
+{
+	return true;
+}
+
+void AMyCharacter::ServerCraftBuilding_Implementation(FName buildingType)
+{
+	GAM312_SCOPE(AMyCharacter, ServerCraftBuilding);
+
+	bool isSuccess = false;
+	CraftBuilding(buildingType, isSuccess);
+}
+
+bool AMyCharacter::ServerConsumeResource_Validate(FName resourceType, float amount)
+{
+	return FMath::IsFinite(amount) && amount >= 0.0f;
+}
+
+void AMyCharacter::ServerConsumeResource_Implementation(FName resourceType, float amount)
+{
+	GAM312_SCOPE(AMyCharacter, ServerConsumeResource);
+
+	bool isSuccess = false;
+	ConsumeResource(resourceType, amount, isSuccess);
+}
+
+// One step of player-like traffic for UNetLoopbackTestSubsystem
+void AMyCharacter::ServerRunBotStep_Implementation()
+{
+	GAM312_SCOPE(AMyCharacter, ServerRunBotStep);
+
+#if !UE_BUILD_SHIPPING
+	// Any client can call this, so it only runs while the loopback test asks for bots
+	const UNetLoopbackTestSubsystem* NetTest = GetWorld()->GetSubsystem<UNetLoopbackTestSubsystem>();
+	if (!NetTest || !NetTest->AreBotStepsAllowed())
+	{
+		return;
+	}
+
+	const UResourceRegistry& Registry = UResourceRegistry::Get();
+	UBuildingManagerSubsystem* BuildingManager = GetWorld()->GetSubsystem<UBuildingManagerSubsystem>();
+	if (!BuildingManager || Registry.NumBuildings() == 0)
+	{
+		return;
+	}
+
+	for (int32 ResourceId = 0; ResourceId < Registry.NumResources(); ++ResourceId)
+	{
+		GiveResourceById(ResourceId, 10.0f);
+	}
+
+	// Craft a random piece and drop it on the 50-unit grid somewhere around the bot
+	const int32 BuildingId = FMath::RandHelper(Registry.NumBuildings());
+	bool isSuccess = false;
+	CraftBuilding(Registry.Buildings[BuildingId].Name, isSuccess);
+
+	if (isSuccess)
+	{
+		const FVector Offset = FVector(FMath::RandPointInCircle(1000.0f), 0.0f);
+		const FVector Location = (GetActorLocation() + Offset).GridSnap(50.0f);
+		const FRotator Rotation(0.0f, 90.0f * FMath::RandHelper(4), 0.0f);
+
+		TSubclassOf<ABuildingPart> PartClass = Registry.Buildings[BuildingId].PartClass ? Registry.Buildings[BuildingId].PartClass : BuildPartClass;
+		if (BuildingManager->PlacePart(PartClass, BuildingId, FTransform(Rotation, Location), true))
+		{
+			Inventory->ConsumeBuilding(BuildingId);
+		}
 	}
+
+	HarvestAlong(GetPawnViewLocation(), GetViewRotation().Vector());
+#endif
 }
 
 // Add to health, clamped under 100
 void AMyCharacter::SetHealth(float amount)
 {
-	if (Health + amount < 100)
+	GAM312_SCOPE(AMyCharacter, SetHealth);
+
+	if (Health + amount < 100 && amount != 0.0f)
 	{
 		Health += amount;
+		MarkStatsDirty(EPlayerStatFlags::Health);
 	}
 }
 
 // Add to hunger, clamped under 100
 void AMyCharacter::SetHunger(float amount)
 {
-	if (Hunger + amount < 100)
+	GAM312_SCOPE(AMyCharacter, SetHunger);
+
+	if (Hunger + amount < 100 && amount != 0.0f)
 	{
 		Hunger += amount;
+		MarkStatsDirty(EPlayerStatFlags::Hunger);
 	}
 }
 
 // Add to stamina, clamped under 100
 void AMyCharacter::SetStamina(float amount)
 {
-	if (Stamina + amount < 100)
+	GAM312_SCOPE(AMyCharacter, SetStamina);
+
+	if (Stamina + amount < 100 && amount != 0.0f)
 	{
 		Stamina += amount;
+		MarkStatsDirty(EPlayerStatFlags::Stamina);
+	}
+}
+
+// Queues a HUD refresh for the given stats; coalesced into one update per frame
+void AMyCharacter::MarkStatsDirty(EPlayerStatFlags ChangedStats)
+{
+	PendingStatChanges |= ChangedStats;
+	bSaveDirty = true;
+}
+
+// Sends one coalesced update to the HUD and any bound listeners
+void AMyCharacter::FlushStatChanges()
+{
+	GAM312_SCOPE(AMyCharacter, FlushStatChanges);
+
+	FPlayerStatsDelta Delta;
+	Delta.ChangedMask = static_cast<uint8>(PendingStatChanges);
+	Delta.Health = Health;
+	Delta.Hunger = Hunger;
+	Delta.Stamina = Stamina;
+
+	PendingStatChanges = EPlayerStatFlags::None;
+	INC_DWORD_STAT(STAT_GAM312_HUDUpdatesPushed);
+
+	// Only whole half-points reach the owning client, and only when one changed
+	if (HasAuthority())
+	{
+		ReplicatedStats.Health = FReplicatedPlayerStats::Quantize(Health);
+		ReplicatedStats.Hunger = FReplicatedPlayerStats::Quantize(Hunger);
+		ReplicatedStats.Stamina = FReplicatedPlayerStats::Quantize(Stamina);
+	}
+
+	if (playerUI)
+	{
+		playerUI->UpdateBars(Health, Hunger, Stamina);
+		GAM312_COUNT(UIEvents);
+	}
+
+	OnStatsChanged.Broadcast(Delta);
+}
+
+// Applies the server's stats on the owning client; the HUD refreshes through the usual flush
+void AMyCharacter::OnRep_ReplicatedStats()
+{
+	GAM312_SCOPE(AMyCharacter, OnRep_ReplicatedStats);
+
+	EPlayerStatFlags ChangedStats = EPlayerStatFlags::None;
+
+	const float NewHealth = FReplicatedPlayerStats::Dequantize(ReplicatedStats.Health);
+	if (NewHealth != Health)
+	{
+		Health = NewHealth;
+		ChangedStats |= EPlayerStatFlags::Health;
+	}
+
+	const float NewHunger = FReplicatedPlayerStats::Dequantize(ReplicatedStats.Hunger);
+	if (NewHunger != Hunger)
+	{
+		Hunger = NewHunger;
+		ChangedStats |= EPlayerStatFlags::Hunger;
+	}
+
+	const float NewStamina = FReplicatedPlayerStats::Dequantize(ReplicatedStats.Stamina);
+	if (NewStamina != Stamina)
+	{
+		Stamina = NewStamina;
+		ChangedStats |= EPlayerStatFlags::Stamina;
+	}
+
+	MarkStatsDirty(ChangedStats);
+}
+
+// Counts granted resources toward the materials objective and refreshes the widget copies, once per commit
+void AMyCharacter::OnInventoryChanged(const FInventoryDelta& Delta)
+{
+	GAM312_SCOPE(AMyCharacter, OnInventoryChanged);
+
+	bSaveDirty = true;
+
+	// Every change goes through a commit, so the widget copies can't drift
+	ResourcesArray = Inventory->GetResources();
+	BuildingArray = Inventory->GetBuildings();
+
+	if (Delta.ResourcesGranted > 0.0f)
+	{
+		matsCollected += Delta.ResourcesGranted;
+		if (objWidget)
+		{
+			objWidget->UpdatematOBJ(matsCollected);
+			GAM312_COUNT(UIEvents);
+		}
 	}
 }
 
 // Decreases hunger periodically and regenerates stamina
 void AMyCharacter::DecreaseStats()
 {
+	GAM312_SCOPE(AMyCharacter, DecreaseStats);
+
 	if (Hunger > 0)
 	{
 		SetHunger(-1.0f);
@@ -211,63 +730,159 @@ void AMyCharacter::DecreaseStats()
 	}
 }
 
-// Adds resource amount to proper index in the array
-void AMyCharacter::GiveResource(float amount, FString resourceType)
+// Adds resource amount to the index registered for resourceType
+void AMyCharacter::GiveResource(float amount, FName resourceType)
 {
-	if (resourceType == "Wood")
-	{
-		ResourcesArray[0] += amount;
-	}
-	else if (resourceType == "Stone")
+	GAM312_SCOPE(AMyCharacter, GiveResource);
+
+	GiveResourceById(UResourceRegistry::Get().FindResourceId(resourceType), amount);
+}
+
+// Queues the resource amount for this frame's inventory commit
+void AMyCharacter::GiveResourceById(int32 resourceId, float amount)
+{
+	GAM312_SCOPE(AMyCharacter, GiveResourceById);
+
+	Inventory->GrantResource(resourceId, amount);
+}
+
+// Queues the consume for this frame's inventory commit, or asks the server to once the projection covers it
+void AMyCharacter::ConsumeResource(FName resourceType, float amount, bool& isSuccess)
+{
+	GAM312_SCOPE(AMyCharacter, ConsumeResource);
+
+	const int32 ResourceId = UResourceRegistry::Get().FindResourceId(resourceType);
+	if (ResourceId == INDEX_NONE)
 	{
-		ResourcesArray[1] += amount;
+		isSuccess = false;
+		return;
 	}
-	else if (resourceType == "Berry")
+
+	if (!HasAuthority())
 	{
-		ResourcesArray[2] += amount;
+		isSuccess = amount >= 0.0f && Inventory->GetProjectedResource(ResourceId) >= amount;
+		if (isSuccess)
+		{
+			ServerConsumeResource(resourceType, amount);
+		}
+		return;
 	}
+
+	isSuccess = Inventory->ConsumeResource(ResourceId, amount);
 }
 
-// Deducts resources and increases building counts
+// Crafts the named building; the registry recipe is the price, whatever amounts the widget passes.
+// Clients only send the name (ServerCraftBuilding), so the amounts never reach the server.
 void AMyCharacter::UpdateResources(float woodAmount, float stoneAmount, FString buildingObject)
 {
-	if (woodAmount <= ResourcesArray[0] && stoneAmount <= ResourcesArray[1])
+	GAM312_SCOPE(AMyCharacter, UpdateResources);
+
+	bool isSuccess = false;
+	CraftBuilding(FName(*buildingObject), isSuccess);
+}
+
+// Reads the Wood and Stone entries of the registry recipe (0 for unknown buildings or resources it doesn't use)
+void AMyCharacter::GetBuildingCost(FName buildingType, float& woodAmount, float& stoneAmount) const
+{
+	static const FName NAME_Wood(TEXT("Wood"));
+	static const FName NAME_Stone(TEXT("Stone"));
+
+	woodAmount = 0.0f;
+	stoneAmount = 0.0f;
+
+	const UResourceRegistry& Registry = UResourceRegistry::Get();
+	const int32 BuildingId = Registry.FindBuildingId(buildingType);
+	if (BuildingId == INDEX_NONE)
 	{
-		ResourcesArray[0] -= woodAmount;
-		ResourcesArray[1] -= stoneAmount;
+		return;
+	}
 
-		if (buildingObject == "Wall")
+	for (const FResourceCost& Item : Registry.Buildings[BuildingId].Cost)
+	{
+		if (Item.Resource == NAME_Wood)
+		{
+			woodAmount += Item.Amount;
+		}
+		else if (Item.Resource == NAME_Stone)
 		{
-			BuildingArray[0]++;
+			stoneAmount += Item.Amount;
 		}
-		else if (buildingObject == "Floor")
+	}
+}
+
+// Deducts the registry recipe for buildingType and increases its building count
+void AMyCharacter::CraftBuilding(FName buildingType, bool& isSuccess)
+{
+	GAM312_SCOPE(AMyCharacter, CraftBuilding);
+
+	isSuccess = false;
+
+	const UResourceRegistry& Registry = UResourceRegistry::Get();
+	const int32 BuildingId = Registry.FindBuildingId(buildingType);
+	if (BuildingId == INDEX_NONE)
+	{
+		return;
+	}
+
+	// Clients can only predict the result; the server runs the real transaction
+	if (!HasAuthority())
+	{
+		isSuccess = true;
+		for (const FResourceCost& Item : Registry.Buildings[BuildingId].Cost)
 		{
-			BuildingArray[1]++;
+			isSuccess &= Inventory->GetProjectedResource(Item.ResourceId) >= Item.Amount;
 		}
-		else if (buildingObject == "Ceiling")
+		if (isSuccess)
 		{
-			BuildingArray[2]++;
+			ServerCraftBuilding(buildingType);
 		}
+		return;
 	}
+
+	// The whole recipe is one transaction, so a failed craft never takes a partial payment
+	TArray<FInventoryOp, TInlineAllocator<8>> Ops;
+	for (const FResourceCost& Item : Registry.Buildings[BuildingId].Cost)
+	{
+		Ops.Add(FInventoryOp::Make(EInventoryOpType::ConsumeResource, Item.ResourceId, Item.Amount));
+	}
+	Ops.Add(FInventoryOp::Make(EInventoryOpType::GrantBuilding, BuildingId, 1.0f));
+
+	isSuccess = Inventory->QueueTransaction(Ops);
 }
 
-// Spawns a building part in front of the player
+// Spawns a building part in front of the player, using up one piece of that type
+// (clients only check for one; the server takes it when the part is placed)
 void AMyCharacter::SpawnBuilding(int buildingID, bool& isSuccess)
 {
+	GAM312_SCOPE(AMyCharacter, SpawnBuilding);
+
 	if (!isBuilding)
 	{
-		if (BuildingArray[buildingID] >= 1)
+		const bool bHasPiece = HasAuthority() ? Inventory->ConsumeBuilding(buildingID) : Inventory->GetProjectedBuildingCount(buildingID) >= 1;
+		if (bHasPiece)
 		{
 			isBuilding = true;
+			PreviewBuildingId = buildingID;
 
 			FVector StartLocation = PlayerCamComp->GetComponentLocation();
 			FVector Direction = PlayerCamComp->GetForwardVector() * 400.0f;
 			FVector EndLocation = StartLocation + Direction;
 			FRotator myRot(0, 0, 0);
-			FActorSpawnParameters SpawnParams;
 
-			BuildingArray[buildingID]--;
-			spawnedPart = GetWorld()->SpawnActor<ABuildingPart>(BuildPartClass, EndLocation, myRot, SpawnParams);
+			// Use the registry's part class for this type when one is set, taken from the preview pool
+			const FBuildingTypeDef& BuildingType = UResourceRegistry::Get().Buildings[buildingID];
+			TSubclassOf<ABuildingPart> PartClass = BuildingType.PartClass ? BuildingType.PartClass : BuildPartClass;
+			if (UBuildingPreviewPool* PreviewPool = GetWorld()->GetSubsystem<UBuildingPreviewPool>())
+			{
+				spawnedPart = PreviewPool->Acquire(PartClass, FTransform(myRot, EndLocation), &BuildingType);
+			}
+
+			// The preview follows the camera on its own tick until it is placed
+			if (spawnedPart)
+			{
+				spawnedPart->BuildingId = buildingID;
+				spawnedPart->StartPreview(PlayerCamComp, 400.0f);
+			}
 
 			isSuccess = true;
 			return;
@@ -280,8 +895,84 @@ void AMyCharacter::SpawnBuilding(int buildingID, bool& isSuccess)
 // Rotates the building part 90 degrees in world space
 void AMyCharacter::RotateBuilding()
 {
+	GAM312_SCOPE(AMyCharacter, RotateBuilding);
+
 	if (isBuilding && spawnedPart)
 	{
 		spawnedPart->AddActorWorldRotation(FRotator(0, 90, 0));
 	}
 }
+
+// Restores the instanced building part under the crosshair as a preview actor
+void AMyCharacter::EditBuilding(bool& isSuccess)
+{
+	GAM312_SCOPE(AMyCharacter, EditBuilding);
+
+	isSuccess = false;
+
+	UBuildingManagerSubsystem* BuildingManager = GetWorld()->GetSubsystem<UBuildingManagerSubsystem>();
+	if (isBuilding || !BuildingManager)
+	{
+		return;
+	}
+
+	FHitResult HitResult;
+	if (TraceInteraction(HitResult))
+	{
+		const int32 RecordId = BuildingManager->FindRecordFromHit(HitResult);
+		const FPlacedBuildingRecord* Record = BuildingManager->GetRecord(RecordId);
+		if (!Record)
+		{
+			return;
+		}
+
+		// Clients pick up their own copy right away and tell the server which piece it was
+		const int32 NetId = BuildingManager->GetNetId(RecordId);
+		if (NetId == INDEX_NONE)
+		{
+			return;
+		}
+
+		// Reuse a pooled preview actor for the picked part when possible
+		ABuildingPart* Preview = nullptr;
+		if (UBuildingPreviewPool* PreviewPool = GetWorld()->GetSubsystem<UBuildingPreviewPool>())
+		{
+			Preview = PreviewPool->Acquire(Record->PartClass, Record->Transform);
+		}
+
+		spawnedPart = BuildingManager->RestorePart(RecordId, Preview);
+		if (spawnedPart)
+		{
+			PreviewBuildingId = spawnedPart->BuildingId;
+			// The server may still refuse; ClientRejectEdit puts the piece back then
+			if (!HasAuthority())
+			{
+				EditNetId = NetId;
+				BuildingManager->ForgetNetPiece(NetId);
+				ServerEditBuilding(NetId);
+			}
+
+			InteractionTraceCache.Invalidate();
+			spawnedPart->StartPreview(PlayerCamComp, 400.0f);
+			isBuilding = true;
+			isEditingPart = true;
+			isSuccess = true;
+		}
+	}
+}
+
+// Line trace from the camera using the interaction profile; repeated calls in one frame reuse the hit
+bool AMyCharacter::TraceInteraction(FHitResult& OutHit)
+{
+	return TraceInteraction(PlayerCamComp->GetComponentLocation(), PlayerCamComp->GetForwardVector(), OutHit);
+}
+
+bool AMyCharacter::TraceInteraction(const FVector& Start, const FVector& Direction, FHitResult& OutHit)
+{
+	GAM312_SCOPE(AMyCharacter, TraceInteraction);
+
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(GAM312Interaction));
+	QueryParams.AddIgnoredActor(this);
+
+	return InteractionTraceCache.Trace(GetWorld(), Start, Direction, InteractionTrace, QueryParams, OutHit);
+}
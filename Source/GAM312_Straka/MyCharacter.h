@@ -9,6 +9,10 @@
 #include "BuildingPart.h"
 #include "PlayerWidget.h"
 #include "ObjectiveWidget.h"
+#include "PlayerStats.h"
+#include "ResourceRegistry.h"
+#include "InteractionTrace.h"
+#include "InventoryComponent.h"
 #include "MyCharacter.generated.h"
 
 /**
@@ -31,6 +35,15 @@ protected:
 	// Called once when the game starts or when spawned
 	virtual void BeginPlay() override;
 
+	// Called when the actor is removed from the world
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	// Server: called when a controller takes over; restores the player's saved state
+	virtual void PossessedBy(AController* NewController) override;
+
+	// Server: called when the controller lets go (also as the player logs out); keeps the player for later saves
+	virtual void UnPossessed() override;
+
 public:
 	// Called every frame
 	virtual void Tick(float DeltaTime) override;
@@ -38,6 +51,8 @@ public:
 	// Binds input axes and actions
 	virtual void SetupPlayerInputComponent(class UInputComponent* PlayerInputComponent) override;
 
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
 	/** Movement Functions **/
 	UFUNCTION()
 	void MoveForward(float axisValue);
@@ -55,6 +70,10 @@ public:
 	UFUNCTION()
 	void FindObject();
 
+	/** How FindObject and EditBuilding trace from the camera (simple collision by default) */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Interaction")
+	FInteractionTraceProfile InteractionTrace;
+
 	/** Camera attached to the player, used for first-person view */
 	UPROPERTY(VisibleAnywhere)
 	UCameraComponent* PlayerCamComp;
@@ -70,15 +89,26 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Player Stats")
 	float Stamina = 100.0f;
 
+	// Broadcast at most once per frame with the stats that changed since the last frame
+	UPROPERTY(BlueprintAssignable, Category = "Player Stats")
+	FOnPlayerStatsChanged OnStatsChanged;
+
 	/** ---------- Resource Tracking ---------- **/
 
-	// Tracks current amount of each resource type (by index)
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Resources")
-	TArray<float> ResourcesArray;
+	// Resource amounts and building pieces, committed once per frame
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Resources")
+	UInventoryComponent* Inventory;
 
-	// Tracks the name of each resource type (matches index in ResourcesArray)
+	// Tracks the name of each resource type (matches the inventory's resource IDs)
 	UPROPERTY()
-	TArray<FString> ResourcesNameArray;
+	TArray<FName> ResourcesNameArray;
+
+	// Read-only copies of the committed inventory totals for widgets (e.g. Crafting_W), by registry ID
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Resources")
+	TArray<float> ResourcesArray;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Building Supplies")
+	TArray<int> BuildingArray;
 
 	// Optional debug or legacy values  not used in the main logic
 	UPROPERTY(EditAnywhere, Category = "Wood")
@@ -96,10 +126,6 @@ public:
 
 	/** ---------- Building System ---------- **/
 
-	// Number of buildable parts of each type (index-based: 0 = Wall, 1 = Floor, etc.)
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Building Supplies")
-	TArray<int> BuildingArray;
-
 	// Whether the player is currently placing a building piece
 	UPROPERTY()
 	bool isBuilding;
@@ -108,10 +134,18 @@ public:
 	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite)
 	TSubclassOf<ABuildingPart> BuildPartClass;
 
+	// Preview actors spawned per building part class during BeginPlay
+	UPROPERTY(EditDefaultsOnly, Category = "Building Supplies")
+	int32 PreviewPoolSize = 2;
+
 	// Pointer to the current building part being previewed/spawned
 	UPROPERTY()
 	ABuildingPart* spawnedPart;
 
+	// Whether the current preview is an already-placed part picked up for editing
+	UPROPERTY()
+	bool isEditingPart;
+
 	/** ---------- UI Widgets ---------- **/
 
 	// Reference to the player's main HUD
@@ -144,18 +178,34 @@ public:
 	UFUNCTION(BlueprintCallable)
 	void SetStamina(float amount);
 
-	// Called every few seconds to reduce hunger, regen stamina, or drain health
+	// Reduces hunger, regens stamina, or drains health (USurvivalStatsSubsystem applies the same rules to every character in one batch)
 	UFUNCTION(BlueprintCallable)
 	void DecreaseStats();
 
-	// Adds resource amount to appropriate index in ResourcesArray
+	// Queues a grant of the named resource to the inventory
 	UFUNCTION()
-	void GiveResource(float amount, FString resourceType);
+	void GiveResource(float amount, FName resourceType);
+
+	// Adds resource amount by registry ID (no name lookup; used by the harvest path)
+	void GiveResourceById(int32 resourceId, float amount);
 
-	// Removes resources and increases internal build part counts
+	// Takes amount of the named resource out of the inventory (e.g. Crafting_W eating berries); fails without
+	// touching it if there isn't enough. Clients only predict the result; the server runs the transaction
+	UFUNCTION(BlueprintCallable)
+	void ConsumeResource(FName resourceType, float amount, bool& isSuccess);
+
+	// Legacy entry point for Crafting_W: crafts buildingObject at its registry recipe (woodAmount and stoneAmount are ignored)
 	UFUNCTION(BlueprintCallable)
 	void UpdateResources(float woodAmount, float stoneAmount, FString buildingObject);
 
+	// Wood and Stone the registry recipe for buildingType costs, for the crafting UI's labels
+	UFUNCTION(BlueprintPure)
+	void GetBuildingCost(FName buildingType, float& woodAmount, float& stoneAmount) const;
+
+	// Pays the registry recipe for buildingType and adds one piece to the inventory
+	UFUNCTION(BlueprintCallable)
+	void CraftBuilding(FName buildingType, bool& isSuccess);
+
 	// Spawns a buildable object in front of the player
 	UFUNCTION(BlueprintCallable)
 	void SpawnBuilding(int buildingID, bool& isSuccess);
@@ -163,4 +213,106 @@ public:
 	// Rotates the current preview building object
 	UFUNCTION()
 	void RotateBuilding();
+
+	// Picks up the placed building part under the crosshair so it can be moved again
+	UFUNCTION(BlueprintCallable)
+	void EditBuilding(bool& isSuccess);
+
+	// Flags stats as changed so the HUD is refreshed at the end of this frame
+	void MarkStatsDirty(EPlayerStatFlags ChangedStats);
+
+	// True if stats or inventory changed since the last call (autosave change tracking)
+	bool ConsumeSaveDirty()
+	{
+		const bool bWasDirty = bSaveDirty;
+		bSaveDirty = false;
+		return bWasDirty;
+	}
+
+	/** ---------- Networking ---------- **/
+
+	// Furthest a client's reported view may be from where the server has its camera
+	UPROPERTY(EditDefaultsOnly, Category = "Networking")
+	float MaxViewError = 300.0f;
+
+	// Furthest from the character a client may place or pick up a building part
+	UPROPERTY(EditDefaultsOnly, Category = "Networking")
+	float MaxBuildReach = 1500.0f;
+
+	// Harvests whatever the client's view points at (the server re-traces it)
+	UFUNCTION(Server, Reliable, WithValidation)
+	void ServerHarvest(FVector_NetQuantize ViewLocation, FVector_NetQuantizeNormal ViewDirection);
+
+	// Places a crafted piece, or the part picked up with ServerEditBuilding when bEdit is set
+	UFUNCTION(Server, Reliable, WithValidation)
+	void ServerPlaceBuilding(int32 BuildingId, FVector_NetQuantize10 Location, FRotator Rotation, bool bEdit);
+
+	// Picks up the placed part with the given network ID so it can be placed again
+	UFUNCTION(Server, Reliable, WithValidation)
+	void ServerEditBuilding(int32 NetId);
+
+	// The server refused ServerEditBuilding: drops the preview if it is still held and puts the piece
+	// back with its network ID (PartClass is null when the server no longer has the piece)
+	UFUNCTION(Client, Reliable)
+	void ClientRejectEdit(int32 NetId, int32 BuildingId, TSubclassOf<ABuildingPart> PartClass, FVector_NetQuantize10 Location, FRotator Rotation);
+
+	// Crafts by name; the server charges its own registry recipe (also how UpdateResources reaches the server)
+	UFUNCTION(Server, Reliable, WithValidation)
+	void ServerCraftBuilding(FName buildingType);
+
+	// Consumes by name from the server's inventory (how ConsumeResource reaches the server)
+	UFUNCTION(Server, Reliable, WithValidation)
+	void ServerConsumeResource(FName resourceType, float amount);
+
+	// Loopback test bot (gam312.Net.Bot): grants, crafts, places and harvests once. Ignored unless the server's
+	// UNetLoopbackTestSubsystem allows bot steps, and always in shipping builds
+	UFUNCTION(Server, Unreliable)
+	void ServerRunBotStep();
+
+private:
+	// Interaction trace from the camera, cached per frame
+	bool TraceInteraction(FHitResult& OutHit);
+
+	// Interaction trace from an explicit view (a client's, on the server)
+	bool TraceInteraction(const FVector& Start, const FVector& Direction, FHitResult& OutHit);
+
+	// Takes one hit's worth of resource from the node along the given view
+	void HarvestAlong(const FVector& Start, const FVector& Direction);
+
+	// Whether a client-reported location is close enough to this character to act on
+	bool IsWithinReach(const FVector& Location, float Reach) const;
+
+	// Server copy of the stats, quantized, for the owning client
+	UPROPERTY(ReplicatedUsing = OnRep_ReplicatedStats)
+	FReplicatedPlayerStats ReplicatedStats;
+
+	UFUNCTION()
+	void OnRep_ReplicatedStats();
+
+	// Building ID of the piece being previewed (used when a client asks the server to place it)
+	int32 PreviewBuildingId = INDEX_NONE;
+
+	// Client: network ID of the part picked up by the last ServerEditBuilding
+	int32 EditNetId = INDEX_NONE;
+
+	// Server: part picked up by this client's ServerEditBuilding, waiting to be placed again
+	TSubclassOf<ABuildingPart> PendingEditClass;
+	int32 PendingEditBuildingId = INDEX_NONE;
+	FTransform PendingEditTransform;
+	bool bHasPendingEdit = false;
+
+	FInteractionTraceCache InteractionTraceCache;
+
+	// Pushes pending stat changes to the HUD and OnStatsChanged listeners
+	void FlushStatChanges();
+
+	// Objective progress and the widget copies from each committed inventory change
+	UFUNCTION()
+	void OnInventoryChanged(const FInventoryDelta& Delta);
+
+	// Stats changed since the last flush (starts dirty so the HUD gets initial values)
+	EPlayerStatFlags PendingStatChanges = EPlayerStatFlags::All;
+
+	// Stats or inventory changed since the last autosave (starts dirty so new players get saved)
+	bool bSaveDirty = true;
 };
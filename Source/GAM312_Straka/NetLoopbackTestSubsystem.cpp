@@ -0,0 +1,371 @@
+#include "NetLoopbackTestSubsystem.h"
+#include "GAM312_Straka.h"
+#include "MyCharacter.h"
+#include "GAM312ReplicationGraph.h"
+#include "Engine/SimulatedClientNetConnection.h"
+#include "Engine/NetConnection.h"
+#include "Engine/NetDriver.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+
+static TAutoConsoleVariable<bool> CVarNetAllowBots(
+	TEXT("gam312.Net.AllowBots"),
+	false,
+	TEXT("Server: run ServerRunBotStep requests from clients outside a bandwidth capture. Off by default, since a step grants resources for free."),
+	ECVF_Cheat);
+
+namespace NetLoopbackTest
+{
+	static constexpr float SampleInterval = 1.0f;
+
+	// Connection counts measured by gam312.Net.RepBenchmark when none are given
+	static const int32 DefaultConnectionCounts[] = { 16, 64, 128 };
+
+	// Seconds after adding connections before timing starts (initial replication of everything)
+	static constexpr float WarmupSeconds = 3.0f;
+
+	// Value below which Fraction of the sorted samples fall
+	static double Percentile(const TArray<double>& Sorted, double Fraction)
+	{
+		return Sorted.Num() > 0 ? Sorted[FMath::Clamp(FMath::FloorToInt(Fraction * (Sorted.Num() - 1)), 0, Sorted.Num() - 1)] : 0.0;
+	}
+}
+
+bool UNetLoopbackTestSubsystem::IsTickable() const
+{
+	return BotInterval > 0.0f || CaptureTimeLeft > 0.0f || RepBenchStage != INDEX_NONE;
+}
+
+TStatId UNetLoopbackTestSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UNetLoopbackTestSubsystem, STATGROUP_Tickables);
+}
+
+void UNetLoopbackTestSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (BotInterval > 0.0f)
+	{
+		TickBot(DeltaTime);
+	}
+
+	if (CaptureTimeLeft > 0.0f)
+	{
+		TimeSinceSample += DeltaTime;
+		if (TimeSinceSample >= NetLoopbackTest::SampleInterval)
+		{
+			TimeSinceSample = 0.0f;
+			SampleBandwidth();
+		}
+
+		CaptureTimeLeft -= DeltaTime;
+		if (CaptureTimeLeft <= 0.0f)
+		{
+			ReportBandwidth();
+		}
+	}
+
+	if (RepBenchStage != INDEX_NONE)
+	{
+		TickReplicationBenchmark(DeltaTime);
+	}
+}
+
+void UNetLoopbackTestSubsystem::SetBotInterval(float Interval)
+{
+	BotInterval = FMath::Max(Interval, 0.0f);
+	TimeSinceBotStep = 0.0f;
+	BotRandom.Initialize(FPlatformTime::Cycles());
+
+	UE_LOG(LogGAM312, Display, TEXT("[NetTest] Bot %s"), BotInterval > 0.0f ? *FString::Printf(TEXT("stepping every %.2fs"), BotInterval) : TEXT("stopped"));
+}
+
+bool UNetLoopbackTestSubsystem::AreBotStepsAllowed() const
+{
+	return CaptureTimeLeft > 0.0f || CVarNetAllowBots.GetValueOnGameThread();
+}
+
+// Keeps the local character walking and asks the server for one gameplay step per interval
+void UNetLoopbackTestSubsystem::TickBot(float DeltaTime)
+{
+	APlayerController* Controller = GetWorld()->GetFirstPlayerController();
+	AMyCharacter* Character = Controller ? Cast<AMyCharacter>(Controller->GetPawn()) : nullptr;
+	if (!Character)
+	{
+		return;
+	}
+
+	Character->AddMovementInput(Character->GetActorForwardVector(), 1.0f);
+
+	TimeSinceBotStep += DeltaTime;
+	if (TimeSinceBotStep < BotInterval)
+	{
+		return;
+	}
+	TimeSinceBotStep = 0.0f;
+
+	// Wander in a new direction each step
+	Controller->SetControlRotation(FRotator(BotRandom.FRandRange(-30.0f, 0.0f), BotRandom.FRandRange(0.0f, 360.0f), 0.0f));
+	Character->ServerRunBotStep();
+}
+
+void UNetLoopbackTestSubsystem::StartBandwidthCapture(float Seconds)
+{
+	const UNetDriver* NetDriver = GetWorld()->GetNetDriver();
+	if (!NetDriver || !NetDriver->IsServer())
+	{
+		UE_LOG(LogGAM312, Warning, TEXT("[NetTest] Bandwidth capture needs a server world"));
+		return;
+	}
+
+	Samples.Reset();
+	CaptureTimeLeft = FMath::Max(Seconds, NetLoopbackTest::SampleInterval);
+	TimeSinceSample = 0.0f;
+
+	UE_LOG(LogGAM312, Display, TEXT("[NetTest] Capturing bandwidth of %d clients for %.0fs"), NetDriver->ClientConnections.Num(), CaptureTimeLeft);
+}
+
+// Each connection reports its traffic over the last second; one sample per second adds them up
+void UNetLoopbackTestSubsystem::SampleBandwidth()
+{
+	const UNetDriver* NetDriver = GetWorld()->GetNetDriver();
+	if (!NetDriver)
+	{
+		return;
+	}
+
+	for (UNetConnection* Connection : NetDriver->ClientConnections)
+	{
+		if (!Connection)
+		{
+			continue;
+		}
+
+		FNetBandwidthSample& Sample = Samples.FindOrAdd(FObjectKey(Connection));
+		if (Sample.NumSamples == 0)
+		{
+			Sample.Address = Connection->LowLevelGetRemoteAddress(true);
+		}
+
+		Sample.OutBytes += Connection->OutBytesPerSecond;
+		Sample.InBytes += Connection->InBytesPerSecond;
+		Sample.PeakOutBytesPerSecond = FMath::Max(Sample.PeakOutBytesPerSecond, Connection->OutBytesPerSecond);
+		++Sample.NumSamples;
+	}
+}
+
+void UNetLoopbackTestSubsystem::ReportBandwidth() const
+{
+	UE_LOG(LogGAM312, Display, TEXT("[NetTest] %-24s %12s %12s %12s"), TEXT("Client"), TEXT("out B/s"), TEXT("peak out"), TEXT("in B/s"));
+
+	double TotalOut = 0.0;
+	int32 NumClients = 0;
+	for (const TPair<FObjectKey, FNetBandwidthSample>& Pair : Samples)
+	{
+		const FNetBandwidthSample& Sample = Pair.Value;
+		const double AverageOut = static_cast<double>(Sample.OutBytes) / Sample.NumSamples;
+		const double AverageIn = static_cast<double>(Sample.InBytes) / Sample.NumSamples;
+
+		UE_LOG(LogGAM312, Display, TEXT("[NetTest] %-24s %12.0f %12d %12.0f"), *Sample.Address, AverageOut, Sample.PeakOutBytesPerSecond, AverageIn);
+
+		TotalOut += AverageOut;
+		++NumClients;
+	}
+
+	UE_LOG(LogGAM312, Display, TEXT("[NetTest] %d clients, %.0f B/s out per client on average, %.0f B/s out total"),
+		NumClients, NumClients > 0 ? TotalOut / NumClients : 0.0, TotalOut);
+}
+
+void UNetLoopbackTestSubsystem::StartReplicationBenchmark(TArray<int32> ConnectionCounts, float SecondsPerStep, float SpreadRadius)
+{
+	const UNetDriver* NetDriver = GetWorld()->GetNetDriver();
+	if (RepBenchStage != INDEX_NONE || !NetDriver || !NetDriver->IsServer())
+	{
+		UE_LOG(LogGAM312, Warning, TEXT("[NetTest] Replication benchmark needs a server world and no benchmark running"));
+		return;
+	}
+
+	if (!Cast<UGAM312ReplicationGraph>(NetDriver->GetReplicationDriver()))
+	{
+		UE_LOG(LogGAM312, Warning, TEXT("[NetTest] Replication graph is not active; only frame times will be reported"));
+	}
+
+	ConnectionCounts.Sort();
+	RepBenchCounts = MoveTemp(ConnectionCounts);
+	RepBenchSeconds = FMath::Max(SecondsPerStep, 1.0f);
+	RepBenchSpread = SpreadRadius;
+	RepBenchStage = 0;
+	RepBenchTimeLeft = 0.0f;
+	bRepBenchWarmingUp = false;
+
+	UE_LOG(LogGAM312, Display, TEXT("[NetTest] %-12s %12s %12s %12s %12s %8s %12s"),
+		TEXT("Connections"), TEXT("avg ms"), TEXT("p50 ms"), TEXT("p95 ms"), TEXT("max ms"), TEXT("ticks"), TEXT("frame ms"));
+}
+
+// Per stage: add connections, warm up, time replication, report, move on
+void UNetLoopbackTestSubsystem::TickReplicationBenchmark(float DeltaTime)
+{
+	UNetDriver* NetDriver = GetWorld()->GetNetDriver();
+	UGAM312ReplicationGraph* Graph = NetDriver ? Cast<UGAM312ReplicationGraph>(NetDriver->GetReplicationDriver()) : nullptr;
+	if (!NetDriver)
+	{
+		RepBenchStage = INDEX_NONE;
+		return;
+	}
+
+	RepBenchTimeLeft -= DeltaTime;
+
+	// Stage start
+	if (!bRepBenchWarmingUp && RepBenchTimeLeft <= 0.0f && RepBenchFrameCount == 0)
+	{
+		AddSimulatedConnections(RepBenchCounts[RepBenchStage] - SimulatedConnections.Num());
+		bRepBenchWarmingUp = true;
+		RepBenchTimeLeft = NetLoopbackTest::WarmupSeconds;
+		return;
+	}
+
+	if (bRepBenchWarmingUp)
+	{
+		if (RepBenchTimeLeft <= 0.0f)
+		{
+			bRepBenchWarmingUp = false;
+			RepBenchTimeLeft = RepBenchSeconds;
+			RepBenchFrameTimeSum = 0.0;
+			if (Graph)
+			{
+				Graph->BeginTimingCapture();
+			}
+		}
+		return;
+	}
+
+	RepBenchFrameTimeSum += DeltaTime;
+	++RepBenchFrameCount;
+	if (RepBenchTimeLeft > 0.0f)
+	{
+		return;
+	}
+
+	TArray<double> Timings = Graph ? Graph->EndTimingCapture() : TArray<double>();
+	Timings.Sort();
+
+	double TimingSum = 0.0;
+	for (double Timing : Timings)
+	{
+		TimingSum += Timing;
+	}
+
+	UE_LOG(LogGAM312, Display, TEXT("[NetTest] %-12d %12.3f %12.3f %12.3f %12.3f %8d %12.2f"),
+		SimulatedConnections.Num(),
+		Timings.Num() > 0 ? TimingSum / Timings.Num() * 1000.0 : 0.0,
+		NetLoopbackTest::Percentile(Timings, 0.5) * 1000.0,
+		NetLoopbackTest::Percentile(Timings, 0.95) * 1000.0,
+		Timings.Num() > 0 ? Timings.Last() * 1000.0 : 0.0,
+		Timings.Num(),
+		RepBenchFrameTimeSum / RepBenchFrameCount * 1000.0);
+
+	RepBenchFrameCount = 0;
+	if (++RepBenchStage >= RepBenchCounts.Num())
+	{
+		RepBenchStage = INDEX_NONE;
+		CloseSimulatedConnections();
+		UE_LOG(LogGAM312, Display, TEXT("[NetTest] Replication benchmark finished"));
+	}
+}
+
+// Fake clients that accept and ack everything, each logged in with its own controller and pawn
+void UNetLoopbackTestSubsystem::AddSimulatedConnections(int32 Count)
+{
+	UWorld* World = GetWorld();
+	UNetDriver* NetDriver = World->GetNetDriver();
+
+	for (int32 Index = 0; Index < Count; ++Index)
+	{
+		USimulatedClientNetConnection* Connection = NewObject<USimulatedClientNetConnection>(NetDriver);
+		Connection->InitConnection(NetDriver, USOCK_Open, World->URL, 1000000);
+		Connection->InitSendBuffer();
+		Connection->SetClientLoginState(EClientLoginState::Welcomed);
+		NetDriver->AddClientConnection(Connection);
+
+		FString Error;
+		APlayerController* Controller = World->SpawnPlayActor(Connection, ROLE_AutonomousProxy, World->URL, FUniqueNetIdRepl(), Error);
+		if (!Controller)
+		{
+			UE_LOG(LogGAM312, Warning, TEXT("[NetTest] Could not log in a simulated connection: %s"), *Error);
+			Connection->Close();
+			continue;
+		}
+
+		// Spread the viewers out so each sees a different part of the grid
+		if (APawn* Pawn = Controller->GetPawn())
+		{
+			const FVector2D Offset = FMath::RandPointInCircle(RepBenchSpread);
+			Pawn->TeleportTo(Pawn->GetActorLocation() + FVector(Offset, 0.0f), FRotator(0.0f, FMath::FRandRange(0.0f, 360.0f), 0.0f));
+		}
+
+		SimulatedConnections.Add(Connection);
+	}
+}
+
+// Closed connections are cleaned up (controller and pawn destroyed) by the net driver
+void UNetLoopbackTestSubsystem::CloseSimulatedConnections()
+{
+	for (const TWeakObjectPtr<UNetConnection>& Connection : SimulatedConnections)
+	{
+		if (Connection.IsValid())
+		{
+			Connection->Close();
+		}
+	}
+	SimulatedConnections.Reset();
+}
+
+static FAutoConsoleCommandWithWorldAndArgs GNetBotCommand(
+	TEXT("gam312.Net.Bot"),
+	TEXT("Client: walks the local character around and asks the server to grant, craft, place and harvest every N seconds (default 1, 0 stops)."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (UNetLoopbackTestSubsystem* NetTest = World ? World->GetSubsystem<UNetLoopbackTestSubsystem>() : nullptr)
+		{
+			NetTest->SetBotInterval(Args.Num() > 0 ? FCString::Atof(*Args[0]) : 1.0f);
+		}
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs GNetBandwidthCommand(
+	TEXT("gam312.Net.Bandwidth"),
+	TEXT("Server: samples every client connection's bandwidth once per second for N seconds (default 30) and logs bytes per second per client."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (UNetLoopbackTestSubsystem* NetTest = World ? World->GetSubsystem<UNetLoopbackTestSubsystem>() : nullptr)
+		{
+			NetTest->StartBandwidthCapture(Args.Num() > 0 ? FCString::Atof(*Args[0]) : 30.0f);
+		}
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs GNetRepBenchmarkCommand(
+	TEXT("gam312.Net.RepBenchmark"),
+	TEXT("Server: adds simulated connections in steps (default 16 64 128) and logs server replication time per net tick at each. Optional args: seconds per step (default 10), spread radius (default 20000), then connection counts."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		UNetLoopbackTestSubsystem* NetTest = World ? World->GetSubsystem<UNetLoopbackTestSubsystem>() : nullptr;
+		if (!NetTest)
+		{
+			return;
+		}
+
+		TArray<int32> ConnectionCounts;
+		for (int32 Index = 2; Index < Args.Num(); ++Index)
+		{
+			ConnectionCounts.Add(FMath::Max(FCString::Atoi(*Args[Index]), 1));
+		}
+		if (ConnectionCounts.Num() == 0)
+		{
+			ConnectionCounts.Append(NetLoopbackTest::DefaultConnectionCounts, UE_ARRAY_COUNT(NetLoopbackTest::DefaultConnectionCounts));
+		}
+
+		NetTest->StartReplicationBenchmark(MoveTemp(ConnectionCounts),
+			Args.Num() > 0 ? FCString::Atof(*Args[0]) : 10.0f,
+			Args.Num() > 1 ? FCString::Atof(*Args[1]) : 20000.0f);
+	}));
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "NetLoopbackTestSubsystem.generated.h"
+
+class UNetConnection;
+
+/**
+ * FNetBandwidthSample
+ *
+ * Bandwidth measured for one client connection over a capture.
+ */
+struct FNetBandwidthSample
+{
+	FString Address;
+
+	// Sums of the per-second rates reported by the connection, and the number of samples
+	int64 OutBytes = 0;
+	int64 InBytes = 0;
+	int32 PeakOutBytesPerSecond = 0;
+	int32 NumSamples = 0;
+};
+
+/**
+ * UNetLoopbackTestSubsystem
+ *
+ * Measures replication cost on a local server, with real bot clients or with simulated
+ * connections.
+ *
+ *   Server only: "gam312.Net.RepBenchmark" on a -server world adds simulated connections
+ *                (each with its own controller and pawn) in steps of 16, 64 and 128, and
+ *                logs the server time spent replicating per net tick at each step.
+ *
+ *   Server:  <Project> <Map> -server -nullrhi -log
+ *            then "gam312.Net.Bandwidth 60" on the server console
+ *   Clients: <Project> 127.0.0.1 -game -nullrhi -ExecCmds="gam312.Net.Bot 1"
+ *
+ * Bots walk around and, once per interval, ask the server to grant, craft, place and
+ * harvest like a player would (AMyCharacter::ServerRunBotStep). The server ignores those
+ * requests unless a bandwidth capture is running or gam312.Net.AllowBots is set. The bandwidth capture
+ * samples every client connection once per second and logs bytes per second per client.
+ */
+UCLASS()
+class GAM312_STRAKA_API UNetLoopbackTestSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+
+	// Client: drives the local character as a bot, one server step every Interval seconds (0 stops)
+	void SetBotInterval(float Interval);
+
+	// Server: samples client connection bandwidth for the given number of seconds, then logs it
+	void StartBandwidthCapture(float Seconds);
+
+	// Server: whether ServerRunBotStep requests may run (during a capture, or with gam312.Net.AllowBots)
+	bool AreBotStepsAllowed() const;
+
+	// Server: measures replication time at each connection count, SecondsPerStep each, with pawns
+	// scattered within SpreadRadius of the world origin
+	void StartReplicationBenchmark(TArray<int32> ConnectionCounts, float SecondsPerStep, float SpreadRadius);
+
+private:
+	void TickBot(float DeltaTime);
+	void SampleBandwidth();
+	void ReportBandwidth() const;
+
+	// Advances the replication benchmark state machine by one frame
+	void TickReplicationBenchmark(float DeltaTime);
+	void AddSimulatedConnections(int32 Count);
+	void CloseSimulatedConnections();
+
+	float BotInterval = 0.0f;
+	float TimeSinceBotStep = 0.0f;
+	FRandomStream BotRandom;
+
+	float CaptureTimeLeft = 0.0f;
+	float TimeSinceSample = 0.0f;
+	TMap<FObjectKey, FNetBandwidthSample> Samples;
+
+	/** ---------- Replication Benchmark State ---------- **/
+
+	TArray<int32> RepBenchCounts;
+	int32 RepBenchStage = INDEX_NONE;
+	float RepBenchTimeLeft = 0.0f;
+	float RepBenchSeconds = 0.0f;
+	float RepBenchSpread = 0.0f;
+	bool bRepBenchWarmingUp = false;
+	double RepBenchFrameTimeSum = 0.0;
+	int32 RepBenchFrameCount = 0;
+	TArray<TWeakObjectPtr<UNetConnection>> SimulatedConnections;
+};
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PlayerStats.generated.h"
+
+/**
+ * EPlayerStatFlags
+ *
+ * Bit mask naming the survival stats that changed since the HUD was last updated.
+ */
+UENUM(BlueprintType, meta = (Bitflags, UseEnumValuesAsMaskValuesInEditor = "true"))
+enum class EPlayerStatFlags : uint8
+{
+	None    = 0,
+	Health  = 1 << 0,
+	Hunger  = 1 << 1,
+	Stamina = 1 << 2,
+	All     = Health | Hunger | Stamina
+};
+ENUM_CLASS_FLAGS(EPlayerStatFlags);
+
+/**
+ * FPlayerStatsDelta
+ *
+ * Coalesced stat change sent to listeners at most once per frame.
+ * Only the values whose bit is set in ChangedMask are meaningful.
+ */
+USTRUCT(BlueprintType)
+struct FPlayerStatsDelta
+{
+	GENERATED_BODY()
+
+	// Which stats changed this frame (EPlayerStatFlags bits)
+	UPROPERTY(BlueprintReadOnly, meta = (Bitmask, BitmaskEnum = "/Script/GAM312_Straka.EPlayerStatFlags"))
+	uint8 ChangedMask = 0;
+
+	UPROPERTY(BlueprintReadOnly)
+	float Health = 0.0f;
+
+	UPROPERTY(BlueprintReadOnly)
+	float Hunger = 0.0f;
+
+	UPROPERTY(BlueprintReadOnly)
+	float Stamina = 0.0f;
+
+	// True if the given stat is part of this delta
+	bool HasChanged(EPlayerStatFlags Stat) const
+	{
+		return EnumHasAnyFlags(static_cast<EPlayerStatFlags>(ChangedMask), Stat);
+	}
+};
+
+/**
+ * FReplicatedPlayerStats
+ *
+ * Survival stats as sent to the owning client: each stat is quantized to half a point
+ * in one byte (0-100), and only bytes that changed are replicated.
+ */
+USTRUCT()
+struct FReplicatedPlayerStats
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	uint8 Health = 200;
+
+	UPROPERTY()
+	uint8 Hunger = 200;
+
+	UPROPERTY()
+	uint8 Stamina = 200;
+
+	static uint8 Quantize(float Value)
+	{
+		return static_cast<uint8>(FMath::Clamp(FMath::RoundToInt(Value * 2.0f), 0, 200));
+	}
+
+	static float Dequantize(uint8 Value)
+	{
+		return Value * 0.5f;
+	}
+};
+
+// Fired once per frame by AMyCharacter when any survival stat changed
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnPlayerStatsChanged, const FPlayerStatsDelta&, Delta);
@@ -0,0 +1,267 @@
+#include "ResourceLifecycleSubsystem.h"
+#include "GAM312_Straka.h"
+#include "Resource_M.h"
+#include "ResourceRegistry.h"
+#include "ResourceSpatialSubsystem.h"
+#include "Engine/World.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Resource Nodes Dormant"), STAT_GAM312_ResourceNodesDormant, STATGROUP_GAM312);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Resource Nodes Regrown"), STAT_GAM312_ResourceNodesRegrown, STATGROUP_GAM312);
+
+namespace ResourceLifecycle
+{
+	// Smallest scale used while fading, so the mesh never collapses to zero
+	static constexpr float MinFadeScale = 0.01f;
+
+	// Nodes in these states hold one of their type's MaxLiveNodes slots
+	static bool HoldsSlot(EResourceNodeState State)
+	{
+		return State == EResourceNodeState::Live || State == EResourceNodeState::FadingIn;
+	}
+
+	static const FResourceTypeDef& GetTypeDef(int32 ResourceId)
+	{
+		static const FResourceTypeDef UnknownType;
+
+		const UResourceRegistry& Registry = UResourceRegistry::Get();
+		return Registry.Resources.IsValidIndex(ResourceId) ? Registry.Resources[ResourceId] : UnknownType;
+	}
+}
+
+void UResourceLifecycleSubsystem::Deinitialize()
+{
+	DEC_DWORD_STAT_BY(STAT_GAM312_ResourceNodesDormant, PendingRecords.Num());
+
+	Records.Reset();
+	FreeRecords.Reset();
+	NodeToRecord.Reset();
+	PendingRecords.Reset();
+	LiveCounts.Reset();
+
+	Super::Deinitialize();
+}
+
+void UResourceLifecycleSubsystem::Tick(float DeltaTime)
+{
+	GAM312_SCOPE(UResourceLifecycleSubsystem, Tick);
+
+	Super::Tick(DeltaTime);
+
+	const double Now = GetWorld()->GetTimeSeconds();
+
+	// Backwards, since finishing a fade-in removes the record from the list
+	for (int32 PendingIndex = PendingRecords.Num() - 1; PendingIndex >= 0; --PendingIndex)
+	{
+		const int32 RecordIndex = PendingRecords[PendingIndex];
+		FResourceNodeRecord& Record = Records[RecordIndex];
+
+		AResource_M* Node = Record.Node.Get();
+		if (!Node)
+		{
+			continue;
+		}
+
+		const float FadeAlpha = static_cast<float>((Now - Record.StateTime) / FadeDuration);
+
+		switch (Record.State)
+		{
+		case EResourceNodeState::FadingOut:
+			if (FadeAlpha >= 1.0f)
+			{
+				// Fully shrunk: hide it at its original size, ready for regrowth
+				Node->SetActorHiddenInGame(true);
+				Node->SetActorScale3D(Record.InitialScale);
+				SetState(RecordIndex, EResourceNodeState::Dormant);
+				Record.StateTime = Now + ResourceLifecycle::GetTypeDef(Record.ResourceId).RegrowthDelay;
+			}
+			else
+			{
+				Node->SetActorScale3D(Record.InitialScale * FMath::Max(1.0f - FadeAlpha, ResourceLifecycle::MinFadeScale));
+			}
+			break;
+
+		case EResourceNodeState::Dormant:
+			if (Node->HasAuthority() && Now >= Record.StateTime && HasFreeSlot(Record.ResourceId))
+			{
+				BeginRegrowth(RecordIndex, Node);
+			}
+			break;
+
+		case EResourceNodeState::FadingIn:
+			if (FadeAlpha >= 1.0f)
+			{
+				Node->SetActorScale3D(Record.InitialScale);
+				SetState(RecordIndex, EResourceNodeState::Live);
+			}
+			else
+			{
+				Node->SetActorScale3D(Record.InitialScale * FMath::Max(FadeAlpha, ResourceLifecycle::MinFadeScale));
+			}
+			break;
+
+		default:
+			break;
+		}
+	}
+}
+
+bool UResourceLifecycleSubsystem::IsTickable() const
+{
+	return PendingRecords.Num() > 0;
+}
+
+TStatId UResourceLifecycleSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UResourceLifecycleSubsystem, STATGROUP_Tickables);
+}
+
+void UResourceLifecycleSubsystem::RegisterNode(AResource_M* Node)
+{
+	if (!Node || NodeToRecord.Contains(Node))
+	{
+		return;
+	}
+
+	const int32 RecordIndex = FreeRecords.Num() > 0 ? FreeRecords.Pop(EAllowShrinking::No) : Records.AddDefaulted();
+	NodeToRecord.Add(Node, RecordIndex);
+
+	FResourceNodeRecord& Record = Records[RecordIndex];
+	Record = FResourceNodeRecord();
+	Record.Node = Node;
+	Record.ResourceId = Node->ResourceId;
+	Record.InitialTotal = Node->totalResource;
+	Record.InitialScale = Node->GetActorScale3D();
+	Record.StateTime = GetWorld()->GetTimeSeconds();
+
+	if (Record.ResourceId >= LiveCounts.Num())
+	{
+		LiveCounts.SetNumZeroed(Record.ResourceId + 1);
+	}
+
+	// Records start Live, so count it before deciding whether it has to wait (clients follow the server)
+	const bool bHasSlot = !Node->HasAuthority() || HasFreeSlot(Record.ResourceId);
+	if (LiveCounts.IsValidIndex(Record.ResourceId))
+	{
+		++LiveCounts[Record.ResourceId];
+	}
+	if (bHasSlot)
+	{
+		return;
+	}
+
+	// Over the cap: wait hidden until a node of this type is depleted
+	Node->SetDepleted(true);
+	Node->SetActorHiddenInGame(true);
+	SetNodeInteractive(Node, false);
+	SetState(RecordIndex, EResourceNodeState::Dormant);
+}
+
+void UResourceLifecycleSubsystem::UnregisterNode(AResource_M* Node)
+{
+	int32 RecordIndex = INDEX_NONE;
+	if (!NodeToRecord.RemoveAndCopyValue(Node, RecordIndex))
+	{
+		return;
+	}
+
+	// Drop it from the counts and the pending list as if it had gone dormant
+	SetState(RecordIndex, EResourceNodeState::Dormant);
+	PendingRecords.RemoveSwap(RecordIndex, EAllowShrinking::No);
+	DEC_DWORD_STAT(STAT_GAM312_ResourceNodesDormant);
+
+	Records[RecordIndex] = FResourceNodeRecord();
+	FreeRecords.Add(RecordIndex);
+}
+
+void UResourceLifecycleSubsystem::DepleteNode(AResource_M* Node)
+{
+	const int32* RecordIndex = NodeToRecord.Find(Node);
+	if (!RecordIndex || Records[*RecordIndex].State != EResourceNodeState::Live)
+	{
+		return;
+	}
+
+	// Stop harvesting and queries right away; the mesh shrinks away over FadeDuration
+	Node->SetDepleted(true);
+	SetNodeInteractive(Node, false);
+	SetState(*RecordIndex, EResourceNodeState::FadingOut);
+}
+
+void UResourceLifecycleSubsystem::RegrowNode(AResource_M* Node)
+{
+	const int32* RecordIndex = NodeToRecord.Find(Node);
+	if (!RecordIndex)
+	{
+		return;
+	}
+
+	const EResourceNodeState State = Records[*RecordIndex].State;
+	if (State == EResourceNodeState::FadingOut || State == EResourceNodeState::Dormant)
+	{
+		Node->SetActorScale3D(Records[*RecordIndex].InitialScale);
+		BeginRegrowth(*RecordIndex, Node);
+	}
+}
+
+void UResourceLifecycleSubsystem::BeginRegrowth(int32 RecordIndex, AResource_M* Node)
+{
+	const FResourceNodeRecord& Record = Records[RecordIndex];
+
+	Node->totalResource = Record.InitialTotal;
+	Node->SetDepleted(false);
+	Node->SetActorScale3D(Record.InitialScale * ResourceLifecycle::MinFadeScale);
+	Node->SetActorHiddenInGame(false);
+	SetNodeInteractive(Node, true);
+	SetState(RecordIndex, EResourceNodeState::FadingIn);
+
+	INC_DWORD_STAT(STAT_GAM312_ResourceNodesRegrown);
+}
+
+// Moves a record between states, keeping the live counts and pending list in step
+void UResourceLifecycleSubsystem::SetState(int32 RecordIndex, EResourceNodeState NewState)
+{
+	FResourceNodeRecord& Record = Records[RecordIndex];
+	const EResourceNodeState OldState = Record.State;
+
+	if (LiveCounts.IsValidIndex(Record.ResourceId))
+	{
+		LiveCounts[Record.ResourceId] += (ResourceLifecycle::HoldsSlot(NewState) ? 1 : 0) - (ResourceLifecycle::HoldsSlot(OldState) ? 1 : 0);
+	}
+
+	if (OldState == EResourceNodeState::Live && NewState != EResourceNodeState::Live)
+	{
+		PendingRecords.Add(RecordIndex);
+		INC_DWORD_STAT(STAT_GAM312_ResourceNodesDormant);
+	}
+	else if (OldState != EResourceNodeState::Live && NewState == EResourceNodeState::Live)
+	{
+		PendingRecords.RemoveSwap(RecordIndex, EAllowShrinking::No);
+		DEC_DWORD_STAT(STAT_GAM312_ResourceNodesDormant);
+	}
+
+	Record.State = NewState;
+	Record.StateTime = GetWorld()->GetTimeSeconds();
+}
+
+bool UResourceLifecycleSubsystem::HasFreeSlot(int32 ResourceId) const
+{
+	const int32 MaxLiveNodes = ResourceLifecycle::GetTypeDef(ResourceId).MaxLiveNodes;
+	return MaxLiveNodes <= 0 || GetNumLiveNodes(ResourceId) < MaxLiveNodes;
+}
+
+void UResourceLifecycleSubsystem::SetNodeInteractive(AResource_M* Node, bool bInteractive)
+{
+	Node->SetActorEnableCollision(bInteractive);
+
+	if (UResourceSpatialSubsystem* SpatialIndex = GetWorld()->GetSubsystem<UResourceSpatialSubsystem>())
+	{
+		if (bInteractive)
+		{
+			SpatialIndex->RegisterNode(Node);
+		}
+		else
+		{
+			SpatialIndex->UnregisterNode(Node);
+		}
+	}
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ResourceLifecycleSubsystem.generated.h"
+
+class AResource_M;
+
+/**
+ * EResourceNodeState
+ */
+enum class EResourceNodeState : uint8
+{
+	// Visible, harvestable and in the spatial index
+	Live,
+	// Depleted; shrinking out of view with collision already off
+	FadingOut,
+	// Hidden, waiting for its regrowth delay and a free slot under the type's cap
+	Dormant,
+	// Refilled; growing back to full size
+	FadingIn,
+};
+
+/**
+ * FResourceNodeRecord
+ *
+ * Lifecycle state of one resource node, plus what it needs to be restored.
+ */
+struct FResourceNodeRecord
+{
+	TWeakObjectPtr<AResource_M> Node;
+	int32 ResourceId = INDEX_NONE;
+
+	// totalResource and actor scale the node started with
+	int32 InitialTotal = 0;
+	FVector InitialScale = FVector::OneVector;
+
+	EResourceNodeState State = EResourceNodeState::Live;
+
+	// World time the current state started (Dormant: the time it may regrow)
+	double StateTime = 0.0;
+};
+
+/**
+ * UResourceLifecycleSubsystem
+ *
+ * Recycles depleted resource nodes instead of destroying them. A depleted node loses
+ * collision and leaves the spatial index, shrinks out of view and stays hidden for its
+ * type's RegrowthDelay; it then refills and grows back once fewer than MaxLiveNodes of
+ * its type are live. Long sessions therefore never spawn or garbage-collect nodes.
+ * Only the server decides when nodes deplete and regrow; clients follow its
+ * replicated AResource_M depletion flag.
+ */
+UCLASS()
+class GAM312_STRAKA_API UResourceLifecycleSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	// Only ticks while some node is fading or dormant
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+
+	// Starts tracking Node (call from BeginPlay); it starts dormant if its type is already at the cap
+	void RegisterNode(AResource_M* Node);
+
+	// Stops tracking Node (call from EndPlay)
+	void UnregisterNode(AResource_M* Node);
+
+	// Retires a harvested-out node until it regrows
+	void DepleteNode(AResource_M* Node);
+
+	// Brings a depleted node back immediately (clients, when the server says it regrew)
+	void RegrowNode(AResource_M* Node);
+
+	// Number of live nodes of a resource type
+	int32 GetNumLiveNodes(int32 ResourceId) const { return LiveCounts.IsValidIndex(ResourceId) ? LiveCounts[ResourceId] : 0; }
+
+	// Seconds depleted nodes take to shrink away and to grow back
+	static constexpr float FadeDuration = 0.5f;
+
+private:
+	void SetState(int32 RecordIndex, EResourceNodeState NewState);
+	bool HasFreeSlot(int32 ResourceId) const;
+
+	// Refills the node and starts growing it back in
+	void BeginRegrowth(int32 RecordIndex, AResource_M* Node);
+
+	// Toggles the node's collision and its spatial-index entry (visibility is handled by the fade)
+	void SetNodeInteractive(AResource_M* Node, bool bInteractive);
+
+	TArray<FResourceNodeRecord> Records;
+	TArray<int32> FreeRecords;
+	TMap<const AResource_M*, int32> NodeToRecord;
+
+	// Records that are not Live, i.e. the only ones Tick has to look at
+	TArray<int32> PendingRecords;
+
+	// Live nodes per resource ID
+	TArray<int32> LiveCounts;
+};
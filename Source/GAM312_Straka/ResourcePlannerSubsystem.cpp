@@ -0,0 +1,412 @@
+#include "ResourcePlannerSubsystem.h"
+#include "GAM312_Straka.h"
+#include "ResourceRegistry.h"
+#include "ResourceSpatialSubsystem.h"
+#include "Resource_M.h"
+#include "NavigationSystem.h"
+#include "Engine/World.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Planner Queue Depth"), STAT_GAM312_PlannerQueue, STATGROUP_GAM312);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Planner Paths In Flight"), STAT_GAM312_PlannerPaths, STATGROUP_GAM312);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Planner Requests Answered"), STAT_GAM312_PlannerAnswered, STATGROUP_GAM312);
+
+static TAutoConsoleVariable<float> CVarPlannerBudgetMs(
+	TEXT("gam312.Planner.BudgetMs"),
+	1.0f,
+	TEXT("Milliseconds per frame the resource planner may spend answering queued requests. At least one batch runs per frame."));
+
+static TAutoConsoleVariable<int32> CVarPlannerMaxPathsInFlight(
+	TEXT("gam312.Planner.MaxPathsInFlight"),
+	64,
+	TEXT("Most async navmesh path queries the resource planner keeps outstanding."));
+
+namespace ResourcePlanner
+{
+	// Requests answered by one RunQueries pass; small enough to stop close to the budget
+	static constexpr int32 BatchSize = 16;
+
+	// Hits asked per query, so nodes emptied since the index was updated can be skipped
+	static constexpr int32 MaxHitsPerQuery = 4;
+
+	// Latency samples kept for the percentiles
+	static constexpr int32 MaxLatencySamples = 4096;
+
+	static constexpr int32 DefaultBenchRequests = 2000;
+	static constexpr float BenchRadius = 20000.0f;
+
+	// Value below which Fraction of the sorted samples fall
+	static double Percentile(const TArray<double>& Sorted, double Fraction)
+	{
+		return Sorted.Num() > 0 ? Sorted[FMath::Clamp(FMath::FloorToInt(Fraction * (Sorted.Num() - 1)), 0, Sorted.Num() - 1)] : 0.0;
+	}
+}
+
+void UResourcePlannerSubsystem::Deinitialize()
+{
+	if (UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld()))
+	{
+		for (const TPair<uint32, FPathRequest>& Pair : PathRequests)
+		{
+			NavSys->AbortAsyncFindPathRequest(Pair.Key);
+		}
+	}
+
+	Queue.Reset();
+	QueueHead = 0;
+	CancelledHandles.Reset();
+	PathRequests.Reset();
+	HandleToPathQuery.Reset();
+	Completed.Reset();
+	BenchHandles.Reset();
+
+	Super::Deinitialize();
+}
+
+bool UResourcePlannerSubsystem::IsTickable() const
+{
+	return GetQueueDepth() > 0 || BenchHandles.Num() > 0;
+}
+
+TStatId UResourcePlannerSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UResourcePlannerSubsystem, STATGROUP_Tickables);
+}
+
+int32 UResourcePlannerSubsystem::RequestPlan(const FResourcePlanRequest& Request)
+{
+	FQueuedRequest& Queued = Queue.AddDefaulted_GetRef();
+	Queued.Handle = NextHandle++;
+	Queued.Request = Request;
+	Queued.RequestTime = FPlatformTime::Seconds();
+
+	++NumRequested;
+	return Queued.Handle;
+}
+
+bool UResourcePlannerSubsystem::TakePlan(int32 Handle, FResourcePlan& OutPlan)
+{
+	return Completed.RemoveAndCopyValue(Handle, OutPlan);
+}
+
+void UResourcePlannerSubsystem::CancelPlan(int32 Handle)
+{
+	if (Completed.Remove(Handle) > 0)
+	{
+		return;
+	}
+
+	uint32 QueryId = 0;
+	if (HandleToPathQuery.RemoveAndCopyValue(Handle, QueryId))
+	{
+		PathRequests.Remove(QueryId);
+		if (UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld()))
+		{
+			NavSys->AbortAsyncFindPathRequest(QueryId);
+		}
+		return;
+	}
+
+	CancelledHandles.Add(Handle);
+}
+
+void UResourcePlannerSubsystem::Tick(float DeltaTime)
+{
+	GAM312_SCOPE(UResourcePlannerSubsystem, Tick);
+
+	Super::Tick(DeltaTime);
+
+	const double StartTime = FPlatformTime::Seconds();
+	const double Deadline = StartTime + CVarPlannerBudgetMs.GetValueOnGameThread() / 1000.0;
+	const int32 MaxPathsInFlight = FMath::Max(CVarPlannerMaxPathsInFlight.GetValueOnGameThread(), 1);
+
+	// Always make some progress; after that, stop at the budget or when paths back up
+	int32 NumAnsweredThisFrame = 0;
+	bool bOverBudget = false;
+	while (QueueHead < Queue.Num())
+	{
+		if (NumAnsweredThisFrame > 0 && FPlatformTime::Seconds() >= Deadline)
+		{
+			bOverBudget = true;
+			break;
+		}
+		if (PathRequests.Num() >= MaxPathsInFlight)
+		{
+			break;
+		}
+
+		// Nothing taken: the next request needs a path and every slot is promised
+		const int32 NumTaken = ProcessBatch(ResourcePlanner::BatchSize, MaxPathsInFlight);
+		if (NumTaken == 0)
+		{
+			break;
+		}
+		NumAnsweredThisFrame += NumTaken;
+	}
+
+	// Drop the consumed front once it outweighs what is left
+	if (QueueHead > 0 && QueueHead * 2 >= Queue.Num())
+	{
+		Queue.RemoveAt(0, QueueHead, EAllowShrinking::No);
+		QueueHead = 0;
+	}
+
+	LastTickSeconds = FPlatformTime::Seconds() - StartTime;
+	MaxTickSeconds = FMath::Max(MaxTickSeconds, LastTickSeconds);
+	NumBudgetFrames += bOverBudget ? 1 : 0;
+	++NumFrames;
+
+	SET_DWORD_STAT(STAT_GAM312_PlannerQueue, Queue.Num() - QueueHead);
+	SET_DWORD_STAT(STAT_GAM312_PlannerPaths, PathRequests.Num());
+	SET_DWORD_STAT(STAT_GAM312_PlannerAnswered, NumAnsweredThisFrame);
+
+	// The benchmark finishes once every one of its plans can be taken
+	if (BenchHandles.Num() > 0)
+	{
+		++BenchFrames;
+		if (!BenchHandles.ContainsByPredicate([this](int32 Handle) { return !Completed.Contains(Handle); }))
+		{
+			TMap<EResourcePlanStatus, int32> StatusCounts;
+			FResourcePlan Plan;
+			for (int32 Handle : BenchHandles)
+			{
+				TakePlan(Handle, Plan);
+				++StatusCounts.FindOrAdd(Plan.Status);
+			}
+
+			UE_LOG(LogGAM312, Display, TEXT("[PlannerBench] %d plans in %.1f ms over %d frames: %d found, %d without a node, %d without a path"),
+				BenchHandles.Num(), (FPlatformTime::Seconds() - BenchStartTime) * 1000.0, BenchFrames,
+				StatusCounts.FindRef(EResourcePlanStatus::Succeeded), StatusCounts.FindRef(EResourcePlanStatus::NoResource), StatusCounts.FindRef(EResourcePlanStatus::NoPath));
+			LogReport();
+			BenchHandles.Reset();
+		}
+	}
+}
+
+int32 UResourcePlannerSubsystem::ProcessBatch(int32 MaxRequests, int32 MaxPathsInFlight)
+{
+	const UResourceSpatialSubsystem* SpatialIndex = GetWorld()->GetSubsystem<UResourceSpatialSubsystem>();
+	UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+	const ANavigationData* NavData = NavSys ? NavSys->GetDefaultNavDataInstance(FNavigationSystem::DontCreate) : nullptr;
+
+	TArray<FResourceQuery, TInlineAllocator<ResourcePlanner::BatchSize>> Queries;
+	TArray<int32, TInlineAllocator<ResourcePlanner::BatchSize>> QueueIndices;
+	// Every request that may end in a path query holds a slot, so the batch can't overshoot the cap
+	int32 NumPathSlots = FMath::Max(MaxPathsInFlight - PathRequests.Num(), 0);
+
+	int32 NumTaken = 0;
+	while (QueueHead < Queue.Num() && Queries.Num() < MaxRequests)
+	{
+		if (CancelledHandles.Remove(Queue[QueueHead].Handle) > 0)
+		{
+			++QueueHead;
+			++NumTaken;
+			continue;
+		}
+
+		// Requests stay in order: one that may need a path waits for a free slot
+		const bool bMayNeedPath = Queue[QueueHead].Request.bFindPath && NavData;
+		if (bMayNeedPath && NumPathSlots == 0)
+		{
+			break;
+		}
+		NumPathSlots -= bMayNeedPath ? 1 : 0;
+
+		const int32 QueueIndex = QueueHead++;
+		++NumTaken;
+
+		const FResourcePlanRequest& Request = Queue[QueueIndex].Request;
+		FResourceQuery& Query = Queries.AddDefaulted_GetRef();
+		Query.Origin = Request.Origin;
+		Query.Radius = Request.Radius;
+		Query.ResourceId = Request.ResourceId;
+		Query.MaxResults = ResourcePlanner::MaxHitsPerQuery;
+		QueueIndices.Add(QueueIndex);
+	}
+
+	TArray<FResourceQueryResult> Results;
+	TArray<FResourceHit> Hits;
+	if (SpatialIndex && Queries.Num() > 0)
+	{
+		SpatialIndex->RunQueries(Queries, Results, Hits);
+	}
+
+	for (int32 QueryIndex = 0; QueryIndex < Queries.Num(); ++QueryIndex)
+	{
+		const FQueuedRequest& Queued = Queue[QueueIndices[QueryIndex]];
+
+		FResourcePlan Plan;
+		if (Results.IsValidIndex(QueryIndex))
+		{
+			const FResourceQueryResult& Result = Results[QueryIndex];
+			for (int32 HitIndex = Result.FirstHit; HitIndex < Result.FirstHit + Result.NumHits; ++HitIndex)
+			{
+				AResource_M* Node = Hits[HitIndex].Node;
+				if (Node && !Node->IsDepleted())
+				{
+					Plan.Node = Node;
+					Plan.Goal = Node->GetActorLocation();
+					break;
+				}
+			}
+		}
+
+		if (!Plan.Node.IsValid())
+		{
+			Plan.Status = EResourcePlanStatus::NoResource;
+			Complete(Queued.Handle, Queued.RequestTime, MoveTemp(Plan));
+			continue;
+		}
+
+		// Without a navmesh (or a path asked for) the plan is a straight line
+		if (!Queued.Request.bFindPath || !NavData)
+		{
+			Plan.Status = EResourcePlanStatus::Succeeded;
+			Plan.PathPoints = { Queued.Request.Origin, Plan.Goal };
+			Complete(Queued.Handle, Queued.RequestTime, MoveTemp(Plan));
+			continue;
+		}
+
+		// Nodes block the navmesh, so the path ends as close to the node as it can get
+		FPathFindingQuery PathQuery(this, *NavData, Queued.Request.Origin, Plan.Goal);
+		PathQuery.SetAllowPartialPaths(true);
+
+		const uint32 QueryId = NavSys->FindPathAsync(NavData->GetConfig(), PathQuery,
+			FNavPathQueryDelegate::CreateUObject(this, &UResourcePlannerSubsystem::OnPathFound));
+		if (QueryId == INVALID_NAVQUERYID)
+		{
+			Plan.Status = EResourcePlanStatus::NoPath;
+			Complete(Queued.Handle, Queued.RequestTime, MoveTemp(Plan));
+			continue;
+		}
+
+		FPathRequest& PathRequest = PathRequests.Add(QueryId);
+		PathRequest.Handle = Queued.Handle;
+		PathRequest.RequestTime = Queued.RequestTime;
+		PathRequest.Plan = MoveTemp(Plan);
+		HandleToPathQuery.Add(Queued.Handle, QueryId);
+	}
+
+	return NumTaken;
+}
+
+void UResourcePlannerSubsystem::OnPathFound(uint32 QueryId, ENavigationQueryResult::Type Result, FNavPathSharedPtr Path)
+{
+	FPathRequest PathRequest;
+	if (!PathRequests.RemoveAndCopyValue(QueryId, PathRequest))
+	{
+		return;
+	}
+	HandleToPathQuery.Remove(PathRequest.Handle);
+
+	FResourcePlan& Plan = PathRequest.Plan;
+	if (Result == ENavigationQueryResult::Success && Path.IsValid())
+	{
+		Plan.Status = EResourcePlanStatus::Succeeded;
+		Plan.PathPoints.Reserve(Path->GetPathPoints().Num());
+		for (const FNavPathPoint& Point : Path->GetPathPoints())
+		{
+			Plan.PathPoints.Add(Point.Location);
+		}
+	}
+	else
+	{
+		Plan.Status = EResourcePlanStatus::NoPath;
+	}
+
+	Complete(PathRequest.Handle, PathRequest.RequestTime, MoveTemp(Plan));
+}
+
+void UResourcePlannerSubsystem::Complete(int32 Handle, double RequestTime, FResourcePlan&& Plan)
+{
+	Plan.Latency = FPlatformTime::Seconds() - RequestTime;
+
+	if (LatencySamples.Num() < ResourcePlanner::MaxLatencySamples)
+	{
+		LatencySamples.Add(Plan.Latency);
+	}
+	else
+	{
+		LatencySamples[LatencyCursor] = Plan.Latency;
+		LatencyCursor = (LatencyCursor + 1) % ResourcePlanner::MaxLatencySamples;
+	}
+
+	++NumAnswered;
+	Completed.Add(Handle, MoveTemp(Plan));
+}
+
+void UResourcePlannerSubsystem::LogReport() const
+{
+	TArray<double> Sorted = LatencySamples;
+	Sorted.Sort();
+
+	UE_LOG(LogGAM312, Display, TEXT("[Planner] queue %d (%d awaiting paths), %lld requested, %lld answered | latency over the last %d: p50 %.2f ms, p90 %.2f ms, p99 %.2f ms, max %.2f ms | tick last %.3f ms, max %.3f ms, budget hit on %d of %d frames"),
+		GetQueueDepth(), PathRequests.Num(), NumRequested, NumAnswered, Sorted.Num(),
+		ResourcePlanner::Percentile(Sorted, 0.5) * 1000.0,
+		ResourcePlanner::Percentile(Sorted, 0.9) * 1000.0,
+		ResourcePlanner::Percentile(Sorted, 0.99) * 1000.0,
+		Sorted.Num() > 0 ? Sorted.Last() * 1000.0 : 0.0,
+		LastTickSeconds * 1000.0, MaxTickSeconds * 1000.0, NumBudgetFrames, NumFrames);
+}
+
+/** ---------- Benchmark ---------- **/
+
+void UResourcePlannerSubsystem::StartBenchmark(const FVector& Center, int32 NumRequests, int32 ResourceId)
+{
+	if (BenchHandles.Num() > 0)
+	{
+		return;
+	}
+
+	// Fresh percentiles for this run
+	LatencySamples.Reset();
+	LatencyCursor = 0;
+	NumBudgetFrames = 0;
+	NumFrames = 0;
+	MaxTickSeconds = 0.0;
+
+	FRandomStream Random(312);
+	for (int32 Index = 0; Index < NumRequests; ++Index)
+	{
+		FResourcePlanRequest Request;
+		Request.Origin = Center + FVector(Random.GetUnitVector2D() * ResourcePlanner::BenchRadius * FMath::Sqrt(Random.FRand()), 0.0f);
+		Request.ResourceId = ResourceId;
+		BenchHandles.Add(RequestPlan(Request));
+	}
+
+	BenchStartTime = FPlatformTime::Seconds();
+	BenchFrames = 0;
+	UE_LOG(LogGAM312, Display, TEXT("[PlannerBench] Queued %d requests, budget %.2f ms per frame, %d paths in flight at most"),
+		NumRequests, CVarPlannerBudgetMs.GetValueOnGameThread(), CVarPlannerMaxPathsInFlight.GetValueOnGameThread());
+}
+
+static FAutoConsoleCommandWithWorld GPlannerReportCommand(
+	TEXT("gam312.Planner.Report"),
+	TEXT("Logs the resource planner's queue depth, throughput and latency percentiles."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (const UResourcePlannerSubsystem* Planner = World ? World->GetSubsystem<UResourcePlannerSubsystem>() : nullptr)
+		{
+			Planner->LogReport();
+		}
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs GPlannerBenchmarkCommand(
+	TEXT("gam312.Planner.Benchmark"),
+	TEXT("Queues plan requests with paths from random points around the local player and reports once all are answered. Args: request count (default 2000), resource name (default any)."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		UResourcePlannerSubsystem* Planner = World ? World->GetSubsystem<UResourcePlannerSubsystem>() : nullptr;
+		if (!Planner)
+		{
+			return;
+		}
+
+		const APlayerController* Controller = World->GetFirstPlayerController();
+		const FVector Center = Controller && Controller->GetPawn() ? Controller->GetPawn()->GetActorLocation() : FVector::ZeroVector;
+		const int32 ResourceId = Args.Num() > 1 ? UResourceRegistry::Get().FindResourceId(FName(*Args[1])) : INDEX_NONE;
+
+		Planner->StartBenchmark(Center, Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : ResourcePlanner::DefaultBenchRequests, ResourceId);
+	}));
@@ -0,0 +1,156 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "NavigationData.h"
+#include "ResourcePlannerSubsystem.generated.h"
+
+class AResource_M;
+
+/**
+ * FResourcePlanRequest
+ *
+ * "Nearest resource of type ResourceId within Radius of Origin, and a path to it".
+ * ResourceId INDEX_NONE matches every type.
+ */
+struct FResourcePlanRequest
+{
+	FVector Origin = FVector::ZeroVector;
+	int32 ResourceId = INDEX_NONE;
+	float Radius = 10000.0f;
+
+	// Agents that walk straight lines can skip the navmesh
+	bool bFindPath = true;
+};
+
+/**
+ * EResourcePlanStatus
+ */
+enum class EResourcePlanStatus : uint8
+{
+	// Queued, or waiting for its path
+	Pending,
+	// Node found; PathPoints lead to it (a straight line where there is no navmesh)
+	Succeeded,
+	// No live node of the type in range
+	NoResource,
+	// Node found but the navmesh has no path to it
+	NoPath,
+};
+
+/**
+ * FResourcePlan
+ *
+ * Answer to one request, collected with UResourcePlannerSubsystem::TakePlan.
+ */
+struct FResourcePlan
+{
+	EResourcePlanStatus Status = EResourcePlanStatus::Pending;
+	TWeakObjectPtr<AResource_M> Node;
+	FVector Goal = FVector::ZeroVector;
+	TArray<FVector> PathPoints;
+
+	// Seconds from the request to the answer
+	double Latency = 0.0;
+};
+
+/**
+ * UResourcePlannerSubsystem
+ *
+ * Answers "find and path to the nearest resource" for any agent so agents don't search the
+ * world or the navmesh on their own. Requests queue up and are answered in batches from
+ * UResourceSpatialSubsystem (one RunQueries pass per batch); paths are found asynchronously
+ * by the navigation system. Each frame stops taking batches once gam312.Planner.BudgetMs is
+ * spent, and at most gam312.Planner.MaxPathsInFlight paths are outstanding.
+ *
+ * Requests return a handle. Agents poll it with TakePlan, which hands the plan over once it
+ * is ready, or drop it with CancelPlan. Queue depth and latency percentiles are in
+ * "stat GAM312" and gam312.Planner.Report.
+ */
+UCLASS()
+class GAM312_STRAKA_API UResourcePlannerSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+
+	// Queues a request and returns its handle
+	int32 RequestPlan(const FResourcePlanRequest& Request);
+
+	// Hands the plan over and releases the handle once it is ready. Returns false while pending.
+	bool TakePlan(int32 Handle, FResourcePlan& OutPlan);
+
+	// Drops a request wherever it is; its plan is never produced
+	void CancelPlan(int32 Handle);
+
+	// Requests queued or waiting for a path
+	int32 GetQueueDepth() const { return Queue.Num() - QueueHead + PathRequests.Num(); }
+
+	// Logs queue depth, throughput and latency percentiles of the recent plans
+	void LogReport() const;
+
+	// Queues NumRequests plans from random points around Center and reports once all are answered
+	void StartBenchmark(const FVector& Center, int32 NumRequests, int32 ResourceId);
+
+private:
+	struct FQueuedRequest
+	{
+		int32 Handle = INDEX_NONE;
+		FResourcePlanRequest Request;
+		double RequestTime = 0.0;
+	};
+
+	struct FPathRequest
+	{
+		int32 Handle = INDEX_NONE;
+		double RequestTime = 0.0;
+		FResourcePlan Plan;
+	};
+
+	// Answers one batch from the spatial index, stopping before a request that could push the path
+	// queries past MaxPathsInFlight; returns the number of requests taken off the queue
+	int32 ProcessBatch(int32 MaxRequests, int32 MaxPathsInFlight);
+
+	void OnPathFound(uint32 QueryId, ENavigationQueryResult::Type Result, FNavPathSharedPtr Path);
+
+	void Complete(int32 Handle, double RequestTime, FResourcePlan&& Plan);
+
+	// Queue[QueueHead..] is pending; the consumed front is dropped once it is half the array
+	TArray<FQueuedRequest> Queue;
+	int32 QueueHead = 0;
+
+	// Handles cancelled while queued, skipped when their turn comes
+	TSet<int32> CancelledHandles;
+
+	// Requests waiting for an async path, by navigation query ID
+	TMap<uint32, FPathRequest> PathRequests;
+	TMap<int32, uint32> HandleToPathQuery;
+
+	// Plans ready to be taken
+	TMap<int32, FResourcePlan> Completed;
+
+	int32 NextHandle = 0;
+
+	// Latency of the most recent plans (a ring), in seconds
+	TArray<double> LatencySamples;
+	int32 LatencyCursor = 0;
+
+	// Totals, for the report
+	int64 NumRequested = 0;
+	int64 NumAnswered = 0;
+	int32 NumBudgetFrames = 0;
+	int32 NumFrames = 0;
+	double LastTickSeconds = 0.0;
+	double MaxTickSeconds = 0.0;
+
+	/** ---------- Benchmark State ---------- **/
+
+	TArray<int32> BenchHandles;
+	double BenchStartTime = 0.0;
+	int32 BenchFrames = 0;
+};
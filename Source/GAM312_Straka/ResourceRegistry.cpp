@@ -0,0 +1,133 @@
+#include "ResourceRegistry.h"
+#include "GAM312_Straka.h"
+
+namespace ResourceRegistryDefaults
+{
+	static FResourceTypeDef MakeResource(FName Name)
+	{
+		FResourceTypeDef Resource;
+		Resource.Name = Name;
+		Resource.DisplayName = FText::FromName(Name);
+		return Resource;
+	}
+
+	static FResourceCost MakeCost(FName Resource, float Amount)
+	{
+		FResourceCost Cost;
+		Cost.Resource = Resource;
+		Cost.Amount = Amount;
+		return Cost;
+	}
+}
+
+// Defaults match the slots AMyCharacter used before the registry existed, and the
+// recipes match the costs Crafting_W has always shown
+UResourceRegistry::UResourceRegistry()
+{
+	const FName Wood(TEXT("Wood"));
+	const FName Stone(TEXT("Stone"));
+	const FName Berry(TEXT("Berry"));
+
+	Resources.Add(ResourceRegistryDefaults::MakeResource(Wood));
+	Resources.Add(ResourceRegistryDefaults::MakeResource(Stone));
+	Resources.Add(ResourceRegistryDefaults::MakeResource(Berry));
+
+	FBuildingTypeDef& Wall = Buildings.AddDefaulted_GetRef();
+	Wall.Name = TEXT("Wall");
+	Wall.Cost = { ResourceRegistryDefaults::MakeCost(Wood, 10.0f), ResourceRegistryDefaults::MakeCost(Stone, 5.0f) };
+
+	FBuildingTypeDef& Floor = Buildings.AddDefaulted_GetRef();
+	Floor.Name = TEXT("Floor");
+	Floor.Cost = { ResourceRegistryDefaults::MakeCost(Wood, 30.0f), ResourceRegistryDefaults::MakeCost(Stone, 15.0f) };
+
+	FBuildingTypeDef& Ceiling = Buildings.AddDefaulted_GetRef();
+	Ceiling.Name = TEXT("Ceiling");
+	Ceiling.Cost = { ResourceRegistryDefaults::MakeCost(Wood, 50.0f), ResourceRegistryDefaults::MakeCost(Stone, 30.0f) };
+}
+
+void UResourceRegistry::PostInitProperties()
+{
+	Super::PostInitProperties();
+
+	ResolveIds();
+}
+
+void UResourceRegistry::PostLoad()
+{
+	Super::PostLoad();
+
+	ResolveIds();
+}
+
+#if WITH_EDITOR
+void UResourceRegistry::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	ResolveIds();
+}
+#endif
+
+const UResourceRegistry& UResourceRegistry::Get()
+{
+	static TWeakObjectPtr<UResourceRegistry> Loaded;
+
+	if (!Loaded.IsValid())
+	{
+		const FSoftObjectPath& AssetPath = GetDefault<UResourceRegistry>()->RegistryAsset;
+		if (AssetPath.IsNull())
+		{
+			return *GetDefault<UResourceRegistry>();
+		}
+
+		UResourceRegistry* Registry = Cast<UResourceRegistry>(AssetPath.TryLoad());
+		if (!Registry)
+		{
+			UE_LOG(LogGAM312, Warning, TEXT("Resource registry %s could not be loaded, using class defaults"), *AssetPath.ToString());
+			return *GetDefault<UResourceRegistry>();
+		}
+
+		// Keep the registry resident; its IDs are cached by characters and resource nodes
+		Registry->AddToRoot();
+		Loaded = Registry;
+	}
+
+	return *Loaded.Get();
+}
+
+int32 UResourceRegistry::FindResourceId(FName Name) const
+{
+	const int32* Id = ResourceLookup.Find(Name);
+	return Id ? *Id : INDEX_NONE;
+}
+
+int32 UResourceRegistry::FindBuildingId(FName Name) const
+{
+	const int32* Id = BuildingLookup.Find(Name);
+	return Id ? *Id : INDEX_NONE;
+}
+
+void UResourceRegistry::ResolveIds()
+{
+	ResourceLookup.Reset();
+	for (int32 Index = 0; Index < Resources.Num(); ++Index)
+	{
+		ResourceLookup.Add(Resources[Index].Name, Index);
+	}
+
+	BuildingLookup.Reset();
+	for (int32 Index = 0; Index < Buildings.Num(); ++Index)
+	{
+		BuildingLookup.Add(Buildings[Index].Name, Index);
+
+		for (FResourceCost& Cost : Buildings[Index].Cost)
+		{
+			Cost.ResourceId = FindResourceId(Cost.Resource);
+			if (Cost.ResourceId == INDEX_NONE)
+			{
+				UE_LOG(LogGAM312, Warning, TEXT("%s: building %s costs unknown resource %s"),
+					*GetName(), *Buildings[Index].Name.ToString(), *Cost.Resource.ToString());
+			}
+		}
+	}
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "BuildingPart.h"
+#include "ResourceRegistry.generated.h"
+
+class UMaterialInterface;
+class UStaticMesh;
+
+/**
+ * FResourceTypeDef
+ *
+ * One harvestable resource type. Its index in UResourceRegistry::Resources is the
+ * compact ID used by UInventoryComponent and AResource_M::ResourceId.
+ */
+USTRUCT(BlueprintType)
+struct FResourceTypeDef
+{
+	GENERATED_BODY()
+
+	// Name matched against AResource_M::resourceName
+	UPROPERTY(EditAnywhere, BlueprintReadOnly)
+	FName Name;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly)
+	FText DisplayName;
+
+	// Seconds a depleted node stays hidden before it regrows
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, meta = (ClampMin = "0"))
+	float RegrowthDelay = 60.0f;
+
+	// Most nodes of this type active at once; regrown nodes wait for a free slot (0 = no cap)
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, meta = (ClampMin = "0"))
+	int32 MaxLiveNodes = 0;
+};
+
+/**
+ * FResourceCost
+ *
+ * Amount of one resource consumed by a recipe.
+ */
+USTRUCT(BlueprintType)
+struct FResourceCost
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly)
+	FName Resource;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly)
+	float Amount = 0.0f;
+
+	// Index into UResourceRegistry::Resources, resolved on load
+	int32 ResourceId = INDEX_NONE;
+};
+
+/**
+ * FBuildingTypeDef
+ *
+ * One craftable building piece. Its index in UResourceRegistry::Buildings is the
+ * building ID used by UInventoryComponent and AMyCharacter::SpawnBuilding.
+ */
+USTRUCT(BlueprintType)
+struct FBuildingTypeDef
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly)
+	FName Name;
+
+	// Resources consumed to craft one piece
+	UPROPERTY(EditAnywhere, BlueprintReadOnly)
+	TArray<FResourceCost> Cost;
+
+	// Part spawned for this type; falls back to AMyCharacter::BuildPartClass when unset
+	UPROPERTY(EditAnywhere, BlueprintReadOnly)
+	TSubclassOf<ABuildingPart> PartClass;
+
+	// Mesh swapped onto a pooled preview actor for this type; the class default when unset
+	UPROPERTY(EditAnywhere, BlueprintReadOnly)
+	UStaticMesh* Mesh = nullptr;
+
+	// Materials swapped onto a pooled preview actor for this type; the class defaults when empty
+	UPROPERTY(EditAnywhere, BlueprintReadOnly)
+	TArray<UMaterialInterface*> Materials;
+};
+
+/**
+ * UResourceRegistry
+ *
+ * Data asset listing every resource and building type plus the building recipes.
+ * Names are resolved to integer IDs once when the asset loads, so the harvest and
+ * craft paths index arrays instead of comparing strings. The asset used at runtime
+ * is set with RegistryAsset in DefaultGame.ini; without one, the class defaults
+ * (Wood/Stone/Berry and Wall/Floor/Ceiling) are used.
+ */
+UCLASS(BlueprintType, Config = Game)
+class GAM312_STRAKA_API UResourceRegistry : public UPrimaryDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	UResourceRegistry();
+
+	virtual void PostInitProperties() override;
+	virtual void PostLoad() override;
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+
+	// Returns the configured registry asset, or the class defaults if none is set
+	static const UResourceRegistry& Get();
+
+	// Returns the resource ID for Name, or INDEX_NONE
+	int32 FindResourceId(FName Name) const;
+
+	// Returns the building ID for Name, or INDEX_NONE
+	int32 FindBuildingId(FName Name) const;
+
+	int32 NumResources() const { return Resources.Num(); }
+	int32 NumBuildings() const { return Buildings.Num(); }
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Registry")
+	TArray<FResourceTypeDef> Resources;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Registry")
+	TArray<FBuildingTypeDef> Buildings;
+
+private:
+	// Rebuilds the name lookups and resolves recipe costs to resource IDs
+	void ResolveIds();
+
+	// Registry asset loaded by Get()
+	UPROPERTY(Config)
+	FSoftObjectPath RegistryAsset;
+
+	TMap<FName, int32> ResourceLookup;
+	TMap<FName, int32> BuildingLookup;
+};
@@ -0,0 +1,229 @@
+#include "ResourceSignificanceSubsystem.h"
+#include "GAM312_Straka.h"
+#include "Resource_M.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+
+DECLARE_STATS_GROUP(TEXT("GAM312Significance"), STATGROUP_GAM312Significance, STATCAT_Advanced);
+
+// Set only on update frames, so they hold their value in between instead of clearing every frame
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Resource Nodes Near"), STAT_GAM312_SignificanceNear, STATGROUP_GAM312Significance);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Resource Nodes Mid"), STAT_GAM312_SignificanceMid, STATGROUP_GAM312Significance);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Resource Nodes Far"), STAT_GAM312_SignificanceFar, STATGROUP_GAM312Significance);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Resource Nodes Culled"), STAT_GAM312_SignificanceCulled, STATGROUP_GAM312Significance);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Bucket Changes (Last Update)"), STAT_GAM312_SignificanceChanges, STATGROUP_GAM312Significance);
+DECLARE_CYCLE_STAT(TEXT("Significance Update"), STAT_GAM312_SignificanceUpdate, STATGROUP_GAM312Significance);
+
+static TAutoConsoleVariable<float> CVarResourceLabelDistance(
+	TEXT("gam312.Resource.LabelDistance"),
+	2000.0f,
+	TEXT("Resource labels are hidden beyond this distance from every local camera."));
+
+static TAutoConsoleVariable<float> CVarResourceFarDistance(
+	TEXT("gam312.Resource.FarDistance"),
+	6000.0f,
+	TEXT("Resource nodes beyond this distance use their lowest mesh LOD and have no collision."));
+
+static TAutoConsoleVariable<float> CVarResourceCullDistance(
+	TEXT("gam312.Resource.CullDistance"),
+	15000.0f,
+	TEXT("Resource nodes beyond this distance are not drawn."));
+
+static TAutoConsoleVariable<float> CVarResourceSignificanceInterval(
+	TEXT("gam312.Resource.SignificanceInterval"),
+	0.25f,
+	TEXT("Seconds between resource significance updates."));
+
+namespace ResourceSignificance
+{
+	// A node has to move this much past a threshold before it drops to a lower-detail bucket,
+	// so nodes sitting on a boundary don't flicker
+	static constexpr float Hysteresis = 1.1f;
+
+	static EResourceSignificance GetBucket(double DistanceSq)
+	{
+		if (DistanceSq > FMath::Square(CVarResourceCullDistance.GetValueOnGameThread()))
+		{
+			return EResourceSignificance::Culled;
+		}
+		if (DistanceSq > FMath::Square(CVarResourceFarDistance.GetValueOnGameThread()))
+		{
+			return EResourceSignificance::Far;
+		}
+		if (DistanceSq > FMath::Square(CVarResourceLabelDistance.GetValueOnGameThread()))
+		{
+			return EResourceSignificance::Mid;
+		}
+		return EResourceSignificance::Near;
+	}
+}
+
+void UResourceSignificanceSubsystem::Deinitialize()
+{
+	Nodes.Reset();
+	NodeToEntry.Reset();
+
+	Super::Deinitialize();
+}
+
+void UResourceSignificanceSubsystem::Tick(float DeltaTime)
+{
+	GAM312_SCOPE(UResourceSignificanceSubsystem, Tick);
+
+	Super::Tick(DeltaTime);
+
+	TimeSinceUpdate += DeltaTime;
+	if (TimeSinceUpdate < CVarResourceSignificanceInterval.GetValueOnGameThread())
+	{
+		return;
+	}
+	TimeSinceUpdate = 0.0f;
+
+	// Every local player's view counts (split screen)
+	TArray<FVector, TInlineAllocator<4>> ViewLocations;
+	bool bHasRemotePlayers = false;
+	for (FConstPlayerControllerIterator Iterator = GetWorld()->GetPlayerControllerIterator(); Iterator; ++Iterator)
+	{
+		const APlayerController* Controller = Iterator->Get();
+		if (!Controller)
+		{
+			continue;
+		}
+
+		if (Controller->IsLocalController())
+		{
+			FVector ViewLocation;
+			FRotator ViewRotation;
+			Controller->GetPlayerViewPoint(ViewLocation, ViewRotation);
+			ViewLocations.Add(ViewLocation);
+		}
+		else
+		{
+			bHasRemotePlayers = true;
+		}
+	}
+
+	// Remote players harvest through this server's traces, so a node far from the host must keep colliding
+	if (bCullCollision == bHasRemotePlayers)
+	{
+		bCullCollision = !bHasRemotePlayers;
+		for (const FNodeEntry& Entry : Nodes)
+		{
+			ApplyBucket(Entry);
+		}
+	}
+
+	// No view to judge distance from (dedicated server): leave nodes as they are
+	if (ViewLocations.Num() > 0)
+	{
+		UpdateSignificance(ViewLocations);
+	}
+}
+
+bool UResourceSignificanceSubsystem::IsTickable() const
+{
+	return Nodes.Num() > 0;
+}
+
+TStatId UResourceSignificanceSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UResourceSignificanceSubsystem, STATGROUP_Tickables);
+}
+
+void UResourceSignificanceSubsystem::RegisterNode(AResource_M* Node)
+{
+	if (!Node || !Node->Mesh || NodeToEntry.Contains(Node))
+	{
+		return;
+	}
+
+	FNodeEntry& Entry = Nodes.AddDefaulted_GetRef();
+	Entry.Node = Node;
+	Entry.Location = Node->GetActorLocation();
+	Entry.MeshCollision = Node->Mesh->GetCollisionEnabled();
+
+	NodeToEntry.Add(Node, Nodes.Num() - 1);
+	++BucketCounts[static_cast<int32>(Entry.Bucket)];
+}
+
+void UResourceSignificanceSubsystem::UnregisterNode(AResource_M* Node)
+{
+	int32 EntryIndex = INDEX_NONE;
+	if (!NodeToEntry.RemoveAndCopyValue(Node, EntryIndex))
+	{
+		return;
+	}
+
+	// Hand the node back at full detail
+	FNodeEntry& Entry = Nodes[EntryIndex];
+	--BucketCounts[static_cast<int32>(Entry.Bucket)];
+	Entry.Bucket = EResourceSignificance::Near;
+	ApplyBucket(Entry);
+
+	// Move the last entry into the freed slot
+	const int32 LastIndex = Nodes.Num() - 1;
+	if (EntryIndex != LastIndex)
+	{
+		NodeToEntry[Nodes[LastIndex].Node] = EntryIndex;
+	}
+	Nodes.RemoveAtSwap(EntryIndex, 1, EAllowShrinking::No);
+}
+
+void UResourceSignificanceSubsystem::UpdateSignificance(TConstArrayView<FVector> ViewLocations)
+{
+	SCOPE_CYCLE_COUNTER(STAT_GAM312_SignificanceUpdate);
+
+	int32 NumChanges = 0;
+	for (FNodeEntry& Entry : Nodes)
+	{
+		double DistanceSq = TNumericLimits<double>::Max();
+		for (const FVector& ViewLocation : ViewLocations)
+		{
+			DistanceSq = FMath::Min(DistanceSq, FVector::DistSquared(Entry.Location, ViewLocation));
+		}
+
+		EResourceSignificance Bucket = ResourceSignificance::GetBucket(DistanceSq);
+		if (Bucket > Entry.Bucket)
+		{
+			Bucket = FMath::Max(Entry.Bucket, ResourceSignificance::GetBucket(DistanceSq / FMath::Square(ResourceSignificance::Hysteresis)));
+		}
+
+		if (Bucket != Entry.Bucket)
+		{
+			--BucketCounts[static_cast<int32>(Entry.Bucket)];
+			++BucketCounts[static_cast<int32>(Bucket)];
+			Entry.Bucket = Bucket;
+			ApplyBucket(Entry);
+			++NumChanges;
+		}
+	}
+
+	SET_DWORD_STAT(STAT_GAM312_SignificanceNear, BucketCounts[static_cast<int32>(EResourceSignificance::Near)]);
+	SET_DWORD_STAT(STAT_GAM312_SignificanceMid, BucketCounts[static_cast<int32>(EResourceSignificance::Mid)]);
+	SET_DWORD_STAT(STAT_GAM312_SignificanceFar, BucketCounts[static_cast<int32>(EResourceSignificance::Far)]);
+	SET_DWORD_STAT(STAT_GAM312_SignificanceCulled, BucketCounts[static_cast<int32>(EResourceSignificance::Culled)]);
+	SET_DWORD_STAT(STAT_GAM312_SignificanceChanges, NumChanges);
+}
+
+// Component state for each bucket; only called when a node changes bucket
+void UResourceSignificanceSubsystem::ApplyBucket(const FNodeEntry& Entry) const
+{
+	AResource_M* Node = Entry.Node;
+	const bool bVisible = Entry.Bucket != EResourceSignificance::Culled;
+	const bool bCollides = !bCullCollision || Entry.Bucket <= EResourceSignificance::Mid;
+
+	if (Node->ResourceNameTxt)
+	{
+		Node->ResourceNameTxt->SetVisibility(Entry.Bucket == EResourceSignificance::Near);
+	}
+
+	Node->Mesh->SetVisibility(bVisible);
+	Node->Mesh->SetCollisionEnabled(bCollides ? Entry.MeshCollision : ECollisionEnabled::NoCollision);
+
+	// Far nodes are pinned to the last LOD (ForcedLodModel is 1-based; 0 lets the mesh choose)
+	const UStaticMesh* StaticMesh = Node->Mesh->GetStaticMesh();
+	const int32 NumLODs = StaticMesh ? StaticMesh->GetNumLODs() : 0;
+	Node->Mesh->SetForcedLodModel(Entry.Bucket == EResourceSignificance::Far && NumLODs > 1 ? NumLODs : 0);
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Engine/EngineTypes.h"
+#include "ResourceSignificanceSubsystem.generated.h"
+
+class AResource_M;
+
+/**
+ * EResourceSignificance
+ *
+ * Detail level of a resource node, from nearest to farthest.
+ */
+enum class EResourceSignificance : uint8
+{
+	// Label, full mesh and collision
+	Near,
+	// No label; the mesh picks its own LOD
+	Mid,
+	// No label, lowest mesh LOD and no collision
+	Far,
+	// Not drawn and no collision
+	Culled,
+
+	Num
+};
+
+/**
+ * UResourceSignificanceSubsystem
+ *
+ * Scales resource-node detail with distance to the nearest local player camera. Labels
+ * turn off first, then meshes drop to their lowest LOD and lose collision, and far nodes
+ * stop rendering. Only components are touched, so the actor-level hiding and collision
+ * used by UResourceLifecycleSubsystem still apply on top. A server with remote players
+ * keeps every node's collision, since it traces for players it can't see from here and
+ * only the visuals follow the local view. Bucket counts are shown by
+ * "stat GAM312Significance"; the distances are gam312.Resource.* console variables.
+ */
+UCLASS()
+class GAM312_STRAKA_API UResourceSignificanceSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+
+	// Starts managing Node's detail (call from BeginPlay)
+	void RegisterNode(AResource_M* Node);
+
+	// Stops managing Node and restores its full detail (call from EndPlay)
+	void UnregisterNode(AResource_M* Node);
+
+	int32 GetNumInBucket(EResourceSignificance Bucket) const { return BucketCounts[static_cast<int32>(Bucket)]; }
+
+private:
+	struct FNodeEntry
+	{
+		AResource_M* Node = nullptr;
+		FVector Location = FVector::ZeroVector;
+		EResourceSignificance Bucket = EResourceSignificance::Near;
+
+		// Mesh collision to restore when the node comes back from Far
+		ECollisionEnabled::Type MeshCollision = ECollisionEnabled::QueryAndPhysics;
+	};
+
+	// Re-buckets every node against the given view locations
+	void UpdateSignificance(TConstArrayView<FVector> ViewLocations);
+
+	void ApplyBucket(const FNodeEntry& Entry) const;
+
+	TArray<FNodeEntry> Nodes;
+	TMap<const AResource_M*, int32> NodeToEntry;
+
+	int32 BucketCounts[static_cast<int32>(EResourceSignificance::Num)] = {};
+
+	float TimeSinceUpdate = 0.0f;
+
+	// False while remote players are connected to this server, so collision is left alone
+	bool bCullCollision = true;
+};
@@ -0,0 +1,149 @@
+#include "ResourceSpatialSubsystem.h"
+#include "GAM312_Straka.h"
+#include "Resource_M.h"
+
+DECLARE_CYCLE_STAT(TEXT("Resource Spatial Queries"), STAT_GAM312_ResourceQueries, STATGROUP_GAM312);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Resource Queries"), STAT_GAM312_NumResourceQueries, STATGROUP_GAM312);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Resource Nodes Indexed"), STAT_GAM312_ResourceNodesIndexed, STATGROUP_GAM312);
+
+namespace ResourceSpatial
+{
+	// Edge length of one grid cell on the XY plane
+	static constexpr float CellSize = 1000.0f;
+}
+
+void UResourceSpatialSubsystem::Deinitialize()
+{
+	Nodes.Reset();
+	NodeToEntry.Reset();
+	Cells.Reset();
+	SET_DWORD_STAT(STAT_GAM312_ResourceNodesIndexed, 0);
+
+	Super::Deinitialize();
+}
+
+FIntPoint UResourceSpatialSubsystem::GetCell(const FVector& Location) const
+{
+	return FIntPoint(
+		FMath::FloorToInt(Location.X / ResourceSpatial::CellSize),
+		FMath::FloorToInt(Location.Y / ResourceSpatial::CellSize));
+}
+
+void UResourceSpatialSubsystem::RegisterNode(AResource_M* Node)
+{
+	if (!Node || NodeToEntry.Contains(Node))
+	{
+		return;
+	}
+
+	FNodeEntry& Entry = Nodes.AddDefaulted_GetRef();
+	Entry.Node = Node;
+	// The bounds sphere is centered on the mesh bounds, which sit off the pivot for many meshes
+	Entry.Location = Node->Mesh ? Node->Mesh->Bounds.Origin : Node->GetActorLocation();
+	Entry.BoundsRadius = Node->Mesh ? Node->Mesh->Bounds.SphereRadius : 0.0f;
+	Entry.ResourceId = Node->ResourceId;
+	Entry.Cell = GetCell(Entry.Location);
+
+	const int32 EntryIndex = Nodes.Num() - 1;
+	NodeToEntry.Add(Node, EntryIndex);
+	Cells.FindOrAdd(Entry.Cell).Add(EntryIndex);
+	MaxBoundsRadius = FMath::Max(MaxBoundsRadius, Entry.BoundsRadius);
+
+	INC_DWORD_STAT(STAT_GAM312_ResourceNodesIndexed);
+}
+
+void UResourceSpatialSubsystem::UnregisterNode(AResource_M* Node)
+{
+	int32 EntryIndex = INDEX_NONE;
+	if (!NodeToEntry.RemoveAndCopyValue(Node, EntryIndex))
+	{
+		return;
+	}
+
+	RemoveFromCell(Nodes[EntryIndex].Cell, EntryIndex);
+
+	// Move the last entry into the freed slot and repoint its cell and lookup
+	const int32 LastIndex = Nodes.Num() - 1;
+	if (EntryIndex != LastIndex)
+	{
+		FNodeEntry& Moved = Nodes[LastIndex];
+		TArray<int32>& MovedCell = Cells.FindChecked(Moved.Cell);
+		MovedCell[MovedCell.IndexOfByKey(LastIndex)] = EntryIndex;
+		NodeToEntry[Moved.Node] = EntryIndex;
+	}
+	Nodes.RemoveAtSwap(EntryIndex, 1, EAllowShrinking::No);
+
+	DEC_DWORD_STAT(STAT_GAM312_ResourceNodesIndexed);
+}
+
+void UResourceSpatialSubsystem::RemoveFromCell(const FIntPoint& Cell, int32 EntryIndex)
+{
+	if (TArray<int32>* CellEntries = Cells.Find(Cell))
+	{
+		CellEntries->RemoveSingleSwap(EntryIndex, EAllowShrinking::No);
+		if (CellEntries->Num() == 0)
+		{
+			Cells.Remove(Cell);
+		}
+	}
+}
+
+void UResourceSpatialSubsystem::RunQueries(TConstArrayView<FResourceQuery> Queries, TArray<FResourceQueryResult>& OutResults, TArray<FResourceHit>& OutHits) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_GAM312_ResourceQueries);
+	INC_DWORD_STAT_BY(STAT_GAM312_NumResourceQueries, Queries.Num());
+
+	OutResults.SetNum(Queries.Num());
+	TArray<FResourceHit, TInlineAllocator<32>> Candidates;
+
+	for (int32 QueryIndex = 0; QueryIndex < Queries.Num(); ++QueryIndex)
+	{
+		const FResourceQuery& Query = Queries[QueryIndex];
+		Candidates.Reset();
+
+		// Widen the cell range by the largest node so big meshes near the edge are still found
+		const float SearchRadius = Query.Radius + MaxBoundsRadius;
+		const FIntPoint MinCell = GetCell(Query.Origin - FVector(SearchRadius));
+		const FIntPoint MaxCell = GetCell(Query.Origin + FVector(SearchRadius));
+
+		for (int32 CellY = MinCell.Y; CellY <= MaxCell.Y; ++CellY)
+		{
+			for (int32 CellX = MinCell.X; CellX <= MaxCell.X; ++CellX)
+			{
+				const TArray<int32>* CellEntries = Cells.Find(FIntPoint(CellX, CellY));
+				if (!CellEntries)
+				{
+					continue;
+				}
+
+				for (const int32 EntryIndex : *CellEntries)
+				{
+					const FNodeEntry& Entry = Nodes[EntryIndex];
+					if (Query.ResourceId != INDEX_NONE && Entry.ResourceId != Query.ResourceId)
+					{
+						continue;
+					}
+
+					const float DistanceSq = static_cast<float>(FVector::DistSquared(Query.Origin, Entry.Location));
+					if (DistanceSq <= FMath::Square(Query.Radius + Entry.BoundsRadius))
+					{
+						Candidates.Add({ Entry.Node, DistanceSq });
+					}
+				}
+			}
+		}
+
+		Candidates.Sort([](const FResourceHit& A, const FResourceHit& B) { return A.DistanceSq < B.DistanceSq; });
+
+		FResourceQueryResult& Result = OutResults[QueryIndex];
+		Result.FirstHit = OutHits.Num();
+		Result.NumHits = FMath::Min(Candidates.Num(), Query.MaxResults);
+		OutHits.Append(Candidates.GetData(), Result.NumHits);
+	}
+}
+
+void UResourceSpatialSubsystem::FindNearest(const FResourceQuery& Query, TArray<FResourceHit>& OutHits) const
+{
+	TArray<FResourceQueryResult> Results;
+	RunQueries(MakeArrayView(&Query, 1), Results, OutHits);
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ResourceSpatialSubsystem.generated.h"
+
+class AResource_M;
+
+/**
+ * FResourceQuery
+ *
+ * "Nearest MaxResults resources of type ResourceId within Radius of Origin".
+ * ResourceId INDEX_NONE matches every type.
+ */
+struct FResourceQuery
+{
+	FVector Origin = FVector::ZeroVector;
+	float Radius = 0.0f;
+	int32 ResourceId = INDEX_NONE;
+	int32 MaxResults = 1;
+};
+
+/**
+ * FResourceHit
+ *
+ * One resource node returned by a query, with its squared distance to the query origin.
+ */
+struct FResourceHit
+{
+	AResource_M* Node = nullptr;
+	float DistanceSq = 0.0f;
+};
+
+/**
+ * FResourceQueryResult
+ *
+ * Range of hits for one query inside the flat hit array filled by RunQueries,
+ * sorted nearest first.
+ */
+struct FResourceQueryResult
+{
+	int32 FirstHit = 0;
+	int32 NumHits = 0;
+};
+
+/**
+ * UResourceSpatialSubsystem
+ *
+ * Uniform-grid spatial hash of every AResource_M in the world. Nodes register on
+ * BeginPlay and unregister on EndPlay (which covers Destroy), so proximity queries
+ * never touch physics.
+ */
+UCLASS()
+class GAM312_STRAKA_API UResourceSpatialSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	void RegisterNode(AResource_M* Node);
+	void UnregisterNode(AResource_M* Node);
+
+	// Answers every query in one pass; OutResults[i] indexes OutHits for Queries[i]
+	void RunQueries(TConstArrayView<FResourceQuery> Queries, TArray<FResourceQueryResult>& OutResults, TArray<FResourceHit>& OutHits) const;
+
+	// Convenience wrapper for a single query
+	void FindNearest(const FResourceQuery& Query, TArray<FResourceHit>& OutHits) const;
+
+	int32 GetNumNodes() const { return Nodes.Num(); }
+
+private:
+	// Dense per-node data; swapped on removal so queries walk contiguous memory
+	struct FNodeEntry
+	{
+		AResource_M* Node = nullptr;
+
+		// Center and radius of the mesh's bounds sphere
+		FVector Location = FVector::ZeroVector;
+		float BoundsRadius = 0.0f;
+		int32 ResourceId = INDEX_NONE;
+		FIntPoint Cell = FIntPoint::ZeroValue;
+	};
+
+	FIntPoint GetCell(const FVector& Location) const;
+	void RemoveFromCell(const FIntPoint& Cell, int32 EntryIndex);
+
+	TArray<FNodeEntry> Nodes;
+	TMap<const AResource_M*, int32> NodeToEntry;
+	TMap<FIntPoint, TArray<int32>> Cells;
+
+	// Largest node bounds radius seen, used to widen cell searches
+	float MaxBoundsRadius = 0.0f;
+};
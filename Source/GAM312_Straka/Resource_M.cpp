@@ -1,10 +1,22 @@
 #include "Resource_M.h"
+#include "GAM312_Straka.h"
 #include "Engine/Engine.h"
+#include "Net/UnrealNetwork.h"
+#include "ResourceRegistry.h"
+#include "ResourceLifecycleSubsystem.h"
+#include "ResourceSignificanceSubsystem.h"
+#include "ResourceSpatialSubsystem.h"
+#include "WorldSaveSubsystem.h"
 
 // Sets default values
 AResource_M::AResource_M()
 {
-	PrimaryActorTick.bCanEverTick = true;
+	// Resource nodes are passive; they never need a tick
+	PrimaryActorTick.bCanEverTick = false;
+
+	// Only depletion is replicated, and rarely, so nodes sleep on the network until then
+	bReplicates = true;
+	NetDormancy = DORM_Initial;
 	ResourceNameTxt = CreateDefaultSubobject<UTextRenderComponent>(TEXT("TextRender"));
 	Mesh = CreateDefaultSubobject<UStaticMeshComponent>(TEXT("Mesh"));
 
@@ -17,6 +29,8 @@ AResource_M::AResource_M()
 
 void AResource_M::BeginPlay()
 {
+	GAM312_SCOPE(AResource_M, BeginPlay);
+
 	Super::BeginPlay();
 
 	if (resourceMesh)
@@ -24,12 +38,115 @@ void AResource_M::BeginPlay()
 		Mesh->SetStaticMesh(resourceMesh);
 	}
 
-	ResourceNameTxt->SetText(FText::FromString(resourceName));
+	// Resolve the type name once so harvesting never compares names
+	const UResourceRegistry& Registry = UResourceRegistry::Get();
+	ResourceId = Registry.FindResourceId(resourceName);
+
+	ResourceNameTxt->SetText(ResourceId != INDEX_NONE ? Registry.Resources[ResourceId].DisplayName : FText::FromName(resourceName));
+
+	// Make the node visible to proximity queries
+	if (UResourceSpatialSubsystem* SpatialIndex = GetWorld()->GetSubsystem<UResourceSpatialSubsystem>())
+	{
+		SpatialIndex->RegisterNode(this);
+	}
+
+	// Depleted nodes are recycled rather than destroyed
+	if (UResourceLifecycleSubsystem* Lifecycle = GetWorld()->GetSubsystem<UResourceLifecycleSubsystem>())
+	{
+		Lifecycle->RegisterNode(this);
+
+		// Joined after the server depleted this node
+		if (bDepleted && !HasAuthority())
+		{
+			Lifecycle->DepleteNode(this);
+		}
+	}
+
+	// Streamed back in by World Partition: pick up the harvest state it left with
+	if (HasAuthority())
+	{
+		if (UWorldSaveSubsystem* WorldSave = GetWorld()->GetSubsystem<UWorldSaveSubsystem>())
+		{
+			WorldSave->RestoreResource(this);
+		}
+	}
+
+	// Label, LOD and collision follow the distance to the local cameras
+	if (UResourceSignificanceSubsystem* Significance = GetWorld()->GetSubsystem<UResourceSignificanceSubsystem>())
+	{
+		Significance->RegisterNode(this);
+	}
+}
+
+// Called when the node is destroyed or the level is unloaded
+void AResource_M::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	GAM312_SCOPE(AResource_M, EndPlay);
+
+	// World Partition streams the node out with its cell; its state would be lost with the actor
+	if (EndPlayReason == EEndPlayReason::RemovedFromWorld && HasAuthority())
+	{
+		if (UWorldSaveSubsystem* WorldSave = GetWorld()->GetSubsystem<UWorldSaveSubsystem>())
+		{
+			WorldSave->StashResource(this);
+		}
+	}
+
+	if (UResourceLifecycleSubsystem* Lifecycle = GetWorld()->GetSubsystem<UResourceLifecycleSubsystem>())
+	{
+		Lifecycle->UnregisterNode(this);
+	}
+
+	if (UResourceSignificanceSubsystem* Significance = GetWorld()->GetSubsystem<UResourceSignificanceSubsystem>())
+	{
+		Significance->UnregisterNode(this);
+	}
+
+	if (UResourceSpatialSubsystem* SpatialIndex = GetWorld()->GetSubsystem<UResourceSpatialSubsystem>())
+	{
+		SpatialIndex->UnregisterNode(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
 }
 
-// Called every frame
-void AResource_M::Tick(float DeltaTime)
+void AResource_M::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
 {
-	Super::Tick(DeltaTime);
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
 
-}
\ No newline at end of file
+	DOREPLIFETIME(AResource_M, bDepleted);
+}
+
+void AResource_M::SetDepleted(bool bNewDepleted)
+{
+	GAM312_SCOPE(AResource_M, SetDepleted);
+
+	if (bDepleted != bNewDepleted && HasAuthority())
+	{
+		FlushNetDormancy();
+		bDepleted = bNewDepleted;
+
+		if (UWorldSaveSubsystem* WorldSave = GetWorld()->GetSubsystem<UWorldSaveSubsystem>())
+		{
+			WorldSave->MarkResourceDirty(this);
+		}
+	}
+}
+
+// Clients run the same fade as the server, but regrowth timing comes from the server
+void AResource_M::OnRep_Depleted()
+{
+	GAM312_SCOPE(AResource_M, OnRep_Depleted);
+
+	if (UResourceLifecycleSubsystem* Lifecycle = GetWorld()->GetSubsystem<UResourceLifecycleSubsystem>())
+	{
+		if (bDepleted)
+		{
+			Lifecycle->DepleteNode(this);
+		}
+		else
+		{
+			Lifecycle->RegrowNode(this);
+		}
+	}
+}
@@ -16,12 +16,23 @@ public:
 
 protected:
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 public:
-	virtual void Tick(float DeltaTime) override;
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
 
+	// Server: marks the node harvested out or regrown and wakes it so clients hear about it
+	void SetDepleted(bool bNewDepleted);
+
+	bool IsDepleted() const { return bDepleted; }
+
+	// Resource type name, resolved against UResourceRegistry on BeginPlay
 	UPROPERTY(EditAnywhere)
-	FString resourceName = "Wood";  
+	FName resourceName = TEXT("Wood");
+
+	// Compact registry ID for resourceName (INDEX_NONE if the type is unknown)
+	UPROPERTY(VisibleInstanceOnly)
+	int32 ResourceId = INDEX_NONE;
 
 	UPROPERTY(EditAnywhere)
 	int resourceAmount = 5;  
@@ -37,4 +48,12 @@ public:
 
 	UPROPERTY(EditAnywhere)
 	UStaticMesh* resourceMesh;  
+
+private:
+	// Replicated lifecycle state; nodes stay dormant on the network until it changes
+	UPROPERTY(ReplicatedUsing = OnRep_Depleted)
+	bool bDepleted = false;
+
+	UFUNCTION()
+	void OnRep_Depleted();
 };
\ No newline at end of file
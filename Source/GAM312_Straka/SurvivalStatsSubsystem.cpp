@@ -0,0 +1,300 @@
+#include "SurvivalStatsSubsystem.h"
+#include "GAM312_Straka.h"
+#include "MyCharacter.h"
+#include "HAL/IConsoleManager.h"
+
+DECLARE_CYCLE_STAT(TEXT("Survival Stats Step"), STAT_GAM312_SurvivalStep, STATGROUP_GAM312);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Survivors Simulated"), STAT_GAM312_Survivors, STATGROUP_GAM312);
+
+namespace SurvivalStats
+{
+	// Per-step amounts, as in AMyCharacter::DecreaseStats
+	static constexpr float HungerDrain = 1.0f;
+	static constexpr float StaminaRegen = 10.0f;
+	static constexpr float StarveDamage = 3.0f;
+
+	// Stats only change while the result stays below this (the SetHealth/SetHunger/SetStamina cap)
+	static constexpr float Cap = 100.0f;
+
+	// Steps run in one frame after a hitch before the remainder is dropped
+	static constexpr int32 MaxStepsPerFrame = 4;
+
+	static constexpr int32 Lanes = 4;
+}
+
+/** ---------- FSurvivorStatArrays ---------- **/
+
+int32 FSurvivorStatArrays::Add(float InHealth, float InHunger, float InStamina)
+{
+	const int32 Index = NumSurvivors++;
+
+	// Grow by a whole register so Step never needs a scalar tail
+	if (Index == Health.Num())
+	{
+		Health.AddZeroed(SurvivalStats::Lanes);
+		Hunger.AddZeroed(SurvivalStats::Lanes);
+		Stamina.AddZeroed(SurvivalStats::Lanes);
+	}
+
+	Health[Index] = InHealth;
+	Hunger[Index] = InHunger;
+	Stamina[Index] = InStamina;
+	return Index;
+}
+
+int32 FSurvivorStatArrays::RemoveAtSwap(int32 Index)
+{
+	check(Index >= 0 && Index < NumSurvivors);
+
+	const int32 Last = --NumSurvivors;
+	if (Index != Last)
+	{
+		Health[Index] = Health[Last];
+		Hunger[Index] = Hunger[Last];
+		Stamina[Index] = Stamina[Last];
+	}
+
+	Health[Last] = 0.0f;
+	Hunger[Last] = 0.0f;
+	Stamina[Last] = 0.0f;
+
+	return Index != Last ? Last : INDEX_NONE;
+}
+
+void FSurvivorStatArrays::Reset()
+{
+	Health.Reset();
+	Hunger.Reset();
+	Stamina.Reset();
+	NumSurvivors = 0;
+}
+
+void FSurvivorStatArrays::Step()
+{
+	const VectorRegister4Float Zero = VectorZeroFloat();
+	const VectorRegister4Float Cap = VectorSetFloat1(SurvivalStats::Cap);
+	const VectorRegister4Float HungerDrain = VectorSetFloat1(SurvivalStats::HungerDrain);
+	const VectorRegister4Float StaminaRegen = VectorSetFloat1(SurvivalStats::StaminaRegen);
+	const VectorRegister4Float StarveDamage = VectorSetFloat1(SurvivalStats::StarveDamage);
+
+	float* HealthData = Health.GetData();
+	float* HungerData = Hunger.GetData();
+	float* StaminaData = Stamina.GetData();
+
+	for (int32 Index = 0; Index < Health.Num(); Index += SurvivalStats::Lanes)
+	{
+		// Hunger drains while above zero
+		const VectorRegister4Float OldHunger = VectorLoad(HungerData + Index);
+		const VectorRegister4Float DrainedHunger = VectorSubtract(OldHunger, HungerDrain);
+		const VectorRegister4Float NewHunger = VectorSelect(
+			VectorBitwiseAnd(VectorCompareGT(OldHunger, Zero), VectorCompareLT(DrainedHunger, Cap)),
+			DrainedHunger, OldHunger);
+		VectorStore(NewHunger, HungerData + Index);
+
+		// Stamina regenerates up to the cap
+		const VectorRegister4Float OldStamina = VectorLoad(StaminaData + Index);
+		const VectorRegister4Float RegenStamina = VectorAdd(OldStamina, StaminaRegen);
+		VectorStore(VectorSelect(VectorCompareLT(RegenStamina, Cap), RegenStamina, OldStamina), StaminaData + Index);
+
+		// Starving survivors lose health
+		const VectorRegister4Float OldHealth = VectorLoad(HealthData + Index);
+		const VectorRegister4Float DamagedHealth = VectorSubtract(OldHealth, StarveDamage);
+		const VectorRegister4Float NewHealth = VectorSelect(
+			VectorBitwiseAnd(VectorCompareLE(NewHunger, Zero), VectorCompareLT(DamagedHealth, Cap)),
+			DamagedHealth, OldHealth);
+		VectorStore(NewHealth, HealthData + Index);
+	}
+}
+
+/** ---------- USurvivalStatsSubsystem ---------- **/
+
+void USurvivalStatsSubsystem::Deinitialize()
+{
+	DEC_DWORD_STAT_BY(STAT_GAM312_Survivors, Characters.Num());
+
+	Stats.Reset();
+	Characters.Reset();
+	CharacterSlots.Reset();
+
+	Super::Deinitialize();
+}
+
+void USurvivalStatsSubsystem::Tick(float DeltaTime)
+{
+	GAM312_SCOPE(USurvivalStatsSubsystem, Tick);
+
+	Super::Tick(DeltaTime);
+
+	TimeSinceStep += DeltaTime;
+
+	int32 NumSteps = 0;
+	while (TimeSinceStep >= StepInterval && NumSteps < SurvivalStats::MaxStepsPerFrame)
+	{
+		TimeSinceStep -= StepInterval;
+		StepCharacters();
+		++NumSteps;
+	}
+
+	// Don't keep catching up after a long hitch
+	TimeSinceStep = FMath::Min(TimeSinceStep, StepInterval);
+}
+
+bool USurvivalStatsSubsystem::IsTickable() const
+{
+	return Characters.Num() > 0;
+}
+
+TStatId USurvivalStatsSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(USurvivalStatsSubsystem, STATGROUP_Tickables);
+}
+
+void USurvivalStatsSubsystem::RegisterCharacter(AMyCharacter* Character)
+{
+	if (!IsValid(Character) || CharacterSlots.Contains(Character))
+	{
+		return;
+	}
+
+	const int32 Slot = Stats.Add(Character->Health, Character->Hunger, Character->Stamina);
+	Characters.Add(Character);
+	CharacterSlots.Add(Character, Slot);
+
+	INC_DWORD_STAT(STAT_GAM312_Survivors);
+}
+
+void USurvivalStatsSubsystem::UnregisterCharacter(AMyCharacter* Character)
+{
+	int32 Slot = INDEX_NONE;
+	if (!CharacterSlots.RemoveAndCopyValue(Character, Slot))
+	{
+		return;
+	}
+
+	// The last survivor takes over the freed slot
+	const int32 MovedFrom = Stats.RemoveAtSwap(Slot);
+	Characters.RemoveAtSwap(Slot, 1, EAllowShrinking::No);
+	if (MovedFrom != INDEX_NONE)
+	{
+		CharacterSlots.Add(Characters[Slot], Slot);
+	}
+
+	DEC_DWORD_STAT(STAT_GAM312_Survivors);
+}
+
+void USurvivalStatsSubsystem::StepCharacters()
+{
+	SCOPE_CYCLE_COUNTER(STAT_GAM312_SurvivalStep);
+
+	// Gameplay may have changed stats since the last step (harvesting, eating, Blueprints)
+	for (int32 Slot = 0; Slot < Characters.Num(); ++Slot)
+	{
+		if (const AMyCharacter* Character = Characters[Slot].ResolveObjectPtr())
+		{
+			Stats.Health[Slot] = Character->Health;
+			Stats.Hunger[Slot] = Character->Hunger;
+			Stats.Stamina[Slot] = Character->Stamina;
+		}
+	}
+
+	Stats.Step();
+
+	// Apply each change through the setters, in DecreaseStats order. The setters repeat the
+	// cap check against the same values, so they take exactly the steps simulated above.
+	for (int32 Slot = 0; Slot < Characters.Num(); ++Slot)
+	{
+		AMyCharacter* Character = Characters[Slot].ResolveObjectPtr();
+		if (!Character)
+		{
+			continue;
+		}
+
+		if (Stats.Hunger[Slot] != Character->Hunger)
+		{
+			Character->SetHunger(-SurvivalStats::HungerDrain);
+		}
+		if (Stats.Stamina[Slot] != Character->Stamina)
+		{
+			Character->SetStamina(SurvivalStats::StaminaRegen);
+		}
+		if (Stats.Health[Slot] != Character->Health)
+		{
+			Character->SetHealth(-SurvivalStats::StarveDamage);
+		}
+	}
+}
+
+/** ---------- Benchmark ---------- **/
+
+static FAutoConsoleCommand GSurvivalBenchmarkCommand(
+	TEXT("gam312.Survival.Benchmark"),
+	TEXT("Steps simulated survivors with the per-character DecreaseStats logic and with the batched pass, and logs the cost of each. Optional args: survivor count (default 10000), steps (default 1000)."),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		const int32 NumSurvivors = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 10000;
+		const int32 NumSteps = Args.Num() > 1 ? FMath::Max(FCString::Atoi(*Args[1]), 1) : 1000;
+
+		// Same starting stats for both layouts, some of them already starving
+		struct FSurvivor
+		{
+			float Health;
+			float Hunger;
+			float Stamina;
+		};
+
+		FRandomStream Random(312);
+		TArray<FSurvivor> Survivors;
+		FSurvivorStatArrays Batched;
+		Survivors.Reserve(NumSurvivors);
+		for (int32 Index = 0; Index < NumSurvivors; ++Index)
+		{
+			const FSurvivor& Survivor = Survivors.Add_GetRef({
+				Random.FRandRange(50.0f, 100.0f), Random.FRandRange(-5.0f, 100.0f), Random.FRandRange(0.0f, 100.0f) });
+			Batched.Add(Survivor.Health, Survivor.Hunger, Survivor.Stamina);
+		}
+
+		// One survivor at a time, as each character's timer did
+		double StartTime = FPlatformTime::Seconds();
+		for (int32 Step = 0; Step < NumSteps; ++Step)
+		{
+			for (FSurvivor& Survivor : Survivors)
+			{
+				if (Survivor.Hunger > 0 && Survivor.Hunger - SurvivalStats::HungerDrain < SurvivalStats::Cap)
+				{
+					Survivor.Hunger -= SurvivalStats::HungerDrain;
+				}
+				if (Survivor.Stamina + SurvivalStats::StaminaRegen < SurvivalStats::Cap)
+				{
+					Survivor.Stamina += SurvivalStats::StaminaRegen;
+				}
+				if (Survivor.Hunger <= 0 && Survivor.Health - SurvivalStats::StarveDamage < SurvivalStats::Cap)
+				{
+					Survivor.Health -= SurvivalStats::StarveDamage;
+				}
+			}
+		}
+		const double ScalarSeconds = FMath::Max(FPlatformTime::Seconds() - StartTime, UE_SMALL_NUMBER);
+
+		// Whole population per pass
+		StartTime = FPlatformTime::Seconds();
+		for (int32 Step = 0; Step < NumSteps; ++Step)
+		{
+			Batched.Step();
+		}
+		const double BatchedSeconds = FMath::Max(FPlatformTime::Seconds() - StartTime, UE_SMALL_NUMBER);
+
+		// Both paths must agree survivor for survivor
+		int32 NumMismatches = 0;
+		for (int32 Index = 0; Index < NumSurvivors; ++Index)
+		{
+			const FSurvivor& Survivor = Survivors[Index];
+			NumMismatches += (Survivor.Health != Batched.Health[Index] || Survivor.Hunger != Batched.Hunger[Index] || Survivor.Stamina != Batched.Stamina[Index]) ? 1 : 0;
+		}
+
+		const double SurvivorSteps = static_cast<double>(NumSurvivors) * NumSteps;
+		UE_LOG(LogGAM312, Display, TEXT("[SurvivalBench] %d survivors x %d steps: per-survivor %.2f ns, batched %.2f ns per survivor-step (%.1fx, %.3f ms per step); %d mismatches"),
+			NumSurvivors, NumSteps,
+			ScalarSeconds * 1.0e9 / SurvivorSteps, BatchedSeconds * 1.0e9 / SurvivorSteps,
+			ScalarSeconds / BatchedSeconds, BatchedSeconds * 1.0e3 / NumSteps,
+			NumMismatches);
+	}));
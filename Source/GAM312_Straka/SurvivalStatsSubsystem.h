@@ -0,0 +1,81 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "SurvivalStatsSubsystem.generated.h"
+
+class AMyCharacter;
+
+/**
+ * FSurvivorStatArrays
+ *
+ * Health, hunger and stamina of many survivors, one array per stat. The arrays are
+ * padded to a multiple of four so Step can run four survivors per SIMD register with
+ * no scalar tail; padding lanes are simulated too but never read back.
+ */
+struct GAM312_STRAKA_API FSurvivorStatArrays
+{
+	// Adds a survivor and returns its slot
+	int32 Add(float InHealth, float InHunger, float InStamina);
+
+	// Moves the last survivor into Index; returns the slot that was moved (INDEX_NONE if none)
+	int32 RemoveAtSwap(int32 Index);
+
+	void Reset();
+
+	int32 Num() const { return NumSurvivors; }
+
+	// One AMyCharacter::DecreaseStats for every survivor: hunger -1 while above zero,
+	// stamina +10, and health -3 once starving, each skipped if it would reach 100
+	void Step();
+
+	TArray<float> Health;
+	TArray<float> Hunger;
+	TArray<float> Stamina;
+
+private:
+	int32 NumSurvivors = 0;
+};
+
+/**
+ * USurvivalStatsSubsystem
+ *
+ * Advances the survival stats of every AMyCharacter in the world in one batched pass
+ * at a fixed rate, replacing a DecreaseStats timer per character. Each step copies the
+ * characters' current stats in, runs FSurvivorStatArrays::Step, and pushes any change
+ * back through SetHealth/SetHunger/SetStamina so HUD and OnStatsChanged updates still fire.
+ */
+UCLASS()
+class GAM312_STRAKA_API USurvivalStatsSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+
+	// Starts simulating Character's stats (call from BeginPlay)
+	void RegisterCharacter(AMyCharacter* Character);
+
+	// Stops simulating Character's stats (call from EndPlay)
+	void UnregisterCharacter(AMyCharacter* Character);
+
+	int32 GetNumCharacters() const { return Characters.Num(); }
+
+	// Seconds between steps, matching the old per-character timer
+	static constexpr float StepInterval = 2.0f;
+
+private:
+	void StepCharacters();
+
+	FSurvivorStatArrays Stats;
+
+	// Character for each slot in Stats
+	TArray<TObjectKey<AMyCharacter>> Characters;
+	TMap<TObjectKey<AMyCharacter>, int32> CharacterSlots;
+
+	float TimeSinceStep = 0.0f;
+};
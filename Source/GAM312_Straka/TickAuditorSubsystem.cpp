@@ -0,0 +1,209 @@
+#include "TickAuditorSubsystem.h"
+#include "GAM312_Straka.h"
+#include "EngineUtils.h"
+#include "HAL/IConsoleManager.h"
+
+static TAutoConsoleVariable<float> CVarTickAuditEmptyThresholdUs(
+	TEXT("gam312.TickAudit.EmptyThresholdUs"),
+	1.0f,
+	TEXT("Ticks cheaper than this (microseconds per frame) are flagged as likely empty in the tick audit report."));
+
+// The actor's or component's tick function an entry audits, if it is still around
+static FTickFunction* GetTickFunction(const FTickAuditEntry& Entry)
+{
+	if (Entry.Component.IsExplicitlyNull())
+	{
+		AActor* Actor = Entry.Actor.Get();
+		return Actor ? &Actor->PrimaryActorTick : nullptr;
+	}
+
+	UActorComponent* Component = Entry.Component.Get();
+	return Component ? &Component->PrimaryComponentTick : nullptr;
+}
+
+void UTickAuditorSubsystem::Deinitialize()
+{
+	RestoreTickFunctions();
+
+	Super::Deinitialize();
+}
+
+bool UTickAuditorSubsystem::IsTickable() const
+{
+	return FramesLeft > 0;
+}
+
+TStatId UTickAuditorSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UTickAuditorSubsystem, STATGROUP_Tickables);
+}
+
+// Collects every enabled actor/component tick and takes it over for the capture window
+void UTickAuditorSubsystem::StartCapture(int32 NumFrames)
+{
+	if (IsCapturing() || NumFrames <= 0)
+	{
+		return;
+	}
+
+	Entries.Reset();
+	FramesLeft = NumFrames;
+	FramesCaptured = 0;
+
+	for (TActorIterator<AActor> It(GetWorld()); It; ++It)
+	{
+		AActor* Actor = *It;
+
+		if (Actor->PrimaryActorTick.IsTickFunctionRegistered() && Actor->PrimaryActorTick.IsTickFunctionEnabled())
+		{
+			FTickAuditEntry& Entry = Entries.AddDefaulted_GetRef();
+			Entry.Actor = Actor;
+			Entry.TickGroup = Actor->PrimaryActorTick.TickGroup;
+			Entry.bDisabledByAudit = true;
+			Actor->PrimaryActorTick.SetTickFunctionEnable(false);
+		}
+
+		for (UActorComponent* Component : Actor->GetComponents())
+		{
+			if (Component && Component->IsRegistered()
+				&& Component->PrimaryComponentTick.IsTickFunctionRegistered() && Component->PrimaryComponentTick.IsTickFunctionEnabled())
+			{
+				FTickAuditEntry& Entry = Entries.AddDefaulted_GetRef();
+				Entry.Actor = Actor;
+				Entry.Component = Component;
+				Entry.TickGroup = Component->PrimaryComponentTick.TickGroup;
+				Entry.bDisabledByAudit = true;
+				Component->PrimaryComponentTick.SetTickFunctionEnable(false);
+			}
+		}
+	}
+
+	UE_LOG(LogGAM312, Display, TEXT("[TickAudit] Capturing %d tick functions for %d frames"), Entries.Num(), NumFrames);
+}
+
+// Runs and times every audited tick that is due this frame
+void UTickAuditorSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	for (FTickAuditEntry& Entry : Entries)
+	{
+		AActor* Actor = Entry.Actor.Get();
+		FTickFunction* TickFunction = GetTickFunction(Entry);
+		if (!IsValid(Actor) || !TickFunction || !Entry.bDisabledByAudit)
+		{
+			continue;
+		}
+
+		// Enabled again by gameplay code: the tick task manager runs it now, so stop running it here
+		if (TickFunction->IsTickFunctionEnabled())
+		{
+			Entry.bDisabledByAudit = false;
+			continue;
+		}
+
+		// Interval ticks get the game time since their last run, like the tick task manager passes them
+		Entry.TimeSinceTick += DeltaTime * Actor->CustomTimeDilation;
+		if (Entry.TimeSinceTick < TickFunction->TickInterval)
+		{
+			continue;
+		}
+		const float DilatedDelta = Entry.TimeSinceTick;
+		Entry.TimeSinceTick = 0.0f;
+
+		const uint64 StartCycles = FPlatformTime::Cycles64();
+
+		if (Entry.Component.IsExplicitlyNull())
+		{
+			Actor->TickActor(DilatedDelta, LEVELTICK_All, Actor->PrimaryActorTick);
+		}
+		else if (UActorComponent* Component = Entry.Component.Get())
+		{
+			if (Component->IsRegistered())
+			{
+				Component->TickComponent(DilatedDelta, LEVELTICK_All, &Component->PrimaryComponentTick);
+			}
+		}
+
+		Entry.Cycles += FPlatformTime::Cycles64() - StartCycles;
+		++Entry.Calls;
+	}
+
+	++FramesCaptured;
+	if (--FramesLeft == 0)
+	{
+		RestoreTickFunctions();
+		ReportResults();
+	}
+}
+
+void UTickAuditorSubsystem::RestoreTickFunctions()
+{
+	// Ticks enabled again during the capture belong to whoever did that; they may have been switched off since
+	for (FTickAuditEntry& Entry : Entries)
+	{
+		FTickFunction* TickFunction = GetTickFunction(Entry);
+		if (TickFunction && Entry.bDisabledByAudit && !TickFunction->IsTickFunctionEnabled())
+		{
+			TickFunction->SetTickFunctionEnable(true);
+		}
+		Entry.bDisabledByAudit = false;
+	}
+
+	FramesLeft = 0;
+}
+
+void UTickAuditorSubsystem::ReportResults() const
+{
+	TArray<const FTickAuditEntry*> Sorted;
+	Sorted.Reserve(Entries.Num());
+	for (const FTickAuditEntry& Entry : Entries)
+	{
+		Sorted.Add(&Entry);
+	}
+	Sorted.Sort([](const FTickAuditEntry& A, const FTickAuditEntry& B) { return A.Cycles > B.Cycles; });
+
+	const double EmptyThresholdUs = CVarTickAuditEmptyThresholdUs.GetValueOnGameThread();
+	const int32 Frames = FMath::Max(FramesCaptured, 1);
+	double TotalUs = 0.0;
+	int32 NumEmpty = 0;
+
+	const UEnum* TickGroupEnum = StaticEnum<ETickingGroup>();
+
+	UE_LOG(LogGAM312, Display, TEXT("[TickAudit] %-10s %-6s %-8s %-20s %-40s %s"), TEXT("us/frame"), TEXT("Calls"), TEXT("Kind"), TEXT("Group"), TEXT("Class"), TEXT("Object"));
+	for (const FTickAuditEntry* Entry : Sorted)
+	{
+		const UObject* Object = Entry->Component.IsExplicitlyNull() ? static_cast<const UObject*>(Entry->Actor.Get()) : Entry->Component.Get();
+		if (!Object)
+		{
+			continue;
+		}
+
+		const double CostUs = FPlatformTime::ToMilliseconds64(Entry->Cycles) * 1000.0 / Frames;
+		const bool bLikelyEmpty = CostUs < EmptyThresholdUs;
+		TotalUs += CostUs;
+		NumEmpty += bLikelyEmpty ? 1 : 0;
+
+		UE_LOG(LogGAM312, Display, TEXT("[TickAudit] %10.2f %6d %-8s %-20s %-40s %s%s"),
+			CostUs,
+			Entry->Calls,
+			Entry->Component.IsExplicitlyNull() ? TEXT("Actor") : TEXT("Comp"),
+			*TickGroupEnum->GetNameStringByValue(Entry->TickGroup),
+			*Object->GetClass()->GetName(),
+			*Object->GetPathName(GetWorld()),
+			bLikelyEmpty ? TEXT("  [likely empty]") : TEXT(""));
+	}
+
+	UE_LOG(LogGAM312, Display, TEXT("[TickAudit] %d tick functions, %.2f us/frame total, %d likely empty"), Sorted.Num(), TotalUs, NumEmpty);
+}
+
+static FAutoConsoleCommandWithWorldAndArgs GTickAuditCommand(
+	TEXT("gam312.TickAudit"),
+	TEXT("Times every ticking actor and component for N frames (default 60) and logs their per-frame cost."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (UTickAuditorSubsystem* Auditor = World ? World->GetSubsystem<UTickAuditorSubsystem>() : nullptr)
+		{
+			Auditor->StartCapture(Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 60);
+		}
+	}));
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/EngineBaseTypes.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "TickAuditorSubsystem.generated.h"
+
+/**
+ * FTickAuditEntry
+ *
+ * One actor or component tick function captured by the auditor.
+ */
+struct FTickAuditEntry
+{
+	TWeakObjectPtr<AActor> Actor;
+	TWeakObjectPtr<UActorComponent> Component;
+
+	// Group the tick function runs in outside the capture
+	TEnumAsByte<ETickingGroup> TickGroup = TG_PrePhysics;
+
+	// Set while the tick is disabled by the auditor; cleared once something else enables it again
+	bool bDisabledByAudit = false;
+
+	// Game time since the auditor last ran the tick, for ticks with a TickInterval
+	float TimeSinceTick = 0.0f;
+
+	// Total cycles spent in this tick over the capture window and the number of calls
+	uint64 Cycles = 0;
+	int32 Calls = 0;
+};
+
+/**
+ * UTickAuditorSubsystem
+ *
+ * Debug tool that lists every ticking actor and component in the world with its
+ * measured per-frame cost, so empty ticks are easy to spot.
+ *
+ * While a capture runs, the audited tick functions are disabled in the tick task
+ * manager and executed (and timed) one by one from this subsystem instead, at their
+ * TickInterval. They all run in this subsystem's tick rather than their own tick group
+ * (listed in the report), so run it in a quiet scene. A tick something else enables
+ * during the capture goes back to the tick task manager and is left as it is afterwards.
+ */
+UCLASS()
+class GAM312_STRAKA_API UTickAuditorSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+
+	// Takes over every enabled tick function in the world for NumFrames frames, then logs the report
+	void StartCapture(int32 NumFrames);
+
+	bool IsCapturing() const { return FramesLeft > 0; }
+
+private:
+	// Hands every tick function the auditor still holds back to the tick task manager
+	void RestoreTickFunctions();
+
+	// Logs all entries sorted by average cost
+	void ReportResults() const;
+
+	TArray<FTickAuditEntry> Entries;
+	int32 FramesLeft = 0;
+	int32 FramesCaptured = 0;
+};
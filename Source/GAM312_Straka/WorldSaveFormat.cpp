@@ -0,0 +1,231 @@
+#include "WorldSaveFormat.h"
+#include "GAM312_Straka.h"
+#include "HAL/PlatformFileManager.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+namespace WorldSave
+{
+	FTransform FSavedPart::GetTransform() const
+	{
+		const FRotator Rotation(FRotator::DecompressAxisFromShort(Pitch), FRotator::DecompressAxisFromShort(Yaw), FRotator::DecompressAxisFromShort(Roll));
+		return FTransform(Rotation, FVector(Location));
+	}
+
+	void FSavedPart::SetTransform(const FTransform& Transform)
+	{
+		const FRotator Rotation = Transform.Rotator();
+		Location = FVector3f(Transform.GetLocation());
+		Pitch = FRotator::CompressAxisToShort(Rotation.Pitch);
+		Yaw = FRotator::CompressAxisToShort(Rotation.Yaw);
+		Roll = FRotator::CompressAxisToShort(Rotation.Roll);
+	}
+
+	FArchive& operator<<(FArchive& Ar, FSavedPart& Part)
+	{
+		Ar << Part.ClassIndex << Part.BuildingId << Part.Location << Part.Pitch << Part.Yaw << Part.Roll;
+		return Ar;
+	}
+
+	FArchive& operator<<(FArchive& Ar, FSavedResource& Resource)
+	{
+		Ar << Resource.ActorName << Resource.TotalResource << Resource.bDepleted;
+		return Ar;
+	}
+
+	FArchive& operator<<(FArchive& Ar, FSavedPlayer& Player)
+	{
+		Ar << Player.PlayerName << Player.Health << Player.Hunger << Player.Stamina << Player.Resources << Player.Buildings;
+		return Ar;
+	}
+
+	uint16 FWorldSaveChunk::FindOrAddClass(const FString& ClassPath)
+	{
+		int32 Index = ClassPaths.Find(ClassPath);
+		if (Index == INDEX_NONE)
+		{
+			Index = ClassPaths.Add(ClassPath);
+		}
+		return static_cast<uint16>(Index);
+	}
+
+	void FWorldSaveChunk::Append(const FWorldSaveChunk& Other)
+	{
+		TArray<uint16, TInlineAllocator<16>> ClassRemap;
+		for (const FString& ClassPath : Other.ClassPaths)
+		{
+			ClassRemap.Add(FindOrAddClass(ClassPath));
+		}
+
+		Parts.Reserve(Parts.Num() + Other.Parts.Num());
+		for (const FSavedPart& Part : Other.Parts)
+		{
+			FSavedPart& Added = Parts.Add_GetRef(Part);
+			Added.ClassIndex = ClassRemap.IsValidIndex(Part.ClassIndex) ? ClassRemap[Part.ClassIndex] : 0;
+		}
+		Resources.Append(Other.Resources);
+	}
+
+	// Parts are bulk-serialized element by element; 22 bytes each, no per-part tags
+	FArchive& operator<<(FArchive& Ar, FWorldSaveChunk& Chunk)
+	{
+		Ar << Chunk.Cell << Chunk.ClassPaths << Chunk.Parts << Chunk.Resources;
+		return Ar;
+	}
+
+	FArchive& operator<<(FArchive& Ar, FChunkInfo& Info)
+	{
+		Ar << Info.Cell << Info.Offset << Info.Size << Info.NumParts;
+		return Ar;
+	}
+
+	FArchive& operator<<(FArchive& Ar, FWorldSaveHeader& Header)
+	{
+		if (Header.FileVersion >= 2)
+		{
+			Ar << Header.SaveId;
+		}
+		Ar << Header.ChunkSize << Header.Players << Header.Chunks;
+		return Ar;
+	}
+
+	FIntPoint GetCell(const FVector& Location, float ChunkSize)
+	{
+		return FIntPoint(FMath::FloorToInt32(Location.X / ChunkSize), FMath::FloorToInt32(Location.Y / ChunkSize));
+	}
+
+	FVector GetCellCenter(const FIntPoint& Cell, float ChunkSize)
+	{
+		return FVector((Cell.X + 0.5) * ChunkSize, (Cell.Y + 0.5) * ChunkSize, 0.0);
+	}
+
+	bool WriteFile(const FString& Filename, FWorldSaveHeader& Header, TArray<FWorldSaveChunk>& Chunks, int64* OutFileSize)
+	{
+		// Encode every chunk first so the header can carry their offsets
+		TArray<TArray<uint8>> ChunkBlobs;
+		ChunkBlobs.SetNum(Chunks.Num());
+		Header.Chunks.Reset(Chunks.Num());
+
+		int64 Offset = 0;
+		for (int32 Index = 0; Index < Chunks.Num(); ++Index)
+		{
+			FMemoryWriter Writer(ChunkBlobs[Index]);
+			Writer << Chunks[Index];
+
+			FChunkInfo& Info = Header.Chunks.AddDefaulted_GetRef();
+			Info.Cell = Chunks[Index].Cell;
+			Info.Offset = Offset;
+			Info.Size = ChunkBlobs[Index].Num();
+			Info.NumParts = Chunks[Index].Parts.Num();
+			Offset += Info.Size;
+		}
+
+		TArray<uint8> HeaderBlob;
+		FMemoryWriter HeaderWriter(HeaderBlob);
+		HeaderWriter << Header;
+
+		uint32 FileMagic = Magic;
+		uint32 FileVersion = Version;
+		int64 HeaderSize = HeaderBlob.Num();
+		TArray<uint8> Preamble;
+		FMemoryWriter PreambleWriter(Preamble);
+		PreambleWriter << FileMagic << FileVersion << HeaderSize;
+
+		IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+		PlatformFile.CreateDirectoryTree(*FPaths::GetPath(Filename));
+
+		const FString TempFilename = Filename + TEXT(".tmp");
+		{
+			TUniquePtr<IFileHandle> File(PlatformFile.OpenWrite(*TempFilename));
+			if (!File)
+			{
+				UE_LOG(LogGAM312, Error, TEXT("[WorldSave] Could not open %s for writing"), *TempFilename);
+				return false;
+			}
+
+			bool bWritten = File->Write(Preamble.GetData(), Preamble.Num()) && File->Write(HeaderBlob.GetData(), HeaderBlob.Num());
+			for (const TArray<uint8>& Blob : ChunkBlobs)
+			{
+				bWritten = bWritten && File->Write(Blob.GetData(), Blob.Num());
+			}
+			bWritten = bWritten && File->Flush();
+
+			if (!bWritten)
+			{
+				UE_LOG(LogGAM312, Error, TEXT("[WorldSave] Writing %s failed"), *TempFilename);
+				File.Reset();
+				PlatformFile.DeleteFile(*TempFilename);
+				return false;
+			}
+		}
+
+		PlatformFile.DeleteFile(*Filename);
+		if (!PlatformFile.MoveFile(*Filename, *TempFilename))
+		{
+			UE_LOG(LogGAM312, Error, TEXT("[WorldSave] Could not replace %s"), *Filename);
+			return false;
+		}
+
+		if (OutFileSize)
+		{
+			*OutFileSize = Preamble.Num() + HeaderBlob.Num() + Offset;
+		}
+		return true;
+	}
+
+	bool ReadHeader(IFileHandle& File, FWorldSaveHeader& OutHeader, int64& OutDataStart)
+	{
+		uint32 FileMagic = 0;
+		uint32 FileVersion = 0;
+		int64 HeaderSize = 0;
+
+		TArray<uint8> Preamble;
+		Preamble.SetNumUninitialized(sizeof(FileMagic) + sizeof(FileVersion) + sizeof(HeaderSize));
+		if (!File.Seek(0) || !File.Read(Preamble.GetData(), Preamble.Num()))
+		{
+			return false;
+		}
+
+		FMemoryReader PreambleReader(Preamble);
+		PreambleReader << FileMagic << FileVersion << HeaderSize;
+		if (FileMagic != Magic || FileVersion == 0 || FileVersion > Version || HeaderSize <= 0 || HeaderSize > File.Size())
+		{
+			UE_LOG(LogGAM312, Error, TEXT("[WorldSave] Not a world save, or written by a newer build (version %u)"), FileVersion);
+			return false;
+		}
+
+		TArray<uint8> HeaderBlob;
+		HeaderBlob.SetNumUninitialized(HeaderSize);
+		if (!File.Read(HeaderBlob.GetData(), HeaderBlob.Num()))
+		{
+			return false;
+		}
+
+		FMemoryReader HeaderReader(HeaderBlob);
+		OutHeader.FileVersion = FileVersion;
+		HeaderReader << OutHeader;
+		OutDataStart = Preamble.Num() + HeaderSize;
+		return !HeaderReader.IsError() && OutHeader.ChunkSize > 0.0f;
+	}
+
+	bool ReadChunk(IFileHandle& File, int64 DataStart, const FChunkInfo& Info, FWorldSaveChunk& OutChunk)
+	{
+		if (Info.Size == 0)
+		{
+			OutChunk = FWorldSaveChunk();
+			OutChunk.Cell = Info.Cell;
+			return true;
+		}
+
+		TArray<uint8> Blob;
+		Blob.SetNumUninitialized(Info.Size);
+		if (!File.Seek(DataStart + Info.Offset) || !File.Read(Blob.GetData(), Blob.Num()))
+		{
+			return false;
+		}
+
+		FMemoryReader Reader(Blob);
+		Reader << OutChunk;
+		return !Reader.IsError();
+	}
+}
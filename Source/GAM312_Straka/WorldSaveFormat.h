@@ -0,0 +1,145 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GenericPlatform/GenericPlatformFile.h"
+
+/**
+ * World save file layout (all little-endian, written with FArchive):
+ *
+ *   uint32 Magic, uint32 Version, int64 HeaderSize
+ *   FWorldSaveHeader          players and the chunk table
+ *   chunk blobs               one FWorldSaveChunk per spatial cell, at ChunkTable offsets
+ *                             (relative to the end of the header)
+ *
+ * Chunks are self-contained (each carries its own class table), so a chunk that was never
+ * streamed in can be copied into the next save without decoding the rest of the file.
+ */
+namespace WorldSave
+{
+	static constexpr uint32 Magic = 0x56533347; // "G3SV"
+
+	// Bump when the layout changes; older versions must keep loading
+	//   2: header carries SaveId, which autosave journals are tied to
+	static constexpr uint32 Version = 2;
+
+	/**
+	 * FSavedPart
+	 *
+	 * One placed building part: 22 bytes on disk.
+	 */
+	struct FSavedPart
+	{
+		uint16 ClassIndex = 0;
+		int16 BuildingId = INDEX_NONE;
+		FVector3f Location = FVector3f::ZeroVector;
+
+		// Axes packed with FRotator::CompressAxisToShort
+		uint16 Pitch = 0;
+		uint16 Yaw = 0;
+		uint16 Roll = 0;
+
+		FTransform GetTransform() const;
+		void SetTransform(const FTransform& Transform);
+
+		friend FArchive& operator<<(FArchive& Ar, FSavedPart& Part);
+	};
+
+	/**
+	 * FSavedResource
+	 *
+	 * Harvest state of one level-placed resource node, found again by actor name.
+	 */
+	struct FSavedResource
+	{
+		FName ActorName;
+		int32 TotalResource = 0;
+		bool bDepleted = false;
+
+		friend FArchive& operator<<(FArchive& Ar, FSavedResource& Resource);
+	};
+
+	/**
+	 * FSavedPlayer
+	 *
+	 * Inventory and stats of one character, keyed by player name.
+	 */
+	struct FSavedPlayer
+	{
+		FString PlayerName;
+		float Health = 100.0f;
+		float Hunger = 100.0f;
+		float Stamina = 100.0f;
+		TArray<float> Resources;
+		TArray<int32> Buildings;
+
+		friend FArchive& operator<<(FArchive& Ar, FSavedPlayer& Player);
+	};
+
+	/**
+	 * FWorldSaveChunk
+	 *
+	 * Everything saved inside one spatial cell.
+	 */
+	struct FWorldSaveChunk
+	{
+		FIntPoint Cell = FIntPoint::ZeroValue;
+		TArray<FString> ClassPaths;
+		TArray<FSavedPart> Parts;
+		TArray<FSavedResource> Resources;
+
+		// Index of ClassPath in ClassPaths, added if new
+		uint16 FindOrAddClass(const FString& ClassPath);
+
+		// Appends Other's parts and resources (class indices are remapped)
+		void Append(const FWorldSaveChunk& Other);
+
+		friend FArchive& operator<<(FArchive& Ar, FWorldSaveChunk& Chunk);
+	};
+
+	/**
+	 * FChunkInfo
+	 *
+	 * Where a chunk lives in the file, so it can be read on its own.
+	 */
+	struct FChunkInfo
+	{
+		FIntPoint Cell = FIntPoint::ZeroValue;
+		int64 Offset = 0;
+		int32 Size = 0;
+		int32 NumParts = 0;
+
+		friend FArchive& operator<<(FArchive& Ar, FChunkInfo& Info);
+	};
+
+	/**
+	 * FWorldSaveHeader
+	 */
+	struct FWorldSaveHeader
+	{
+		// Version the header was read with (Version when writing)
+		uint32 FileVersion = Version;
+
+		// New for every file written; a journal only applies to the file it was started on
+		FGuid SaveId;
+
+		float ChunkSize = 0.0f;
+		TArray<FSavedPlayer> Players;
+		TArray<FChunkInfo> Chunks;
+
+		friend FArchive& operator<<(FArchive& Ar, FWorldSaveHeader& Header);
+	};
+
+	// Cell of a location for the given chunk size
+	GAM312_STRAKA_API FIntPoint GetCell(const FVector& Location, float ChunkSize);
+	GAM312_STRAKA_API FVector GetCellCenter(const FIntPoint& Cell, float ChunkSize);
+
+	// Writes header and chunks to Filename through a temporary file that replaces it at the end,
+	// so a failed or interrupted save never leaves a half-written file. Fills in Header.Chunks.
+	GAM312_STRAKA_API bool WriteFile(const FString& Filename, FWorldSaveHeader& Header, TArray<FWorldSaveChunk>& Chunks, int64* OutFileSize = nullptr);
+
+	// Reads the fixed preamble and header. On success the file position is at the start of the chunk data.
+	GAM312_STRAKA_API bool ReadHeader(IFileHandle& File, FWorldSaveHeader& OutHeader, int64& OutDataStart);
+
+	// Reads and decodes one chunk. Chunks with no data (Size 0) come back empty.
+	GAM312_STRAKA_API bool ReadChunk(IFileHandle& File, int64 DataStart, const FChunkInfo& Info, FWorldSaveChunk& OutChunk);
+}
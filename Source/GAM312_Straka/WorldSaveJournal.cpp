@@ -0,0 +1,318 @@
+#include "WorldSaveJournal.h"
+#include "GAM312_Straka.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+namespace WorldSave
+{
+	FJournalPartKey FJournalPartKey::Make(FName ClassPath, const FSavedPart& Part)
+	{
+		FJournalPartKey Key;
+		Key.ClassPath = ClassPath;
+		Key.Location = FIntVector(FMath::RoundToInt32(Part.Location.X), FMath::RoundToInt32(Part.Location.Y), FMath::RoundToInt32(Part.Location.Z));
+		Key.Pitch = Part.Pitch;
+		Key.Yaw = Part.Yaw;
+		Key.Roll = Part.Roll;
+		return Key;
+	}
+
+	FArchive& operator<<(FArchive& Ar, FJournalBatch& Batch)
+	{
+		Ar << Batch.ClassPaths << Batch.AddedParts << Batch.RemovedParts << Batch.Resources << Batch.Players;
+		return Ar;
+	}
+
+	void FJournalReplay::AddBatch(const FJournalBatch& Batch)
+	{
+		TArray<FName, TInlineAllocator<16>> ClassNames;
+		for (const FString& ClassPath : Batch.ClassPaths)
+		{
+			ClassNames.Add(FName(*ClassPath));
+		}
+
+		auto AddPartChange = [this, &ClassNames](const FSavedPart& Part, int32 Count)
+		{
+			if (!ClassNames.IsValidIndex(Part.ClassIndex))
+			{
+				return;
+			}
+
+			FJournalCell& Cell = Cells.FindOrAdd(GetCell(FVector(Part.Location), ChunkSize));
+			FJournalPartChange& Change = Cell.Parts.FindOrAdd(FJournalPartKey::Make(ClassNames[Part.ClassIndex], Part));
+			Change.Part = Part;
+			Change.Count += Count;
+		};
+
+		for (const FSavedPart& Part : Batch.AddedParts)
+		{
+			AddPartChange(Part, 1);
+		}
+		for (const FSavedPart& Part : Batch.RemovedParts)
+		{
+			AddPartChange(Part, -1);
+		}
+
+		for (const TPair<FIntPoint, FSavedResource>& Resource : Batch.Resources)
+		{
+			Cells.FindOrAdd(Resource.Key).Resources.Add(Resource.Value.ActorName, Resource.Value);
+		}
+
+		for (const FSavedPlayer& Player : Batch.Players)
+		{
+			Players.Add(Player.PlayerName, Player);
+		}
+
+		++NumBatches;
+	}
+
+	void FJournalReplay::ApplyToChunk(FWorldSaveChunk& Chunk) const
+	{
+		const FJournalCell* Cell = Cells.Find(Chunk.Cell);
+		if (!Cell)
+		{
+			return;
+		}
+
+		// Removals cancel against the chunk's parts, adds are appended
+		TMap<FJournalPartKey, int32> Removals;
+		for (const TPair<FJournalPartKey, FJournalPartChange>& Pair : Cell->Parts)
+		{
+			if (Pair.Value.Count < 0)
+			{
+				Removals.Add(Pair.Key, -Pair.Value.Count);
+			}
+		}
+
+		if (Removals.Num() > 0)
+		{
+			TArray<FName, TInlineAllocator<16>> ClassNames;
+			for (const FString& ClassPath : Chunk.ClassPaths)
+			{
+				ClassNames.Add(FName(*ClassPath));
+			}
+
+			Chunk.Parts.RemoveAllSwap([&Removals, &ClassNames](const FSavedPart& Part)
+			{
+				int32* Remaining = ClassNames.IsValidIndex(Part.ClassIndex) ? Removals.Find(FJournalPartKey::Make(ClassNames[Part.ClassIndex], Part)) : nullptr;
+				if (Remaining && *Remaining > 0)
+				{
+					--*Remaining;
+					return true;
+				}
+				return false;
+			}, EAllowShrinking::No);
+		}
+
+		for (const TPair<FJournalPartKey, FJournalPartChange>& Pair : Cell->Parts)
+		{
+			if (Pair.Value.Count > 0)
+			{
+				const uint16 ClassIndex = Chunk.FindOrAddClass(Pair.Key.ClassPath.ToString());
+				for (int32 Copy = 0; Copy < Pair.Value.Count; ++Copy)
+				{
+					Chunk.Parts.Add_GetRef(Pair.Value.Part).ClassIndex = ClassIndex;
+				}
+			}
+		}
+
+		for (const TPair<FName, FSavedResource>& Pair : Cell->Resources)
+		{
+			FSavedResource* Existing = Chunk.Resources.FindByPredicate([&Pair](const FSavedResource& Resource)
+			{
+				return Resource.ActorName == Pair.Key;
+			});
+
+			if (Existing)
+			{
+				*Existing = Pair.Value;
+			}
+			else
+			{
+				Chunk.Resources.Add(Pair.Value);
+			}
+		}
+	}
+
+	void FJournalReplay::ApplyToPlayers(TArray<FSavedPlayer>& InOutPlayers) const
+	{
+		for (const TPair<FString, FSavedPlayer>& Pair : Players)
+		{
+			FSavedPlayer* Existing = InOutPlayers.FindByPredicate([&Pair](const FSavedPlayer& Player)
+			{
+				return Player.PlayerName == Pair.Key;
+			});
+
+			if (Existing)
+			{
+				*Existing = Pair.Value;
+			}
+			else
+			{
+				InOutPlayers.Add(Pair.Value);
+			}
+		}
+	}
+
+	FString GetJournalFilename(const FString& SaveFilename)
+	{
+		return FPaths::ChangeExtension(SaveFilename, TEXT("gjnl"));
+	}
+
+	// Preamble of an existing journal, if it has one
+	static bool ReadJournalPreamble(FArchive& Reader, FGuid& OutSaveId, float& OutChunkSize)
+	{
+		uint32 FileMagic = 0;
+		uint32 FileVersion = 0;
+		Reader << FileMagic << FileVersion << OutSaveId << OutChunkSize;
+		return !Reader.IsError() && FileMagic == JournalMagic && FileVersion >= 1 && FileVersion <= JournalVersion;
+	}
+
+	// End of the last batch that passes its size and CRC checks, scanning from DataStart
+	static int64 FindIntactEnd(const TArray<uint8>& Bytes, int64 DataStart)
+	{
+		FMemoryReader Reader(Bytes);
+		Reader.Seek(DataStart);
+
+		int64 End = DataStart;
+		while (Reader.Tell() < Reader.TotalSize())
+		{
+			int32 Size = 0;
+			uint32 Crc = 0;
+			Reader << Size << Crc;
+			if (Reader.IsError() || Size < 0 || Reader.Tell() + Size > Reader.TotalSize()
+				|| FCrc::MemCrc32(Bytes.GetData() + Reader.Tell(), Size) != Crc)
+			{
+				break;
+			}
+
+			Reader.Seek(Reader.Tell() + Size);
+			End = Reader.Tell();
+		}
+		return End;
+	}
+
+	bool AppendJournal(const FString& Filename, const FGuid& SaveId, float ChunkSize, FJournalBatch& Batch, int64 KnownEnd, int64* OutBytesWritten, int64* OutEnd)
+	{
+		IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+
+		// Where the batch goes: after the last intact batch, or at the start of a new journal. Without
+		// a known end the file is scanned, and a journal left from another save (or a damaged one)
+		// is started over.
+		bool bNeedsPreamble = KnownEnd <= 0;
+		int64 WriteAt = FMath::Max<int64>(KnownEnd, 0);
+		if (KnownEnd == INDEX_NONE && PlatformFile.FileExists(*Filename))
+		{
+			TArray<uint8> Existing;
+			if (FFileHelper::LoadFileToArray(Existing, *Filename, FILEREAD_Silent))
+			{
+				FMemoryReader Reader(Existing);
+				FGuid ExistingId;
+				float ExistingChunkSize = 0.0f;
+				bNeedsPreamble = !ReadJournalPreamble(Reader, ExistingId, ExistingChunkSize) || ExistingId != SaveId || ExistingChunkSize != ChunkSize;
+
+				// Reading stops at the first damaged batch, so anything appended behind one would be lost
+				if (!bNeedsPreamble)
+				{
+					WriteAt = FindIntactEnd(Existing, Reader.Tell());
+					if (WriteAt != Existing.Num())
+					{
+						UE_LOG(LogGAM312, Warning, TEXT("[WorldSave] %s ends in a damaged batch at byte %lld; cutting it off before appending"), *Filename, WriteAt);
+					}
+				}
+			}
+
+			if (bNeedsPreamble)
+			{
+				UE_LOG(LogGAM312, Warning, TEXT("[WorldSave] Discarding journal %s, it belongs to another save"), *Filename);
+			}
+		}
+
+		TArray<uint8> Bytes;
+		FMemoryWriter Writer(Bytes);
+		if (bNeedsPreamble)
+		{
+			uint32 FileMagic = JournalMagic;
+			uint32 FileVersion = JournalVersion;
+			FGuid FileSaveId = SaveId;
+			Writer << FileMagic << FileVersion << FileSaveId << ChunkSize;
+		}
+
+		TArray<uint8> Payload;
+		FMemoryWriter PayloadWriter(Payload);
+		PayloadWriter << Batch;
+
+		int32 Size = Payload.Num();
+		uint32 Crc = FCrc::MemCrc32(Payload.GetData(), Payload.Num());
+		Writer << Size << Crc;
+		Writer.Serialize(Payload.GetData(), Payload.Num());
+
+		// Anything past WriteAt is a torn batch (or a journal being started over). A file shorter than
+		// the caller's known end was changed behind its back; the caller rescans after the failure.
+		PlatformFile.CreateDirectoryTree(*FPaths::GetPath(Filename));
+		TUniquePtr<IFileHandle> File(PlatformFile.OpenWrite(*Filename, true));
+		const bool bPositioned = File && File->Size() >= WriteAt && (File->Size() == WriteAt || (File->Truncate(WriteAt) && File->Seek(WriteAt)));
+		if (!bPositioned || !File->Write(Bytes.GetData(), Bytes.Num()) || !File->Flush())
+		{
+			UE_LOG(LogGAM312, Error, TEXT("[WorldSave] Appending to %s failed"), *Filename);
+			return false;
+		}
+
+		if (OutBytesWritten)
+		{
+			*OutBytesWritten = Bytes.Num();
+		}
+		if (OutEnd)
+		{
+			*OutEnd = WriteAt + Bytes.Num();
+		}
+		return true;
+	}
+
+	bool ReadJournal(const FString& Filename, FJournalReplay& OutReplay)
+	{
+		TArray<uint8> Bytes;
+		if (!FFileHelper::LoadFileToArray(Bytes, *Filename, FILEREAD_Silent))
+		{
+			return false;
+		}
+
+		FMemoryReader Reader(Bytes);
+		if (!ReadJournalPreamble(Reader, OutReplay.SaveId, OutReplay.ChunkSize) || OutReplay.ChunkSize <= 0.0f)
+		{
+			UE_LOG(LogGAM312, Warning, TEXT("[WorldSave] %s is not a save journal"), *Filename);
+			return false;
+		}
+		OutReplay.IntactEnd = Reader.Tell();
+
+		while (Reader.Tell() < Reader.TotalSize())
+		{
+			const int64 BatchStart = Reader.Tell();
+			int32 Size = 0;
+			uint32 Crc = 0;
+			Reader << Size << Crc;
+
+			// A batch cut short ends the journal
+			if (Reader.IsError() || Size < 0 || Reader.Tell() + Size > Reader.TotalSize()
+				|| FCrc::MemCrc32(Bytes.GetData() + Reader.Tell(), Size) != Crc)
+			{
+				UE_LOG(LogGAM312, Warning, TEXT("[WorldSave] %s ends in a damaged batch at byte %lld; ignoring the rest"), *Filename, BatchStart);
+				break;
+			}
+
+			FJournalBatch Batch;
+			Reader << Batch;
+			if (Reader.IsError())
+			{
+				break;
+			}
+			OutReplay.AddBatch(Batch);
+			OutReplay.IntactEnd = BatchStart + sizeof(int32) + sizeof(uint32) + Size;
+		}
+
+		OutReplay.NumBytes = Bytes.Num();
+		return true;
+	}
+}
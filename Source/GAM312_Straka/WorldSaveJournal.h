@@ -0,0 +1,130 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "WorldSaveFormat.h"
+
+/**
+ * Autosave journal layout, stored next to the save as <Slot>.gjnl:
+ *
+ *   uint32 JournalMagic, uint32 JournalVersion, FGuid SaveId, float ChunkSize
+ *   batches                   int32 Size, uint32 Crc, FJournalBatch
+ *
+ * Each autosave appends one batch holding only what changed since the last one, at the end
+ * the save subsystem remembers from the last load or write. A batch cut short by a crash
+ * fails its size or CRC check and ends the journal there; an append without a known end
+ * (after a failed write) scans for the last intact batch and cuts the journal back to it. The journal
+ * only applies to the save whose SaveId it names; compaction folds it into a new save.
+ */
+namespace WorldSave
+{
+	static constexpr uint32 JournalMagic = 0x4A533347; // "G3SJ"
+	static constexpr uint32 JournalVersion = 1;
+
+	/**
+	 * FJournalPartKey
+	 *
+	 * Identifies a placed part across saves: its class and its packed transform.
+	 */
+	struct FJournalPartKey
+	{
+		FName ClassPath;
+		FIntVector Location = FIntVector::ZeroValue;
+		uint16 Pitch = 0;
+		uint16 Yaw = 0;
+		uint16 Roll = 0;
+
+		static FJournalPartKey Make(FName ClassPath, const FSavedPart& Part);
+
+		bool operator==(const FJournalPartKey& Other) const
+		{
+			return ClassPath == Other.ClassPath && Location == Other.Location && Pitch == Other.Pitch && Yaw == Other.Yaw && Roll == Other.Roll;
+		}
+
+		friend uint32 GetTypeHash(const FJournalPartKey& Key)
+		{
+			return HashCombine(HashCombine(GetTypeHash(Key.ClassPath), GetTypeHash(Key.Location)), (uint32(Key.Pitch) << 16 | Key.Yaw) ^ (uint32(Key.Roll) << 8));
+		}
+	};
+
+	/**
+	 * FJournalPartChange
+	 *
+	 * Net change of one part: Count > 0 adds that many, Count < 0 removes them.
+	 * Placing and removing the same part cancels out.
+	 */
+	struct FJournalPartChange
+	{
+		FSavedPart Part;
+		int32 Count = 0;
+	};
+
+	/**
+	 * FJournalBatch
+	 *
+	 * Everything one autosave changed. Parts index into the batch's own class table.
+	 */
+	struct FJournalBatch
+	{
+		TArray<FString> ClassPaths;
+		TArray<FSavedPart> AddedParts;
+		TArray<FSavedPart> RemovedParts;
+		TArray<TPair<FIntPoint, FSavedResource>> Resources;
+		TArray<FSavedPlayer> Players;
+
+		int32 NumRecords() const { return AddedParts.Num() + RemovedParts.Num() + Resources.Num() + Players.Num(); }
+
+		friend FArchive& operator<<(FArchive& Ar, FJournalBatch& Batch);
+	};
+
+	/**
+	 * FJournalCell
+	 *
+	 * Journal changes that fall inside one chunk.
+	 */
+	struct FJournalCell
+	{
+		TMap<FJournalPartKey, FJournalPartChange> Parts;
+		TMap<FName, FSavedResource> Resources;
+	};
+
+	/**
+	 * FJournalReplay
+	 *
+	 * A journal folded into its net changes, ready to be laid over the save's chunks and
+	 * players as they are read.
+	 */
+	struct FJournalReplay
+	{
+		FGuid SaveId;
+		float ChunkSize = 0.0f;
+		int32 NumBatches = 0;
+		int64 NumBytes = 0;
+
+		// End of the last intact batch, where the next one is appended
+		int64 IntactEnd = 0;
+
+		// Latest saved state of each player, by name
+		TMap<FString, FSavedPlayer> Players;
+		TMap<FIntPoint, FJournalCell> Cells;
+
+		void AddBatch(const FJournalBatch& Batch);
+
+		// Removes the journal's removed parts from Chunk and adds its added parts and resource states
+		void ApplyToChunk(FWorldSaveChunk& Chunk) const;
+
+		// Replaces saved players with their journaled state (adding players the save didn't have)
+		void ApplyToPlayers(TArray<FSavedPlayer>& Players) const;
+	};
+
+	// Journal stored next to a save file
+	GAM312_STRAKA_API FString GetJournalFilename(const FString& SaveFilename);
+
+	// Appends one batch at KnownEnd, the end of the last intact batch as the caller last saw it (0 starts
+	// the journal for SaveId over). With INDEX_NONE the file is scanned for it instead, starting the
+	// journal if there is none. OutBytesWritten includes a new preamble; OutEnd is the journal's new end.
+	GAM312_STRAKA_API bool AppendJournal(const FString& Filename, const FGuid& SaveId, float ChunkSize, FJournalBatch& Batch, int64 KnownEnd,
+		int64* OutBytesWritten = nullptr, int64* OutEnd = nullptr);
+
+	// Reads every intact batch. Returns false if there is no journal or it is unreadable.
+	GAM312_STRAKA_API bool ReadJournal(const FString& Filename, FJournalReplay& OutReplay);
+}
@@ -0,0 +1,1635 @@
+#include "WorldSaveSubsystem.h"
+#include "GAM312_Straka.h"
+#include "BuildingManagerSubsystem.h"
+#include "MyCharacter.h"
+#include "ResourceLifecycleSubsystem.h"
+#include "Resource_M.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/PlayerState.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/Paths.h"
+
+DECLARE_CYCLE_STAT(TEXT("Save Gather"), STAT_GAM312_SaveGather, STATGROUP_GAM312);
+DECLARE_CYCLE_STAT(TEXT("Save Chunk Apply"), STAT_GAM312_SaveChunkApply, STATGROUP_GAM312);
+DECLARE_CYCLE_STAT(TEXT("Save Chunk Unload"), STAT_GAM312_SaveChunkUnload, STATGROUP_GAM312);
+
+static TAutoConsoleVariable<float> CVarSaveChunkSize(
+	TEXT("gam312.Save.ChunkSize"),
+	10000.0f,
+	TEXT("Size of the spatial chunks world saves are split into. Saves that carry unloaded chunks over keep the size they were loaded with."));
+
+static TAutoConsoleVariable<float> CVarSaveStreamDistance(
+	TEXT("gam312.Save.StreamDistance"),
+	20000.0f,
+	TEXT("Chunks of a loaded save are streamed in once a player is this close to them."));
+
+static TAutoConsoleVariable<float> CVarSaveUnloadDistance(
+	TEXT("gam312.Save.UnloadDistance"),
+	40000.0f,
+	TEXT("Streamed-in chunks whose parts are all saved are unloaded once every player is this far from them, and stream back in from the save (0 keeps them loaded). At least StreamDistance plus one chunk."));
+
+static TAutoConsoleVariable<int32> CVarSavePartsPerFrame(
+	TEXT("gam312.Save.PartsPerFrame"),
+	5000,
+	TEXT("Most building parts placed per frame while applying streamed chunks."));
+
+static TAutoConsoleVariable<float> CVarSaveAutosaveInterval(
+	TEXT("gam312.Save.AutosaveInterval"),
+	0.0f,
+	TEXT("Seconds between autosaves, which append changed records to the slot's journal. 0 (the default) disables them, so PIE and benchmarks don't write saves; servers opt in, e.g. 60 in the [ConsoleVariables] section of DefaultEngine.ini."));
+
+static TAutoConsoleVariable<int32> CVarSaveCompactBytes(
+	TEXT("gam312.Save.CompactBytes"),
+	1024 * 1024,
+	TEXT("Journal size at which it is folded into a new save in the background."));
+
+namespace WorldSaveStream
+{
+	// Seconds between checks for chunks that came into range
+	static constexpr float CheckInterval = 0.25f;
+
+	// Most chunks decoded by one worker read
+	static constexpr int32 MaxChunksPerRead = 8;
+}
+
+namespace WorldSaveBenchmark
+{
+	static const TCHAR* SlotName = TEXT("SaveBenchmark");
+	static const TCHAR* DefaultPartClass = TEXT("/Game/Building/Wall_BP.Wall_BP_C");
+
+	// Grid spacing between benchmark parts
+	static constexpr float Spacing = 450.0f;
+
+	static constexpr int32 DefaultParts = 100000;
+}
+
+namespace WorldSaveWalk
+{
+	// Seconds between memory samples
+	static constexpr float SampleInterval = 1.0f;
+
+	static constexpr float DefaultDistance = 150000.0f;
+	static constexpr float DefaultSpeed = 3000.0f;
+}
+
+// Slot autosaves go to until something is saved or loaded
+static const TCHAR* DefaultAutosaveSlot = TEXT("Autosave");
+
+// Saves are keyed by player name so they survive reconnects (object names don't)
+static FString GetSavedPlayerName(const AMyCharacter* Character)
+{
+	const APlayerState* PlayerState = Character->GetPlayerState();
+	return PlayerState ? PlayerState->GetPlayerName() : Character->GetName();
+}
+
+// Committed inventory; anything queued this frame lands in the next save
+static void SavePlayer(const AMyCharacter* Character, WorldSave::FSavedPlayer& OutPlayer)
+{
+	OutPlayer.PlayerName = GetSavedPlayerName(Character);
+	OutPlayer.Health = Character->Health;
+	OutPlayer.Hunger = Character->Hunger;
+	OutPlayer.Stamina = Character->Stamina;
+	if (Character->Inventory)
+	{
+		OutPlayer.Resources = Character->Inventory->GetResources();
+		OutPlayer.Buildings = Character->Inventory->GetBuildings();
+	}
+}
+
+static WorldSave::FSavedResource SaveResource(const AResource_M* Node)
+{
+	WorldSave::FSavedResource Resource;
+	Resource.ActorName = Node->GetFName();
+	Resource.TotalResource = Node->totalResource;
+	Resource.bDepleted = Node->IsDepleted();
+	return Resource;
+}
+
+void UWorldSaveSubsystem::Deinitialize()
+{
+	// Let a save in flight finish so the slot isn't left behind as a .tmp
+	if (PendingSave.IsValid())
+	{
+		PendingSave.Wait();
+		PendingSave = {};
+	}
+	ResetStream();
+	ResolvedClasses.Reset();
+	StashedResources.Reset();
+	OfflinePlayers.Reset();
+	DirtyOfflinePlayers.Reset();
+	BenchStage = INDEX_NONE;
+	WalkPawn.Reset();
+
+	Super::Deinitialize();
+}
+
+bool UWorldSaveSubsystem::IsTickable() const
+{
+	const UWorld* World = GetWorld();
+	const bool bAutosaving = CVarSaveAutosaveInterval.GetValueOnGameThread() > 0.0f && World && World->IsGameWorld() && World->GetNetMode() != NM_Client;
+	return IsSaving() || IsStreaming() || bAutosaving || BenchStage != INDEX_NONE || WalkPawn.IsValid();
+}
+
+TStatId UWorldSaveSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UWorldSaveSubsystem, STATGROUP_Tickables);
+}
+
+FString UWorldSaveSubsystem::GetSlotFilename(const FString& SlotName)
+{
+	return FPaths::ProjectSavedDir() / TEXT("SaveGames") / SlotName + TEXT(".gsav");
+}
+
+void UWorldSaveSubsystem::Tick(float DeltaTime)
+{
+	GAM312_SCOPE(UWorldSaveSubsystem, Tick);
+
+	Super::Tick(DeltaTime);
+
+	if (PendingSave.IsValid() && PendingSave.IsCompleted())
+	{
+		FinishSave();
+	}
+
+	// Full saves and compactions suspend the stream while their worker owns the file
+	if (IsStreaming())
+	{
+		if (PendingRead.IsValid() && PendingRead.IsCompleted())
+		{
+			FinishRead();
+		}
+
+		TimeSinceStreamCheck += DeltaTime;
+		if (!PendingRead.IsValid() && (bStreamAllChunks || TimeSinceStreamCheck >= WorldSaveStream::CheckInterval))
+		{
+			TimeSinceStreamCheck = 0.0f;
+			UnloadChunks();
+			RequestChunks();
+		}
+
+		if (ApplyQueue.Num() > 0)
+		{
+			ApplyChunks(FMath::Max(CVarSavePartsPerFrame.GetValueOnGameThread(), 1));
+			++LoadFrames;
+		}
+
+		if (LoadStartTime > 0.0 && !PendingRead.IsValid() && ApplyQueue.Num() == 0 && ChunkRequested.Find(false) == INDEX_NONE)
+		{
+			UE_LOG(LogGAM312, Log, TEXT("[WorldSave] Loaded all %d chunks of %s: %d parts in %.1f ms over %d frames"),
+				StreamChunks.Num(), *FPaths::GetBaseFilename(StreamFilename), LoadedParts,
+				(FPlatformTime::Seconds() - LoadStartTime) * 1000.0, LoadFrames);
+			LoadStartTime = 0.0;
+			bStreamAllChunks = false;
+
+			// Chunks that get unloaded stream back in from this save, so it stays open
+			if (CVarSaveUnloadDistance.GetValueOnGameThread() <= 0.0f)
+			{
+				ResetStream();
+			}
+		}
+	}
+
+	const float AutosaveInterval = CVarSaveAutosaveInterval.GetValueOnGameThread();
+	if (AutosaveInterval > 0.0f && !IsSaving() && GetWorld()->GetTimeSeconds() - LastAutosaveTime >= AutosaveInterval)
+	{
+		Autosave();
+	}
+
+	TickBenchmark();
+
+	if (WalkPawn.IsValid())
+	{
+		TickStreamWalk(DeltaTime);
+	}
+}
+
+/** ---------- Saving ---------- **/
+
+bool UWorldSaveSubsystem::SaveWorld(const FString& SlotName)
+{
+	if (GetWorld()->GetNetMode() == NM_Client || IsSaving())
+	{
+		UE_LOG(LogGAM312, Warning, TEXT("[WorldSave] Can't save %s now (client, or a save is already running)"), *SlotName);
+		return false;
+	}
+
+	// Chunks the world already has parts in must be merged with those parts rather than carried over
+	FinishRead();
+	LoadChunksWithParts();
+	ApplyChunks(INDEX_NONE);
+
+	FSaveSnapshot Snapshot;
+	Snapshot.Filename = GetSlotFilename(SlotName);
+	Snapshot.ChunkSize = FMath::Max(CVarSaveChunkSize.GetValueOnGameThread(), 100.0f);
+	Snapshot.Header.SaveId = FGuid::NewGuid();
+
+	// The worker reads carried chunks from the streamed file and may replace it; FinishSave reopens it
+	const FString OldFilename = StreamFilename;
+	const int64 OldDataStart = StreamDataStart;
+	const float OldChunkSize = StreamChunkSize;
+	Snapshot.Journal = StreamJournal;
+	SuspendStream(&Snapshot.CarriedChunks);
+
+	// Carried chunks are copied as they are, so their cells must keep their size
+	if (Snapshot.CarriedChunks.Num() > 0)
+	{
+		Snapshot.ChunkSize = OldChunkSize;
+		Snapshot.OldFilename = OldFilename;
+		Snapshot.OldDataStart = OldDataStart;
+	}
+
+	const double GatherStart = FPlatformTime::Seconds();
+	GatherWorld(Snapshot);
+	LastGatherSeconds = FPlatformTime::Seconds() - GatherStart;
+
+	// The snapshot holds every change so far; a failed write asks for another full save
+	ResetChanges();
+	ActiveSlot = SlotName;
+
+	PendingSaveFilename = Snapshot.Filename;
+	PendingSave = UE::Tasks::Launch(UE_SOURCE_LOCATION, [Snapshot = MoveTemp(Snapshot)]() mutable
+	{
+		return WriteSnapshot(Snapshot);
+	});
+	return true;
+}
+
+void UWorldSaveSubsystem::LoadChunksWithParts()
+{
+	UBuildingManagerSubsystem* BuildingManager = GetWorld()->GetSubsystem<UBuildingManagerSubsystem>();
+	if (!IsStreaming() || !BuildingManager)
+	{
+		return;
+	}
+
+	TSet<FIntPoint> PartCells;
+	for (const FPlacedBuildingRecord& Record : BuildingManager->GetRecords())
+	{
+		if (Record.IsValid())
+		{
+			PartCells.Add(WorldSave::GetCell(Record.Transform.GetLocation(), StreamChunkSize));
+		}
+	}
+
+	for (int32 Index = 0; Index < StreamChunks.Num(); ++Index)
+	{
+		if (!ChunkRequested[Index] && PartCells.Contains(StreamChunks[Index].Cell))
+		{
+			LoadChunk(Index);
+		}
+	}
+}
+
+void UWorldSaveSubsystem::GatherWorld(FSaveSnapshot& Snapshot) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_GAM312_SaveGather);
+
+	UWorld* World = GetWorld();
+	Snapshot.Header.ChunkSize = Snapshot.ChunkSize;
+
+	TSet<FString> OnlinePlayers;
+	for (TActorIterator<AMyCharacter> It(World); It; ++It)
+	{
+		WorldSave::FSavedPlayer& Player = Snapshot.Header.Players.AddDefaulted_GetRef();
+		SavePlayer(*It, Player);
+		OnlinePlayers.Add(Player.PlayerName);
+	}
+
+	// Players who aren't here keep what they had
+	for (const TPair<FString, WorldSave::FSavedPlayer>& Pair : OfflinePlayers)
+	{
+		if (!OnlinePlayers.Contains(Pair.Key))
+		{
+			Snapshot.Header.Players.Add(Pair.Value);
+		}
+	}
+
+	// Parts point into one class table here; the worker splits it per chunk
+	if (const UBuildingManagerSubsystem* BuildingManager = World->GetSubsystem<UBuildingManagerSubsystem>())
+	{
+		TMap<const UClass*, uint16> ClassLookup;
+		Snapshot.Parts.Reserve(BuildingManager->GetNumPlacedParts());
+
+		for (const FPlacedBuildingRecord& Record : BuildingManager->GetRecords())
+		{
+			if (!Record.IsValid() || !Record.PartClass)
+			{
+				continue;
+			}
+
+			uint16* ClassIndex = ClassLookup.Find(Record.PartClass);
+			if (!ClassIndex)
+			{
+				ClassIndex = &ClassLookup.Add(Record.PartClass, static_cast<uint16>(Snapshot.ClassPaths.Add(Record.PartClass->GetPathName())));
+			}
+
+			WorldSave::FSavedPart& Part = Snapshot.Parts.AddDefaulted_GetRef();
+			Part.ClassIndex = *ClassIndex;
+			Part.BuildingId = static_cast<int16>(Record.BuildingId);
+			Part.SetTransform(Record.Transform);
+		}
+	}
+
+	for (TActorIterator<AResource_M> It(World); It; ++It)
+	{
+		const AResource_M* Node = *It;
+		const FIntPoint Cell = WorldSave::GetCell(Node->GetActorLocation(), Snapshot.ChunkSize);
+
+		// Untouched nodes in carried chunks were never restored, so the carried state is the saved one
+		if (PendingCarriedCells.Contains(Cell) && ResourceNodes.Contains(Node->GetFName()))
+		{
+			continue;
+		}
+
+		Snapshot.Resources.Emplace(Cell, SaveResource(Node));
+	}
+
+	// Nodes World Partition streamed out aren't in the world to iterate
+	for (const TPair<FName, TPair<FVector, WorldSave::FSavedResource>>& Pair : StashedResources)
+	{
+		const FIntPoint Cell = WorldSave::GetCell(Pair.Value.Key, Snapshot.ChunkSize);
+		if (!PendingCarriedCells.Contains(Cell) || !ResourceNodes.Contains(Pair.Key))
+		{
+			Snapshot.Resources.Emplace(Cell, Pair.Value.Value);
+		}
+	}
+}
+
+void UWorldSaveSubsystem::ResetChanges()
+{
+	DirtyParts.Reset();
+	DirtyResources.Reset();
+	DirtyOfflinePlayers.Reset();
+	bFullSaveNeeded = false;
+
+	for (TActorIterator<AMyCharacter> It(GetWorld()); It; ++It)
+	{
+		It->ConsumeSaveDirty();
+	}
+}
+
+void UWorldSaveSubsystem::GatherChanges(WorldSave::FJournalBatch& Batch)
+{
+	TMap<FName, uint16> ClassLookup;
+	for (const TPair<WorldSave::FJournalPartKey, WorldSave::FJournalPartChange>& Pair : DirtyParts)
+	{
+		if (Pair.Value.Count == 0)
+		{
+			continue;
+		}
+
+		uint16* ClassIndex = ClassLookup.Find(Pair.Key.ClassPath);
+		if (!ClassIndex)
+		{
+			ClassIndex = &ClassLookup.Add(Pair.Key.ClassPath, static_cast<uint16>(Batch.ClassPaths.Add(Pair.Key.ClassPath.ToString())));
+		}
+
+		TArray<WorldSave::FSavedPart>& Parts = Pair.Value.Count > 0 ? Batch.AddedParts : Batch.RemovedParts;
+		for (int32 Copy = 0; Copy < FMath::Abs(Pair.Value.Count); ++Copy)
+		{
+			Parts.Add_GetRef(Pair.Value.Part).ClassIndex = *ClassIndex;
+		}
+	}
+
+	for (const TPair<FName, TWeakObjectPtr<AResource_M>>& Pair : DirtyResources)
+	{
+		if (const AResource_M* Node = Pair.Value.Get())
+		{
+			Batch.Resources.Emplace(WorldSave::GetCell(Node->GetActorLocation(), ActiveChunkSize), SaveResource(Node));
+		}
+		else if (const TPair<FVector, WorldSave::FSavedResource>* Stashed = StashedResources.Find(Pair.Key))
+		{
+			Batch.Resources.Emplace(WorldSave::GetCell(Stashed->Key, ActiveChunkSize), Stashed->Value);
+		}
+	}
+
+	for (TActorIterator<AMyCharacter> It(GetWorld()); It; ++It)
+	{
+		if (It->ConsumeSaveDirty())
+		{
+			SavePlayer(*It, Batch.Players.AddDefaulted_GetRef());
+		}
+	}
+
+	for (const FString& PlayerName : DirtyOfflinePlayers)
+	{
+		if (const WorldSave::FSavedPlayer* Player = OfflinePlayers.Find(PlayerName))
+		{
+			Batch.Players.Add(*Player);
+		}
+	}
+
+	DirtyParts.Reset();
+	DirtyResources.Reset();
+	DirtyOfflinePlayers.Reset();
+}
+
+FWorldSaveResult UWorldSaveSubsystem::WriteSnapshot(FSaveSnapshot& Snapshot)
+{
+	const double StartTime = FPlatformTime::Seconds();
+
+	TArray<WorldSave::FWorldSaveChunk> Chunks;
+	TMap<FIntPoint, int32> CellToChunk;
+
+	// Global class index -> chunk class index, per chunk
+	TArray<TArray<int32>> ClassRemaps;
+
+	auto FindOrAddChunk = [&](const FIntPoint& Cell)
+	{
+		if (const int32* Existing = CellToChunk.Find(Cell))
+		{
+			return *Existing;
+		}
+
+		const int32 ChunkIndex = Chunks.AddDefaulted();
+		Chunks[ChunkIndex].Cell = Cell;
+		ClassRemaps.AddDefaulted_GetRef().Init(INDEX_NONE, Snapshot.ClassPaths.Num());
+		CellToChunk.Add(Cell, ChunkIndex);
+		return ChunkIndex;
+	};
+
+	for (const WorldSave::FSavedPart& Part : Snapshot.Parts)
+	{
+		const int32 ChunkIndex = FindOrAddChunk(WorldSave::GetCell(FVector(Part.Location), Snapshot.ChunkSize));
+		WorldSave::FWorldSaveChunk& Chunk = Chunks[ChunkIndex];
+
+		int32& ChunkClass = ClassRemaps[ChunkIndex][Part.ClassIndex];
+		if (ChunkClass == INDEX_NONE)
+		{
+			ChunkClass = Chunk.ClassPaths.Add(Snapshot.ClassPaths[Part.ClassIndex]);
+		}
+
+		WorldSave::FSavedPart& Added = Chunk.Parts.Add_GetRef(Part);
+		Added.ClassIndex = static_cast<uint16>(ChunkClass);
+	}
+
+	for (const TPair<FIntPoint, WorldSave::FSavedResource>& Resource : Snapshot.Resources)
+	{
+		Chunks[FindOrAddChunk(Resource.Key)].Resources.Add(Resource.Value);
+	}
+
+	// Copy over the chunks that were never streamed in
+	if (Snapshot.CarriedChunks.Num() > 0)
+	{
+		TUniquePtr<IFileHandle> OldFile(FPlatformFileManager::Get().GetPlatformFile().OpenRead(*Snapshot.OldFilename));
+		for (const WorldSave::FChunkInfo& Info : Snapshot.CarriedChunks)
+		{
+			WorldSave::FWorldSaveChunk Carried;
+			if (!OldFile || !ReadStreamChunk(*OldFile, Snapshot.OldDataStart, Info, Snapshot.Journal.Get(), Carried))
+			{
+				UE_LOG(LogGAM312, Error, TEXT("[WorldSave] Could not carry chunk (%d, %d) over from %s"), Info.Cell.X, Info.Cell.Y, *Snapshot.OldFilename);
+				return FWorldSaveResult();
+			}
+
+			// Nodes gathered from the world changed since the load; their carried state is stale
+			WorldSave::FWorldSaveChunk& Chunk = Chunks[FindOrAddChunk(Info.Cell)];
+			Carried.Resources.RemoveAllSwap([&Chunk](const WorldSave::FSavedResource& Resource)
+			{
+				return Chunk.Resources.ContainsByPredicate([&Resource](const WorldSave::FSavedResource& Gathered) { return Gathered.ActorName == Resource.ActorName; });
+			});
+			Chunk.Append(Carried);
+		}
+	}
+
+	FWorldSaveResult Result;
+	Result.Kind = EWorldSaveWrite::Full;
+	Result.SaveId = Snapshot.Header.SaveId;
+	Result.ChunkSize = Snapshot.ChunkSize;
+	Result.bSuccess = WorldSave::WriteFile(Snapshot.Filename, Snapshot.Header, Chunks, &Result.FileSize);
+	for (const WorldSave::FWorldSaveChunk& Chunk : Chunks)
+	{
+		Result.NumParts += Chunk.Parts.Num();
+	}
+
+	// The journal belonged to the save that was just replaced
+	if (Result.bSuccess)
+	{
+		FPlatformFileManager::Get().GetPlatformFile().DeleteFile(*WorldSave::GetJournalFilename(Snapshot.Filename));
+	}
+
+	Result.WriteSeconds = FPlatformTime::Seconds() - StartTime;
+	return Result;
+}
+
+FWorldSaveResult UWorldSaveSubsystem::CompactSave(const FString& Filename)
+{
+	const double StartTime = FPlatformTime::Seconds();
+
+	FWorldSaveResult Result;
+	Result.Kind = EWorldSaveWrite::Compaction;
+
+	WorldSave::FWorldSaveHeader Header;
+	int64 DataStart = 0;
+	TUniquePtr<IFileHandle> File(FPlatformFileManager::Get().GetPlatformFile().OpenRead(*Filename));
+	if (!File || !WorldSave::ReadHeader(*File, Header, DataStart))
+	{
+		UE_LOG(LogGAM312, Error, TEXT("[WorldSave] Could not read %s to compact it"), *Filename);
+		return Result;
+	}
+
+	const FString JournalFilename = WorldSave::GetJournalFilename(Filename);
+	WorldSave::FJournalReplay Journal;
+	if (!WorldSave::ReadJournal(JournalFilename, Journal) || Journal.SaveId != Header.SaveId || Journal.ChunkSize != Header.ChunkSize)
+	{
+		UE_LOG(LogGAM312, Warning, TEXT("[WorldSave] %s has no journal to compact"), *Filename);
+		return Result;
+	}
+
+	// Every chunk of the save, plus cells only the journal has parts in
+	TArray<WorldSave::FWorldSaveChunk> Chunks;
+	TSet<FIntPoint> Cells;
+	for (const WorldSave::FChunkInfo& Info : Header.Chunks)
+	{
+		if (!ReadStreamChunk(*File, DataStart, Info, &Journal, Chunks.AddDefaulted_GetRef()))
+		{
+			UE_LOG(LogGAM312, Error, TEXT("[WorldSave] Could not read chunk (%d, %d) of %s to compact it"), Info.Cell.X, Info.Cell.Y, *Filename);
+			return Result;
+		}
+		Cells.Add(Info.Cell);
+	}
+	File.Reset();
+
+	for (const TPair<FIntPoint, WorldSave::FJournalCell>& Cell : Journal.Cells)
+	{
+		if (!Cells.Contains(Cell.Key))
+		{
+			WorldSave::FWorldSaveChunk& Chunk = Chunks.AddDefaulted_GetRef();
+			Chunk.Cell = Cell.Key;
+			Journal.ApplyToChunk(Chunk);
+		}
+	}
+
+	Chunks.RemoveAllSwap([](const WorldSave::FWorldSaveChunk& Chunk) { return Chunk.Parts.Num() == 0 && Chunk.Resources.Num() == 0; });
+	Journal.ApplyToPlayers(Header.Players);
+
+	Header.FileVersion = WorldSave::Version;
+	Header.SaveId = FGuid::NewGuid();
+	Result.SaveId = Header.SaveId;
+	Result.ChunkSize = Header.ChunkSize;
+	Result.bSuccess = WorldSave::WriteFile(Filename, Header, Chunks, &Result.FileSize);
+	if (Result.bSuccess)
+	{
+		FPlatformFileManager::Get().GetPlatformFile().DeleteFile(*JournalFilename);
+	}
+
+	for (const WorldSave::FWorldSaveChunk& Chunk : Chunks)
+	{
+		Result.NumParts += Chunk.Parts.Num();
+	}
+	Result.WriteSeconds = FPlatformTime::Seconds() - StartTime;
+	return Result;
+}
+
+void UWorldSaveSubsystem::FinishSave()
+{
+	LastSaveResult = PendingSave.GetResult();
+	PendingSave = {};
+
+	if (LastSaveResult.Kind == EWorldSaveWrite::Journal)
+	{
+		if (LastSaveResult.bSuccess)
+		{
+			JournalBytes += LastSaveResult.FileSize;
+			JournalEnd = LastSaveResult.JournalEnd;
+			++JournalBatches;
+			UE_LOG(LogGAM312, Log, TEXT("[Autosave] %d records (%d part changes) after %.0f s: %lld bytes, gather %.2f ms, write %.2f ms, latency %.1f ms; journal %lld bytes in %d batches"),
+				AutosaveRecords, LastSaveResult.NumParts, AutosaveSpan, LastSaveResult.FileSize,
+				LastGatherSeconds * 1000.0, LastSaveResult.WriteSeconds * 1000.0, (FPlatformTime::Seconds() - AutosaveStartTime) * 1000.0,
+				JournalBytes, JournalBatches);
+
+			if (JournalBytes >= CVarSaveCompactBytes.GetValueOnGameThread())
+			{
+				CompactJournal();
+			}
+		}
+		else
+		{
+			// The batch's changes are gone from the tracking, so only a full save can catch up
+			UE_LOG(LogGAM312, Error, TEXT("[Autosave] Appending to %s failed; the next autosave is a full save"), *PendingSaveFilename);
+			bFullSaveNeeded = true;
+			JournalEnd = INDEX_NONE;
+		}
+		return;
+	}
+
+	const bool bCompaction = LastSaveResult.Kind == EWorldSaveWrite::Compaction;
+	if (LastSaveResult.bSuccess)
+	{
+		UE_LOG(LogGAM312, Log, TEXT("[WorldSave] %s %s: %d parts, %lld bytes (%.1f bytes/part), %s%.1f ms"),
+			bCompaction ? TEXT("Compacted journal into") : TEXT("Saved"), *PendingSaveFilename, LastSaveResult.NumParts, LastSaveResult.FileSize,
+			LastSaveResult.NumParts > 0 ? static_cast<double>(LastSaveResult.FileSize) / LastSaveResult.NumParts : 0.0,
+			bCompaction ? TEXT("") : *FString::Printf(TEXT("gather %.1f ms, write "), LastGatherSeconds * 1000.0), LastSaveResult.WriteSeconds * 1000.0);
+
+		ActiveSaveId = LastSaveResult.SaveId;
+		ActiveChunkSize = LastSaveResult.ChunkSize;
+		JournalBytes = 0;
+		JournalBatches = 0;
+		JournalEnd = 0;
+	}
+	else
+	{
+		UE_LOG(LogGAM312, Error, TEXT("[WorldSave] %s %s failed"), bCompaction ? TEXT("Compacting") : TEXT("Saving"), *PendingSaveFilename);
+
+		// A failed compaction leaves the save and journal as they were
+		bFullSaveNeeded |= !bCompaction;
+	}
+
+	// Keep streaming the carried chunks, now from whichever file holds them
+	ResumeStream(LastSaveResult.bSuccess ? PendingSaveFilename : StreamFilename);
+}
+
+void UWorldSaveSubsystem::SuspendStream(TArray<WorldSave::FChunkInfo>* OutCarriedChunks)
+{
+	PendingCarriedCells.Reset();
+	for (int32 Index = 0; Index < StreamChunks.Num(); ++Index)
+	{
+		if (!ChunkRequested[Index])
+		{
+			PendingCarriedCells.Add(StreamChunks[Index].Cell);
+			if (OutCarriedChunks)
+			{
+				OutCarriedChunks->Add(StreamChunks[Index]);
+			}
+		}
+	}
+
+	StreamFile.Reset();
+	StreamChunks.Reset();
+	StreamChunkIndex.Reset();
+	ChunkRequested.Reset();
+}
+
+void UWorldSaveSubsystem::ResumeStream(const FString& Filename)
+{
+	// With unloading on, the new save stays open so chunks can be unloaded and streamed back from it
+	if (Filename.IsEmpty() || (PendingCarriedCells.Num() == 0 && CVarSaveUnloadDistance.GetValueOnGameThread() <= 0.0f))
+	{
+		ResetStream();
+		PendingCarriedCells.Reset();
+		return;
+	}
+
+	WorldSave::FWorldSaveHeader Header;
+	if (OpenStream(Filename, Header))
+	{
+		for (int32 Index = 0; Index < StreamChunks.Num(); ++Index)
+		{
+			ChunkRequested[Index] = !PendingCarriedCells.Contains(StreamChunks[Index].Cell);
+		}
+	}
+	else
+	{
+		UE_LOG(LogGAM312, Error, TEXT("[WorldSave] Could not reopen %s; %d unloaded chunks will not stream in"), *Filename, PendingCarriedCells.Num());
+		ResetStream();
+	}
+	PendingCarriedCells.Reset();
+}
+
+/** ---------- Autosave ---------- **/
+
+bool UWorldSaveSubsystem::Autosave()
+{
+	if (GetWorld()->GetNetMode() == NM_Client || IsSaving())
+	{
+		return false;
+	}
+
+	AutosaveSpan = GetWorld()->GetTimeSeconds() - LastAutosaveTime;
+	LastAutosaveTime = GetWorld()->GetTimeSeconds();
+
+	if (ActiveSlot.IsEmpty())
+	{
+		ActiveSlot = DefaultAutosaveSlot;
+	}
+
+	// No save for the journal to build on yet (or changes were missed)
+	if (bFullSaveNeeded || !ActiveSaveId.IsValid())
+	{
+		return SaveWorld(ActiveSlot);
+	}
+
+	AutosaveStartTime = FPlatformTime::Seconds();
+	WorldSave::FJournalBatch Batch;
+	GatherChanges(Batch);
+	LastGatherSeconds = FPlatformTime::Seconds() - AutosaveStartTime;
+
+	AutosaveRecords = Batch.NumRecords();
+	if (AutosaveRecords == 0)
+	{
+		UE_LOG(LogGAM312, Verbose, TEXT("[Autosave] Nothing changed"));
+		return true;
+	}
+
+	const FString Filename = WorldSave::GetJournalFilename(GetSlotFilename(ActiveSlot));
+	const FGuid SaveId = ActiveSaveId;
+	const float ChunkSize = ActiveChunkSize;
+
+	// Chunks unloaded from now on have to stream back in with this batch laid over them. The
+	// replay is copied rather than changed in place because a chunk read in flight may hold it.
+	if (IsStreaming() && StreamSaveId == SaveId)
+	{
+		TSharedRef<WorldSave::FJournalReplay> Journal = StreamJournal ? MakeShared<WorldSave::FJournalReplay>(*StreamJournal) : MakeShared<WorldSave::FJournalReplay>();
+		Journal->SaveId = SaveId;
+		Journal->ChunkSize = ChunkSize;
+		Journal->AddBatch(Batch);
+
+		// Cells the save has no chunk for are loaded already; they are in the world
+		for (const TPair<FIntPoint, WorldSave::FJournalCell>& Cell : Journal->Cells)
+		{
+			if (!StreamChunkIndex.Contains(Cell.Key))
+			{
+				WorldSave::FChunkInfo& Info = StreamChunks.AddDefaulted_GetRef();
+				Info.Cell = Cell.Key;
+				StreamChunkIndex.Add(Cell.Key, StreamChunks.Num() - 1);
+				ChunkRequested.Add(true);
+			}
+		}
+		StreamJournal = Journal;
+	}
+
+	PendingSaveFilename = Filename;
+	PendingSave = UE::Tasks::Launch(UE_SOURCE_LOCATION, [Filename, SaveId, ChunkSize, KnownEnd = JournalEnd, Batch = MoveTemp(Batch)]() mutable
+	{
+		const double StartTime = FPlatformTime::Seconds();
+
+		FWorldSaveResult Result;
+		Result.Kind = EWorldSaveWrite::Journal;
+		Result.SaveId = SaveId;
+		Result.ChunkSize = ChunkSize;
+		Result.NumParts = Batch.AddedParts.Num() + Batch.RemovedParts.Num();
+		Result.bSuccess = WorldSave::AppendJournal(Filename, SaveId, ChunkSize, Batch, KnownEnd, &Result.FileSize, &Result.JournalEnd);
+		Result.WriteSeconds = FPlatformTime::Seconds() - StartTime;
+		return Result;
+	});
+	return true;
+}
+
+bool UWorldSaveSubsystem::CompactJournal()
+{
+	if (GetWorld()->GetNetMode() == NM_Client || IsSaving() || ActiveSlot.IsEmpty() || !ActiveSaveId.IsValid() || JournalBatches == 0)
+	{
+		return false;
+	}
+
+	// Journaled parts in chunks that haven't streamed in would be folded into them and placed twice
+	FinishRead();
+	LoadChunksWithParts();
+	ApplyChunks(INDEX_NONE);
+	SuspendStream(nullptr);
+
+	const FString Filename = GetSlotFilename(ActiveSlot);
+	PendingSaveFilename = Filename;
+	PendingSave = UE::Tasks::Launch(UE_SOURCE_LOCATION, [Filename]()
+	{
+		return CompactSave(Filename);
+	});
+	return true;
+}
+
+void UWorldSaveSubsystem::MarkPartAdded(const FPlacedBuildingRecord& Record)
+{
+	if (bApplyingSave || !Record.PartClass || GetWorld()->GetNetMode() == NM_Client)
+	{
+		return;
+	}
+
+	WorldSave::FSavedPart Part;
+	Part.BuildingId = static_cast<int16>(Record.BuildingId);
+	Part.SetTransform(Record.Transform);
+
+	WorldSave::FJournalPartChange& Change = DirtyParts.FindOrAdd(WorldSave::FJournalPartKey::Make(FName(*Record.PartClass->GetPathName()), Part));
+	Change.Part = Part;
+	++Change.Count;
+
+	// The saved chunk has to be in the world before the part is, or streaming it in would place the part twice
+	if (const int32* ChunkIndex = StreamChunkIndex.Find(WorldSave::GetCell(Record.Transform.GetLocation(), StreamChunkSize)))
+	{
+		if (!ChunkRequested[*ChunkIndex])
+		{
+			LoadChunk(*ChunkIndex);
+		}
+	}
+}
+
+void UWorldSaveSubsystem::MarkPartRemoved(const FPlacedBuildingRecord& Record)
+{
+	if (bApplyingSave || !Record.PartClass || GetWorld()->GetNetMode() == NM_Client)
+	{
+		return;
+	}
+
+	WorldSave::FSavedPart Part;
+	Part.BuildingId = static_cast<int16>(Record.BuildingId);
+	Part.SetTransform(Record.Transform);
+
+	WorldSave::FJournalPartChange& Change = DirtyParts.FindOrAdd(WorldSave::FJournalPartKey::Make(FName(*Record.PartClass->GetPathName()), Part));
+	Change.Part = Part;
+	--Change.Count;
+}
+
+void UWorldSaveSubsystem::MarkPartsCleared()
+{
+	if (!bApplyingSave && GetWorld()->GetNetMode() != NM_Client)
+	{
+		DirtyParts.Reset();
+		bFullSaveNeeded = true;
+	}
+}
+
+void UWorldSaveSubsystem::MarkResourceDirty(AResource_M* Node)
+{
+	if (bApplyingSave || !Node || GetWorld()->GetNetMode() == NM_Client)
+	{
+		return;
+	}
+
+	DirtyResources.Add(Node->GetFName(), Node);
+	ResourceNodes.Remove(Node->GetFName());
+	ChangedResources.Add(Node->GetFName());
+}
+
+void UWorldSaveSubsystem::StashResource(const AResource_M* Node)
+{
+	if (Node && GetWorld()->GetNetMode() != NM_Client)
+	{
+		StashedResources.Add(Node->GetFName(), TPair<FVector, WorldSave::FSavedResource>(Node->GetActorLocation(), SaveResource(Node)));
+	}
+}
+
+void UWorldSaveSubsystem::RestoreResource(AResource_M* Node)
+{
+	if (!Node || GetWorld()->GetNetMode() == NM_Client)
+	{
+		return;
+	}
+
+	// Chunks streamed in later apply to it like to a node that was there when the load started
+	if (IsStreaming() && !ChangedResources.Contains(Node->GetFName()))
+	{
+		ResourceNodes.Add(Node->GetFName(), Node);
+	}
+	if (TWeakObjectPtr<AResource_M>* Dirty = DirtyResources.Find(Node->GetFName()))
+	{
+		*Dirty = Node;
+	}
+
+	TPair<FVector, WorldSave::FSavedResource> Stashed;
+	if (StashedResources.RemoveAndCopyValue(Node->GetFName(), Stashed))
+	{
+		ApplyResourceState(Node, Stashed.Value);
+	}
+}
+
+void UWorldSaveSubsystem::RestorePlayer(AMyCharacter* Character)
+{
+	if (!Character || GetWorld()->GetNetMode() == NM_Client)
+	{
+		return;
+	}
+
+	WorldSave::FSavedPlayer Saved;
+	if (OfflinePlayers.RemoveAndCopyValue(GetSavedPlayerName(Character), Saved))
+	{
+		const bool bUnsaved = DirtyOfflinePlayers.Remove(Saved.PlayerName) > 0;
+		ApplyPlayer(Character, Saved);
+
+		// Matches the save already, unless the player left with changes no autosave has written yet
+		if (!bUnsaved)
+		{
+			Character->ConsumeSaveDirty();
+		}
+	}
+}
+
+void UWorldSaveSubsystem::StashPlayer(AMyCharacter* Character)
+{
+	if (!Character || GetWorld()->GetNetMode() == NM_Client)
+	{
+		return;
+	}
+
+	WorldSave::FSavedPlayer Player;
+	SavePlayer(Character, Player);
+
+	// Changes the next autosave would have found on the character
+	if (Character->ConsumeSaveDirty())
+	{
+		DirtyOfflinePlayers.Add(Player.PlayerName);
+	}
+	OfflinePlayers.Add(Player.PlayerName, MoveTemp(Player));
+}
+
+/** ---------- Loading ---------- **/
+
+bool UWorldSaveSubsystem::LoadWorld(const FString& SlotName, bool bLoadAllChunks)
+{
+	UWorld* World = GetWorld();
+	UBuildingManagerSubsystem* BuildingManager = World->GetSubsystem<UBuildingManagerSubsystem>();
+	if (World->GetNetMode() == NM_Client || IsSaving() || !BuildingManager)
+	{
+		UE_LOG(LogGAM312, Warning, TEXT("[WorldSave] Can't load %s now (client, or a save is running)"), *SlotName);
+		return false;
+	}
+
+	ResetStream();
+
+	WorldSave::FWorldSaveHeader Header;
+	if (!OpenStream(GetSlotFilename(SlotName), Header))
+	{
+		UE_LOG(LogGAM312, Warning, TEXT("[WorldSave] Could not load %s"), *GetSlotFilename(SlotName));
+		ResetStream();
+		return false;
+	}
+
+	{
+		TGuardValue<bool> ApplyingGuard(bApplyingSave, true);
+		BuildingManager->ClearAll();
+	}
+
+	// Nodes World Partition hasn't streamed in get the loaded state instead of their stashed one
+	StashedResources.Reset();
+	for (TActorIterator<AResource_M> It(World); It; ++It)
+	{
+		ResourceNodes.Add(It->GetFName(), *It);
+	}
+
+	ApplyPlayers(Header.Players);
+
+	// Autosaves now journal against this save; anything tracked before the load is moot
+	ActiveSlot = SlotName;
+	ActiveSaveId = Header.SaveId;
+	ActiveChunkSize = Header.ChunkSize;
+	JournalBytes = StreamJournal ? StreamJournal->NumBytes : 0;
+	JournalBatches = StreamJournal ? StreamJournal->NumBatches : 0;
+	JournalEnd = StreamJournal ? StreamJournal->IntactEnd : 0;
+	ResetChanges();
+
+	bStreamAllChunks = bLoadAllChunks;
+	LoadStartTime = FPlatformTime::Seconds();
+	LoadedParts = 0;
+	LoadFrames = 0;
+
+	int32 NumParts = 0;
+	for (const WorldSave::FChunkInfo& Info : StreamChunks)
+	{
+		NumParts += Info.NumParts;
+	}
+	UE_LOG(LogGAM312, Log, TEXT("[WorldSave] Loading %s: %d players, %d chunks, %d parts, %d journal batches"),
+		*SlotName, Header.Players.Num(), StreamChunks.Num(), NumParts, JournalBatches);
+
+	if (StreamChunks.Num() == 0)
+	{
+		ResetStream();
+	}
+	return true;
+}
+
+// Players in the world get their saved state now; everyone else waits in OfflinePlayers until they join
+void UWorldSaveSubsystem::ApplyPlayers(const TArray<WorldSave::FSavedPlayer>& Players)
+{
+	OfflinePlayers.Reset();
+	DirtyOfflinePlayers.Reset();
+	for (const WorldSave::FSavedPlayer& Player : Players)
+	{
+		OfflinePlayers.Add(Player.PlayerName, Player);
+	}
+
+	for (TActorIterator<AMyCharacter> It(GetWorld()); It; ++It)
+	{
+		WorldSave::FSavedPlayer Saved;
+		if (OfflinePlayers.RemoveAndCopyValue(GetSavedPlayerName(*It), Saved))
+		{
+			ApplyPlayer(*It, Saved);
+		}
+	}
+}
+
+void UWorldSaveSubsystem::ApplyPlayer(AMyCharacter* Character, const WorldSave::FSavedPlayer& Saved)
+{
+	TGuardValue<bool> ApplyingGuard(bApplyingSave, true);
+
+	Character->Health = Saved.Health;
+	Character->Hunger = Saved.Hunger;
+	Character->Stamina = Saved.Stamina;
+	Character->MarkStatsDirty(EPlayerStatFlags::All);
+
+	if (Character->Inventory)
+	{
+		Character->Inventory->RestoreTotals(Saved.Resources, Saved.Buildings);
+	}
+}
+
+bool UWorldSaveSubsystem::OpenStream(const FString& Filename, WorldSave::FWorldSaveHeader& OutHeader)
+{
+	StreamFile.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenRead(*Filename));
+	if (!StreamFile || !WorldSave::ReadHeader(*StreamFile, OutHeader, StreamDataStart))
+	{
+		StreamFile.Reset();
+		return false;
+	}
+
+	StreamFilename = Filename;
+	StreamSaveId = OutHeader.SaveId;
+	StreamChunkSize = OutHeader.ChunkSize;
+	StreamChunks = OutHeader.Chunks;
+
+	StreamChunkIndex.Reset();
+	for (int32 Index = 0; Index < StreamChunks.Num(); ++Index)
+	{
+		StreamChunkIndex.Add(StreamChunks[Index].Cell, Index);
+	}
+
+	// The journal's players replace the saved ones, and cells only the journal has parts in become empty chunks
+	StreamJournal.Reset();
+	TSharedRef<WorldSave::FJournalReplay> Journal = MakeShared<WorldSave::FJournalReplay>();
+	if (WorldSave::ReadJournal(WorldSave::GetJournalFilename(Filename), *Journal))
+	{
+		if (Journal->SaveId == OutHeader.SaveId && Journal->ChunkSize == OutHeader.ChunkSize)
+		{
+			Journal->ApplyToPlayers(OutHeader.Players);
+			for (const TPair<FIntPoint, WorldSave::FJournalCell>& Cell : Journal->Cells)
+			{
+				if (!StreamChunkIndex.Contains(Cell.Key))
+				{
+					WorldSave::FChunkInfo& Info = StreamChunks.AddDefaulted_GetRef();
+					Info.Cell = Cell.Key;
+					StreamChunkIndex.Add(Cell.Key, StreamChunks.Num() - 1);
+				}
+			}
+			StreamJournal = Journal;
+		}
+		else
+		{
+			UE_LOG(LogGAM312, Warning, TEXT("[WorldSave] Ignoring the journal next to %s, it belongs to another save"), *Filename);
+		}
+	}
+
+	ChunkRequested.Init(false, StreamChunks.Num());
+
+	// Check for chunks in range on the next tick
+	TimeSinceStreamCheck = WorldSaveStream::CheckInterval;
+	return true;
+}
+
+void UWorldSaveSubsystem::GetPlayerLocations(TArray<FVector, TInlineAllocator<8>>& OutLocations) const
+{
+	for (FConstPlayerControllerIterator Iterator = GetWorld()->GetPlayerControllerIterator(); Iterator; ++Iterator)
+	{
+		const APlayerController* Controller = Iterator->Get();
+		if (Controller && Controller->GetPawn())
+		{
+			OutLocations.Add(Controller->GetPawn()->GetActorLocation());
+		}
+	}
+}
+
+void UWorldSaveSubsystem::RequestChunks()
+{
+	TArray<FVector, TInlineAllocator<8>> PlayerLocations;
+	GetPlayerLocations(PlayerLocations);
+
+	// Distance from a player to the nearest edge of each unloaded chunk
+	const double StreamDistance = CVarSaveStreamDistance.GetValueOnGameThread() + StreamChunkSize * UE_HALF_SQRT_2;
+	TArray<TPair<double, int32>> Candidates;
+	for (int32 Index = 0; Index < StreamChunks.Num(); ++Index)
+	{
+		if (ChunkRequested[Index])
+		{
+			continue;
+		}
+
+		double Distance = bStreamAllChunks ? 0.0 : TNumericLimits<double>::Max();
+		const FVector Center = WorldSave::GetCellCenter(StreamChunks[Index].Cell, StreamChunkSize);
+		for (const FVector& Location : PlayerLocations)
+		{
+			Distance = FMath::Min(Distance, FVector::Dist2D(Location, Center));
+		}
+
+		if (Distance <= StreamDistance)
+		{
+			Candidates.Emplace(Distance, Index);
+		}
+	}
+
+	if (Candidates.Num() == 0)
+	{
+		return;
+	}
+
+	Candidates.Sort([](const TPair<double, int32>& A, const TPair<double, int32>& B) { return A.Key < B.Key; });
+
+	TArray<WorldSave::FChunkInfo> Infos;
+	for (int32 Candidate = 0; Candidate < FMath::Min(Candidates.Num(), WorldSaveStream::MaxChunksPerRead); ++Candidate)
+	{
+		const int32 Index = Candidates[Candidate].Value;
+		ChunkRequested[Index] = true;
+		Infos.Add(StreamChunks[Index]);
+	}
+	NumChunksStreamed += Infos.Num();
+
+	// Only one read is in flight at a time, and the handle outlives it (FinishRead/ResetStream wait for it)
+	IFileHandle* File = StreamFile.Get();
+	const int64 DataStart = StreamDataStart;
+	PendingRead = UE::Tasks::Launch(UE_SOURCE_LOCATION, [File, DataStart, Journal = StreamJournal, Infos = MoveTemp(Infos)]()
+	{
+		TArray<WorldSave::FWorldSaveChunk> Chunks;
+		Chunks.Reserve(Infos.Num());
+		for (const WorldSave::FChunkInfo& Info : Infos)
+		{
+			if (!ReadStreamChunk(*File, DataStart, Info, Journal.Get(), Chunks.AddDefaulted_GetRef()))
+			{
+				UE_LOG(LogGAM312, Warning, TEXT("[WorldSave] Could not read chunk (%d, %d)"), Info.Cell.X, Info.Cell.Y);
+				Chunks.Pop(EAllowShrinking::No);
+			}
+		}
+		return Chunks;
+	});
+}
+
+void UWorldSaveSubsystem::UnloadChunks()
+{
+	SCOPE_CYCLE_COUNTER(STAT_GAM312_SaveChunkUnload);
+
+	// Only chunks the streamed save and its journal fully describe can be dropped and streamed back.
+	// An autosave in flight may still fail, and a pending full save means the file is behind.
+	UBuildingManagerSubsystem* BuildingManager = GetWorld()->GetSubsystem<UBuildingManagerSubsystem>();
+	const float UnloadSetting = CVarSaveUnloadDistance.GetValueOnGameThread();
+	if (UnloadSetting <= 0.0f || !BuildingManager || bStreamAllChunks || bFullSaveNeeded || IsSaving() || ApplyQueue.Num() > 0
+		|| StreamSaveId != ActiveSaveId || GetWorld()->GetNetMode() == NM_Client)
+	{
+		return;
+	}
+
+	TArray<FVector, TInlineAllocator<8>> PlayerLocations;
+	GetPlayerLocations(PlayerLocations);
+	if (PlayerLocations.Num() == 0)
+	{
+		return;
+	}
+
+	// Parts changed since the last autosave aren't in the journal yet; their chunks wait for it
+	TSet<FIntPoint> DirtyCells;
+	for (const TPair<WorldSave::FJournalPartKey, WorldSave::FJournalPartChange>& Pair : DirtyParts)
+	{
+		if (Pair.Value.Count != 0)
+		{
+			DirtyCells.Add(WorldSave::GetCell(FVector(Pair.Value.Part.Location), StreamChunkSize));
+		}
+	}
+
+	// At least a chunk past the stream-in range, so a player on the edge doesn't load and unload it every check
+	const double UnloadDistance = FMath::Max<double>(UnloadSetting, CVarSaveStreamDistance.GetValueOnGameThread() + StreamChunkSize) + StreamChunkSize * UE_HALF_SQRT_2;
+	TSet<FIntPoint> UnloadCells;
+	for (int32 Index = 0; Index < StreamChunks.Num(); ++Index)
+	{
+		const FIntPoint& Cell = StreamChunks[Index].Cell;
+		if (!ChunkRequested[Index] || DirtyCells.Contains(Cell))
+		{
+			continue;
+		}
+
+		double Distance = TNumericLimits<double>::Max();
+		const FVector Center = WorldSave::GetCellCenter(Cell, StreamChunkSize);
+		for (const FVector& Location : PlayerLocations)
+		{
+			Distance = FMath::Min(Distance, FVector::Dist2D(Location, Center));
+		}
+
+		if (Distance > UnloadDistance)
+		{
+			ChunkRequested[Index] = false;
+			UnloadCells.Add(Cell);
+		}
+	}
+
+	if (UnloadCells.Num() == 0)
+	{
+		return;
+	}
+
+	// Not tracked as removals: the saved chunk still has them
+	TGuardValue<bool> ApplyingGuard(bApplyingSave, true);
+	int32 NumRemoved = 0;
+	const TArray<FPlacedBuildingRecord>& Records = BuildingManager->GetRecords();
+	for (int32 RecordId = 0; RecordId < Records.Num(); ++RecordId)
+	{
+		if (Records[RecordId].IsValid() && UnloadCells.Contains(WorldSave::GetCell(Records[RecordId].Transform.GetLocation(), StreamChunkSize)))
+		{
+			NumRemoved += BuildingManager->RemovePart(RecordId) ? 1 : 0;
+		}
+	}
+
+	NumChunksUnloaded += UnloadCells.Num();
+	UE_LOG(LogGAM312, Verbose, TEXT("[WorldSave] Unloaded %d chunks (%d parts) out of range of every player"), UnloadCells.Num(), NumRemoved);
+}
+
+bool UWorldSaveSubsystem::ReadStreamChunk(IFileHandle& File, int64 DataStart, const WorldSave::FChunkInfo& Info, const WorldSave::FJournalReplay* Journal, WorldSave::FWorldSaveChunk& OutChunk)
+{
+	if (!WorldSave::ReadChunk(File, DataStart, Info, OutChunk))
+	{
+		return false;
+	}
+
+	if (Journal)
+	{
+		Journal->ApplyToChunk(OutChunk);
+	}
+	return true;
+}
+
+void UWorldSaveSubsystem::LoadChunk(int32 ChunkIndex)
+{
+	// The worker shares the file handle
+	FinishRead();
+
+	const WorldSave::FChunkInfo& Info = StreamChunks[ChunkIndex];
+	ChunkRequested[ChunkIndex] = true;
+	++NumChunksStreamed;
+	if (!ReadStreamChunk(*StreamFile, StreamDataStart, Info, StreamJournal.Get(), ApplyQueue.AddDefaulted_GetRef()))
+	{
+		UE_LOG(LogGAM312, Warning, TEXT("[WorldSave] Could not read chunk (%d, %d) of %s"), Info.Cell.X, Info.Cell.Y, *StreamFilename);
+		ApplyQueue.Pop(EAllowShrinking::No);
+	}
+}
+
+void UWorldSaveSubsystem::FinishRead()
+{
+	if (!PendingRead.IsValid())
+	{
+		return;
+	}
+
+	PendingRead.Wait();
+	ApplyQueue.Append(MoveTemp(PendingRead.GetResult()));
+	PendingRead = {};
+}
+
+void UWorldSaveSubsystem::ApplyChunks(int32 MaxParts)
+{
+	UBuildingManagerSubsystem* BuildingManager = GetWorld()->GetSubsystem<UBuildingManagerSubsystem>();
+	if (!BuildingManager)
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_GAM312_SaveChunkApply);
+	TGuardValue<bool> ApplyingGuard(bApplyingSave, true);
+
+	int32 NumPlaced = 0;
+	while (ApplyQueue.Num() > 0 && (MaxParts == INDEX_NONE || NumPlaced < MaxParts))
+	{
+		const WorldSave::FWorldSaveChunk& Chunk = ApplyQueue[0];
+
+		// Resources go first, when a chunk is started
+		if (ApplyPartIndex == 0)
+		{
+			for (const WorldSave::FSavedResource& Resource : Chunk.Resources)
+			{
+				ApplyResource(Resource, Chunk.Cell);
+			}
+		}
+
+		TArray<TSubclassOf<ABuildingPart>, TInlineAllocator<16>> ChunkClasses;
+		for (const FString& ClassPath : Chunk.ClassPaths)
+		{
+			ChunkClasses.Add(ResolvePartClass(ClassPath));
+		}
+
+		for (; ApplyPartIndex < Chunk.Parts.Num() && (MaxParts == INDEX_NONE || NumPlaced < MaxParts); ++ApplyPartIndex)
+		{
+			const WorldSave::FSavedPart& Part = Chunk.Parts[ApplyPartIndex];
+			if (ChunkClasses.IsValidIndex(Part.ClassIndex) && ChunkClasses[Part.ClassIndex])
+			{
+				BuildingManager->PlacePart(ChunkClasses[Part.ClassIndex], Part.BuildingId, Part.GetTransform(), false);
+			}
+			++NumPlaced;
+		}
+
+		if (ApplyPartIndex >= Chunk.Parts.Num())
+		{
+			ApplyQueue.RemoveAt(0, 1, EAllowShrinking::No);
+			ApplyPartIndex = 0;
+		}
+	}
+
+	LoadedParts += NumPlaced;
+}
+
+void UWorldSaveSubsystem::ApplyResource(const WorldSave::FSavedResource& Saved, const FIntPoint& Cell)
+{
+	const TWeakObjectPtr<AResource_M>* Found = ResourceNodes.Find(Saved.ActorName);
+	if (AResource_M* Node = Found ? Found->Get() : nullptr)
+	{
+		ApplyResourceState(Node, Saved);
+	}
+	else if (!ChangedResources.Contains(Saved.ActorName))
+	{
+		// Not streamed in by World Partition right now; restored when it is
+		const TPair<FVector, WorldSave::FSavedResource>* Stashed = StashedResources.Find(Saved.ActorName);
+		StashedResources.Add(Saved.ActorName, TPair<FVector, WorldSave::FSavedResource>(Stashed ? Stashed->Key : WorldSave::GetCellCenter(Cell, StreamChunkSize), Saved));
+	}
+}
+
+void UWorldSaveSubsystem::ApplyResourceState(AResource_M* Node, const WorldSave::FSavedResource& Saved)
+{
+	UResourceLifecycleSubsystem* Lifecycle = GetWorld()->GetSubsystem<UResourceLifecycleSubsystem>();
+	if (!Lifecycle)
+	{
+		return;
+	}
+
+	// Restoring saved state isn't a change to track
+	TGuardValue<bool> ApplyingGuard(bApplyingSave, true);
+
+	if (Saved.bDepleted && !Node->IsDepleted())
+	{
+		Lifecycle->DepleteNode(Node);
+	}
+	else if (!Saved.bDepleted && Node->IsDepleted())
+	{
+		Lifecycle->RegrowNode(Node);
+	}
+
+	// After the lifecycle, which refills regrown nodes
+	Node->totalResource = Saved.TotalResource;
+}
+
+TSubclassOf<ABuildingPart> UWorldSaveSubsystem::ResolvePartClass(const FString& ClassPath)
+{
+	if (const TSubclassOf<ABuildingPart>* Resolved = ResolvedClasses.Find(ClassPath))
+	{
+		return *Resolved;
+	}
+
+	TSubclassOf<ABuildingPart> PartClass = LoadClass<ABuildingPart>(nullptr, *ClassPath);
+	if (!PartClass)
+	{
+		UE_LOG(LogGAM312, Warning, TEXT("[WorldSave] Unknown part class %s; its parts are skipped"), *ClassPath);
+	}
+	ResolvedClasses.Add(ClassPath, PartClass);
+	return PartClass;
+}
+
+void UWorldSaveSubsystem::ResetStream()
+{
+	if (PendingRead.IsValid())
+	{
+		PendingRead.Wait();
+		PendingRead = {};
+	}
+
+	StreamFile.Reset();
+	StreamFilename.Reset();
+	StreamDataStart = 0;
+	StreamChunks.Reset();
+	StreamChunkIndex.Reset();
+	ChunkRequested.Reset();
+	StreamJournal.Reset();
+	bStreamAllChunks = false;
+	ApplyQueue.Reset();
+	ApplyPartIndex = 0;
+	ResourceNodes.Reset();
+	ChangedResources.Reset();
+	LoadStartTime = 0.0;
+}
+
+/** ---------- Benchmark ---------- **/
+
+void UWorldSaveSubsystem::StartBenchmark(TSubclassOf<ABuildingPart> PartClass, int32 NumParts)
+{
+	UBuildingManagerSubsystem* BuildingManager = GetWorld()->GetSubsystem<UBuildingManagerSubsystem>();
+	if (!BuildingManager || !PartClass || BenchStage != INDEX_NONE || IsSaving())
+	{
+		return;
+	}
+
+	ResetStream();
+	BuildingManager->ClearAll();
+
+	// Square grid around the world origin, spread over many chunks
+	const int32 Side = FMath::CeilToInt32(FMath::Sqrt(static_cast<float>(NumParts)));
+	const FVector Origin(-Side * WorldSaveBenchmark::Spacing * 0.5f, -Side * WorldSaveBenchmark::Spacing * 0.5f, 0.0f);
+
+	const double PlaceStart = FPlatformTime::Seconds();
+	{
+		// Not tracked for autosave: the full save right after covers them
+		TGuardValue<bool> ApplyingGuard(bApplyingSave, true);
+		for (int32 Index = 0; Index < NumParts; ++Index)
+		{
+			const FVector Location = Origin + FVector((Index % Side) * WorldSaveBenchmark::Spacing, (Index / Side) * WorldSaveBenchmark::Spacing, 0.0f);
+			BuildingManager->PlacePart(PartClass, INDEX_NONE, FTransform(FRotator(0.0f, (Index % 4) * 90.0f, 0.0f), Location), false);
+		}
+	}
+
+	BenchParts = BuildingManager->GetNumPlacedParts();
+	UE_LOG(LogGAM312, Log, TEXT("[SaveBench] Placed %d parts in %.1f ms"), BenchParts, (FPlatformTime::Seconds() - PlaceStart) * 1000.0);
+
+	if (BenchParts == 0)
+	{
+		UE_LOG(LogGAM312, Warning, TEXT("[SaveBench] No instanced parts to save (is gam312.Building.Instancing off?)"));
+		return;
+	}
+
+	if (SaveWorld(WorldSaveBenchmark::SlotName))
+	{
+		BenchStage = 0;
+	}
+}
+
+void UWorldSaveSubsystem::TickBenchmark()
+{
+	if (BenchStage == 0 && !IsSaving())
+	{
+		if (!LastSaveResult.bSuccess)
+		{
+			BenchStage = INDEX_NONE;
+			return;
+		}
+
+		UBuildingManagerSubsystem* BuildingManager = GetWorld()->GetSubsystem<UBuildingManagerSubsystem>();
+		BuildingManager->ClearAll();
+
+		BenchLoadStart = FPlatformTime::Seconds();
+		BenchStage = LoadWorld(WorldSaveBenchmark::SlotName, true) ? 1 : INDEX_NONE;
+	}
+	else if (BenchStage == 1 && LoadStartTime == 0.0)
+	{
+		UBuildingManagerSubsystem* BuildingManager = GetWorld()->GetSubsystem<UBuildingManagerSubsystem>();
+		const int32 NumRestored = BuildingManager->GetNumPlacedParts();
+
+		UE_LOG(LogGAM312, Log, TEXT("[SaveBench] %d parts | save: gather %.1f ms, write %.1f ms, %lld bytes (%.1f bytes/part) | load: %.1f ms over %d frames, %d parts restored%s"),
+			BenchParts, LastGatherSeconds * 1000.0, LastSaveResult.WriteSeconds * 1000.0, LastSaveResult.FileSize,
+			static_cast<double>(LastSaveResult.FileSize) / BenchParts,
+			(FPlatformTime::Seconds() - BenchLoadStart) * 1000.0, LoadFrames, NumRestored,
+			NumRestored == BenchParts ? TEXT("") : TEXT(" (MISMATCH)"));
+
+		BenchStage = INDEX_NONE;
+	}
+}
+
+/** ---------- Streaming Walk ---------- **/
+
+void UWorldSaveSubsystem::StartStreamWalk(float Distance, float Speed)
+{
+	APlayerController* Controller = GetWorld()->GetFirstPlayerController();
+	APawn* Pawn = Controller ? Controller->GetPawn() : nullptr;
+	if (!Pawn || GetWorld()->GetNetMode() == NM_Client)
+	{
+		UE_LOG(LogGAM312, Warning, TEXT("[StreamWalk] Needs a local pawn on the server or in a standalone game"));
+		return;
+	}
+
+	WalkPawn = Pawn;
+	WalkStart = Pawn->GetActorLocation();
+	WalkDirection = Pawn->GetActorForwardVector().GetSafeNormal2D(UE_SMALL_NUMBER, FVector::ForwardVector);
+	WalkDistance = FMath::Max(Distance, 0.0f);
+	WalkSpeed = FMath::Max(Speed, 1.0f);
+	WalkTravelled = 0.0f;
+	WalkElapsed = 0.0f;
+	TimeSinceWalkSample = 0.0f;
+
+	WalkStartMemory = FPlatformMemory::GetStats().UsedPhysical;
+	WalkPeakMemory = WalkStartMemory;
+	WalkPeakParts = 0;
+	WalkStartStreamed = NumChunksStreamed;
+	WalkStartUnloaded = NumChunksUnloaded;
+
+	UE_LOG(LogGAM312, Log, TEXT("[StreamWalk] Walking %.0f units at %.0f units/s from (%.0f, %.0f); unload distance %.0f, stream distance %.0f"),
+		WalkDistance, WalkSpeed, WalkStart.X, WalkStart.Y,
+		CVarSaveUnloadDistance.GetValueOnGameThread(), CVarSaveStreamDistance.GetValueOnGameThread());
+	SampleStreamWalk();
+}
+
+// Teleports along a straight line so every run crosses the same chunks at the same pace
+void UWorldSaveSubsystem::TickStreamWalk(float DeltaTime)
+{
+	APawn* Pawn = WalkPawn.Get();
+	WalkElapsed += DeltaTime;
+	WalkTravelled = FMath::Min(WalkTravelled + WalkSpeed * DeltaTime, WalkDistance);
+	Pawn->SetActorLocation(WalkStart + WalkDirection * WalkTravelled, false, nullptr, ETeleportType::TeleportPhysics);
+
+	TimeSinceWalkSample += DeltaTime;
+	if (TimeSinceWalkSample >= WorldSaveWalk::SampleInterval)
+	{
+		TimeSinceWalkSample = 0.0f;
+		SampleStreamWalk();
+	}
+
+	if (WalkTravelled < WalkDistance)
+	{
+		return;
+	}
+
+	SampleStreamWalk();
+
+	const UBuildingManagerSubsystem* BuildingManager = GetWorld()->GetSubsystem<UBuildingManagerSubsystem>();
+	const uint64 EndMemory = FPlatformMemory::GetStats().UsedPhysical;
+	UE_LOG(LogGAM312, Log, TEXT("[StreamWalk] Walked %.0f units in %.1f s | memory: start %.1f MB, peak %+.1f MB, end %+.1f MB | parts: peak %d, end %d | chunks: %d streamed in, %d unloaded"),
+		WalkTravelled, WalkElapsed,
+		WalkStartMemory / (1024.0 * 1024.0),
+		(static_cast<int64>(WalkPeakMemory) - static_cast<int64>(WalkStartMemory)) / (1024.0 * 1024.0),
+		(static_cast<int64>(EndMemory) - static_cast<int64>(WalkStartMemory)) / (1024.0 * 1024.0),
+		WalkPeakParts, BuildingManager ? BuildingManager->GetNumPlacedParts() : 0,
+		NumChunksStreamed - WalkStartStreamed, NumChunksUnloaded - WalkStartUnloaded);
+
+	WalkPawn.Reset();
+}
+
+void UWorldSaveSubsystem::SampleStreamWalk()
+{
+	const UBuildingManagerSubsystem* BuildingManager = GetWorld()->GetSubsystem<UBuildingManagerSubsystem>();
+	const int32 NumParts = BuildingManager ? BuildingManager->GetNumPlacedParts() : 0;
+	const uint64 UsedMemory = FPlatformMemory::GetStats().UsedPhysical;
+
+	WalkPeakMemory = FMath::Max(WalkPeakMemory, UsedMemory);
+	WalkPeakParts = FMath::Max(WalkPeakParts, NumParts);
+
+	UE_LOG(LogGAM312, Log, TEXT("[StreamWalk] %6.1f s  %7.0f units  parts %6d  chunks %4d/%-4d  memory %8.1f MB (%+.1f MB)"),
+		WalkElapsed, WalkTravelled, NumParts, ChunkRequested.CountSetBits(), StreamChunks.Num(),
+		UsedMemory / (1024.0 * 1024.0), (static_cast<int64>(UsedMemory) - static_cast<int64>(WalkStartMemory)) / (1024.0 * 1024.0));
+}
+
+static FAutoConsoleCommandWithWorldAndArgs GWorldSaveCommand(
+	TEXT("gam312.Save"),
+	TEXT("Saves placed parts, resource nodes and players to a slot. Arg: slot name (default: Quick)."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (UWorldSaveSubsystem* WorldSave = World ? World->GetSubsystem<UWorldSaveSubsystem>() : nullptr)
+		{
+			WorldSave->SaveWorld(Args.Num() > 0 ? Args[0] : TEXT("Quick"));
+		}
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs GWorldLoadCommand(
+	TEXT("gam312.Load"),
+	TEXT("Loads a slot, streaming its chunks in around the players. Args: slot name (default: Quick), \"all\" to stream every chunk."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (UWorldSaveSubsystem* WorldSave = World ? World->GetSubsystem<UWorldSaveSubsystem>() : nullptr)
+		{
+			WorldSave->LoadWorld(Args.Num() > 0 ? Args[0] : TEXT("Quick"), Args.Num() > 1 && Args[1] == TEXT("all"));
+		}
+	}));
+
+static FAutoConsoleCommandWithWorld GAutosaveCommand(
+	TEXT("gam312.Save.Autosave"),
+	TEXT("Autosaves now: appends the records changed since the last autosave to the slot's journal."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (UWorldSaveSubsystem* WorldSave = World ? World->GetSubsystem<UWorldSaveSubsystem>() : nullptr)
+		{
+			WorldSave->Autosave();
+		}
+	}));
+
+static FAutoConsoleCommandWithWorld GCompactJournalCommand(
+	TEXT("gam312.Save.Compact"),
+	TEXT("Folds the autosave journal into a new save in the background."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (UWorldSaveSubsystem* WorldSave = World ? World->GetSubsystem<UWorldSaveSubsystem>() : nullptr)
+		{
+			WorldSave->CompactJournal();
+		}
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs GWorldSaveBenchmarkCommand(
+	TEXT("gam312.Save.Benchmark"),
+	TEXT("Places a base of parts, saves it and loads it back, logging each step. Args: part count (default 100000), part class path."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		UWorldSaveSubsystem* WorldSave = World ? World->GetSubsystem<UWorldSaveSubsystem>() : nullptr;
+		if (!WorldSave)
+		{
+			return;
+		}
+
+		const int32 NumParts = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : WorldSaveBenchmark::DefaultParts;
+		const FString ClassPath = Args.Num() > 1 ? Args[1] : FString(WorldSaveBenchmark::DefaultPartClass);
+		UClass* PartClass = LoadClass<ABuildingPart>(nullptr, *ClassPath);
+		if (!PartClass)
+		{
+			UE_LOG(LogGAM312, Warning, TEXT("[SaveBench] Could not load part class %s"), *ClassPath);
+			return;
+		}
+
+		WorldSave->StartBenchmark(PartClass, NumParts);
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs GStreamWalkCommand(
+	TEXT("gam312.Save.StreamWalk"),
+	TEXT("Walks the local pawn straight ahead across the map, logging memory, placed parts and loaded chunks once a second. Args: distance (default 150000), speed in units/s (default 3000)."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (UWorldSaveSubsystem* WorldSave = World ? World->GetSubsystem<UWorldSaveSubsystem>() : nullptr)
+		{
+			WorldSave->StartStreamWalk(
+				Args.Num() > 0 ? FCString::Atof(*Args[0]) : WorldSaveWalk::DefaultDistance,
+				Args.Num() > 1 ? FCString::Atof(*Args[1]) : WorldSaveWalk::DefaultSpeed);
+		}
+	}));
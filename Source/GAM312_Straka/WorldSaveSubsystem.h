@@ -0,0 +1,341 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tasks/Task.h"
+#include "WorldSaveFormat.h"
+#include "WorldSaveJournal.h"
+#include "WorldSaveSubsystem.generated.h"
+
+class ABuildingPart;
+class AMyCharacter;
+class APawn;
+class AResource_M;
+struct FPlacedBuildingRecord;
+
+/**
+ * EWorldSaveWrite
+ */
+enum class EWorldSaveWrite : uint8
+{
+	// The whole world, replacing the save and its journal
+	Full,
+	// One autosave batch appended to the journal
+	Journal,
+	// The journal folded into a new save
+	Compaction,
+};
+
+/**
+ * FWorldSaveResult
+ *
+ * Outcome of one background save, handed back to the game thread.
+ */
+struct FWorldSaveResult
+{
+	EWorldSaveWrite Kind = EWorldSaveWrite::Full;
+	bool bSuccess = false;
+	int32 NumParts = 0;
+
+	// Size of the written save, or bytes appended to the journal
+	int64 FileSize = 0;
+	double WriteSeconds = 0.0;
+
+	// Where the journal now ends, after an append
+	int64 JournalEnd = INDEX_NONE;
+
+	// Save the journal now belongs to (new for full saves and compactions)
+	FGuid SaveId;
+	float ChunkSize = 0.0f;
+};
+
+/**
+ * UWorldSaveSubsystem
+ *
+ * Saves placed building parts, resource node harvest state and every character's
+ * inventory and stats to a versioned binary file split into spatial chunks
+ * (see WorldSaveFormat.h), under Saved/SaveGames/<Slot>.gsav. Players who are offline
+ * keep the state they were loaded or left with, and get it back when they join again.
+ *
+ * Saving gathers the world on the game thread and encodes and writes it on a worker.
+ * Loading reads the header right away (players) and then streams chunks in around the
+ * players: chunks are read on a worker and applied a bounded number of parts per frame.
+ * Chunks that were never streamed in are carried over into the next save unchanged.
+ * Only the server (or a standalone game) saves and loads.
+ *
+ * Autosaves don't rewrite the world. Characters, building parts and resource nodes
+ * report changes as they happen, and each autosave (gam312.Save.AutosaveInterval, off by default)
+ * appends just those records to the slot's journal (see WorldSaveJournal.h). Once the
+ * journal passes gam312.Save.CompactBytes it is folded into a new save in the background.
+ * Loading lays the journal over the save's chunks as they stream in.
+ *
+ * Runtime-placed parts aren't part of any World Partition cell, so the save's chunks
+ * stand in for them: once every player is past gam312.Save.UnloadDistance, a chunk's
+ * parts are removed from the world and the chunk streams back in from the save and
+ * journal when a player returns. Resource nodes are level actors that World Partition
+ * streams itself; their harvest state is stashed as they stream out and restored when
+ * they come back.
+ */
+UCLASS()
+class GAM312_STRAKA_API UWorldSaveSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	// Streams chunks, applies them and finishes saves; only ticks while one of those is pending
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+
+	// Gathers the world and starts writing it in the background. Returns false if a save is already running.
+	UFUNCTION(BlueprintCallable, Category = "Save")
+	bool SaveWorld(const FString& SlotName);
+
+	// Replaces the placed parts with the slot's and starts streaming its chunks in around the players
+	// (or all of them with bLoadAllChunks)
+	UFUNCTION(BlueprintCallable, Category = "Save")
+	bool LoadWorld(const FString& SlotName, bool bLoadAllChunks = false);
+
+	UFUNCTION(BlueprintPure, Category = "Save")
+	bool IsSaving() const { return PendingSave.IsValid(); }
+
+	// True while streamed chunks are being read or applied
+	UFUNCTION(BlueprintPure, Category = "Save")
+	bool IsApplyingChunks() const { return PendingRead.IsValid() || ApplyQueue.Num() > 0; }
+
+	// True while a loaded save still has chunks that may be streamed in
+	bool IsStreaming() const { return StreamChunks.Num() > 0; }
+
+	static FString GetSlotFilename(const FString& SlotName);
+
+	// Appends everything changed since the last autosave to the journal of the last saved or loaded slot
+	// (a full save if that slot has none yet). Returns false if a save is already running.
+	UFUNCTION(BlueprintCallable, Category = "Save")
+	bool Autosave();
+
+	// Folds the journal into a new save in the background
+	bool CompactJournal();
+
+	/** ---------- Change Tracking ---------- **/
+
+	// Called by UBuildingManagerSubsystem as parts are placed and removed
+	void MarkPartAdded(const FPlacedBuildingRecord& Record);
+	void MarkPartRemoved(const FPlacedBuildingRecord& Record);
+
+	// Placed parts were cleared outside a load; the next autosave has to be a full save
+	void MarkPartsCleared();
+
+	// Called when a node is harvested, depletes or regrows
+	void MarkResourceDirty(AResource_M* Node);
+
+	// Called as World Partition streams a resource node out and back in, so its harvest state survives
+	void StashResource(const AResource_M* Node);
+	void RestoreResource(AResource_M* Node);
+
+	// Called when a character is possessed on the server: gives it the saved state of its player, if any
+	void RestorePlayer(AMyCharacter* Character);
+
+	// Called when a character is unpossessed on the server: its player is saved as offline until possessed again
+	void StashPlayer(AMyCharacter* Character);
+
+	// Places a base of NumParts parts of PartClass, saves it and loads it back, logging the time of each step
+	void StartBenchmark(TSubclassOf<ABuildingPart> PartClass, int32 NumParts);
+
+	// Walks the local player's pawn Distance units straight ahead at Speed, logging memory,
+	// placed parts and loaded chunks once a second as chunks stream in and out
+	void StartStreamWalk(float Distance, float Speed);
+
+private:
+	/** ---------- Saving ---------- **/
+
+	// Everything the worker needs, copied from the world on the game thread
+	struct FSaveSnapshot
+	{
+		FString Filename;
+		float ChunkSize = 0.0f;
+		WorldSave::FWorldSaveHeader Header;
+		TArray<FString> ClassPaths;
+		TArray<WorldSave::FSavedPart> Parts;
+		TArray<TPair<FIntPoint, WorldSave::FSavedResource>> Resources;
+
+		// Chunks of the streamed save that were never applied, copied from OldFilename
+		// with the streamed journal laid over them
+		FString OldFilename;
+		int64 OldDataStart = 0;
+		TArray<WorldSave::FChunkInfo> CarriedChunks;
+		TSharedPtr<const WorldSave::FJournalReplay> Journal;
+	};
+
+	void GatherWorld(FSaveSnapshot& Snapshot) const;
+
+	// Clears every tracked change (after gathering a full save)
+	void ResetChanges();
+
+	// Builds a journal batch from the tracked changes and clears them
+	void GatherChanges(WorldSave::FJournalBatch& Batch);
+
+	// Synchronously streams in every unloaded chunk the world already has parts in, so the save can merge them
+	void LoadChunksWithParts();
+	static FWorldSaveResult WriteSnapshot(FSaveSnapshot& Snapshot);
+
+	// Worker: reads the whole save and its journal and writes them back as one save
+	static FWorldSaveResult CompactSave(const FString& Filename);
+
+	void FinishSave();
+
+	// Closes the streamed file so a worker can replace it; the unapplied chunks are remembered
+	void SuspendStream(TArray<WorldSave::FChunkInfo>* OutCarriedChunks);
+
+	// Reopens the stream from Filename, skipping chunks that were applied before SuspendStream
+	void ResumeStream(const FString& Filename);
+
+	/** ---------- Loading ---------- **/
+
+	void ApplyPlayers(const TArray<WorldSave::FSavedPlayer>& Players);
+	void ApplyPlayer(AMyCharacter* Character, const WorldSave::FSavedPlayer& Saved);
+
+	void GetPlayerLocations(TArray<FVector, TInlineAllocator<8>>& OutLocations) const;
+
+	// Starts a worker read of the nearest unloaded chunks in range of a player
+	void RequestChunks();
+
+	// Removes the parts of loaded chunks that every player has left behind; they stream back in from the save
+	void UnloadChunks();
+
+	// Reads one streamed chunk right away and queues it
+	void LoadChunk(int32 ChunkIndex);
+
+	// Reads a chunk and lays the journal (if any) over it
+	static bool ReadStreamChunk(IFileHandle& File, int64 DataStart, const WorldSave::FChunkInfo& Info, const WorldSave::FJournalReplay* Journal, WorldSave::FWorldSaveChunk& OutChunk);
+
+	// Applies queued chunks until MaxParts parts were placed (INDEX_NONE for no limit)
+	void ApplyChunks(int32 MaxParts);
+	void ApplyResource(const WorldSave::FSavedResource& Saved, const FIntPoint& Cell);
+	void ApplyResourceState(AResource_M* Node, const WorldSave::FSavedResource& Saved);
+	TSubclassOf<ABuildingPart> ResolvePartClass(const FString& ClassPath);
+
+	// Waits for the chunk read in flight and queues its chunks
+	void FinishRead();
+
+	// Stops streaming and forgets the streamed save
+	void ResetStream();
+
+	bool OpenStream(const FString& Filename, WorldSave::FWorldSaveHeader& OutHeader);
+
+	// Advances the benchmark state machine by one frame
+	void TickBenchmark();
+
+	// Moves the walking pawn and samples memory
+	void TickStreamWalk(float DeltaTime);
+	void SampleStreamWalk();
+
+	UE::Tasks::TTask<FWorldSaveResult> PendingSave;
+	FString PendingSaveFilename;
+	double LastGatherSeconds = 0.0;
+	FWorldSaveResult LastSaveResult;
+
+	// Cells of the streamed save copied into the pending save without being loaded
+	TSet<FIntPoint> PendingCarriedCells;
+
+	/** ---------- Autosave ---------- **/
+
+	// Slot autosaves go to, and the save its journal belongs to
+	FString ActiveSlot;
+	FGuid ActiveSaveId;
+	float ActiveChunkSize = 0.0f;
+	int64 JournalBytes = 0;
+	int32 JournalBatches = 0;
+
+	// End of the last batch written to or read from the journal, where the next one goes. INDEX_NONE
+	// after a failed append, so the next one scans the file for it.
+	int64 JournalEnd = INDEX_NONE;
+
+	// Set when changes may have been missed, so only a full save is safe
+	bool bFullSaveNeeded = false;
+
+	// Set while a load applies saved state, which must not be tracked as changes
+	bool bApplyingSave = false;
+
+	// World time of the last autosave, and the time one in flight was started (for latency)
+	double LastAutosaveTime = 0.0;
+	double AutosaveStartTime = 0.0;
+	double AutosaveSpan = 0.0;
+	int32 AutosaveRecords = 0;
+
+	// Net part changes since the last autosave
+	TMap<WorldSave::FJournalPartKey, WorldSave::FJournalPartChange> DirtyParts;
+
+	// Resource nodes changed since the last autosave
+	TMap<FName, TWeakObjectPtr<AResource_M>> DirtyResources;
+
+	// Players who left with unsaved changes since the last autosave, by player name
+	TSet<FString> DirtyOfflinePlayers;
+
+	// Last known state of every player who isn't in the world, by player name: loaded from
+	// the save, or taken as they left. Merged into full saves so they aren't dropped.
+	TMap<FString, WorldSave::FSavedPlayer> OfflinePlayers;
+
+	// Save currently streamed from
+	FString StreamFilename;
+	FGuid StreamSaveId;
+	TUniquePtr<IFileHandle> StreamFile;
+	int64 StreamDataStart = 0;
+	float StreamChunkSize = 0.0f;
+	TArray<WorldSave::FChunkInfo> StreamChunks;
+	TMap<FIntPoint, int32> StreamChunkIndex;
+	TBitArray<> ChunkRequested;
+
+	// Journal of the streamed save, laid over its chunks as they are read
+	TSharedPtr<const WorldSave::FJournalReplay> StreamJournal;
+	bool bStreamAllChunks = false;
+	float TimeSinceStreamCheck = 0.0f;
+
+	UE::Tasks::TTask<TArray<WorldSave::FWorldSaveChunk>> PendingRead;
+	TArray<WorldSave::FWorldSaveChunk> ApplyQueue;
+	int32 ApplyPartIndex = 0;
+
+	// Level resource nodes by actor name, built when a load starts. Nodes that change
+	// afterwards are dropped (and named in ChangedResources) so a chunk streamed in later
+	// doesn't roll them back.
+	TMap<FName, TWeakObjectPtr<AResource_M>> ResourceNodes;
+	TSet<FName> ChangedResources;
+
+	// Location and state of resource nodes World Partition has streamed out, by actor name
+	TMap<FName, TPair<FVector, WorldSave::FSavedResource>> StashedResources;
+
+	UPROPERTY()
+	TMap<FString, TSubclassOf<ABuildingPart>> ResolvedClasses;
+
+	// Load progress, for logging
+	double LoadStartTime = 0.0;
+	int32 LoadedParts = 0;
+	int32 LoadFrames = 0;
+
+	// Chunks streamed in and unloaded so far, for the walk's report
+	int32 NumChunksStreamed = 0;
+	int32 NumChunksUnloaded = 0;
+
+	/** ---------- Benchmark State ---------- **/
+
+	int32 BenchStage = INDEX_NONE;
+	int32 BenchParts = 0;
+	double BenchLoadStart = 0.0;
+
+	/** ---------- Streaming Walk ---------- **/
+
+	TWeakObjectPtr<APawn> WalkPawn;
+	FVector WalkStart = FVector::ZeroVector;
+	FVector WalkDirection = FVector::ForwardVector;
+	float WalkDistance = 0.0f;
+	float WalkSpeed = 0.0f;
+	float WalkTravelled = 0.0f;
+	float WalkElapsed = 0.0f;
+	float TimeSinceWalkSample = 0.0f;
+	uint64 WalkStartMemory = 0;
+	uint64 WalkPeakMemory = 0;
+	int32 WalkPeakParts = 0;
+	int32 WalkStartStreamed = 0;
+	int32 WalkStartUnloaded = 0;
+};